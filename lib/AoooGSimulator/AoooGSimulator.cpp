@@ -0,0 +1,330 @@
+#include "AoooGSimulator.h"
+#include "AoooGFrame.h"
+
+AoooGSimulator::AoooGSimulator(uint32_t seed) {
+    probeCount = 0;
+    rxHead = 0;
+    rxCount = 0;
+    lineFreeMicros = 0;
+    requestLength = 0;
+    lastRequestByteTime = 0;
+    latencyMs = DEFAULT_LATENCY_MS;
+    jitterMs = 0;
+    dropRate = 0;
+    crcErrorRate = 0;
+    collisions = true;
+    bootTimeMs = DEFAULT_BOOT_TIME_MS;
+    setBaudrate(9600);
+    setSeed(seed);
+    resetStats();
+}
+
+int AoooGSimulator::addProbe(uint8_t address) {
+    if (probeCount >= MAX_PROBES || address == BROADCAST_ADDRESS || findProbe(address) != nullptr) {
+        return -1;
+    }
+    
+    // Plausible defaults, tests adjust what they need through getProbe()
+    Probe& probe = probes[probeCount];
+    probe.address = address;
+    probe.online = true;
+    probe.temperature = 25;
+    probe.fuelValue = 2048;
+    probe.frequency = 59303;
+    probe.levelMax = 4000;
+    probe.levelMin = 100;
+    probe.emptyFrequency = 18982;
+    probe.serialNumber = 800000UL + address;
+    snprintf(probe.firmware, sizeof(probe.firmware), "SIM-AoooG v1.0");
+    probe.bootUntil = 0;
+    return probeCount++;
+}
+
+AoooGSimulator::Probe* AoooGSimulator::getProbe(int index) {
+    if (index < 0 || index >= probeCount) {
+        return nullptr;
+    }
+    return &probes[index];
+}
+
+AoooGSimulator::Probe* AoooGSimulator::findProbe(uint8_t address) {
+    for (int i = 0; i < probeCount; i++) {
+        if (probes[i].address == address) {
+            return &probes[i];
+        }
+    }
+    return nullptr;
+}
+
+int AoooGSimulator::getProbeCount() const {
+    return probeCount;
+}
+
+void AoooGSimulator::setBaudrate(unsigned long baudrate) {
+    // 8N1: start + 8 data + stop bit
+    byteMicros = baudrate > 0 ? 10000000UL / baudrate : 0;
+}
+
+void AoooGSimulator::setLatency(unsigned long latency, unsigned long jitter) {
+    latencyMs = latency;
+    jitterMs = jitter;
+}
+
+void AoooGSimulator::setByteDropRate(uint16_t perMille) {
+    dropRate = perMille;
+}
+
+void AoooGSimulator::setCrcErrorRate(uint16_t perMille) {
+    crcErrorRate = perMille;
+}
+
+void AoooGSimulator::setBroadcastCollisions(bool enabled) {
+    collisions = enabled;
+}
+
+void AoooGSimulator::setBootTime(unsigned long bootTime) {
+    bootTimeMs = bootTime;
+}
+
+void AoooGSimulator::setSeed(uint32_t seed) {
+    randomState = seed ? seed : 1; // xorshift must not start at 0
+}
+
+const AoooGSimulator::Stats& AoooGSimulator::getStats() const {
+    return stats;
+}
+
+void AoooGSimulator::resetStats() {
+    memset(&stats, 0, sizeof(stats));
+}
+
+uint32_t AoooGSimulator::nextRandom() {
+    // xorshift32: cheap, and the same seed gives the same run on host and target
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+bool AoooGSimulator::chance(uint16_t perMille) {
+    return perMille > 0 && nextRandom() % 1000 < perMille;
+}
+
+// ---------------------------------------------------------------------------
+// Stream side: what the driver reads and writes
+// ---------------------------------------------------------------------------
+
+int AoooGSimulator::available() {
+    unsigned long now = micros();
+    int count = 0;
+    while (count < rxCount &&
+           (long)(now - rxBuffer[(rxHead + count) % RX_BUFFER_SIZE].dueMicros) >= 0) {
+        count++;
+    }
+    return count;
+}
+
+int AoooGSimulator::read() {
+    if (available() == 0) {
+        return -1;
+    }
+    uint8_t value = rxBuffer[rxHead].value;
+    rxHead = (rxHead + 1) % RX_BUFFER_SIZE;
+    rxCount--;
+    return value;
+}
+
+int AoooGSimulator::peek() {
+    return available() > 0 ? rxBuffer[rxHead].value : -1;
+}
+
+void AoooGSimulator::flush() {
+    // Requests are handled as they are written, nothing to drain
+}
+
+size_t AoooGSimulator::write(uint8_t byte) {
+    unsigned long now = millis();
+    
+    // A pause inside a request, or a byte that cannot start one, restarts framing like a probe would
+    if (requestLength > 0 && now - lastRequestByteTime > REQUEST_GAP_MS) {
+        requestLength = 0;
+    }
+    lastRequestByteTime = now;
+    if (requestLength == 0 && byte != REQUEST_HEADER) {
+        return 1;
+    }
+    
+    request[requestLength++] = byte;
+    if (requestLength == sizeof(request)) {
+        requestLength = 0;
+        if (AoooGCrc8::compute(request, 3) != request[3]) {
+            stats.badRequests++;
+        } else {
+            stats.requests++;
+            handleRequest(request[1], request[2]);
+        }
+    }
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Probe side
+// ---------------------------------------------------------------------------
+
+bool AoooGSimulator::isListening(const Probe& probe, unsigned long now) const {
+    return probe.online && (long)(now - probe.bootUntil) >= 0;
+}
+
+void AoooGSimulator::handleRequest(uint8_t address, uint8_t eventCode) {
+    unsigned long now = millis();
+    uint8_t merged[40];
+    int mergedLength = 0;
+    int answered = 0;
+    
+    for (int i = 0; i < probeCount; i++) {
+        Probe& probe = probes[i];
+        if (!isListening(probe, now) || (address != BROADCAST_ADDRESS && address != probe.address)) {
+            continue;
+        }
+        if (address == BROADCAST_ADDRESS && answered > 0 && !collisions) {
+            break;
+        }
+        
+        uint8_t frame[40];
+        int length = buildReply(probe, eventCode, frame);
+        if (length <= 0) {
+            continue;
+        }
+        
+        // Probes answering the same broadcast talk over each other: the line holds the AND
+        // of both drivers (a 0 bit wins), which is what the receiver then sees
+        if (answered == 0) {
+            memcpy(merged, frame, length);
+            mergedLength = length;
+        } else {
+            for (int j = 0; j < length; j++) {
+                merged[j] = j < mergedLength ? (merged[j] & frame[j]) : frame[j];
+            }
+            mergedLength = max(mergedLength, length);
+        }
+        answered++;
+    }
+    
+    if (answered > 1) {
+        stats.collisions++;
+    }
+    if (answered > 0) {
+        queueReply(merged, mergedLength);
+    }
+}
+
+int AoooGSimulator::buildReply(Probe& probe, uint8_t eventCode, uint8_t* frame) {
+    int length = 0;
+    frame[length++] = RESPONSE_HEADER;
+    frame[length++] = probe.address;
+    frame[length++] = eventCode;
+    
+    switch (eventCode) {
+        case 0x06: // TT F0 F1 (level LE) Q0 Q1 (frequency BE)
+            frame[length++] = probe.temperature;
+            frame[length++] = probe.fuelValue & 0xFF;
+            frame[length++] = probe.fuelValue >> 8;
+            frame[length++] = probe.frequency >> 8;
+            frame[length++] = probe.frequency & 0xFF;
+            break;
+        
+        case 0x07: // MX MX MN MN, both LE
+            frame[length++] = probe.levelMax & 0xFF;
+            frame[length++] = probe.levelMax >> 8;
+            frame[length++] = probe.levelMin & 0xFF;
+            frame[length++] = probe.levelMin >> 8;
+            break;
+        
+        case 0x02: // S0..S3 LE
+            for (int i = 0; i < 4; i++) {
+                frame[length++] = (probe.serialNumber >> (8 * i)) & 0xFF;
+            }
+            break;
+        
+        case 0x1C: { // ASCII, variable length
+            int textLength = strnlen(probe.firmware, FIRMWARE_SIZE);
+            memcpy(frame + length, probe.firmware, textLength);
+            length += textLength;
+            break;
+        }
+        
+        case 0xE3: // Undocumented, variable length: echo some internal state
+            frame[length++] = probe.temperature;
+            frame[length++] = probe.frequency >> 8;
+            frame[length++] = probe.frequency & 0xFF;
+            frame[length++] = 0x00;
+            break;
+        
+        case 0x18: // Factory reset: limits back to the full scale, status 00 = OK
+            probe.levelMax = 4095;
+            probe.levelMin = 0;
+            frame[length++] = 0x00;
+            break;
+        
+        case 0x45: // Set empty at the current level, status 01 = OK
+            probe.levelMin = probe.fuelValue;
+            probe.emptyFrequency = probe.frequency;
+            frame[length++] = 0x01;
+            break;
+        
+        case 0x46: // Set full at the current level, status 01 = OK
+            probe.levelMax = probe.fuelValue;
+            frame[length++] = 0x01;
+            break;
+        
+        case 0x51: // Empty frequency, LE
+            frame[length++] = probe.emptyFrequency & 0xFF;
+            frame[length++] = probe.emptyFrequency >> 8;
+            break;
+        
+        case 0x4D: // Restart: no reply, deaf while booting
+            probe.bootUntil = millis() + bootTimeMs;
+            return 0;
+        
+        default:   // Unknown commands are ignored
+            return 0;
+    }
+    
+    frame[length] = AoooGCrc8::compute(frame, length);
+    return length + 1;
+}
+
+void AoooGSimulator::queueReply(const uint8_t* frame, int length) {
+    stats.replies++;
+    
+    uint8_t bytes[40];
+    memcpy(bytes, frame, length);
+    if (chance(crcErrorRate)) {
+        bytes[nextRandom() % length] ^= (uint8_t)(1 << (nextRandom() % 8));
+        stats.corruptedFrames++;
+    }
+    
+    // The reply starts after the probe's latency, but never before the previous one has left the line
+    unsigned long delayMs = latencyMs + (jitterMs > 0 ? nextRandom() % (jitterMs + 1) : 0);
+    unsigned long start = micros() + delayMs * 1000UL;
+    if (rxCount > 0 && (long)(lineFreeMicros - start) > 0) {
+        start = lineFreeMicros;
+    }
+    
+    for (int i = 0; i < length; i++) {
+        unsigned long due = start + (unsigned long)(i + 1) * byteMicros;
+        lineFreeMicros = due;
+        if (chance(dropRate)) {
+            stats.droppedBytes++;
+            continue;
+        }
+        if (rxCount >= RX_BUFFER_SIZE) {
+            stats.overflowBytes++;
+            continue;
+        }
+        PendingByte& slot = rxBuffer[(rxHead + rxCount) % RX_BUFFER_SIZE];
+        slot.value = bytes[i];
+        slot.dueMicros = due;
+        rxCount++;
+    }
+}
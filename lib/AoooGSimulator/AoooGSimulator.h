@@ -0,0 +1,113 @@
+#ifndef AOOOGSIMULATOR_H
+#define AOOOGSIMULATOR_H
+
+#include <Arduino.h>
+
+// Virtual AoooG probes behind a Stream, for running FuelSensor without hardware:
+//   fuelSensor.begin(simulator);
+// Answers the commands FuelSensor uses (06, 07, 1C, 02, 18, E3, 4D, 45/46/51) from up to
+// MAX_PROBES addresses. Reply bytes become readable one at a time at the configured baud rate
+// after a latency with jitter; byte drops, CRC corruption and broadcast collisions can be
+// switched on. All randomness comes from a seeded generator, so a run can be repeated exactly.
+class AoooGSimulator : public Stream {
+public:
+    static const int MAX_PROBES = 8;
+    static const int FIRMWARE_SIZE = 24;
+    static const int RX_BUFFER_SIZE = 256;          // Reply bytes not yet read by the driver
+    static const unsigned long DEFAULT_LATENCY_MS = 15;
+    static const unsigned long DEFAULT_BOOT_TIME_MS = 1500;
+    
+    struct Probe {
+        uint8_t address;
+        bool online;               // false = unplugged, never answers
+        uint8_t temperature;       // Whole °C
+        uint16_t fuelValue;        // Raw level 0-4095
+        uint16_t frequency;        // Hz
+        uint16_t levelMax;
+        uint16_t levelMin;
+        uint16_t emptyFrequency;
+        uint32_t serialNumber;
+        char firmware[FIRMWARE_SIZE];
+        unsigned long bootUntil;   // millis() until which a restarted probe stays silent
+    };
+    
+    struct Stats {
+        uint32_t requests;         // Well-formed requests seen
+        uint32_t badRequests;      // Request frames with a wrong CRC
+        uint32_t replies;          // Reply frames queued (a collision counts once)
+        uint32_t collisions;       // Broadcasts answered by more than one probe
+        uint32_t droppedBytes;
+        uint32_t corruptedFrames;
+        uint32_t overflowBytes;    // Reply bytes lost because the driver did not read them
+    };
+    
+    AoooGSimulator(uint32_t seed = 1);
+    
+    // Probes
+    int addProbe(uint8_t address);              // Index, -1 when full or already present
+    Probe* getProbe(int index);                 // nullptr when out of range
+    Probe* findProbe(uint8_t address);
+    int getProbeCount() const;
+    
+    // Link behaviour
+    void setBaudrate(unsigned long baudrate);   // Paces reply bytes, 10 bits per byte
+    void setLatency(unsigned long latencyMs, unsigned long jitterMs = 0);
+    void setByteDropRate(uint16_t perMille);    // Each reply byte lost with this probability
+    void setCrcErrorRate(uint16_t perMille);    // Each reply frame gets one bit flipped
+    void setBroadcastCollisions(bool enabled);  // false: only the first online probe answers 0xFF
+    void setBootTime(unsigned long bootTimeMs); // Silence after a 0x4D restart
+    void setSeed(uint32_t seed);
+    
+    const Stats& getStats() const;
+    void resetStats();
+    
+    // Stream
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override;
+    size_t write(uint8_t byte) override;
+    using Print::write;
+
+private:
+    static const uint8_t REQUEST_HEADER = 0x31;
+    static const uint8_t RESPONSE_HEADER = 0x3E;
+    static const uint8_t BROADCAST_ADDRESS = 0xFF;
+    static const unsigned long REQUEST_GAP_MS = 20;  // Pause that abandons a partial request
+    
+    struct PendingByte {
+        uint8_t value;
+        unsigned long dueMicros;   // When the byte has fully arrived on the virtual line
+    };
+    
+    Probe probes[MAX_PROBES];
+    int probeCount;
+    
+    PendingByte rxBuffer[RX_BUFFER_SIZE];
+    int rxHead;
+    int rxCount;
+    unsigned long lineFreeMicros;  // End of the last queued reply byte
+    
+    uint8_t request[4];
+    uint8_t requestLength;         // Bytes of request[] so far; unsigned keeps the store provably in bounds
+    unsigned long lastRequestByteTime;
+    
+    unsigned long byteMicros;
+    unsigned long latencyMs;
+    unsigned long jitterMs;
+    uint16_t dropRate;
+    uint16_t crcErrorRate;
+    bool collisions;
+    unsigned long bootTimeMs;
+    uint32_t randomState;
+    Stats stats;
+    
+    void handleRequest(uint8_t address, uint8_t eventCode);
+    int buildReply(Probe& probe, uint8_t eventCode, uint8_t* frame);
+    void queueReply(const uint8_t* frame, int length);
+    bool isListening(const Probe& probe, unsigned long now) const;
+    uint32_t nextRandom();
+    bool chance(uint16_t perMille);
+};
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef CRC8_H
+#define CRC8_H
+
+#include <Arduino.h>
+#include <array>
+
+// Lookup strategy, trades flash for speed:
+//   CRC8_BITWISE  no table, 8 shift/xor steps per byte
+//   CRC8_NIBBLE   16-byte table, 2 lookups per byte
+//   CRC8_TABLE    256-byte table, 1 lookup per byte
+enum CRC8Variant {
+    CRC8_BITWISE = 0,
+    CRC8_NIBBLE,
+    CRC8_TABLE
+};
+
+namespace CRC8Detail {
+
+constexpr uint8_t reflect(uint8_t value) {
+    uint8_t result = 0;
+    for (int bit = 0; bit < 8; bit++) {
+        if (value & (1 << bit)) {
+            result |= 0x80 >> bit;
+        }
+    }
+    return result;
+}
+
+// Shift 'bits' bits of the register through the polynomial. poly is in processing order:
+// already bit-reversed when reflected, so nothing is recomputed per bit
+constexpr uint8_t shift(uint8_t crc, uint8_t poly, bool reflected, int bits) {
+    for (int bit = 0; bit < bits; bit++) {
+        if (reflected) {
+            crc = (crc & 0x01) ? (crc >> 1) ^ poly : crc >> 1;
+        } else {
+            crc = (crc & 0x80) ? (crc << 1) ^ poly : crc << 1;
+        }
+    }
+    return crc;
+}
+
+template <size_t N>
+constexpr std::array<uint8_t, N> makeTable(uint8_t poly, bool reflected) {
+    std::array<uint8_t, N> table = {};
+    // 256 entries cover a whole byte, 16 entries one nibble
+    const int bits = (N == 256) ? 8 : 4;
+    for (size_t i = 0; i < N; i++) {
+        uint8_t index = (uint8_t)i;
+        if (bits == 4 && !reflected) {
+            index <<= 4; // MSB-first: the nibble sits in the high half
+        }
+        table[i] = shift(index, poly, reflected, bits);
+    }
+    return table;
+}
+
+} // namespace CRC8Detail
+
+// CRC-8 engine in the parameter style of the CRC catalogue: Poly is the normal
+// (MSB-first) polynomial, Init the register start value and Reflected selects
+// LSB-first processing. Output XOR is not used by any of our devices.
+// Only the table of the variant actually used ends up in flash.
+template <uint8_t Poly, uint8_t Init, bool Reflected, CRC8Variant Variant = CRC8_TABLE>
+class CRC8 {
+public:
+    static constexpr uint8_t INIT = Init;
+    static constexpr uint8_t POLY = Reflected ? CRC8Detail::reflect(Poly) : Poly;   // Processing order
+    static constexpr std::array<uint8_t, 256> TABLE = CRC8Detail::makeTable<256>(POLY, Reflected);
+    static constexpr std::array<uint8_t, 16> NIBBLE_TABLE = CRC8Detail::makeTable<16>(POLY, Reflected);
+    
+    static constexpr uint8_t update(uint8_t crc, uint8_t byte) {
+        crc ^= byte;
+        // if constexpr keeps the unused table out of the build
+        if constexpr (Variant == CRC8_TABLE) {
+            return TABLE[crc];
+        } else if constexpr (Variant == CRC8_NIBBLE) {
+            if (Reflected) {
+                crc = (crc >> 4) ^ NIBBLE_TABLE[crc & 0x0F];
+                return (crc >> 4) ^ NIBBLE_TABLE[crc & 0x0F];
+            }
+            crc = (uint8_t)(crc << 4) ^ NIBBLE_TABLE[crc >> 4];
+            return (uint8_t)(crc << 4) ^ NIBBLE_TABLE[crc >> 4];
+        } else {
+            return CRC8Detail::shift(crc, POLY, Reflected, 8);
+        }
+    }
+    
+    static constexpr uint8_t compute(const uint8_t* data, size_t length, uint8_t crc = Init) {
+        for (size_t i = 0; i < length; i++) {
+            crc = update(crc, data[i]);
+        }
+        return crc;
+    }
+    
+    template <size_t N>
+    static constexpr uint8_t compute(const std::array<uint8_t, N>& data) {
+        return compute(data.data(), N);
+    }
+};
+
+// Catalogue check values over "123456789", every variant must agree
+constexpr std::array<uint8_t, 9> CRC8_CHECK_INPUT = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+static_assert(CRC8<0x31, 0x00, true, CRC8_TABLE>::compute(CRC8_CHECK_INPUT) == 0xA1, "CRC-8/MAXIM table");
+static_assert(CRC8<0x31, 0x00, true, CRC8_NIBBLE>::compute(CRC8_CHECK_INPUT) == 0xA1, "CRC-8/MAXIM nibble");
+static_assert(CRC8<0x31, 0x00, true, CRC8_BITWISE>::compute(CRC8_CHECK_INPUT) == 0xA1, "CRC-8/MAXIM bitwise");
+static_assert(CRC8<0x31, 0xFF, false, CRC8_TABLE>::compute(CRC8_CHECK_INPUT) == 0xF7, "CRC-8/NRSC-5 table");
+static_assert(CRC8<0x31, 0xFF, false, CRC8_NIBBLE>::compute(CRC8_CHECK_INPUT) == 0xF7, "CRC-8/NRSC-5 nibble");
+static_assert(CRC8<0x31, 0xFF, false, CRC8_BITWISE>::compute(CRC8_CHECK_INPUT) == 0xF7, "CRC-8/NRSC-5 bitwise");
+
+#endif
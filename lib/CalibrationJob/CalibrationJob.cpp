@@ -0,0 +1,211 @@
+#include "CalibrationJob.h"
+
+CalibrationJob::CalibrationJob(FuelSensor& sensor) : sensor(sensor) {
+    kind = CALIBRATE_FULL;
+    address = FuelSensor::BROADCAST_ADDRESS;
+    state = JOB_IDLE;
+    step = STEP_SEND_SET;
+    cancelRequested = false;
+    replyDone = false;
+    replyStatus = FuelSensor::TRANSACTION_UNKNOWN;
+    jobStart = 0;
+    stepStart = 0;
+    stepDuration = 0;
+}
+
+bool CalibrationJob::start(Kind jobKind, uint8_t probeAddress) {
+    if (state == JOB_RUNNING) {
+        return false;
+    }
+    
+    kind = jobKind;
+    address = probeAddress;
+    state = JOB_RUNNING;
+    cancelRequested = false;
+    jobStart = millis();
+    enterStep(STEP_SEND_SET, jobStart);
+    Serial.printf("=== %s LEVEL (job, probe 0x%02X) ===\n", getName(), address);
+    return true;
+}
+
+void CalibrationJob::cancel() {
+    if (state == JOB_RUNNING) {
+        cancelRequested = true;
+        Serial.printf("%s: cancel requested\n", getName());
+    }
+}
+
+void CalibrationJob::poll() {
+    if (state != JOB_RUNNING) {
+        return;
+    }
+    unsigned long now = millis();
+    
+    // Nothing can be called back once the restart is on its way, everything before can
+    if (cancelRequested && step != STEP_WAIT_RESTART && step != STEP_RESTART_SETTLE) {
+        bool requestInFlight = (step == STEP_WAIT_SET || step == STEP_WAIT_LIMITS) && !replyDone;
+        if (!requestInFlight) {
+            finish(JOB_CANCELLED);
+            return;
+        }
+    }
+    
+    switch (step) {
+        case STEP_SEND_SET:
+            if (!submit(kind == CALIBRATE_FULL ? FuelSensor::EVENT_SET_FULL_FREQ : FuelSensor::EVENT_SET_EMPTY_FREQ)) {
+                finish(JOB_FAILED);
+                return;
+            }
+            enterStep(STEP_WAIT_SET, now);
+            break;
+        
+        case STEP_WAIT_SET:
+            if (!replyDone) {
+                return;
+            }
+            // The engine already stored the reply (or cleared it) in lastSetResponse
+            if (replyStatus != FuelSensor::TRANSACTION_OK || !sensor.getLastSetSuccess()) {
+                finish(JOB_FAILED);
+                return;
+            }
+            enterStep(STEP_SETTLE, now, LIMITS_SETTLE_MS);
+            break;
+        
+        case STEP_SETTLE:
+            if (!waitElapsed(now)) {
+                return;
+            }
+            if (!submit(FuelSensor::EVENT_READ_LIMITS)) {
+                // Limits are refreshed later anyway, the restart still has to happen
+                enterStep(STEP_RESTART_DELAY, now, RESTART_DELAY_MS);
+                return;
+            }
+            enterStep(STEP_WAIT_LIMITS, now);
+            break;
+        
+        case STEP_WAIT_LIMITS:
+            if (!replyDone) {
+                return;
+            }
+            if (replyStatus != FuelSensor::TRANSACTION_OK) {
+                Serial.printf("%s: limits not read, continuing\n", getName());
+            }
+            Serial.printf("Sending restart command after %s in %lu ms...\n", getName(), RESTART_DELAY_MS);
+            enterStep(STEP_RESTART_DELAY, now, RESTART_DELAY_MS);
+            break;
+        
+        case STEP_RESTART_DELAY:
+            if (!waitElapsed(now)) {
+                return;
+            }
+            if (!submit(FuelSensor::EVENT_RESTART_SENSOR)) {
+                // The new point is stored, only the restart is missing
+                Serial.printf("%s: restart could not be queued\n", getName());
+                finish(JOB_DONE);
+                return;
+            }
+            enterStep(STEP_WAIT_RESTART, now);
+            break;
+        
+        case STEP_WAIT_RESTART:
+            if (!replyDone) {
+                return;
+            }
+            enterStep(STEP_RESTART_SETTLE, now, RESTART_SETTLE_MS);
+            break;
+        
+        case STEP_RESTART_SETTLE:
+            if (waitElapsed(now)) {
+                finish(JOB_DONE);
+            }
+            break;
+    }
+}
+
+bool CalibrationJob::submit(uint8_t eventCode) {
+    replyDone = false;
+    replyStatus = FuelSensor::TRANSACTION_PENDING;
+    return sensor.submitRequest(address, eventCode, onReply, this) != FuelSensor::INVALID_TRANSACTION;
+}
+
+void CalibrationJob::enterStep(Step next, unsigned long now, unsigned long duration) {
+    step = next;
+    stepStart = now;
+    stepDuration = duration;
+}
+
+bool CalibrationJob::waitElapsed(unsigned long now) const {
+    return now - stepStart >= stepDuration;
+}
+
+void CalibrationJob::finish(State result) {
+    state = result;
+    const char* outcome = result == JOB_DONE ? "done" : result == JOB_CANCELLED ? "cancelled" : "failed";
+    Serial.printf("%s job %s after %lu ms\n", getName(), outcome, millis() - jobStart);
+}
+
+void CalibrationJob::onReply(FuelSensor& sensor, const FuelSensor::TransactionResult& result, void* context) {
+    CalibrationJob* job = static_cast<CalibrationJob*>(context);
+    job->replyStatus = result.status;
+    job->replyDone = true;
+}
+
+CalibrationJob::State CalibrationJob::getState() const {
+    return state;
+}
+
+bool CalibrationJob::isRunning() const {
+    return state == JOB_RUNNING;
+}
+
+CalibrationJob::Kind CalibrationJob::getKind() const {
+    return kind;
+}
+
+uint8_t CalibrationJob::getAddress() const {
+    return address;
+}
+
+const char* CalibrationJob::getName() const {
+    return kind == CALIBRATE_FULL ? "SET FULL" : "SET EMPTY";
+}
+
+const char* CalibrationJob::getStepName() const {
+    switch (state) {
+        case JOB_IDLE:      return "";
+        case JOB_DONE:      return "DONE";
+        case JOB_FAILED:    return "FAILED";
+        case JOB_CANCELLED: return "CANCELLED";
+        case JOB_RUNNING:   break;
+    }
+    switch (step) {
+        case STEP_SEND_SET:
+        case STEP_WAIT_SET:       return "Sending...";
+        case STEP_SETTLE:
+        case STEP_WAIT_LIMITS:    return "Read limits";
+        case STEP_RESTART_DELAY:  return "Restart in";
+        case STEP_WAIT_RESTART:
+        case STEP_RESTART_SETTLE: return "Restarting";
+    }
+    return "";
+}
+
+int CalibrationJob::getProgress() const {
+    if (state == JOB_IDLE) {
+        return 0;
+    }
+    if (state != JOB_RUNNING) {
+        return 100;
+    }
+    // Slow replies stretch the run, so stop short of 100 until the last step is over
+    unsigned long elapsed = millis() - jobStart;
+    return (int)min(elapsed * 100 / NOMINAL_DURATION_MS, 99UL);
+}
+
+unsigned long CalibrationJob::getStepRemaining() const {
+    if (state != JOB_RUNNING || stepDuration == 0) {
+        return 0;
+    }
+    unsigned long elapsed = millis() - stepStart;
+    return elapsed >= stepDuration ? 0 : stepDuration - elapsed;
+}
@@ -0,0 +1,81 @@
+#ifndef CALIBRATIONJOB_H
+#define CALIBRATIONJOB_H
+
+#include <Arduino.h>
+#include "FuelSensor.h"
+
+// Set Full / Set Empty as a resumable job on the FuelSensor engine:
+//   send 0x46/0x45 -> wait 100 ms -> read limits (0x07) -> wait 5 s -> restart (0x4D) -> wait 1 s
+// poll() advances it from loop() and never blocks, so display, encoder and other sensors keep
+// running. The set reply (or its absence) ends up in FuelSensor's lastSetResponse as before.
+class CalibrationJob {
+public:
+    enum Kind {
+        CALIBRATE_FULL = 0,
+        CALIBRATE_EMPTY
+    };
+    
+    enum State {
+        JOB_IDLE = 0,      // Never started
+        JOB_RUNNING,
+        JOB_DONE,          // Sensor accepted the new point and was restarted
+        JOB_FAILED,        // No reply or NACK to the set command
+        JOB_CANCELLED      // Stopped by cancel() before the restart was sent
+    };
+    
+    static const unsigned long LIMITS_SETTLE_MS = 100;    // Sensor stores the new point before limits are read
+    static const unsigned long RESTART_DELAY_MS = 5000;   // Sensor writes its flash before the restart
+    static const unsigned long RESTART_SETTLE_MS = 1000;  // Sensor boots, bus stays quiet
+    
+    CalibrationJob(FuelSensor& sensor);
+    
+    // address: the probe to calibrate. Broadcast reaches every probe on the link and their
+    // replies collide, so it only works with a single probe fitted. false while a job is running
+    bool start(Kind kind, uint8_t address);
+    void cancel();                  // Takes effect between steps; a request on the wire still completes
+    void poll();                    // Call from loop() after fuelSensor.poll()
+    
+    State getState() const;
+    bool isRunning() const;
+    Kind getKind() const;
+    uint8_t getAddress() const;
+    const char* getName() const;                // "SET FULL" / "SET EMPTY"
+    const char* getStepName() const;            // Short text for the progress screen
+    int getProgress() const;                    // 0-100
+    unsigned long getStepRemaining() const;     // ms left in the current wait, 0 when not waiting
+
+private:
+    enum Step {
+        STEP_SEND_SET = 0,
+        STEP_WAIT_SET,
+        STEP_SETTLE,
+        STEP_WAIT_LIMITS,
+        STEP_RESTART_DELAY,
+        STEP_WAIT_RESTART,
+        STEP_RESTART_SETTLE
+    };
+    
+    // Nominal run time with prompt replies, used to turn elapsed time into progress
+    static const unsigned long NOMINAL_DURATION_MS = 200 + LIMITS_SETTLE_MS + RESTART_DELAY_MS + RESTART_SETTLE_MS;
+    
+    FuelSensor& sensor;
+    Kind kind;
+    uint8_t address;
+    State state;
+    Step step;
+    bool cancelRequested;
+    bool replyDone;                             // Callback of the current step's request has fired
+    FuelSensor::TransactionStatus replyStatus;
+    unsigned long jobStart;
+    unsigned long stepStart;
+    unsigned long stepDuration;
+    
+    bool submit(uint8_t eventCode);
+    void enterStep(Step next, unsigned long now, unsigned long duration = 0);
+    bool waitElapsed(unsigned long now) const;
+    void finish(State result);
+    
+    static void onReply(FuelSensor& sensor, const FuelSensor::TransactionResult& result, void* context);
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include "CircuitBreaker.h"
+
+CircuitBreaker::CircuitBreaker(uint8_t threshold, unsigned long baseBackoffMs, unsigned long maxBackoffMs) {
+    failureThreshold = threshold > 0 ? threshold : 1;
+    baseBackoff = baseBackoffMs;
+    maxBackoff = maxBackoffMs > baseBackoffMs ? maxBackoffMs : baseBackoffMs;
+    memset(&counters, 0, sizeof(counters));
+    reset();
+}
+
+void CircuitBreaker::reset() {
+    state = BREAKER_CLOSED;
+    consecutiveFailures = 0;
+    backoff = baseBackoff;
+    openedAt = 0;
+}
+
+bool CircuitBreaker::allowRequest(unsigned long now) {
+    switch (state) {
+        case BREAKER_CLOSED:
+            return true;
+        
+        case BREAKER_OPEN:
+            if (now - openedAt >= backoff) {
+                state = BREAKER_HALF_OPEN;
+                counters.halfOpened++;
+                return true;
+            }
+            counters.rejected++;
+            return false;
+        
+        case BREAKER_HALF_OPEN:
+            // The trial is still out
+            counters.rejected++;
+            return false;
+    }
+    return false;
+}
+
+void CircuitBreaker::recordSuccess(unsigned long now) {
+    counters.successes++;
+    consecutiveFailures = 0;
+    if (state != BREAKER_CLOSED) {
+        state = BREAKER_CLOSED;
+        backoff = baseBackoff;
+        counters.closed++;
+    }
+}
+
+void CircuitBreaker::recordFailure(unsigned long now) {
+    counters.failures++;
+    if (consecutiveFailures < 255) {
+        consecutiveFailures++;
+    }
+    
+    if (state == BREAKER_HALF_OPEN) {
+        // Still dead: wait twice as long before the next trial
+        backoff = backoff * 2 < maxBackoff ? backoff * 2 : maxBackoff;
+        open(now);
+    } else if (state == BREAKER_CLOSED && consecutiveFailures >= failureThreshold) {
+        backoff = baseBackoff;
+        open(now);
+    }
+}
+
+void CircuitBreaker::recordRetry() {
+    counters.retries++;
+}
+
+void CircuitBreaker::cancelRequest() {
+    if (state == BREAKER_HALF_OPEN) {
+        // openedAt is unchanged, so the next allowRequest() hands the trial out again
+        state = BREAKER_OPEN;
+        counters.halfOpened--;
+    }
+}
+
+void CircuitBreaker::open(unsigned long now) {
+    state = BREAKER_OPEN;
+    openedAt = now;
+    counters.opened++;
+}
+
+CircuitBreaker::State CircuitBreaker::getState() const {
+    return state;
+}
+
+const char* CircuitBreaker::getStateName() const {
+    switch (state) {
+        case BREAKER_CLOSED:    return "CLOSED";
+        case BREAKER_OPEN:      return "OPEN";
+        case BREAKER_HALF_OPEN: return "HALF";
+    }
+    return "?";
+}
+
+bool CircuitBreaker::isClosed() const {
+    return state == BREAKER_CLOSED;
+}
+
+uint8_t CircuitBreaker::getConsecutiveFailures() const {
+    return consecutiveFailures;
+}
+
+unsigned long CircuitBreaker::getBackoff() const {
+    return backoff;
+}
+
+unsigned long CircuitBreaker::getRetryIn(unsigned long now) const {
+    if (state != BREAKER_OPEN) {
+        return 0;
+    }
+    unsigned long elapsed = now - openedAt;
+    return elapsed >= backoff ? 0 : backoff - elapsed;
+}
+
+const CircuitBreaker::Counters& CircuitBreaker::getCounters() const {
+    return counters;
+}
@@ -0,0 +1,63 @@
+#ifndef CIRCUITBREAKER_H
+#define CIRCUITBREAKER_H
+
+#include <Arduino.h>
+
+// Stops asking a device that does not answer, and asks again at growing intervals.
+//   CLOSED     requests go out; failureThreshold failures in a row open the breaker
+//   OPEN       requests are refused for the current backoff
+//   HALF_OPEN  backoff over: exactly one trial request; success closes the breaker,
+//              failure opens it again with the backoff doubled (up to maxBackoff)
+// Callers ask allowRequest() before sending and report every outcome with recordSuccess()
+// or recordFailure(). No timers of its own: everything is decided from the millis() passed in.
+class CircuitBreaker {
+public:
+    enum State {
+        BREAKER_CLOSED = 0,
+        BREAKER_OPEN,
+        BREAKER_HALF_OPEN
+    };
+    
+    struct Counters {
+        uint32_t successes;
+        uint32_t failures;
+        uint32_t retries;          // Extra attempts inside CLOSED, see recordRetry()
+        uint32_t rejected;         // allowRequest() answered false
+        uint32_t opened;           // Entries into OPEN (trips and failed trials)
+        uint32_t halfOpened;       // Trial requests let through
+        uint32_t closed;           // Recoveries from OPEN/HALF_OPEN
+    };
+    
+    CircuitBreaker(uint8_t failureThreshold = 3, unsigned long baseBackoffMs = 1000,
+                   unsigned long maxBackoffMs = 60000);
+    
+    bool allowRequest(unsigned long now);
+    void recordSuccess(unsigned long now);
+    void recordFailure(unsigned long now);
+    void recordRetry();
+    void cancelRequest();                           // The allowed request never went out: a trial is given back
+    void reset();                                   // Back to CLOSED, counters kept
+    
+    State getState() const;
+    const char* getStateName() const;               // "CLOSED", "OPEN", "HALF"
+    bool isClosed() const;
+    uint8_t getConsecutiveFailures() const;
+    unsigned long getBackoff() const;               // Current (next) OPEN duration
+    unsigned long getRetryIn(unsigned long now) const; // ms until the next trial, 0 when not OPEN
+    const Counters& getCounters() const;
+
+private:
+    uint8_t failureThreshold;
+    unsigned long baseBackoff;
+    unsigned long maxBackoff;
+    
+    State state;
+    uint8_t consecutiveFailures;
+    unsigned long backoff;
+    unsigned long openedAt;
+    Counters counters;
+    
+    void open(unsigned long now);
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include "ConsumptionEstimator.h"
+
+ConsumptionEstimator::ConsumptionEstimator() {
+    reset();
+}
+
+void ConsumptionEstimator::reset() {
+    head = 0;
+    count = 0;
+    sumT = 0;
+    sumY = 0;
+    sumTT = 0;
+    sumTY = 0;
+    anchor = 0;
+    lastSample = 0;
+    started = false;
+    bucketStart = 0;
+    bucketSum = 0;
+    bucketTimeSum = 0;
+    bucketSamples = 0;
+}
+
+void ConsumptionEstimator::add(uint16_t level, unsigned long now) {
+    // Differences in 32 bits, as millis() wraps on the C3 (unsigned long is wider on the host)
+    if (started && (uint32_t)(now - lastSample) > MAX_GAP_MS) {
+        reset();
+    }
+    if (!started) {
+        started = true;
+        anchor = now;
+        bucketStart = now;
+    }
+    lastSample = now;
+    
+    // Close the bucket first: mean level at the mean time of its readings
+    if ((uint32_t)(now - bucketStart) >= BUCKET_MS && bucketSamples > 0) {
+        int32_t time = (int32_t)(bucketTimeSum / bucketSamples / 1000);
+        int32_t mean = (int32_t)((bucketSum + bucketSamples / 2) / bucketSamples);
+        if (time >= REBASE_SECONDS) {
+            int32_t shift = count > 0 ? ring[(head + WINDOW_SIZE - count) % WINDOW_SIZE].time : time;
+            rebase(shift);
+            time -= shift;
+        }
+        push(time, mean);
+        bucketStart = now;
+        bucketSum = 0;
+        bucketTimeSum = 0;
+        bucketSamples = 0;
+    }
+    bucketSum += level;
+    bucketTimeSum += (uint32_t)(now - anchor);
+    bucketSamples++;
+}
+
+void ConsumptionEstimator::push(int32_t time, int32_t level) {
+    if (count == WINDOW_SIZE) {
+        const Bucket& oldest = ring[head];
+        sumT -= oldest.time;
+        sumY -= oldest.level;
+        sumTT -= (int64_t)oldest.time * oldest.time;
+        sumTY -= (int64_t)oldest.time * oldest.level;
+    } else {
+        count++;
+    }
+    ring[head].time = time;
+    ring[head].level = level;
+    head = (head + 1) % WINDOW_SIZE;
+    sumT += time;
+    sumY += level;
+    sumTT += (int64_t)time * time;
+    sumTY += (int64_t)time * level;
+}
+
+// Move t = 0 forward by shift seconds; the slope does not change, the sums are rebuilt once
+void ConsumptionEstimator::rebase(int32_t shift) {
+    anchor += (unsigned long)shift * 1000;
+    sumT = 0;
+    sumTT = 0;
+    sumTY = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        Bucket& bucket = ring[(head + WINDOW_SIZE - count + i) % WINDOW_SIZE];
+        bucket.time -= shift;
+        sumT += bucket.time;
+        sumTT += (int64_t)bucket.time * bucket.time;
+        sumTY += (int64_t)bucket.time * bucket.level;
+    }
+}
+
+bool ConsumptionEstimator::isValid() const {
+    return count >= MIN_BUCKETS;
+}
+
+Centi ConsumptionEstimator::getRate() const {
+    if (!isValid()) {
+        return Centi::invalid();
+    }
+    // slope = (n*Sty - St*Sy) / (n*Stt - St^2) in units/s; gaps are bounded by MAX_GAP_MS, so
+    // numerator * 360000 (to 0.01 units/h) stays inside 64 bits
+    int64_t n = count;
+    int64_t numerator = n * sumTY - sumT * sumY;
+    int64_t denominator = n * sumTT - sumT * sumT;
+    if (denominator <= 0) {
+        return Centi::invalid();
+    }
+    return Centi::fromRaw((int32_t)(-numerator * 360000 / denominator));
+}
+
+uint8_t ConsumptionEstimator::getBucketCount() const {
+    return count;
+}
+
+unsigned long ConsumptionEstimator::getSpan() const {
+    if (count < 2) {
+        return 0;
+    }
+    const Bucket& newest = ring[(head + WINDOW_SIZE - 1) % WINDOW_SIZE];
+    const Bucket& oldest = ring[(head + WINDOW_SIZE - count) % WINDOW_SIZE];
+    return (unsigned long)(newest.time - oldest.time) * 1000;
+}
@@ -0,0 +1,58 @@
+#ifndef CONSUMPTIONESTIMATOR_H
+#define CONSUMPTIONESTIMATOR_H
+
+#include <Arduino.h>
+#include <FixedPoint.h>
+
+// How fast one probe's level falls: least-squares slope over a sliding window, updated per sample.
+// Readings are averaged into BUCKET_MS buckets (so the window length does not depend on the poll
+// rate); the last WINDOW_SIZE buckets are kept in a ring together with the running sums
+// n, sum t, sum y, sum t^2, sum t*y, so adding a bucket or dropping the oldest is O(1).
+// All integer: times in seconds from an anchor, levels in sensor units, 64-bit sums.
+// The owner resets it across refuel/drain steps and after gaps longer than MAX_GAP_MS.
+class ConsumptionEstimator {
+public:
+    static const uint8_t WINDOW_SIZE = 64;
+    static const unsigned long BUCKET_MS = 15000;      // 64 buckets = 16 min window
+    static const uint8_t MIN_BUCKETS = 8;              // Before that no rate is given
+    static const unsigned long MAX_GAP_MS = 600000;    // Longer without a reading restarts the window
+    
+    ConsumptionEstimator();
+    
+    void reset();
+    void add(uint16_t level, unsigned long now);
+    
+    bool isValid() const;
+    Centi getRate() const;              // Units per hour, positive while the level falls
+    uint8_t getBucketCount() const;
+    unsigned long getSpan() const;      // ms between the oldest and newest bucket
+
+private:
+    static const int32_t REBASE_SECONDS = 1L << 20;     // Anchor moves before t^2 sums get large
+    
+    struct Bucket {
+        int32_t time;                   // Seconds since anchor
+        int32_t level;                  // Mean of the bucket, units
+    };
+    
+    Bucket ring[WINDOW_SIZE];
+    uint8_t head;
+    uint8_t count;
+    int64_t sumT;
+    int64_t sumY;
+    int64_t sumTT;
+    int64_t sumTY;
+    
+    unsigned long anchor;               // millis() of t = 0
+    unsigned long lastSample;
+    bool started;
+    unsigned long bucketStart;
+    uint32_t bucketSum;
+    uint64_t bucketTimeSum;             // ms since anchor, summed over the bucket's readings
+    uint16_t bucketSamples;
+    
+    void push(int32_t time, int32_t level);
+    void rebase(int32_t shift);
+};
+
+#endif
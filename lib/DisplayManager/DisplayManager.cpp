@@ -4,24 +4,28 @@ DisplayManager::DisplayManager(uint8_t width, uint8_t height, uint8_t address) {
     _width = width;
     _height = height;
     _address = address;
-    _display = new Adafruit_SSD1306(width, height, &Wire, -1);
+    _bus = nullptr;
+    // Same clock during and after a transfer: the library must not drop the bus to 100 kHz behind
+    // the bus manager's back
+    _display = new Adafruit_SSD1306(width, height, &Wire, -1, I2C_CLOCK, I2C_CLOCK);
 }
 
-bool DisplayManager::begin(int sda_pin, int scl_pin) {
-    if (sda_pin != -1 && scl_pin != -1) {
-        Wire.begin(sda_pin, scl_pin);
-    } else {
-        Wire.begin();
-    }
-    
-    if (!_display->begin(SSD1306_SWITCHCAPVCC, _address)) {
+bool DisplayManager::begin(I2CBus& bus) {
+    _bus = &bus;
+    _bus->addDevice(_address, "OLED", I2C_CLOCK);
+    
+    // periphBegin = false: the bus manager already started Wire
+    _bus->lock(_address);
+    bool ok = _display->begin(SSD1306_SWITCHCAPVCC, _address, true, false);
+    _bus->unlock(ok);
+    if (!ok) {
         return false;
     }
     
     _display->clearDisplay();
     _display->setTextColor(SSD1306_WHITE);
     _display->setTextSize(1);
-    _display->display();
+    display();
     
     return true;
 }
@@ -31,7 +35,14 @@ void DisplayManager::clear() {
 }
 
 void DisplayManager::display() {
-    _display->display();
+    // The frame goes out in several Wire transfers; hold the bus for all of them
+    if (_bus != nullptr) {
+        _bus->lock(_address);
+        _display->display();
+        _bus->unlock();
+    } else {
+        _display->display();
+    }
 }
 
 void DisplayManager::showStartupMessage() {
@@ -62,7 +73,7 @@ void DisplayManager::showConnecting() {
     display();
 }
 
-void DisplayManager::drawSensorBox(int x, int y, int w, int h, const char* title, float temp, float hum, bool valid) {
+void DisplayManager::drawSensorBox(int x, int y, int w, int h, const char* title, Centi temp, Centi hum, bool valid) {
     _display->drawRect(x, y, w, h, SSD1306_WHITE);
     
     _display->setTextSize(1);
@@ -71,11 +82,11 @@ void DisplayManager::drawSensorBox(int x, int y, int w, int h, const char* title
     
     if (valid) {
         _display->setCursor(x + 2, y + 10);
-        _display->print(temp, 1);
+        printFixed(temp, 1);
         _display->print("C");
         
         _display->setCursor(x + 2, y + 19);
-        _display->print(hum, 0);
+        printFixed(hum, 0);
         _display->print("%");
     } else {
         _display->setCursor(x + 2, y + 12);
@@ -83,21 +94,21 @@ void DisplayManager::drawSensorBox(int x, int y, int w, int h, const char* title
     }
 }
 
-void DisplayManager::showSensorData(float temp1, float hum1, float temp2, float hum2, bool sensor2Available) {
+void DisplayManager::showSensorData(Centi temp1, Centi hum1, Centi temp2, Centi hum2, bool sensor2Available) {
     clear();
     
     if (_height >= 64) {
         // Large display - show both sensors side by side
-        drawSensorBox(0, 0, 63, 30, "SHT1", temp1, hum1, !isnan(temp1));
+        drawSensorBox(0, 0, 63, 30, "SHT1", temp1, hum1, temp1.isValid());
         if (sensor2Available) {
-            drawSensorBox(65, 0, 63, 30, "SHT2", temp2, hum2, !isnan(temp2));
+            drawSensorBox(65, 0, 63, 30, "SHT2", temp2, hum2, temp2.isValid());
         }
         
         // Status line
         _display->setCursor(0, 54);
         _display->setTextSize(1);
         _display->print("Status: ");
-        if (!isnan(temp1) || (sensor2Available && !isnan(temp2))) {
+        if (temp1.isValid() || (sensor2Available && temp2.isValid())) {
             _display->print("OK");
         } else {
             _display->print("ERROR");
@@ -109,18 +120,18 @@ void DisplayManager::showSensorData(float temp1, float hum1, float temp2, float
         _display->print("SHT Sensor Data");
         
         _display->setCursor(0, 10);
-        if (!isnan(temp1)) {
+        if (temp1.isValid()) {
             _display->print("Temp: ");
-            _display->print(temp1, 1);
+            printFixed(temp1, 1);
             _display->print(" C");
         } else {
             _display->print("Temp: N/A");
         }
         
         _display->setCursor(0, 20);
-        if (!isnan(hum1)) {
+        if (hum1.isValid()) {
             _display->print("Hum:  ");
-            _display->print(hum1, 0);
+            printFixed(hum1, 0);
             _display->print(" %");
         } else {
             _display->print("Hum:  N/A");
@@ -130,17 +141,17 @@ void DisplayManager::showSensorData(float temp1, float hum1, float temp2, float
     display();
 }
 
-void DisplayManager::showSensorAndFuelData(float shtTemp, float shtHum, 
-                                          float fuelTemp, int fuelLevel) {
+void DisplayManager::showSensorAndFuelData(Centi shtTemp, Centi shtHum, 
+                                          Centi fuelTemp, int fuelLevel) {
     clear();
     
     // SHT sensor data (line 1-2)
     _display->setCursor(0, 0);
-    if (!isnan(shtTemp)) {
+    if (shtTemp.isValid()) {
         _display->print("SHT: ");
-        _display->print(shtTemp, 1);
+        printFixed(shtTemp, 1);
         _display->print("C ");
-        _display->print(shtHum, 0);
+        printFixed(shtHum, 0);
         _display->print("%");
     } else {
         _display->print("SHT: N/A");
@@ -148,9 +159,9 @@ void DisplayManager::showSensorAndFuelData(float shtTemp, float shtHum,
     
     // Fuel sensor data (line 3-4)
     _display->setCursor(0, 15);
-    if (!isnan(fuelTemp)) {
+    if (fuelTemp.isValid()) {
         _display->print("Fuel: ");
-        _display->print(fuelTemp, 1);
+        printFixed(fuelTemp, 1);
         _display->print("C");
     } else {
         _display->print("Fuel: N/A");
@@ -167,18 +178,18 @@ void DisplayManager::showSensorAndFuelData(float shtTemp, float shtHum,
     display();
 }
 
-void DisplayManager::showSensorAndFuelWithLimits(float shtTemp, float shtHum, 
-                                                float fuelTemp, int fuelLevel,
+void DisplayManager::showSensorAndFuelWithLimits(Centi shtTemp, Centi shtHum, 
+                                                Centi fuelTemp, int fuelLevel,
                                                 int levelMax, int levelMin) {
     clear();
     
     // SHT sensor data (line 1)
     _display->setCursor(0, 0);
-    if (!isnan(shtTemp)) {
+    if (shtTemp.isValid()) {
         _display->print("T:");
-        _display->print(shtTemp, 1);
+        printFixed(shtTemp, 1);
         _display->print("C H:");
-        _display->print(shtHum, 0);
+        printFixed(shtHum, 0);
         _display->print("%");
     } else {
         _display->print("SHT: N/A");
@@ -186,9 +197,9 @@ void DisplayManager::showSensorAndFuelWithLimits(float shtTemp, float shtHum,
     
     // Fuel temperature (line 2)
     _display->setCursor(0, 8);
-    if (!isnan(fuelTemp)) {
+    if (fuelTemp.isValid()) {
         _display->print("Fuel: ");
-        _display->print(fuelTemp, 1);
+        printFixed(fuelTemp, 1);
         _display->print("C");
     } else {
         _display->print("Fuel: N/A");
@@ -218,7 +229,7 @@ void DisplayManager::showSensorAndFuelWithLimits(float shtTemp, float shtHum,
     display();
 }
 
-void DisplayManager::showFuelDetails(float fuelTemp, int fuelLevel, int levelMax, int levelMin) {
+void DisplayManager::showFuelDetails(Centi fuelTemp, int fuelLevel, int levelMax, int levelMin) {
     clear();
     
     // Title with fuel icon
@@ -232,14 +243,14 @@ void DisplayManager::showFuelDetails(float fuelTemp, int fuelLevel, int levelMax
     _display->setCursor(0, 12);
     _display->print("TEMP:");
     _display->setCursor(50, 12);
-    if (!isnan(fuelTemp)) {
-        _display->print(fuelTemp, 1);
+    if (fuelTemp.isValid()) {
+        printFixed(fuelTemp, 1);
         _display->print("C");
         
         // Simple thermometer visualization
-        if (fuelTemp > 70) {
+        if (fuelTemp > Centi::fromUnits(70)) {
             _display->print(" HOT!");
-        } else if (fuelTemp < 10) {
+        } else if (fuelTemp < Centi::fromUnits(10)) {
             _display->print(" COLD");
         }
     } else {
@@ -280,7 +291,7 @@ void DisplayManager::showFuelDetails(float fuelTemp, int fuelLevel, int levelMax
     display();
 }
 
-void DisplayManager::showSHTDetails(float shtTemp, float shtHum, uint8_t address) {
+void DisplayManager::showSHTDetails(Centi shtTemp, Centi shtHum, uint8_t address) {
     clear();
     
     _display->setCursor(0, 0);
@@ -291,18 +302,18 @@ void DisplayManager::showSHTDetails(float shtTemp, float shtHum, uint8_t address
     _display->print(address, HEX);
     
     _display->setCursor(0, 16);
-    if (!isnan(shtTemp)) {
+    if (shtTemp.isValid()) {
         _display->print("Temp: ");
-        _display->print(shtTemp, 2);
+        printFixed(shtTemp, 2);
         _display->print("C");
     } else {
         _display->print("Temp: N/A");
     }
     
     _display->setCursor(0, 24);
-    if (!isnan(shtHum)) {
+    if (shtHum.isValid()) {
         _display->print("Humidity: ");
-        _display->print(shtHum, 0);
+        printFixed(shtHum, 0);
         _display->print("%");
     } else {
         _display->print("Humidity: N/A");
@@ -343,7 +354,7 @@ void DisplayManager::showSystemInfo(bool sht_available, bool fuel_available, uin
     display();
 }
 
-void DisplayManager::showMainMenu(float shtTemp, float shtHum, float fuelTemp, int fuelLevel, 
+void DisplayManager::showMainMenu(Centi shtTemp, Centi shtHum, Centi fuelTemp, int fuelLevel, Deci fuelVolume,
                                  int highlight, bool sht_available, bool fuel_available) {
     clear();
 
@@ -366,10 +377,14 @@ void DisplayManager::showMainMenu(float shtTemp, float shtHum, float fuelTemp, i
         _display->setCursor(2, 10);
         _display->print("FUEL");
         
-        // Fuel value with larger text
+        // Fuel value with larger text: litres from the tank table, else sensor units
         _display->setTextSize(2);
         _display->setCursor(2, 18);
-        if (fuel_available && fuelLevel >= 0) {
+        if (fuel_available && fuelVolume.isValid()) {
+            _display->print(fuelVolume.whole());
+            _display->setTextSize(1);
+            _display->print("L");
+        } else if (fuel_available && fuelLevel >= 0) {
             _display->print(fuelLevel);
         } else {
             _display->setTextSize(1);
@@ -383,10 +398,12 @@ void DisplayManager::showMainMenu(float shtTemp, float shtHum, float fuelTemp, i
         
         _display->setTextSize(2);
         _display->setCursor(2, 18);
-        if (fuel_available && fuelLevel >= 0) {
-            _display->print(fuelLevel);
+        if (fuel_available && fuelVolume.isValid()) {
+            _display->print(fuelVolume.whole());
             _display->setTextSize(1);
             _display->print("L");
+        } else if (fuel_available && fuelLevel >= 0) {
+            _display->print(fuelLevel);
         } else {
             _display->setTextSize(1);
             _display->print("N/A");
@@ -405,11 +422,11 @@ void DisplayManager::showMainMenu(float shtTemp, float shtHum, float fuelTemp, i
         _display->print("SHT");
         _display->setTextSize(2);
         // Temperature and humidity with larger text
-        if (sht_available && !isnan(shtTemp) && !isnan(shtHum)) {
+        if (sht_available && shtTemp.isValid() && shtHum.isValid()) {
             _display->setCursor(66, 18);
-            _display->print((int)shtTemp);
+            _display->print(shtTemp.whole());
             _display->print("-");
-            _display->print((int)shtHum);
+            _display->print(shtHum.whole());
             _display->print("%");
         } else {
             _display->setCursor(66, 18);
@@ -422,11 +439,11 @@ void DisplayManager::showMainMenu(float shtTemp, float shtHum, float fuelTemp, i
         _display->setCursor(66, 10);
         _display->print("SHT");
         _display->setTextSize(2);
-        if (sht_available && !isnan(shtTemp) && !isnan(shtHum)) {
+        if (sht_available && shtTemp.isValid() && shtHum.isValid()) {
             _display->setCursor(66, 18);
-            _display->print((int)shtTemp);
+            _display->print(shtTemp.whole());
             _display->print("-");
-            _display->print((int)shtHum);
+            _display->print(shtHum.whole());
             _display->print("%");
         } else {
             _display->setCursor(66, 18);
@@ -512,6 +529,36 @@ void DisplayManager::showSettingMenuWithProgress(int currentSetting, int progres
     display();
 }
 
+void DisplayManager::showCalibrationProgress(const char* title, const char* status, int progressPercent) {
+    clear();
+    
+    // Title centered on the top line, e.g. "== SET FULL =="
+    char header[24];
+    snprintf(header, sizeof(header), "== %s ==", title);
+    int16_t x1, y1;
+    uint16_t w, h;
+    _display->getTextBounds(header, 0, 0, &x1, &y1, &w, &h);
+    _display->setTextSize(1);
+    _display->setCursor((_width - w) / 2, 1);
+    _display->print(header);
+    
+    // Current step, or the outcome once the job has ended
+    _display->setCursor(0, 12);
+    _display->print(status);
+    
+    // Progress bar across the bottom
+    if (progressPercent < 0) progressPercent = 0;
+    if (progressPercent > 100) progressPercent = 100;
+    _display->drawRect(0, 24, 100, 6, SSD1306_WHITE); // 1 pixel per percent
+    if (progressPercent > 0) {
+        _display->fillRect(0, 25, progressPercent, 4, SSD1306_WHITE);
+    }
+    _display->setCursor(104, 24);
+    _display->printf("%d%%", progressPercent);
+    
+    display();
+}
+
 void DisplayManager::showDSSTool() {
     clear();
     
@@ -534,10 +581,10 @@ void DisplayManager::showDSSTool() {
     display();
 }
 
-void DisplayManager::showSHTLargeDisplay(float shtTemp, float shtHum) {
+void DisplayManager::showSHTLargeDisplay(Centi shtTemp, Centi shtHum) {
     clear();
     
-    if (isnan(shtTemp) || isnan(shtHum)) {
+    if (!shtTemp.isValid() || !shtHum.isValid()) {
         // Show error message if no data
         _display->setCursor(20, 8);
         _display->print("SHT SENSOR");
@@ -552,7 +599,7 @@ void DisplayManager::showSHTLargeDisplay(float shtTemp, float shtHum) {
     
     // Temperature display - top half
     _display->setCursor(5, 2);
-    _display->print(shtTemp, 2);
+    printFixed(shtTemp, 2);
     _display->print(" C");
     
     // Small degree symbol manually (since large font doesn't show it well)
@@ -563,7 +610,7 @@ void DisplayManager::showSHTLargeDisplay(float shtTemp, float shtHum) {
     // Humidity display - bottom half
     _display->setTextSize(2);
     _display->setCursor(5, 18);
-    _display->print(shtHum, 0);
+    printFixed(shtHum, 0);
     _display->print("%");
     
     // Add small labels
@@ -621,7 +668,7 @@ void DisplayManager::fillInvertedRect(int x, int y, int w, int h) {
     _display->fillRect(x, y, w, h, WHITE);
 }
 
-void DisplayManager::showFuelDetailsWithRaw(float fuelTemp, int fuelLevel, int levelMax, int levelMin, const String& rawData) {
+void DisplayManager::showFuelDetailsWithRaw(Centi fuelTemp, int fuelLevel, int levelMax, int levelMin, const uint8_t* rawData, int rawLen) {
     clear();
     _display->setTextSize(1);
     _display->setCursor(0, 0);
@@ -629,8 +676,10 @@ void DisplayManager::showFuelDetailsWithRaw(float fuelTemp, int fuelLevel, int l
     _display->println("FUEL + RAW DATA");
     _display->println("---------------");
     
-    if (!isnan(fuelTemp)) {
-        _display->printf("T:%.1fC ", fuelTemp);
+    if (fuelTemp.isValid()) {
+        _display->print("T:");
+        printFixed(fuelTemp, 1);
+        _display->print("C ");
     } else {
         _display->print("T:-- ");
     }
@@ -645,51 +694,73 @@ void DisplayManager::showFuelDetailsWithRaw(float fuelTemp, int fuelLevel, int l
     _display->println("Raw Serial Data:");
     
     // Split long hex strings into multiple lines
-    String data = rawData;
-    int maxCharsPerLine = 21; // 128px / 6px per char
+    printHexLines(rawData, rawLen);
     
-    while (data.length() > 0) {
-        if (data.length() <= maxCharsPerLine) {
-            _display->println(data);
-            break;
-        } else {
-            // Find last space before maxCharsPerLine
-            int splitPos = data.lastIndexOf(' ', maxCharsPerLine);
-            if (splitPos == -1) splitPos = maxCharsPerLine;
-            
-            _display->println(data.substring(0, splitPos));
-            data = data.substring(splitPos + 1);
+    display();
+}
+
+void DisplayManager::printFixed(Centi value, int decimals) {
+    // Integer formatting, Print::print(double) would pull in soft-float on the C3
+    char text[FIXED_TEXT_SIZE];
+    value.format(text, sizeof(text), decimals);
+    _display->print(text);
+}
+
+void DisplayManager::printHexLines(const uint8_t* data, int length) {
+    // 7 bytes "XX XX .. XX" = 20 chars per line (128px / 6px per char = 21),
+    // rendered into a stack buffer only when the raw page is drawn
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+    const int bytesPerLine = 7;
+    char line[bytesPerLine * 3];
+    
+    for (int start = 0; start < length; start += bytesPerLine) {
+        int pos = 0;
+        for (int i = start; i < length && i < start + bytesPerLine; i++) {
+            if (i > start) line[pos++] = ' ';
+            line[pos++] = HEX_DIGITS[data[i] >> 4];
+            line[pos++] = HEX_DIGITS[data[i] & 0x0F];
         }
+        line[pos] = '\0';
+        _display->println(line);
     }
-    
-    display();
 }
 
-void DisplayManager::showFuelDetailsScrollable(float fuelTemp, int fuelLevel, int levelMax, int levelMin, uint16_t frequency, const String& rawData, 
+void DisplayManager::showFuelDetailsScrollable(Centi fuelTemp, int fuelLevel, Deci fuelVolume, Centi fuelPercent,
+                                             int levelMax, int levelMin, uint16_t frequency, 
+                                             const uint8_t* rawData, int rawLen, 
                                              const uint8_t* firmwareData, int firmwareLen,
-                                             const uint8_t* serialData, int serialLen, uint32_t serialNumber, int scrollPos) {
+                                             const uint8_t* serialData, int serialLen, uint32_t serialNumber,
+                                             Deci consumption, long minutesToEmpty, int scrollPos,
+                                             uint8_t probeAddress, int probeIndex, int probeCount) {
     clear();
     _display->setTextSize(1);
     _display->setCursor(0, 0);
     
-    // Show scroll indicator
-    _display->printf("FUEL [%d/5]", scrollPos + 1);
+    // Show scroll indicator, plus which probe when several share the fuel link
+    if (probeCount > 1) {
+        _display->printf("FUEL %02X %d/%d [%d/6]", probeAddress, probeIndex + 1, probeCount, scrollPos + 1);
+    } else {
+        _display->printf("FUEL [%d/6]", scrollPos + 1);
+    }
     _display->println();
     _display->println("------------");
     
     switch (scrollPos) {
-        case 0: // Basic info - Compact layout for 128x32
+        case 0: { // Basic info - Compact layout for 128x32
+            char tempText[FIXED_TEXT_SIZE];
+            fuelTemp.format(tempText, sizeof(tempText), 1);
+            
             // Line 1: Temperature + Units + Frequency together
-            if (!isnan(fuelTemp) && fuelLevel >= 0 && frequency > 0) {
-                _display->printf("T:%.1fC U:%d F:%d\n", fuelTemp, fuelLevel, frequency);
-            } else if (!isnan(fuelTemp) && fuelLevel >= 0) {
-                _display->printf("T:%.1fC U:%d F:--\n", fuelTemp, fuelLevel);
-            } else if (!isnan(fuelTemp) && frequency > 0) {
-                _display->printf("T:%.1fC U:-- F:%d\n", fuelTemp, frequency);
+            if (fuelTemp.isValid() && fuelLevel >= 0 && frequency > 0) {
+                _display->printf("T:%sC U:%d F:%d\n", tempText, fuelLevel, frequency);
+            } else if (fuelTemp.isValid() && fuelLevel >= 0) {
+                _display->printf("T:%sC U:%d F:--\n", tempText, fuelLevel);
+            } else if (fuelTemp.isValid() && frequency > 0) {
+                _display->printf("T:%sC U:-- F:%d\n", tempText, frequency);
             } else if (fuelLevel >= 0 && frequency > 0) {
                 _display->printf("T:-- U:%d F:%d\n", fuelLevel, frequency);
-            } else if (!isnan(fuelTemp)) {
-                _display->printf("T:%.1fC U:-- F:--\n", fuelTemp);
+            } else if (fuelTemp.isValid()) {
+                _display->printf("T:%sC U:-- F:--\n", tempText);
             } else if (fuelLevel >= 0) {
                 _display->printf("T:-- U:%d F:--\n", fuelLevel);
             } else if (frequency > 0) {
@@ -698,32 +769,24 @@ void DisplayManager::showFuelDetailsScrollable(float fuelTemp, int fuelLevel, in
                 _display->println("T:-- U:-- F:--");
             }
             
-            // Line 2: Max and Min limits together
-            if (levelMax >= 0 && levelMin >= 0) {
+            // Line 2: volume from the tank table, else Max and Min limits together
+            if (fuelVolume.isValid()) {
+                char volumeText[FIXED_TEXT_SIZE], percentText[FIXED_TEXT_SIZE];
+                fuelVolume.format(volumeText, sizeof(volumeText), 1);
+                fuelPercent.format(percentText, sizeof(percentText), 0);
+                _display->printf("V:%sL %s%%", volumeText, percentText);
+            } else if (levelMax >= 0 && levelMin >= 0) {
                 _display->printf("Max:%d Min:%d", levelMax, levelMin);
             } else {
                 _display->print("Max:-- Min:--");
             }
             break;
+        }
             
         case 1: // Raw data
             _display->println("Raw Serial Data:");
-            if (rawData.length() > 0) {
-                String data = rawData;
-                int maxCharsPerLine = 21;
-                
-                while (data.length() > 0) {
-                    if (data.length() <= maxCharsPerLine) {
-                        _display->println(data);
-                        break;
-                    } else {
-                        int splitPos = data.lastIndexOf(' ', maxCharsPerLine);
-                        if (splitPos == -1) splitPos = maxCharsPerLine;
-                        
-                        _display->println(data.substring(0, splitPos));
-                        data = data.substring(splitPos + 1);
-                    }
-                }
+            if (rawData && rawLen > 0) {
+                printHexLines(rawData, rawLen);
             } else {
                 _display->println("No data");
             }
@@ -780,11 +843,26 @@ void DisplayManager::showFuelDetailsScrollable(float fuelTemp, int fuelLevel, in
             _display->println("Protocol: AoooG");
             _display->println("Baud: 9600");
             _display->println("Connection: RS232");
-            if (levelMax >= 0 && levelMin >= 0 && fuelLevel >= 0) {
-                float percent = ((float)(fuelLevel - levelMin) / (levelMax - levelMin)) * 100.0;
-                if (percent < 0) percent = 0;
-                if (percent > 100) percent = 100;
-                _display->printf("Percent: %.1f%%", percent);
+            if (fuelPercent.isValid()) {
+                char percentText[FIXED_TEXT_SIZE];
+                fuelPercent.format(percentText, sizeof(percentText), 1);
+                _display->printf("Percent: %s%%", percentText);
+            }
+            break;
+        
+        case 5: // Consumption from the level trend (starts over after a refuel/drain)
+            if (consumption.isValid()) {
+                char rateText[FIXED_TEXT_SIZE];
+                consumption.format(rateText, sizeof(rateText), 1);
+                _display->printf("Rate: %s L/h\n", rateText);
+                if (minutesToEmpty >= 0) {
+                    _display->printf("Empty in: %ldh%02ldm", minutesToEmpty / 60, minutesToEmpty % 60);
+                } else {
+                    _display->print("Empty in: --");
+                }
+            } else {
+                _display->println("Rate: measuring...");
+                _display->print("Empty in: --");
             }
             break;
     }
@@ -793,13 +871,20 @@ void DisplayManager::showFuelDetailsScrollable(float fuelTemp, int fuelLevel, in
     display();
 }
 
-void DisplayManager::showSHTDetailsScrollable(float shtTemp, float shtHum, uint8_t address, int scrollPos) {
+void DisplayManager::showSHTDetailsScrollable(Centi shtTemp, Centi shtHum, uint8_t address, int scrollPos,
+                                              uint8_t channel, int sensorIndex, int sensorCount) {
     clear();
     _display->setTextSize(1);
     _display->setCursor(0, 0);
     
-    // Show scroll indicator
-    _display->printf("SHT [%d/3]", scrollPos + 1);
+    // Show scroll indicator, plus which sensor when several are fitted
+    if (sensorCount > 1 && channel != I2CBus::NO_CHANNEL) {
+        _display->printf("SHT c%u %02X %d/%d [%d/3]", channel, address, sensorIndex + 1, sensorCount, scrollPos + 1);
+    } else if (sensorCount > 1) {
+        _display->printf("SHT %02X %d/%d [%d/3]", address, sensorIndex + 1, sensorCount, scrollPos + 1);
+    } else {
+        _display->printf("SHT [%d/3]", scrollPos + 1);
+    }
     _display->println();
     _display->println("------------");
     
@@ -807,15 +892,17 @@ void DisplayManager::showSHTDetailsScrollable(float shtTemp, float shtHum, uint8
         case 0: // Large display
             _display->setTextSize(2);
             _display->setCursor(0, 15);
-            if (!isnan(shtTemp)) {
-                _display->printf("%.1fC", shtTemp);
+            if (shtTemp.isValid()) {
+                printFixed(shtTemp, 1);
+                _display->print("C");
             } else {
                 _display->print("--C");
             }
             
             _display->setCursor(70, 12);
-            if (!isnan(shtHum)) {
-                _display->printf("%.0f%%", shtHum);
+            if (shtHum.isValid()) {
+                printFixed(shtHum, 0);
+                _display->print("%");
             } else {
                 _display->print("--%");
             }
@@ -823,26 +910,30 @@ void DisplayManager::showSHTDetailsScrollable(float shtTemp, float shtHum, uint8
             
         case 1: // Detailed info
             _display->setTextSize(1);
-            if (!isnan(shtTemp)) {
-                _display->printf("Temp: %.2fC\n", shtTemp);
+            if (shtTemp.isValid()) {
+                _display->print("Temp: ");
+                printFixed(shtTemp, 2);
+                _display->println("C");
                 
                 // Temperature status
-                if (shtTemp > 35.0) {
+                if (shtTemp > Centi::fromUnits(35)) {
                     _display->println("Status: HOT!");
-                } else if (shtTemp < 10.0) {
+                } else if (shtTemp < Centi::fromUnits(10)) {
                     _display->println("Status: COLD");
                 } else {
                     _display->println("Status: Normal");
                 }
             }
             
-            if (!isnan(shtHum)) {
-                _display->printf("Humidity: %.1f%%\n", shtHum);
+            if (shtHum.isValid()) {
+                _display->print("Humidity: ");
+                printFixed(shtHum, 1);
+                _display->println("%");
                 
                 // Humidity status
-                if (shtHum > 80.0) {
+                if (shtHum > Centi::fromUnits(80)) {
                     _display->println("Level: HIGH");
-                } else if (shtHum < 30.0) {
+                } else if (shtHum < Centi::fromUnits(30)) {
                     _display->println("Level: LOW");
                 } else {
                     _display->println("Level: Normal");
@@ -853,7 +944,11 @@ void DisplayManager::showSHTDetailsScrollable(float shtTemp, float shtHum, uint8
         case 2: // Sensor info
             _display->printf("SHT Sensor Info:\n");
             _display->printf("Address: 0x%02X\n", address);
-            _display->println("Protocol: I2C");
+            if (channel != I2CBus::NO_CHANNEL) {
+                _display->printf("TCA9548A channel %u\n", channel);
+            } else {
+                _display->println("Protocol: I2C");
+            }
             _display->println("Type: SHT3x");
             _display->println("Connection: OK");
             break;
@@ -872,24 +967,26 @@ void DisplayManager::showExtendedMenu(int currentExtended) {
     _display->print("Extended Commands");
     _display->drawLine(0, 8, 128, 8, WHITE);
     
+    const char* commandNames[] = {
+        "FW: Read Version", 
+        "E3: Extended Cmd",
+        "RS: Restart Sensor",
+        "ALL: Send All Cmds",
+        "DG: Diagnostics"
+    };
+    const int commandCount = sizeof(commandNames) / sizeof(commandNames[0]);
+    
     // Calculate which commands to show (we can show 3 at a time)
     int startIndex = 0;
     if (currentExtended >= 3) {
         startIndex = currentExtended - 2;
     }
-    if (startIndex > 1) {
-        startIndex = 1; // Max start index to show last 3 items (now we have 4 total)
+    if (startIndex > commandCount - 3) {
+        startIndex = commandCount - 3; // Max start index to show the last 3 items
     }
     
-    const char* commandNames[] = {
-        "FW: Read Version", 
-        "E3: Extended Cmd",
-        "RS: Restart Sensor",
-        "ALL: Send All Cmds"
-    };
-    
     // Show 3 commands starting from startIndex
-    for (int i = 0; i < 3 && (startIndex + i) < 4; i++) {
+    for (int i = 0; i < 3 && (startIndex + i) < commandCount; i++) {
         int cmdIndex = startIndex + i;
         int yPos = 10 + (i * 8);
         
@@ -908,6 +1005,24 @@ void DisplayManager::showExtendedMenu(int currentExtended) {
     display();
 }
 
+void DisplayManager::showDiagnostics(const char* title, const char* line1, const char* line2, const char* line3) {
+    clear();
+    
+    // Title
+    _display->setCursor(0, 0);
+    _display->print(title);
+    _display->drawLine(0, 8, 128, 8, WHITE);
+    
+    // Three text lines, caller-formatted (21 characters fit)
+    const char* lines[] = { line1, line2, line3 };
+    for (int i = 0; i < 3; i++) {
+        _display->setCursor(0, 10 + (i * 8));
+        _display->print(lines[i]);
+    }
+    
+    display();
+}
+
 void DisplayManager::showExtendedResults(const uint8_t* firmwareData, int firmwareLen, 
                                        const uint8_t* extendedData, int extendedLen) {
     clear();
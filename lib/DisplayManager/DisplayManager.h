@@ -3,33 +3,44 @@
 
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
-#include <Wire.h>
+#include <I2CBus.h>
+#include <FixedPoint.h>
 
 class DisplayManager {
 public:
+    static const uint32_t I2C_CLOCK = 400000;   // SSD1306 fast mode; a 512-byte frame in ~13 ms
+    
     DisplayManager(uint8_t width = 128, uint8_t height = 32, uint8_t address = 0x3C);
-    bool begin(int sda_pin = -1, int scl_pin = -1);
+    bool begin(I2CBus& bus);
     void clear();
     void display();
     
     // Display sensor data
-    void showSensorData(float temp1, float hum1, float temp2 = NAN, float hum2 = NAN, bool sensor2Available = false);
-    void showSensorAndFuelData(float shtTemp, float shtHum, float fuelTemp, int fuelLevel);
-    void showSensorAndFuelWithLimits(float shtTemp, float shtHum, float fuelTemp, int fuelLevel, 
+    void showSensorData(Centi temp1, Centi hum1, Centi temp2 = Centi(), Centi hum2 = Centi(), bool sensor2Available = false);
+    void showSensorAndFuelData(Centi shtTemp, Centi shtHum, Centi fuelTemp, int fuelLevel);
+    void showSensorAndFuelWithLimits(Centi shtTemp, Centi shtHum, Centi fuelTemp, int fuelLevel, 
                                    int levelMax, int levelMin);
-    void showFuelDetails(float fuelTemp, int fuelLevel, int levelMax, int levelMin);
-    void showFuelDetailsWithRaw(float fuelTemp, int fuelLevel, int levelMax, int levelMin, const String& rawData);
-    void showFuelDetailsScrollable(float fuelTemp, int fuelLevel, int levelMax, int levelMin, uint16_t frequency, const String& rawData, 
+    void showFuelDetails(Centi fuelTemp, int fuelLevel, int levelMax, int levelMin);
+    void showFuelDetailsWithRaw(Centi fuelTemp, int fuelLevel, int levelMax, int levelMin, const uint8_t* rawData, int rawLen);
+    void showFuelDetailsScrollable(Centi fuelTemp, int fuelLevel, Deci fuelVolume, Centi fuelPercent,
+                                 int levelMax, int levelMin, uint16_t frequency, 
+                                 const uint8_t* rawData, int rawLen, 
                                  const uint8_t* firmwareData, int firmwareLen, 
-                                 const uint8_t* serialData, int serialLen, uint32_t serialNumber, int scrollPos);
-    void showSHTDetails(float shtTemp, float shtHum, uint8_t address);
-    void showSHTDetailsScrollable(float shtTemp, float shtHum, uint8_t address, int scrollPos);
-    void showSHTLargeDisplay(float shtTemp, float shtHum);
+                                 const uint8_t* serialData, int serialLen, uint32_t serialNumber,
+                                 Deci consumption, long minutesToEmpty, int scrollPos,
+                                 uint8_t probeAddress = 0, int probeIndex = 0, int probeCount = 1);
+    void showSHTDetails(Centi shtTemp, Centi shtHum, uint8_t address);
+    void showSHTDetailsScrollable(Centi shtTemp, Centi shtHum, uint8_t address, int scrollPos,
+                                  uint8_t channel = I2CBus::NO_CHANNEL, int sensorIndex = 0, int sensorCount = 1);
+    void showSHTLargeDisplay(Centi shtTemp, Centi shtHum);
     void showSystemInfo(bool sht_available, bool fuel_available, uint8_t sht_address, int displayMode, int timeoutCounter);
-    void showMainMenu(float shtTemp, float shtHum, float fuelTemp, int fuelLevel, int highlight, bool sht_available, bool fuel_available);
+    void showMainMenu(Centi shtTemp, Centi shtHum, Centi fuelTemp, int fuelLevel, Deci fuelVolume,
+                      int highlight, bool sht_available, bool fuel_available);
     void showSettingMenu(int currentSetting);
     void showSettingMenuWithProgress(int currentSetting, int progressPercent);
+    void showCalibrationProgress(const char* title, const char* status, int progressPercent);
     void showExtendedMenu(int currentExtended);
+    void showDiagnostics(const char* title, const char* line1, const char* line2, const char* line3);
     void showExtendedResults(const uint8_t* firmwareData, int firmwareLen, 
                            const uint8_t* extendedData, int extendedLen);
     void showDSSTool();
@@ -45,12 +56,15 @@ public:
     void fillInvertedRect(int x, int y, int w, int h);
     
 private:
+    I2CBus* _bus;
     Adafruit_SSD1306* _display;
     uint8_t _width;
     uint8_t _height;
     uint8_t _address;
     
-    void drawSensorBox(int x, int y, int w, int h, const char* title, float temp, float hum, bool valid);
+    void drawSensorBox(int x, int y, int w, int h, const char* title, Centi temp, Centi hum, bool valid);
+    void printHexLines(const uint8_t* data, int length);
+    void printFixed(Centi value, int decimals);
 };
 
 #endif // DISPLAYMANAGER_H
\ No newline at end of file
@@ -0,0 +1,95 @@
+#ifndef FIXEDPOINT_H
+#define FIXEDPOINT_H
+
+#include <Arduino.h>
+
+// Decimal fixed-point value for the FPU-less ESP32-C3: an int32 count of 1/Scale units
+// (Scale = 100 -> 0.01 steps). Default-constructed values are invalid and take the
+// place of NAN; check isValid() before comparing, as with isnan() before.
+template <int32_t Scale>
+class FixedPoint {
+public:
+    static const int32_t SCALE = Scale;
+    static const int32_t INVALID_RAW = INT32_MIN;
+    
+    constexpr FixedPoint() : raw(INVALID_RAW) {}
+    
+    static constexpr FixedPoint fromRaw(int32_t raw) { return FixedPoint(raw); }
+    static constexpr FixedPoint fromUnits(int32_t units) { return FixedPoint(units * Scale); }
+    static constexpr FixedPoint invalid() { return FixedPoint(); }
+    
+    constexpr bool isValid() const { return raw != INVALID_RAW; }
+    constexpr int32_t toRaw() const { return raw; }
+    constexpr int32_t whole() const { return raw / Scale; }   // Truncates like a (int) cast
+    
+    constexpr FixedPoint operator+(FixedPoint other) const { return FixedPoint(raw + other.raw); }
+    constexpr FixedPoint operator-(FixedPoint other) const { return FixedPoint(raw - other.raw); }
+    constexpr bool operator==(FixedPoint other) const { return raw == other.raw; }
+    constexpr bool operator!=(FixedPoint other) const { return raw != other.raw; }
+    constexpr bool operator<(FixedPoint other) const { return raw < other.raw; }
+    constexpr bool operator>(FixedPoint other) const { return raw > other.raw; }
+    constexpr bool operator<=(FixedPoint other) const { return raw <= other.raw; }
+    constexpr bool operator>=(FixedPoint other) const { return raw >= other.raw; }
+    
+    // "-12.3" with 'decimals' digits (rounded half away from zero), "--" when invalid.
+    // Integer-only, writes at most size-1 chars; returns the text length.
+    size_t format(char* buffer, size_t size, int decimals) const {
+        if (buffer == nullptr || size == 0) {
+            return 0;
+        }
+        if (!isValid()) {
+            return copy(buffer, size, "--");
+        }
+        
+        int32_t fractionScale = 1;
+        for (int i = 0; i < decimals && fractionScale < Scale; i++) {
+            fractionScale *= 10;
+        }
+        int32_t divisor = Scale / fractionScale;
+        uint32_t magnitude = raw < 0 ? (uint32_t)(-(int64_t)raw) : (uint32_t)raw;
+        uint32_t rounded = (magnitude + divisor / 2) / divisor;
+        uint32_t integerPart = rounded / fractionScale;
+        uint32_t fractionPart = rounded % fractionScale;
+        const char* sign = (raw < 0 && rounded > 0) ? "-" : "";
+        
+        int written;
+        if (fractionScale > 1) {
+            int digits = 0;
+            for (int32_t f = fractionScale; f > 1; f /= 10) {
+                digits++;
+            }
+            written = snprintf(buffer, size, "%s%lu.%0*lu", sign, (unsigned long)integerPart,
+                               digits, (unsigned long)fractionPart);
+        } else {
+            written = snprintf(buffer, size, "%s%lu", sign, (unsigned long)integerPart);
+        }
+        if (written < 0) {
+            buffer[0] = '\0';
+            return 0;
+        }
+        return min((size_t)written, size - 1);
+    }
+
+private:
+    int32_t raw;
+    
+    explicit constexpr FixedPoint(int32_t value) : raw(value) {}
+    
+    static size_t copy(char* buffer, size_t size, const char* text) {
+        size_t length = strlen(text);
+        if (length >= size) {
+            length = size - 1;
+        }
+        memcpy(buffer, text, length);
+        buffer[length] = '\0';
+        return length;
+    }
+};
+
+typedef FixedPoint<100> Centi;   // 0.01 steps: temperature in centi-degrees, humidity/percent in centi-percent
+typedef FixedPoint<10> Deci;     // 0.1 steps: fuel sensor units (deci-litres)
+
+// Text buffer for Centi/Deci::format(): sign, 10 digits, point, 2 decimals, terminator
+static const size_t FIXED_TEXT_SIZE = 16;
+
+#endif
@@ -0,0 +1,563 @@
+#include "FuelBusManager.h"
+
+FuelBusManager::FuelBusManager(FuelSensor& sensor)
+    : sensor(sensor), dataSchedule(DEFAULT_REQUEST_INTERVAL_MS, MAX_REQUEST_INTERVAL_MS) {
+    identityCache = nullptr;
+    probeCount = 0;
+    pollIndex = 0;
+    filterWindow = LevelFilter::DEFAULT_MEDIAN_WINDOW;
+    filterProcessNoise = LevelFilter::DEFAULT_PROCESS_NOISE;
+    filterMeasurementNoise = LevelFilter::DEFAULT_MEASUREMENT_NOISE;
+    filterSloshVariance = LevelFilter::DEFAULT_SLOSH_VARIANCE;
+    cycleFailureTime = 0;
+    budgetDeferrals = 0;
+    pollRetries = 0;
+    pollNoiseMark = 0;
+    scanning = false;
+    scanBroadcastPending = false;
+    scanRetried = false;
+    scanInFlight = false;
+    scanAddress = FIRST_ADDRESS;
+    scanLast = LAST_ADDRESS;
+    scanNoiseMark = 0;
+}
+
+void FuelBusManager::setIdentityCache(ProbeIdentityCache* cache) {
+    identityCache = cache;
+}
+
+void FuelBusManager::startScan(uint8_t first, uint8_t last) {
+    if (first < FIRST_ADDRESS) first = FIRST_ADDRESS;
+    if (last > LAST_ADDRESS) last = LAST_ADDRESS;
+    
+    scanning = true;
+    scanBroadcastPending = true;
+    scanRetried = false;
+    scanAddress = first;
+    scanLast = last;
+    Serial.printf("Fuel bus scan 0x%02X-0x%02X started\n", first, last);
+}
+
+void FuelBusManager::stopScan() {
+    // A request already on the wire still completes through onScanReply
+    scanning = false;
+    scanBroadcastPending = false;
+}
+
+bool FuelBusManager::isScanning() const {
+    return scanning || scanInFlight;
+}
+
+uint8_t FuelBusManager::getScanAddress() const {
+    return (uint8_t)min(scanAddress, (int)LAST_ADDRESS);
+}
+
+void FuelBusManager::poll() {
+    // One request at a time: the engine queue stays free for menu commands
+    if (sensor.isBusy() || scanInFlight) {
+        return;
+    }
+    
+    unsigned long now = millis();
+    bool pollDue = probeCount > 0 && dataSchedule.isDue(now);
+    
+    // Known probes keep their refresh rate, static reads and scan requests use the idle time in between
+    if (pollDue && pollNext(now)) {
+        return;
+    }
+    if (!readNextStatic(now) && scanning) {
+        scanNext();
+    }
+}
+
+void FuelBusManager::scanNext() {
+    if (scanBroadcastPending) {
+        scanBroadcastPending = false;
+        if (sensor.submitRequest(FuelSensor::BROADCAST_ADDRESS, FuelSensor::EVENT_READ_DATA,
+                                 onScanReply, this, SCAN_TIMEOUT_MS) != FuelSensor::INVALID_TRANSACTION) {
+            scanInFlight = true;
+        }
+        return;
+    }
+    
+    // Addresses found by the broadcast or an earlier scan are not asked again
+    while (scanAddress <= scanLast && findProbe((uint8_t)scanAddress) >= 0) {
+        scanAddress++;
+    }
+    if (scanAddress > scanLast) {
+        finishScan();
+        return;
+    }
+    
+    // A retry gets the engine's full deadline for slow probes
+    scanNoiseMark = parserNoise();
+    unsigned long timeout = scanRetried ? 0 : SCAN_TIMEOUT_MS;
+    if (sensor.submitRequest((uint8_t)scanAddress, FuelSensor::EVENT_READ_DATA,
+                             onScanReply, this, timeout) != FuelSensor::INVALID_TRANSACTION) {
+        scanInFlight = true;
+    }
+}
+
+void FuelBusManager::finishScan() {
+    scanning = false;
+    Serial.printf("Fuel bus scan complete: %d probe(s)\n", probeCount);
+    for (int i = 0; i < probeCount; i++) {
+        Serial.printf("  Probe %d: 0x%02X %s\n", i + 1, probes[i].address, probes[i].online ? "online" : "offline");
+    }
+}
+
+uint32_t FuelBusManager::parserNoise() const {
+    const AoooGFrameParser& parser = sensor.getFrameParser();
+    return parser.getCrcErrors() + parser.getDiscardedBytes();
+}
+
+bool FuelBusManager::budgetLeft() const {
+    return cycleFailureTime < CYCLE_FAILURE_BUDGET_MS;
+}
+
+bool FuelBusManager::pollNext(unsigned long now) {
+    // At most one pass over the table: probes whose breaker is open are skipped without a request
+    for (int checked = 0; checked < probeCount; checked++) {
+        if (pollIndex >= probeCount) {
+            pollIndex = 0;
+            cycleFailureTime = 0;
+        }
+        Probe& probe = probes[pollIndex];
+        pollIndex++;
+        
+        // A trial is due but this cycle already lost its budget to failures: next cycle
+        if (!probe.online && !budgetLeft() && probe.link.getRetryIn(now) == 0) {
+            budgetDeferrals++;
+            continue;
+        }
+        if (!probe.link.allowRequest(now)) {
+            continue;
+        }
+        
+        dataSchedule.begin(now);
+        pollRetries = 0;
+        if (!submitPoll(probe)) {
+            // Queue full: the breaker gets its trial back, the schedule counts a miss
+            probe.link.cancelRequest();
+            dataSchedule.complete(now, false, false);
+        }
+        return true;
+    }
+    return false;
+}
+
+bool FuelBusManager::submitPoll(Probe& probe) {
+    // Offline probes are only tried, with the scan deadline so a trial costs little bus time
+    unsigned long timeout = probe.online ? 0 : SCAN_TIMEOUT_MS;
+    pollNoiseMark = parserNoise();
+    return sensor.submitRequest(probe.address, FuelSensor::EVENT_READ_DATA, onProbeReply, this, timeout) !=
+           FuelSensor::INVALID_TRANSACTION;
+}
+
+bool FuelBusManager::readNextStatic(unsigned long now) {
+    for (int i = 0; i < probeCount; i++) {
+        Probe& probe = probes[i];
+        if (!probe.online) {
+            continue;
+        }
+        
+        // Cached values are confirmed once per session, well after the probe is up and polled
+        if (probe.fromCache && probe.pendingReads == 0 && now - probe.foundTime >= IDENTITY_REFRESH_DELAY_MS) {
+            probe.fromCache = false;
+            probe.pendingReads = READ_LIMITS | READ_FIRMWARE;
+        }
+        if (probe.pendingReads == 0) {
+            continue;
+        }
+        
+        // Serial first: it is the cache key and may make the other two unnecessary
+        uint8_t read = (probe.pendingReads & READ_SERIAL) ? READ_SERIAL
+                     : (probe.pendingReads & READ_LIMITS) ? READ_LIMITS : READ_FIRMWARE;
+        uint8_t eventCode = read == READ_SERIAL ? FuelSensor::EVENT_READ_SERIAL
+                          : read == READ_LIMITS ? FuelSensor::EVENT_READ_LIMITS : FuelSensor::EVENT_READ_FIRMWARE;
+        
+        // Cleared on submit, a failed read is not retried on its own
+        probe.pendingReads &= ~read;
+        return sensor.submitRequest(probe.address, eventCode, onProbeReply, this) != FuelSensor::INVALID_TRANSACTION;
+    }
+    return false;
+}
+
+void FuelBusManager::queueMissingReads(Probe& probe) {
+    if (!probe.limitsValid) {
+        probe.pendingReads |= READ_LIMITS;
+    }
+    if (probe.firmwareVersionLength == 0) {
+        probe.pendingReads |= READ_FIRMWARE;
+    }
+}
+
+bool FuelBusManager::restoreFromCache(Probe& probe) {
+    ProbeIdentityCache::Entry entry;
+    if (!identityCache || !identityCache->lookup(probe.serialNumber, entry)) {
+        return false;
+    }
+    
+    bool restored = false;
+    if (!probe.limitsValid && entry.limitsValid) {
+        probe.levelMax = entry.levelMax;
+        probe.levelMin = entry.levelMin;
+        probe.limitsValid = true;
+        restored = true;
+    }
+    if (probe.firmwareVersionLength == 0 && entry.firmwareVersionLength > 0) {
+        probe.firmwareVersionLength = min((int)entry.firmwareVersionLength, (int)sizeof(probe.firmwareVersion));
+        memcpy(probe.firmwareVersion, entry.firmwareVersion, probe.firmwareVersionLength);
+        restored = true;
+    }
+    if (restored) {
+        probe.fromCache = true;
+        Serial.printf("Fuel probe 0x%02X: identity restored from cache (SN %lu)\n",
+                      probe.address, (unsigned long)probe.serialNumber);
+    }
+    return restored;
+}
+
+void FuelBusManager::saveToCache(const Probe& probe) {
+    if (!identityCache || probe.serialNumberLength == 0 ||
+        (!probe.limitsValid && probe.firmwareVersionLength == 0)) {
+        return;
+    }
+    
+    ProbeIdentityCache::Entry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.serialNumber = probe.serialNumber;
+    entry.firmwareVersionLength = (uint8_t)min(probe.firmwareVersionLength, (int)ProbeIdentityCache::FIRMWARE_SIZE);
+    memcpy(entry.firmwareVersion, probe.firmwareVersion, entry.firmwareVersionLength);
+    entry.limitsValid = probe.limitsValid;
+    entry.levelMax = probe.levelMax;
+    entry.levelMin = probe.levelMin;
+    identityCache->store(entry);
+}
+
+int FuelBusManager::addProbe(uint8_t address) {
+    int index = findProbe(address);
+    if (index >= 0) {
+        return index;
+    }
+    if (probeCount >= MAX_PROBES) {
+        Serial.printf("Fuel probe table full, ignoring 0x%02X\n", address);
+        return -1;
+    }
+    
+    index = probeCount++;
+    Probe& probe = probes[index];
+    probe.address = address;
+    probe.online = true;
+    probe.temperature = Centi::fromRaw(0);
+    probe.fuelValue = 0;
+    probe.frequency = 0;
+    probe.dataValid = false;
+    memset(probe.rawFrame, 0, sizeof(probe.rawFrame));
+    probe.rawFrameLength = 0;
+    configureFilter(probe);
+    probe.level.reset();
+    probe.events.reset();
+    probe.consumption.reset();
+    probe.levelMax = 0;
+    probe.levelMin = 0;
+    probe.limitsValid = false;
+    memset(probe.firmwareVersion, 0, sizeof(probe.firmwareVersion));
+    probe.firmwareVersionLength = 0;
+    memset(probe.serialNumberData, 0, sizeof(probe.serialNumberData));
+    probe.serialNumberLength = 0;
+    probe.serialNumber = 0;
+    probe.pendingReads = READ_SERIAL;
+    probe.fromCache = false;
+    probe.foundTime = millis();
+    probe.lastSeen = millis();
+    probe.link = CircuitBreaker(OFFLINE_AFTER_FAILURES, OFFLINE_BACKOFF_MS, MAX_OFFLINE_BACKOFF_MS);
+    probe.pollCount = 0;
+    
+    Serial.printf("Found fuel probe at 0x%02X\n", address);
+    
+    // Static data is read once per probe in idle bus time (serial first, see readNextStatic),
+    // data is refreshed by the round-robin
+    return index;
+}
+
+void FuelBusManager::storeReply(Probe& probe, const FuelSensor::TransactionResult& result) {
+    // Called from the completion callback: the driver fields hold this reply
+    probe.lastSeen = millis();
+    probe.link.recordSuccess(probe.lastSeen);
+    if (!probe.online) {
+        probe.online = true;
+        probe.level.reset();    // The level may have moved a lot while the probe was away
+        probe.events.reset();
+        probe.consumption.reset();
+        Serial.printf("Fuel probe 0x%02X back online\n", probe.address);
+    }
+    
+    switch (result.eventCode) {
+        case FuelSensor::EVENT_READ_DATA:
+            probe.temperature = sensor.getTemperature();
+            probe.fuelValue = sensor.getFuelValue();
+            probe.frequency = sensor.getFrequency();
+            probe.rawFrameLength = min(sensor.getLastRawResponseLength(), (int)sizeof(probe.rawFrame));
+            memcpy(probe.rawFrame, sensor.getLastRawResponse(), probe.rawFrameLength);
+            probe.level.add(probe.fuelValue);
+            // The median follows a step within a few samples; the smoothed value would smear its timing
+            if (!probe.level.isSloshing()) {
+                uint32_t reported = probe.events.getEventCount();
+                probe.events.add(probe.level.getMedian(), probe.lastSeen);
+                // A refuel or drain is not consumption: the rate starts over once one is reported.
+                // A steady burn also enters short steps that end below minStep, the rate only pauses through those
+                if (probe.events.getEventCount() != reported) {
+                    probe.consumption.reset();
+                } else if (!probe.events.isInStep()) {
+                    probe.consumption.add(probe.level.getMedian(), probe.lastSeen);
+                }
+            }
+            probe.dataValid = true;
+            probe.pollCount++;
+            break;
+        
+        case FuelSensor::EVENT_READ_LIMITS:
+            probe.levelMax = sensor.getLevelMax();
+            probe.levelMin = sensor.getLevelMin();
+            probe.limitsValid = true;
+            saveToCache(probe);
+            break;
+        
+        case FuelSensor::EVENT_READ_FIRMWARE:
+            probe.firmwareVersionLength = min(sensor.getFirmwareVersionLength(), (int)sizeof(probe.firmwareVersion));
+            memcpy(probe.firmwareVersion, sensor.getFirmwareVersion(), probe.firmwareVersionLength);
+            saveToCache(probe);
+            break;
+        
+        case FuelSensor::EVENT_READ_SERIAL:
+            probe.serialNumberLength = min(sensor.getSerialNumberLength(), (int)sizeof(probe.serialNumberData));
+            memcpy(probe.serialNumberData, sensor.getSerialNumberData(), probe.serialNumberLength);
+            probe.serialNumber = sensor.getSerialNumber();
+            
+            // A probe seen before needs no limits/firmware reads, the rest is read and saved
+            restoreFromCache(probe);
+            queueMissingReads(probe);
+            saveToCache(probe);
+            break;
+        
+        default:
+            break;
+    }
+}
+
+void FuelBusManager::handleScanReply(const FuelSensor::TransactionResult& result) {
+    scanInFlight = false;
+    bool broadcast = result.address == FuelSensor::BROADCAST_ADDRESS;
+    
+    if (result.status == FuelSensor::TRANSACTION_OK) {
+        // The frame carries the address of whoever answered (the only way to learn it from a broadcast)
+        int index = addProbe(result.response[1]);
+        if (index >= 0) {
+            storeReply(probes[index], result);
+        }
+    } else if (!broadcast && result.status == FuelSensor::TRANSACTION_INVALID && result.responseLength > 0) {
+        // A frame from this address that the driver rejected still means a probe is there
+        addProbe(result.address);
+    } else if (!broadcast && !scanRetried && parserNoise() != scanNoiseMark) {
+        // Bytes arrived but no clean frame before the short deadline: ask this address once more
+        Serial.printf("Noise while scanning 0x%02X, retrying\n", result.address);
+        scanRetried = true;
+        return;
+    }
+    
+    if (!broadcast && result.address == scanAddress) {
+        scanAddress++;
+        scanRetried = false;
+    }
+    if (scanning && scanAddress > scanLast) {
+        finishScan();
+    }
+}
+
+void FuelBusManager::handleProbeReply(const FuelSensor::TransactionResult& result) {
+    int index = findProbe(result.address);
+    if (index < 0) {
+        return;
+    }
+    Probe& probe = probes[index];
+    unsigned long now = millis();
+    bool ok = result.status == FuelSensor::TRANSACTION_OK;
+    bool alive = ok || (result.status == FuelSensor::TRANSACTION_INVALID && result.responseLength > 0);
+    
+    if (result.eventCode == FuelSensor::EVENT_READ_DATA && !alive) {
+        cycleFailureTime += result.elapsedMs;
+        
+        // Bytes arrived but no clean frame: ask a live probe again at once. Silence is what a dead
+        // probe sounds like and is not retried, the breaker deals with it.
+        if (probe.online && pollRetries < POLL_RETRIES && parserNoise() != pollNoiseMark) {
+            if (!budgetLeft()) {
+                budgetDeferrals++;
+            } else if (submitPoll(probe)) {
+                pollRetries++;
+                probe.link.recordRetry();
+                Serial.printf("Noise polling 0x%02X, retrying\n", probe.address);
+                return;
+            }
+        }
+    }
+    
+    if (result.eventCode == FuelSensor::EVENT_READ_DATA) {
+        // A level that moves (or a probe that fails) keeps the schedule at its base rate
+        bool changed = ok && (!probe.dataValid ||
+                              abs((int)sensor.getFuelValue() - (int)probe.fuelValue) > STABLE_LEVEL_DELTA ||
+                              sensor.getTemperature() != probe.temperature);
+        dataSchedule.complete(now, ok, changed);
+    }
+    
+    if (result.status == FuelSensor::TRANSACTION_OK) {
+        storeReply(probe, result);
+        return;
+    }
+    if (result.eventCode == FuelSensor::EVENT_READ_SERIAL) {
+        // No serial number, no cache key: read everything from the probe
+        queueMissingReads(probe);
+    }
+    if (result.status == FuelSensor::TRANSACTION_INVALID && result.responseLength > 0) {
+        // The probe answered with something the driver rejected: alive, but keep the old data
+        probe.lastSeen = now;
+        probe.link.recordSuccess(now);
+        return;
+    }
+    
+    // Only missed data polls count towards offline, identity reads may simply be unsupported
+    if (result.eventCode == FuelSensor::EVENT_READ_DATA) {
+        probe.link.recordFailure(now);
+        if (probe.online && !probe.link.isClosed()) {
+            probe.online = false;
+            probe.dataValid = false;
+            Serial.printf("Fuel probe 0x%02X offline after %d failed polls, next try in %lu ms\n",
+                          probe.address, probe.link.getConsecutiveFailures(), probe.link.getBackoff());
+        }
+    }
+}
+
+void FuelBusManager::onScanReply(FuelSensor& sensor, const FuelSensor::TransactionResult& result, void* context) {
+    static_cast<FuelBusManager*>(context)->handleScanReply(result);
+}
+
+void FuelBusManager::onProbeReply(FuelSensor& sensor, const FuelSensor::TransactionResult& result, void* context) {
+    static_cast<FuelBusManager*>(context)->handleProbeReply(result);
+}
+
+void FuelBusManager::setRequestInterval(unsigned long intervalMs) {
+    dataSchedule.setBaseInterval(intervalMs);
+}
+
+unsigned long FuelBusManager::getRequestInterval() const {
+    return dataSchedule.getBaseInterval();
+}
+
+SampleScheduler& FuelBusManager::getDataSchedule() {
+    return dataSchedule;
+}
+
+void FuelBusManager::setLevelFilter(uint8_t medianWindow, uint32_t processNoise, uint32_t measurementNoise,
+                                    uint32_t sloshVariance) {
+    filterWindow = medianWindow;
+    filterProcessNoise = processNoise;
+    filterMeasurementNoise = measurementNoise;
+    filterSloshVariance = sloshVariance;
+    for (int i = 0; i < probeCount; i++) {
+        configureFilter(probes[i]);
+    }
+}
+
+void FuelBusManager::configureFilter(Probe& probe) {
+    probe.level.setMedianWindow(filterWindow);
+    probe.level.setNoise(filterProcessNoise, filterMeasurementNoise);
+    probe.level.setSloshThreshold(filterSloshVariance);
+}
+
+void FuelBusManager::printLinkHealth(Print& out) const {
+    unsigned long now = millis();
+    out.printf("Fuel link: cycle failures %lu/%lu ms, %lu deferred\n",
+               cycleFailureTime, CYCLE_FAILURE_BUDGET_MS, (unsigned long)budgetDeferrals);
+    for (int i = 0; i < probeCount; i++) {
+        const CircuitBreaker& link = probes[i].link;
+        const CircuitBreaker::Counters& counters = link.getCounters();
+        out.printf("  0x%02X %-6s ok %lu fail %lu retry %lu | open %lu half %lu closed %lu rejected %lu | next %lu ms\n",
+                   probes[i].address, link.getStateName(),
+                   (unsigned long)counters.successes, (unsigned long)counters.failures,
+                   (unsigned long)counters.retries, (unsigned long)counters.opened,
+                   (unsigned long)counters.halfOpened, (unsigned long)counters.closed,
+                   (unsigned long)counters.rejected, link.getRetryIn(now));
+    }
+}
+
+uint32_t FuelBusManager::getBudgetDeferrals() const {
+    return budgetDeferrals;
+}
+
+int FuelBusManager::getProbeCount() const {
+    return probeCount;
+}
+
+int FuelBusManager::getOnlineCount() const {
+    int count = 0;
+    for (int i = 0; i < probeCount; i++) {
+        if (probes[i].online) {
+            count++;
+        }
+    }
+    return count;
+}
+
+const FuelBusManager::Probe* FuelBusManager::getProbe(int index) const {
+    if (index < 0 || index >= probeCount) {
+        return nullptr;
+    }
+    return &probes[index];
+}
+
+bool FuelBusManager::takeLevelEvent(int index, LevelEventDetector::Event& event) {
+    if (index < 0 || index >= probeCount) {
+        return false;
+    }
+    return probes[index].events.takeEvent(event);
+}
+
+int FuelBusManager::findProbe(uint8_t address) const {
+    for (int i = 0; i < probeCount; i++) {
+        if (probes[i].address == address) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool FuelBusManager::requestLimits(int index) {
+    if (index < 0 || index >= probeCount) {
+        return false;
+    }
+    return sensor.submitRequest(probes[index].address, FuelSensor::EVENT_READ_LIMITS,
+                                onProbeReply, this) != FuelSensor::INVALID_TRANSACTION;
+}
+
+void FuelBusManager::invalidateLimits() {
+    for (int i = 0; i < probeCount; i++) {
+        Probe& probe = probes[i];
+        probe.limitsValid = false;
+        probe.pendingReads |= READ_LIMITS;
+        if (identityCache && probe.serialNumberLength > 0) {
+            identityCache->invalidateLimits(probe.serialNumber);
+        }
+    }
+}
+
+bool FuelBusManager::requestIdentity(int index) {
+    if (index < 0 || index >= probeCount) {
+        return false;
+    }
+    uint8_t address = probes[index].address;
+    bool ok = sensor.submitRequest(address, FuelSensor::EVENT_READ_SERIAL,
+                                   onProbeReply, this) != FuelSensor::INVALID_TRANSACTION;
+    ok = sensor.submitRequest(address, FuelSensor::EVENT_READ_FIRMWARE,
+                              onProbeReply, this) != FuelSensor::INVALID_TRANSACTION && ok;
+    return ok;
+}
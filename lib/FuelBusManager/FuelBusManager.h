@@ -0,0 +1,172 @@
+#ifndef FUELBUSMANAGER_H
+#define FUELBUSMANAGER_H
+
+#include <Arduino.h>
+#include "FuelSensor.h"
+#include "ProbeIdentityCache.h"
+#include "SampleScheduler.h"
+#include "CircuitBreaker.h"
+#include "LevelFilter.h"
+#include "LevelEventDetector.h"
+#include "ConsumptionEstimator.h"
+
+// Several AoooG probes sharing one RS232/RS485 line behind a single FuelSensor engine.
+// Discovers addresses 0x01-0xFE, keeps one record per probe and polls them round-robin.
+// Everything runs from FuelSensor callbacks: call poll() from loop() after fuelSensor.poll().
+// Online/offline state comes from the data polls themselves, no separate connection probe:
+// each probe has a CircuitBreaker that opens after OFFLINE_AFTER_FAILURES missed polls. An open
+// probe is skipped at no bus time and asked again (one short trial) at doubling intervals up to
+// MAX_OFFLINE_BACKOFF_MS, so a dead probe costs ~100 ms of bus time per minute, not a full
+// deadline per round. Failed requests of one round-robin cycle share CYCLE_FAILURE_BUDGET_MS:
+// once spent, retries and trials wait for the next cycle and the live probes go first.
+// Static data (serial, limits, firmware) is read in idle bus time; with an identity cache
+// attached, a probe seen before only needs its serial number read.
+// Data polls follow a SampleScheduler: adaptive by default (backs off while levels are steady),
+// burst runs them back to back at whatever rate the probes allow. Burst leaves no idle bus time,
+// so scanning and static reads wait until it is switched off.
+class FuelBusManager {
+public:
+    static const int MAX_PROBES = 8;
+    static const uint8_t FIRST_ADDRESS = 0x01;
+    static const uint8_t LAST_ADDRESS = 0xFE;
+    static const uint8_t QUICK_SCAN_LAST = 0x10;        // Range probes ship with, scanned first
+    static const unsigned long SCAN_TIMEOUT_MS = 100;   // Per-address deadline while scanning
+    static const unsigned long DEFAULT_REQUEST_INTERVAL_MS = 1000;
+    static const unsigned long MAX_REQUEST_INTERVAL_MS = 8000;    // Adaptive back-off limit for steady levels
+    static const uint16_t STABLE_LEVEL_DELTA = 2;                 // Raw level change still counted as steady
+    static const uint8_t OFFLINE_AFTER_FAILURES = 3;    // Unanswered data polls before a probe is offline
+    static const unsigned long OFFLINE_BACKOFF_MS = 2000;       // First wait before an offline probe is tried again
+    static const unsigned long MAX_OFFLINE_BACKOFF_MS = 60000;  // Doubling stops here
+    static const uint8_t POLL_RETRIES = 1;              // Immediate retries of a data poll spoiled by line noise
+    static const unsigned long CYCLE_FAILURE_BUDGET_MS = 1500;  // Bus time failed requests may take per cycle
+    static const unsigned long IDENTITY_REFRESH_DELAY_MS = 60000; // Cached data is re-read once, this long after discovery
+    
+    struct Probe {
+        uint8_t address;
+        bool online;
+        
+        // Latest data (0x06)
+        Centi temperature;
+        uint16_t fuelValue;
+        uint16_t frequency;
+        bool dataValid;
+        uint8_t rawFrame[16];      // Last data frame as received, see FuelSensor::formatHex
+        int rawFrameLength;
+        LevelFilter level;         // fuelValue smoothed (median + Kalman) and slosh flag
+        LevelEventDetector events; // Refuel/drain steps in the median level, fed while not sloshing
+        ConsumptionEstimator consumption; // Units/hour from the median level, restarted after each reported event
+        
+        // Limits (0x07)
+        uint16_t levelMax;
+        uint16_t levelMin;
+        bool limitsValid;
+        
+        // Identity (0x1C, 0x02)
+        uint8_t firmwareVersion[32];
+        int firmwareVersionLength;
+        uint8_t serialNumberData[8];
+        int serialNumberLength;
+        uint32_t serialNumber;
+        
+        uint8_t pendingReads;      // Static data still to read (READ_* bits)
+        bool fromCache;            // Limits/firmware restored from the identity cache, refresh not yet queued
+        unsigned long foundTime;   // millis() when the probe was discovered
+        
+        unsigned long lastSeen;    // millis() of the last good reply
+        CircuitBreaker link;       // Closed = online; failures, backoff and per-state counters
+        uint32_t pollCount;
+    };
+    
+    FuelBusManager(FuelSensor& sensor);
+    
+    // Optional: restore limits/firmware of known probes from NVS instead of asking them
+    void setIdentityCache(ProbeIdentityCache* cache);
+    
+    // Discovery: a broadcast read first (answers at once when a single probe is fitted),
+    // then every address in [first, last] not already known, with a short per-address
+    // deadline. Scan requests fill the gaps between round-robin polls.
+    void startScan(uint8_t first = FIRST_ADDRESS, uint8_t last = LAST_ADDRESS);
+    void stopScan();
+    bool isScanning() const;
+    uint8_t getScanAddress() const;             // Next address to be scanned
+    
+    void poll();
+    
+    // Breaker state and counters of every probe, plus the cycle budget, as text
+    void printLinkHealth(Print& out) const;
+    uint32_t getBudgetDeferrals() const;        // Retries/trials pushed to the next cycle by the budget
+    
+    // Time between two data requests on the bus, shared by all probes (base interval of the schedule)
+    void setRequestInterval(unsigned long intervalMs);
+    unsigned long getRequestInterval() const;
+    SampleScheduler& getDataSchedule();         // Mode, achieved rate and duty cycle of the data polls
+    
+    // Level filter settings for every probe (see LevelFilter), applied at once and to probes found later
+    void setLevelFilter(uint8_t medianWindow, uint32_t processNoise, uint32_t measurementNoise, uint32_t sloshVariance);
+    
+    int getProbeCount() const;
+    int getOnlineCount() const;
+    const Probe* getProbe(int index) const;     // nullptr when out of range
+    bool takeLevelEvent(int index, LevelEventDetector::Event& event);   // Next refuel/drain of a probe
+    int findProbe(uint8_t address) const;       // -1 when unknown
+    
+    bool requestLimits(int index);
+    bool requestIdentity(int index);            // Serial number + firmware version
+    void invalidateLimits();                    // After Set Full/Empty/Reset: drop cached limits of all probes and read them again
+
+private:
+    enum StaticRead {
+        READ_SERIAL = 0x01,
+        READ_LIMITS = 0x02,
+        READ_FIRMWARE = 0x04
+    };
+    
+    FuelSensor& sensor;
+    ProbeIdentityCache* identityCache;
+    Probe probes[MAX_PROBES];
+    int probeCount;
+    int pollIndex;
+    SampleScheduler dataSchedule;
+    
+    // Level filter settings
+    uint8_t filterWindow;
+    uint32_t filterProcessNoise;
+    uint32_t filterMeasurementNoise;
+    uint32_t filterSloshVariance;
+    
+    // Link health
+    unsigned long cycleFailureTime;    // Bus time spent on failed requests in this round-robin cycle
+    uint32_t budgetDeferrals;
+    uint8_t pollRetries;               // Retries of the data poll in flight
+    uint32_t pollNoiseMark;            // Parser error counters before that poll
+    
+    // Scan state
+    bool scanning;
+    bool scanBroadcastPending;
+    bool scanRetried;              // Current address already got a full-length retry
+    bool scanInFlight;
+    int scanAddress;
+    int scanLast;
+    uint32_t scanNoiseMark;        // Parser error counters before the scan request
+    
+    int addProbe(uint8_t address);
+    void scanNext();
+    void finishScan();
+    bool pollNext(unsigned long now);
+    bool submitPoll(Probe& probe);
+    bool budgetLeft() const;
+    bool readNextStatic(unsigned long now);
+    void queueMissingReads(Probe& probe);
+    void configureFilter(Probe& probe);
+    bool restoreFromCache(Probe& probe);
+    void saveToCache(const Probe& probe);
+    uint32_t parserNoise() const;
+    void storeReply(Probe& probe, const FuelSensor::TransactionResult& result);
+    void handleScanReply(const FuelSensor::TransactionResult& result);
+    void handleProbeReply(const FuelSensor::TransactionResult& result);
+    
+    static void onScanReply(FuelSensor& sensor, const FuelSensor::TransactionResult& result, void* context);
+    static void onProbeReply(FuelSensor& sensor, const FuelSensor::TransactionResult& result, void* context);
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef AOOOGFRAME_H
+#define AOOOGFRAME_H
+
+#include <Arduino.h>
+#include <array>
+#include <CRC8.h>
+
+// CRC-8/MAXIM (reflected polynomial 0x8C, init 0x00), 256-entry table generated at compile time
+typedef CRC8<0x31, 0x00, true, CRC8_TABLE> AoooGCrc8;
+
+// Request frame 31 [address] [event] [CRC] for an address only known at runtime
+constexpr std::array<uint8_t, 4> AoooGRequest(uint8_t address, uint8_t eventCode) {
+    return {0x31, address, eventCode, AoooGCrc8::update(AoooGCrc8::update(AoooGCrc8::update(0x00, 0x31), address), eventCode)};
+}
+
+// Request frame with the checksum baked in at compile time, e.g. AoooGFrame<0xFF, 0x46>::bytes
+template <uint8_t Address, uint8_t Event>
+struct AoooGFrame {
+    static constexpr std::array<uint8_t, 4> bytes = AoooGRequest(Address, Event);
+};
+
+// Byte-wise compare usable in static_assert (std::array::operator== is not constexpr before C++20)
+constexpr bool AoooGFrameEquals(const std::array<uint8_t, 4>& frame,
+                                uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3) {
+    return frame[0] == b0 && frame[1] == b1 && frame[2] == b2 && frame[3] == b3;
+}
+
+// Frames as documented in FuelSensor.h and the README command table
+static_assert(AoooGFrameEquals(AoooGFrame<0xFF, 0x06>::bytes, 0x31, 0xFF, 0x06, 0x29), "Read data 31 FF 06 29");
+static_assert(AoooGFrameEquals(AoooGFrame<0xFF, 0x1C>::bytes, 0x31, 0xFF, 0x1C, 0xCA), "Read firmware 31 FF 1C CA");
+static_assert(AoooGFrameEquals(AoooGFrame<0xFF, 0x46>::bytes, 0x31, 0xFF, 0x46, 0x6F), "Set full 31 FF 46 6F");
+static_assert(AoooGFrameEquals(AoooGFrame<0xFF, 0x45>::bytes, 0x31, 0xFF, 0x45, 0x8D), "Set empty 31 FF 45 8D");
+static_assert(AoooGFrameEquals(AoooGFrame<0xFF, 0xE3>::bytes, 0x31, 0xFF, 0xE3, 0xFF), "Extended 31 FF E3 FF");
+static_assert(AoooGFrameEquals(AoooGFrame<0xFF, 0x4D>::bytes, 0x31, 0xFF, 0x4D, 0x4F), "Restart 31 FF 4D 4F");
+
+// Reply examples from the driver comments: CRC over a whole valid frame is zero
+static_assert(AoooGCrc8::compute(std::array<uint8_t, 8>{0x3E, 0x01, 0x02, 0x3C, 0x83, 0x0C, 0x00, 0x4E}) == 0,
+              "Serial number 3E 01 02 3C 83 0C 00 4E");
+static_assert(AoooGCrc8::compute(std::array<uint8_t, 6>{0x3E, 0x01, 0x51, 0x26, 0x4A, 0x2A}) == 0,
+              "Empty frequency 3E 01 51 26 4A 2A");
+static_assert(AoooGCrc8::compute(std::array<uint8_t, 5>{0x3E, 0x01, 0x18, 0x00, 0x6C}) == 0,
+              "Factory reset 3E 01 18 00 6C");
+
+#endif
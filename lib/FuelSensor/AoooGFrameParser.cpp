@@ -0,0 +1,200 @@
+#include "AoooGFrameParser.h"
+#include "AoooGFrame.h"
+
+AoooGFrameParser::AoooGFrameParser() {
+    frameCount = 0;
+    crcErrors = 0;
+    discardedBytes = 0;
+    reset();
+}
+
+void AoooGFrameParser::reset() {
+    length = 0;
+    expected = -1;
+    crc = 0;
+    frameReady = false;
+    backlogStart = 0;
+    backlogLength = 0;
+    current.data = buffer;
+    current.length = 0;
+    current.type = FRAME_UNKNOWN;
+    current.crcValid = false;
+}
+
+int AoooGFrameParser::frameLength(uint8_t eventCode) {
+    switch (eventCode) {
+        case 0x06: return 9; // 3E AA 06 TT F0 F1 Q0 Q1 CRC
+        case 0x07: return 8; // 3E AA 07 MX MX MN MN CRC
+        case 0x02: return 8; // 3E AA 02 S0 S1 S2 S3 CRC
+        case 0x51: return 6; // 3E AA 51 F0 F1 CRC
+        case 0x18:
+        case 0x45:
+        case 0x46: return 5; // 3E AA EV ST CRC
+        case 0x1C:
+        case 0xE3: return 0; // Variable, ends on line idle
+        default:   return -1;
+    }
+}
+
+AoooGFrameParser::FrameType AoooGFrameParser::frameType(uint8_t eventCode) {
+    switch (eventCode) {
+        case 0x06: return FRAME_DATA;
+        case 0x07: return FRAME_LIMITS;
+        case 0x02: return FRAME_SERIAL;
+        case 0x51: return FRAME_EMPTY_FREQ;
+        case 0x18:
+        case 0x45:
+        case 0x46: return FRAME_STATUS;
+        case 0x1C: return FRAME_FIRMWARE;
+        case 0xE3: return FRAME_EXTENDED;
+        default:   return FRAME_UNKNOWN;
+    }
+}
+
+uint8_t AoooGFrameParser::crcUpdate(uint8_t crc, uint8_t byte) {
+    // CRC-8/MAXIM, one table lookup per byte
+    return AoooGCrc8::update(crc, byte);
+}
+
+bool AoooGFrameParser::feed(uint8_t byte) {
+    if (backlogLength == 0) {
+        return step(byte);
+    }
+    
+    // Earlier bytes are still waiting to be rescanned, keep the order
+    if (backlogStart + backlogLength >= (int)sizeof(backlog)) {
+        memmove(backlog, backlog + backlogStart, backlogLength);
+        backlogStart = 0;
+    }
+    if (backlogLength < (int)sizeof(backlog)) {
+        backlog[backlogStart + backlogLength] = byte;
+        backlogLength++;
+    } else {
+        discardedBytes++;
+    }
+    return drainBacklog();
+}
+
+bool AoooGFrameParser::drainBacklog() {
+    while (backlogLength > 0) {
+        uint8_t byte = backlog[backlogStart];
+        backlogStart++;
+        backlogLength--;
+        if (backlogLength == 0) {
+            backlogStart = 0;
+        }
+        if (step(byte)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AoooGFrameParser::step(uint8_t byte) {
+    if (frameReady) {
+        // Previous frame was handed out, start a new one
+        frameReady = false;
+        length = 0;
+    }
+    
+    if (length == 0) {
+        if (byte != HEADER) {
+            discardedBytes++;
+            return false;
+        }
+        crc = 0;
+        expected = -1;
+    }
+    
+    buffer[length++] = byte;
+    crc = crcUpdate(crc, byte);
+    
+    if (length == 3) {
+        expected = frameLength(byte);
+        if (expected < 0) {
+            // Not a reply we know, the header byte was data
+            resync();
+            return drainBacklog();
+        }
+    }
+    
+    if (expected > 0 && length == expected) {
+        // CRC over frame including its CRC byte is zero for CRC-8/MAXIM
+        if (crc == 0) {
+            return emit(true);
+        }
+        crcErrors++;
+        resync();
+        return drainBacklog();
+    }
+    
+    if (expected == 0 && length == MAX_FRAME_LENGTH) {
+        return emit(crc == 0);
+    }
+    
+    return false;
+}
+
+void AoooGFrameParser::resync() {
+    // Drop the header byte and rescan the rest from the next candidate header
+    discardedBytes++;
+    int rest = length - 1;
+    if (rest > 0) {
+        if (backlogLength + rest > (int)sizeof(backlog)) {
+            // The frame bytes go back in front; the newest pending bytes lose, as in feed()
+            discardedBytes += backlogLength + rest - sizeof(backlog);
+            backlogLength = sizeof(backlog) - rest;
+        }
+        if (backlogLength > 0) {
+            memmove(backlog + rest, backlog + backlogStart, backlogLength);
+        }
+        memcpy(backlog, buffer + 1, rest);
+        backlogStart = 0;
+        backlogLength += rest;
+    }
+    length = 0;
+    expected = -1;
+    crc = 0;
+}
+
+bool AoooGFrameParser::emit(bool crcValid) {
+    current.data = buffer;
+    current.length = length;
+    current.type = frameType(buffer[2]);
+    current.crcValid = crcValid;
+    frameReady = true;
+    expected = -1;
+    frameCount++;
+    return true;
+}
+
+bool AoooGFrameParser::finish() {
+    if (!frameReady && expected == 0 && length >= MIN_FRAME_LENGTH) {
+        return emit(crc == 0);
+    }
+    return false;
+}
+
+const AoooGFrameParser::Frame& AoooGFrameParser::frame() const {
+    return current;
+}
+
+int AoooGFrameParser::pendingLength() const {
+    return frameReady ? 0 : length;
+}
+
+bool AoooGFrameParser::isVariableLengthPending() const {
+    return !frameReady && expected == 0;
+}
+
+uint32_t AoooGFrameParser::getFrameCount() const {
+    return frameCount;
+}
+
+uint32_t AoooGFrameParser::getCrcErrors() const {
+    return crcErrors;
+}
+
+uint32_t AoooGFrameParser::getDiscardedBytes() const {
+    return discardedBytes;
+}
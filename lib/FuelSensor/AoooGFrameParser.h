@@ -0,0 +1,93 @@
+#ifndef AOOOGFRAMEPARSER_H
+#define AOOOGFRAMEPARSER_H
+
+#include <Arduino.h>
+
+// Byte-fed parser for AoooG replies: 3E [address] [event] [payload...] [CRC-8/MAXIM].
+// Hunts for the 0x3E header, learns the frame length from the event code, runs
+// the CRC as bytes arrive and rescans from the next header after a bad frame.
+// Completed frames point into the parser buffer (no copy) and stay valid until
+// the next call to feed(), finish() or reset().
+class AoooGFrameParser {
+public:
+    static const uint8_t HEADER = 0x3E;
+    static const int MAX_FRAME_LENGTH = 32;
+    static const int MIN_FRAME_LENGTH = 4;   // Header, address, event, CRC
+    
+    enum FrameType {
+        FRAME_UNKNOWN = 0,
+        FRAME_DATA,          // 0x06: temperature, fuel value, frequency
+        FRAME_LIMITS,        // 0x07: level max/min
+        FRAME_SERIAL,        // 0x02: serial number
+        FRAME_EMPTY_FREQ,    // 0x51: empty frequency
+        FRAME_STATUS,        // 0x18/0x45/0x46: single status byte
+        FRAME_FIRMWARE,      // 0x1C: variable length, ends on line idle
+        FRAME_EXTENDED       // 0xE3: variable length, ends on line idle
+    };
+    
+    struct Frame {
+        const uint8_t* data;    // Whole frame including header and CRC
+        uint8_t length;
+        FrameType type;
+        bool crcValid;          // Always true for fixed-length frames
+        
+        uint8_t address() const { return data[1]; }
+        uint8_t eventCode() const { return data[2]; }
+        const uint8_t* payload() const { return data + 3; }
+        uint8_t payloadLength() const { return length - MIN_FRAME_LENGTH; }
+        
+        // Payload field helpers (offset is relative to the payload)
+        uint16_t u16le(int offset) const {
+            return (uint16_t)data[3 + offset] | ((uint16_t)data[4 + offset] << 8);
+        }
+        uint16_t u16be(int offset) const {
+            return ((uint16_t)data[3 + offset] << 8) | (uint16_t)data[4 + offset];
+        }
+        uint32_t u32le(int offset) const {
+            return (uint32_t)u16le(offset) | ((uint32_t)u16le(offset + 2) << 16);
+        }
+    };
+    
+    AoooGFrameParser();
+    
+    bool feed(uint8_t byte);        // Returns true when frame() holds a new complete frame
+    bool finish();                  // Close a variable-length frame once the line went idle
+    void reset();                   // Drop any partial frame and pending bytes
+    
+    const Frame& frame() const;
+    int pendingLength() const;      // Bytes collected for an incomplete frame
+    bool isVariableLengthPending() const;
+    
+    static int frameLength(uint8_t eventCode);     // >0 fixed, 0 variable, -1 unknown event
+    static FrameType frameType(uint8_t eventCode);
+    
+    // Statistics
+    uint32_t getFrameCount() const;
+    uint32_t getCrcErrors() const;
+    uint32_t getDiscardedBytes() const;
+
+private:
+    uint8_t buffer[MAX_FRAME_LENGTH];
+    uint8_t length;                 // Bytes in buffer for the current frame
+    int8_t expected;                // Expected frame length, 0 = variable, -1 = not known yet
+    uint8_t crc;                    // Running CRC over buffer[0..length)
+    bool frameReady;                // buffer holds an emitted frame
+    Frame current;
+    
+    // Bytes waiting to be rescanned after a resync
+    uint8_t backlog[MAX_FRAME_LENGTH * 2];
+    uint8_t backlogStart;
+    uint8_t backlogLength;
+    
+    uint32_t frameCount;
+    uint32_t crcErrors;
+    uint32_t discardedBytes;
+    
+    bool step(uint8_t byte);
+    bool drainBacklog();
+    void resync();
+    bool emit(bool crcValid);
+    static uint8_t crcUpdate(uint8_t crc, uint8_t byte);
+};
+
+#endif
@@ -1,9 +1,17 @@
 #include "FuelSensor.h"
+#include "AoooGFrame.h"
+#include "UartCapture.h"
+#include "UartRxBuffer.h"
 
 FuelSensor::FuelSensor(uint8_t address) {
     sensorAddress = address;
-    serial = &Serial1;
-    temperature = 0.0;
+    uart = &Serial1;
+    serial = uart;
+    capture = nullptr;
+    verbose = false;
+    serialNumberLength = 0;
+    serialNumber = 0;
+    temperature = Centi::fromRaw(0);
     fuelValue = 0;
     frequency = 0;
     levelMax = 0;
@@ -13,7 +21,6 @@ FuelSensor::FuelSensor(uint8_t address) {
     firmwareVersionLength = 0;
     extendedResponseLength = 0;
     lastRawResponseLength = 0;
-    lastRawDataString = "";
     memset(lastRawResponse, 0, sizeof(lastRawResponse));
     memset(extendedResponse, 0, sizeof(extendedResponse));
     memset(firmwareVersion, 0, sizeof(firmwareVersion));
@@ -27,170 +34,457 @@ FuelSensor::FuelSensor(uint8_t address) {
     // Initialize empty frequency variables
     emptyFrequency = 0;
     emptyFrequencyValid = false;
-}
-
-bool FuelSensor::begin(int txPin, int rxPin, unsigned long baudrate) {
+    
+    // Initialize transaction engine
+    pendingHead = 0;
+    pendingCount = 0;
+    engineState = ENGINE_IDLE;
+    activeStartTime = 0;
+    lastByteMicros = 0;
+    replyStarted = false;
+    setFrameGap(9600);
+    quietUntil = 0;
+    transactionTimeout = TRANSACTION_TIMEOUT_MS;
+    responseData = nullptr;
+    responseLength = 0;
+    nextHandle = 0;
+    historyIndex = 0;
+    consecutiveMisses = 0;
+    replySeen = false;
+    lastReplyTime = 0;
+    lastTrafficTime = 0;
+    memset(&activeTransaction, 0, sizeof(activeTransaction));
+    for (int i = 0; i < TRANSACTION_HISTORY; i++) {
+        historyHandles[i] = INVALID_TRANSACTION;
+        historyStatus[i] = TRANSACTION_UNKNOWN;
+    }
+}
+
+bool FuelSensor::begin(int txPin, int rxPin, unsigned long baudrate, UartRxBuffer* rxBuffer) {
+    if (uart == nullptr) {
+        uart = &Serial1;
+    }
+    serial = uart;
+    
     // Khởi tạo UART1 với pins được chỉ định
-    serial->begin(baudrate, SERIAL_8N1, rxPin, txPin);
+    uart->begin(baudrate, SERIAL_8N1, rxPin, txPin);
+    // Short RX timeout so a reply reaches available() as soon as the line goes quiet,
+    // not when the RX FIFO threshold is reached
+    uart->setRxTimeout(UART_RX_TIMEOUT_SYMBOLS);
+    setFrameGap(baudrate);
+    if (rxBuffer != nullptr) {
+        // Bytes are pushed from the UART event task; the engine only looks at the ring
+        rxBuffer->begin(*uart);
+        serial = rxBuffer;
+    }
     
     // Đợi UART stable
     delay(100);
     
     Serial.println("FuelSensor initialized");
-    Serial.printf("UART1: TX=%d, RX=%d, Baud=%lu\n", txPin, rxPin, baudrate);
+    Serial.printf("UART1: TX=%d, RX=%d, Baud=%lu%s\n", txPin, rxPin, baudrate,
+                  rxBuffer != nullptr ? ", RX ring" : "");
     Serial.printf("Sensor Address: 0x%02X\n", sensorAddress);
     
     return true;
 }
 
-bool FuelSensor::readSensorDataBroadcast() {
-    // Temporarily save current sensor address
-    uint8_t originalAddress = sensorAddress;
+bool FuelSensor::begin(Stream& stream, unsigned long baudrate) {
+    // Attach an externally configured stream instead of UART1
+    uart = nullptr;
+    serial = &stream;
+    setFrameGap(baudrate);
     
-    // Set to broadcast address
-    sensorAddress = BROADCAST_ADDRESS; // 0xFF
+    Serial.println("FuelSensor initialized on external stream");
+    Serial.printf("Sensor Address: 0x%02X\n", sensorAddress);
     
-    Serial.println("=== BROADCAST REQUEST ===");
-    Serial.println("Sending broadcast request (31 FF 06 29) to all fuel sensors...");
+    return true;
+}
+
+void FuelSensor::setFrameGap(unsigned long baudrate) {
+    // 10 bits per character (8N1), 3.5 characters of silence end a frame
+    unsigned long gap = baudrate > 0 ? 35000000UL / baudrate : 0;
+    frameGapMicros = gap > FRAME_GAP_MIN_MICROS ? gap : FRAME_GAP_MIN_MICROS;
+}
+
+unsigned long FuelSensor::getFrameGap() const {
+    return frameGapMicros;
+}
+
+void FuelSensor::setCapture(UartCapture* trace) {
+    capture = trace;
+}
+
+void FuelSensor::setVerbose(bool enabled) {
+    verbose = enabled;
+}
+
+bool FuelSensor::isVerbose() const {
+    return verbose;
+}
+
+int FuelSensor::readByte() {
+    int value = serial->read();
+    if (capture != nullptr && value >= 0) {
+        capture->record(UartCapture::CAPTURE_RX, (uint8_t)value);
+    }
+    return value;
+}
+
+void FuelSensor::discardInput() {
+    uint8_t scratch[16];
+    int count;
+    while ((count = serial->available()) > 0) {
+        size_t length = serial->readBytes(scratch, count < (int)sizeof(scratch) ? count : sizeof(scratch));
+        if (length == 0) {
+            break;
+        }
+        if (capture != nullptr) {
+            capture->record(UartCapture::CAPTURE_RX, scratch, length);
+        }
+    }
+}
+
+bool FuelSensor::sendRequest(uint8_t address, uint8_t eventCode) {
+    // 31 [address] [event] [CRC-8/MAXIM], checksum from the compile-time table
+    const std::array<uint8_t, 4> request = AoooGRequest(address, eventCode);
     
-    if (!sendRequest(EVENT_READ_DATA)) {
-        Serial.println("Failed to send broadcast request to fuel sensors");
-        sensorAddress = originalAddress; // Restore original address
-        dataValid = false;
-        return false;
+    if (verbose) {
+        Serial.print("Sending request: ");
+        for (int i = 0; i < 4; i++) {
+            Serial.printf("%02X ", request[i]);
+        }
+        Serial.println();
     }
     
-    // Đợi response từ bất kỳ sensor nào
-    delay(100); // Increased delay for broadcast response
+    // Clear any existing data in buffer (late replies from a timed out request)
+    discardInput();
     
-    if (serial->available() > 0) {
-        uint8_t response[16];
-        int bytesRead = 0;
-        
-        // Đọc response với timeout
-        unsigned long startTime = millis();
-        while (bytesRead < sizeof(response) && (millis() - startTime) < 1000) { // Increased timeout
-            if (serial->available()) {
-                response[bytesRead] = serial->read();
-                bytesRead++;
-                
-                // Kiểm tra nếu đã đọc đủ một gói tin hoàn chỉnh
-                if (bytesRead >= 9) break; // Minimum response length
+    // Send request - no flush(), the UART driver drains the TX FIFO in the background
+    if (capture != nullptr) {
+        capture->record(UartCapture::CAPTURE_TX, request.data(), request.size());
+    }
+    return serial->write(request.data(), request.size()) == request.size();
+}
+
+// ---------------------------------------------------------------------------
+// Asynchronous transaction engine
+// ---------------------------------------------------------------------------
+
+int FuelSensor::expectedResponseLength(uint8_t eventCode) {
+    if (eventCode == EVENT_RESTART_SENSOR) {
+        return -1; // No reply, sensor reboots
+    }
+    // Frame lengths per event code live in the parser; unknown events end on line idle
+    int length = AoooGFrameParser::frameLength(eventCode);
+    return length < 0 ? 0 : length;
+}
+
+FuelSensor::TransactionHandle FuelSensor::submitRequest(uint8_t address, uint8_t eventCode,
+                                                        TransactionCallback callback, void* context,
+                                                        unsigned long timeoutMs) {
+    if (pendingCount >= MAX_PENDING_TRANSACTIONS) {
+        Serial.printf("Transaction queue full, dropping event 0x%02X\n", eventCode);
+        return INVALID_TRANSACTION;
+    }
+    
+    PendingTransaction& txn = pendingQueue[(pendingHead + pendingCount) % MAX_PENDING_TRANSACTIONS];
+    txn.handle = nextHandle;
+    txn.address = address;
+    txn.eventCode = eventCode;
+    txn.callback = callback;
+    txn.context = context;
+    txn.timeoutMs = timeoutMs;
+    pendingCount++;
+    
+    // Overwrites the oldest entry, which has completed: at most TRANSACTION_HISTORY - 8 are live
+    historyHandles[historyIndex] = txn.handle;
+    historyStatus[historyIndex] = TRANSACTION_PENDING;
+    historyIndex = (historyIndex + 1) % TRANSACTION_HISTORY;
+    
+    nextHandle = (nextHandle == INT16_MAX) ? 0 : nextHandle + 1;
+    return txn.handle;
+}
+
+void FuelSensor::poll() {
+    unsigned long now = millis();
+    
+    switch (engineState) {
+        case ENGINE_QUIET:
+            if ((long)(now - quietUntil) < 0) {
+                return;
             }
-            delay(1);
+            engineState = ENGINE_IDLE;
+            // fall through
+            
+        case ENGINE_IDLE:
+            if (pendingCount > 0) {
+                startNextTransaction(now);
+            } else {
+                // Nobody is waiting: discard unsolicited bytes and late replies
+                discardInput();
+            }
+            return;
+            
+        case ENGINE_WAIT_RESPONSE:
+            break;
+    }
+    
+    // Feed bytes as they arrive; the parser resynchronizes on leftovers and bad CRCs
+    while (serial->available()) {
+        lastByteMicros = micros();
+        replyStarted = true;
+        if (!frameParser.feed((uint8_t)readByte())) {
+            continue;
         }
         
-        if (bytesRead >= 9) {
-            Serial.print("Broadcast response received: ");
-            for (int i = 0; i < bytesRead; i++) {
-                Serial.printf("%02X ", response[i]);
+        const AoooGFrameParser::Frame& frame = frameParser.frame();
+        bool addressMatch = activeTransaction.address == BROADCAST_ADDRESS ||
+                            frame.address() == activeTransaction.address;
+        if (frame.eventCode() == activeTransaction.eventCode && addressMatch) {
+            finishResponse(frame);
+            return;
+        }
+        if (verbose) {
+            Serial.printf("Ignoring frame for event 0x%02X from 0x%02X\n", frame.eventCode(), frame.address());
+        }
+        // A clean frame for someone else is not the start of ours
+        replyStarted = false;
+    }
+    
+    // Line idle for 3.5 character times: the reply is over. Variable-length replies end here,
+    // a fixed-length one that is still short lost bytes and will not complete anymore, and
+    // bytes the parser threw away (bad CRC, no header) were a garbled reply.
+    int pending = frameParser.pendingLength();
+    if (replyStarted && micros() - lastByteMicros >= frameGapMicros) {
+        if (frameParser.isVariableLengthPending() && frameParser.finish()) {
+            finishResponse(frameParser.frame());
+            return;
+        }
+        if (pending > 0) {
+            if (verbose) {
+                Serial.printf("Partial response for event 0x%02X: %d of %d bytes\n",
+                              activeTransaction.eventCode, pending,
+                              expectedResponseLength(activeTransaction.eventCode));
             }
-            Serial.println();
-            
-            // Parse response (any sensor can respond)
-            bool result = parseBroadcastResponse(response, bytesRead);
-            sensorAddress = originalAddress; // Restore original address
-            return result;
+            completeTransaction(TRANSACTION_TIMEOUT);
         } else {
-            Serial.printf("Insufficient broadcast response data: %d bytes\n", bytesRead);
-            sensorAddress = originalAddress; // Restore original address
-            dataValid = false;
-            return false;
+            if (verbose) {
+                Serial.printf("Garbled response for event 0x%02X\n", activeTransaction.eventCode);
+            }
+            completeTransaction(TRANSACTION_INVALID);
         }
-    } else {
-        Serial.println("No response from any fuel sensor (broadcast)");
-        sensorAddress = originalAddress; // Restore original address
-        dataValid = false;
-        return false;
+        return;
+    }
+    
+    unsigned long timeout = activeTransaction.timeoutMs ? activeTransaction.timeoutMs : transactionTimeout;
+    if (now - activeStartTime >= timeout) {
+        if (verbose && pending > 0) {
+            Serial.printf("Partial response for event 0x%02X: %d of %d bytes\n",
+                          activeTransaction.eventCode, pending,
+                          expectedResponseLength(activeTransaction.eventCode));
+        } else if (verbose) {
+            Serial.printf("No response for event 0x%02X from 0x%02X\n",
+                          activeTransaction.eventCode, activeTransaction.address);
+        }
+        completeTransaction(TRANSACTION_TIMEOUT);
     }
 }
 
-bool FuelSensor::readSensorData() {
-    if (!sendRequest(EVENT_READ_DATA)) {
-        Serial.println("Failed to send request to fuel sensor");
-        dataValid = false;
-        return false;
+void FuelSensor::startNextTransaction(unsigned long now) {
+    activeTransaction = pendingQueue[pendingHead];
+    pendingHead = (pendingHead + 1) % MAX_PENDING_TRANSACTIONS;
+    pendingCount--;
+    
+    frameParser.reset();
+    responseData = nullptr;
+    responseLength = 0;
+    activeStartTime = now;
+    lastByteMicros = micros();
+    replyStarted = false;
+    
+    if (!sendRequest(activeTransaction.address, activeTransaction.eventCode)) {
+        engineState = ENGINE_WAIT_RESPONSE;
+        completeTransaction(TRANSACTION_INVALID);
+        return;
     }
     
-    // Đợi response
-    delay(50);
+    engineState = ENGINE_WAIT_RESPONSE;
+    if (expectedResponseLength(activeTransaction.eventCode) < 0) {
+        // Fire-and-forget command: hold the bus while the sensor restarts
+        quietUntil = now + RESTART_SETTLE_MS;
+        completeTransaction(TRANSACTION_OK);
+    }
+}
+
+void FuelSensor::finishResponse(const AoooGFrameParser::Frame& frame) {
+    responseData = frame.data;
+    responseLength = frame.length;
     
-    if (serial->available() > 0) {
-        uint8_t response[16];
-        int bytesRead = 0;
-        
-        // Đọc response với timeout
-        unsigned long startTime = millis();
-        while (bytesRead < sizeof(response) && (millis() - startTime) < 1000) {
-            if (serial->available()) {
-                response[bytesRead] = serial->read();
-                bytesRead++;
-                
-                // Kiểm tra nếu đã đọc đủ một gói tin hoàn chỉnh
-                if (bytesRead >= 9) break; // Minimum response length
-            }
-            delay(1);
+    // Fixed-length frames only come out of the parser with a good CRC; a variable-length one
+    // (firmware, E3) is closed by line idle and carries its CRC result instead
+    if (!frame.crcValid) {
+        if (verbose) {
+            Serial.printf("Bad CRC in reply to event 0x%02X\n", activeTransaction.eventCode);
         }
-        
-        if (bytesRead >= 9) {
-            Serial.print("Received response: ");
-            for (int i = 0; i < bytesRead; i++) {
-                Serial.printf("%02X ", response[i]);
-            }
-            Serial.println();
-            
-            return parseResponse(response, bytesRead);
-        } else {
-            Serial.printf("Insufficient response data: %d bytes\n", bytesRead);
-            dataValid = false;
-            return false;
+        completeTransaction(TRANSACTION_INVALID);
+        return;
+    }
+    
+    if (verbose) {
+        Serial.print("Received response: ");
+        for (int i = 0; i < frame.length; i++) {
+            Serial.printf("%02X ", frame.data[i]);
         }
-    } else {
-        Serial.println("No response from fuel sensor");
-        dataValid = false;
-        return false;
+        Serial.println();
+    }
+    
+    bool ok = dispatchResponse(activeTransaction, frame.data, frame.length);
+    completeTransaction(ok ? TRANSACTION_OK : TRANSACTION_INVALID);
+}
+
+bool FuelSensor::dispatchResponse(const PendingTransaction& txn, const uint8_t* response, int length) {
+    switch (txn.eventCode) {
+        case EVENT_READ_DATA:
+            if (txn.address == BROADCAST_ADDRESS) {
+                return parseBroadcastResponse(response, length);
+            }
+            return parseResponse(response, length);
+        case EVENT_READ_LIMITS:
+            return parseLimitsResponse(response, length);
+        case EVENT_READ_FIRMWARE:
+            return parseFirmwareResponse(response, length);
+        case EVENT_READ_SERIAL:
+            return parseSerialNumberResponse(response, length);
+        case EVENT_FACTORY_RESET:
+            return parseFactoryResetResponse(response, length);
+        case EVENT_SET_FULL_FREQ:
+        case EVENT_SET_EMPTY_FREQ:
+            return parseSetLevelResponse(response, length);
+        case EVENT_READ_EMPTY_FREQ:
+            return parseEmptyFrequencyResponse(response, length);
+        case EVENT_EXTENDED_E3:
+            return parseExtendedE3Response(response, length);
+        default:
+            return length > 0;
+    }
+}
+
+void FuelSensor::markFailed(uint8_t eventCode) {
+    // Same invalidation the blocking readers used to do on a failed exchange
+    switch (eventCode) {
+        case EVENT_READ_DATA:       dataValid = false; break;
+        case EVENT_READ_LIMITS:     limitsValid = false; break;
+        case EVENT_READ_EMPTY_FREQ: emptyFrequencyValid = false; break;
+        case EVENT_FACTORY_RESET:   lastSetSuccess = false; break;
+        case EVENT_SET_FULL_FREQ:
+        case EVENT_SET_EMPTY_FREQ:
+            // No reply at all: do not leave the previous command's bytes on display
+            if (responseLength == 0) {
+                lastSetResponseLength = 0;
+                lastSetCommand = eventCode == EVENT_SET_FULL_FREQ ? "SET FULL" : "SET EMPTY";
+            }
+            lastSetSuccess = false;
+            break;
+        default: break;
     }
 }
 
-bool FuelSensor::sendRequest(uint8_t eventCode) {
-    uint8_t request[4];
-    request[0] = HEADER_REQUEST;     // 0x31
-    request[1] = sensorAddress;      // Sensor address (0x01, 0x02... or 0xFF for broadcast)
-    request[2] = eventCode;          // Event code (0x06 for data, 0x07 for limits)
-    request[3] = calculateCRC8(request, 3); // CRC-8/MAXIM checksum
+void FuelSensor::completeTransaction(TransactionStatus status) {
+    unsigned long now = millis();
+    PendingTransaction txn = activeTransaction;
     
-    Serial.print("Sending request: ");
-    for (int i = 0; i < 4; i++) {
-        Serial.printf("%02X ", request[i]);
+    if (status != TRANSACTION_OK) {
+        markFailed(txn.eventCode);
     }
-    Serial.println();
     
-    // Clear any existing data in buffer
-    while (serial->available()) {
-        serial->read();
+    // Every exchange doubles as a liveness check: a rejected frame still proves someone answered.
+    // Commands without a reply and requests that never reached the wire say nothing either way.
+    if (expectedResponseLength(txn.eventCode) >= 0 && responseLength > 0) {
+        consecutiveMisses = 0;
+        replySeen = true;
+        lastReplyTime = now;
+    } else if (status == TRANSACTION_TIMEOUT && consecutiveMisses < 255) {
+        consecutiveMisses++;
+        if (consecutiveMisses == LINK_LOST_AFTER_MISSES) {
+            Serial.printf("Fuel link: %d requests in a row unanswered\n", consecutiveMisses);
+        }
     }
+    lastTrafficTime = now;
     
-    // Send request
-    serial->write(request, 4);
-    serial->flush();
+    for (int i = 0; i < TRANSACTION_HISTORY; i++) {
+        if (historyHandles[i] == txn.handle) {
+            historyStatus[i] = status;
+            break;
+        }
+    }
     
-    return true;
+    engineState = ((long)(quietUntil - now) > 0) ? ENGINE_QUIET : ENGINE_IDLE;
+    
+    // Callback runs last so it may submit follow-up requests
+    if (txn.callback) {
+        TransactionResult result;
+        result.handle = txn.handle;
+        result.address = txn.address;
+        result.eventCode = txn.eventCode;
+        result.status = status;
+        result.response = responseData;
+        result.responseLength = responseLength;
+        result.elapsedMs = now - activeStartTime;
+        txn.callback(*this, result, txn.context);
+    }
+}
+
+bool FuelSensor::isBusy() const {
+    return engineState == ENGINE_WAIT_RESPONSE || pendingCount > 0;
+}
+
+int FuelSensor::getPendingCount() const {
+    return pendingCount;
+}
+
+FuelSensor::TransactionStatus FuelSensor::getTransactionStatus(TransactionHandle handle) const {
+    if (handle == INVALID_TRANSACTION) {
+        return TRANSACTION_UNKNOWN;
+    }
+    // Queued and active requests are in the history too, as TRANSACTION_PENDING
+    for (int i = 0; i < TRANSACTION_HISTORY; i++) {
+        if (historyHandles[i] == handle) {
+            return historyStatus[i];
+        }
+    }
+    return TRANSACTION_UNKNOWN;
+}
+
+void FuelSensor::setTransactionTimeout(unsigned long timeoutMs) {
+    transactionTimeout = timeoutMs;
+}
+
+const AoooGFrameParser& FuelSensor::getFrameParser() const {
+    return frameParser;
+}
+
+bool FuelSensor::isLinkUp() const {
+    return replySeen && consecutiveMisses < LINK_LOST_AFTER_MISSES;
+}
+
+uint8_t FuelSensor::getConsecutiveMisses() const {
+    return consecutiveMisses;
+}
+
+unsigned long FuelSensor::getLastReplyTime() const {
+    return lastReplyTime;
+}
+
+unsigned long FuelSensor::getIdleTime() const {
+    return millis() - lastTrafficTime;
 }
 
-bool FuelSensor::parseResponse(uint8_t* response, int length) {
-    // Store raw response data
+bool FuelSensor::parseResponse(const uint8_t* response, int length) {
+    // Store raw response data (hex text is only built when someone asks for it)
     lastRawResponseLength = min(length, (int)sizeof(lastRawResponse));
     memcpy(lastRawResponse, response, lastRawResponseLength);
     
-    // Create formatted hex string
-    lastRawDataString = "";
-    for (int i = 0; i < lastRawResponseLength; i++) {
-        if (i > 0) lastRawDataString += " ";
-        lastRawDataString += String(response[i], HEX);
-        if (response[i] < 16) lastRawDataString = lastRawDataString.substring(0, lastRawDataString.length()-1) + "0" + lastRawDataString.substring(lastRawDataString.length()-1);
-    }
-    lastRawDataString.toUpperCase();
-    
     if (length < 9) {
         Serial.println("Response too short");
         return false;
@@ -202,9 +496,10 @@ bool FuelSensor::parseResponse(uint8_t* response, int length) {
         return false;
     }
     
-    // Kiểm tra address - chỉ kiểm tra nếu không phải broadcast
-    if (sensorAddress != BROADCAST_ADDRESS && response[1] != sensorAddress) {
-        Serial.printf("Address mismatch: 0x%02X (expected 0x%02X)\n", response[1], sensorAddress);
+    // Kiểm tra address theo địa chỉ của request - chỉ kiểm tra nếu không phải broadcast
+    uint8_t requestAddress = activeTransaction.address;
+    if (requestAddress != BROADCAST_ADDRESS && response[1] != requestAddress) {
+        Serial.printf("Address mismatch: 0x%02X (expected 0x%02X)\n", response[1], requestAddress);
         return false;
     }
     
@@ -214,15 +509,10 @@ bool FuelSensor::parseResponse(uint8_t* response, int length) {
         return false;
     }
     
-    // Tính toán và kiểm tra CRC-8/MAXIM
-    uint8_t calculatedCRC = calculateCRC8(response, length - 1);
-    if (response[length - 1] != calculatedCRC) {
-        Serial.printf("CRC mismatch: 0x%02X (calculated 0x%02X)\n", response[length - 1], calculatedCRC);
-        // Vẫn tiếp tục parse data, chỉ warning
-    }
+    // CRC-8/MAXIM đã được kiểm tra bởi AoooGFrameParser - frame lỗi CRC không tới đây
     
     // Parse temperature (byte 3)
-    temperature = (float)response[3];
+    temperature = Centi::fromUnits(response[3]);
     
     // Parse fuel value (bytes 4-5, little endian)
     fuelValue = (uint16_t)response[4] | ((uint16_t)response[5] << 8);
@@ -234,27 +524,20 @@ bool FuelSensor::parseResponse(uint8_t* response, int length) {
         frequency = 0;
     }
     
-    Serial.printf("Parsed - Sensor: 0x%02X, Temperature: %.1f°C, Fuel Value: %d, Frequency: %d Hz\n", 
-                  response[1], temperature, fuelValue, frequency);
+    if (verbose) {
+        Serial.printf("Parsed - Sensor: 0x%02X, Temperature: %d°C, Fuel Value: %d, Frequency: %d Hz\n", 
+                      response[1], response[3], fuelValue, frequency);
+    }
     
     dataValid = true;
     return true;
 }
 
-bool FuelSensor::parseBroadcastResponse(uint8_t* response, int length) {
-    // Store raw response data
+bool FuelSensor::parseBroadcastResponse(const uint8_t* response, int length) {
+    // Store raw response data (hex text is only built when someone asks for it)
     lastRawResponseLength = min(length, (int)sizeof(lastRawResponse));
     memcpy(lastRawResponse, response, lastRawResponseLength);
     
-    // Create formatted hex string
-    lastRawDataString = "";
-    for (int i = 0; i < lastRawResponseLength; i++) {
-        if (i > 0) lastRawDataString += " ";
-        lastRawDataString += String(response[i], HEX);
-        if (response[i] < 16) lastRawDataString = lastRawDataString.substring(0, lastRawDataString.length()-1) + "0" + lastRawDataString.substring(lastRawDataString.length()-1);
-    }
-    lastRawDataString.toUpperCase();
-    
     if (length < 9) {
         Serial.println("Broadcast response too short");
         return false;
@@ -268,7 +551,9 @@ bool FuelSensor::parseBroadcastResponse(uint8_t* response, int length) {
     
     // Không kiểm tra address trong broadcast - chấp nhận từ bất kỳ sensor nào
     uint8_t respondingSensorAddress = response[1];
-    Serial.printf("Response from sensor address: 0x%02X\n", respondingSensorAddress);
+    if (verbose) {
+        Serial.printf("Response from sensor address: 0x%02X\n", respondingSensorAddress);
+    }
     
     // Kiểm tra event code
     if (response[2] != EVENT_READ_DATA) {
@@ -276,15 +561,10 @@ bool FuelSensor::parseBroadcastResponse(uint8_t* response, int length) {
         return false;
     }
     
-    // Tính toán và kiểm tra CRC-8/MAXIM
-    uint8_t calculatedCRC = calculateCRC8(response, length - 1);
-    if (response[length - 1] != calculatedCRC) {
-        Serial.printf("Broadcast CRC mismatch: 0x%02X (calculated 0x%02X)\n", response[length - 1], calculatedCRC);
-        // Vẫn tiếp tục parse data, chỉ warning
-    }
+    // CRC-8/MAXIM đã được kiểm tra bởi AoooGFrameParser - frame lỗi CRC không tới đây
     
     // Parse temperature (byte 3)
-    temperature = (float)response[3];
+    temperature = Centi::fromUnits(response[3]);
     
     // Parse fuel value (bytes 4-5, little endian)
     fuelValue = (uint16_t)response[4] | ((uint16_t)response[5] << 8);
@@ -296,36 +576,19 @@ bool FuelSensor::parseBroadcastResponse(uint8_t* response, int length) {
         frequency = 0;
     }
     
-    Serial.printf("Broadcast Parsed - Responding Sensor: 0x%02X, Temperature: %.1f°C, Fuel Value: %d, Frequency: %d Hz\n", 
-                  respondingSensorAddress, temperature, fuelValue, frequency);
+    if (verbose) {
+        Serial.printf("Broadcast Parsed - Responding Sensor: 0x%02X, Temperature: %d°C, Fuel Value: %d, Frequency: %d Hz\n", 
+                      respondingSensorAddress, response[3], fuelValue, frequency);
+    }
     
-    // Cập nhật address thành sensor đã trả lời để sử dụng cho các lệnh tiếp theo
-    sensorAddress = respondingSensorAddress;
-    Serial.printf("Updated sensor address to: 0x%02X\n", sensorAddress);
+    // Không ghi đè sensorAddress: với nhiều đầu dò trên cùng đường truyền, sensor trả lời
+    // broadcast trước là ngẫu nhiên. Địa chỉ sensor trả lời nằm ở response[1]
     
     dataValid = true;
     return true;
 }
 
-uint8_t FuelSensor::calculateCRC8(uint8_t* data, int length) {
-    // CRC-8/MAXIM implementation
-    uint8_t crc = 0x00;
-    
-    for (int i = 0; i < length; i++) {
-        crc ^= data[i];
-        for (int j = 0; j < 8; j++) {
-            if (crc & 0x01) {
-                crc = (crc >> 1) ^ 0x8C;
-            } else {
-                crc >>= 1;
-            }
-        }
-    }
-    
-    return crc;
-}
-
-float FuelSensor::getTemperature() const {
+Centi FuelSensor::getTemperature() const {
     return temperature;
 }
 
@@ -337,12 +600,12 @@ uint16_t FuelSensor::getFrequency() const {
     return frequency;
 }
 
-float FuelSensor::getFuelLiters() const {
-    return fuelValue * 0.1f;
+Deci FuelSensor::getFuelLiters() const {
+    return Deci::fromRaw(fuelValue);
 }
 
-float FuelSensor::getFuelPercent() const {
-    return fuelValue * 0.1f;
+Deci FuelSensor::getFuelPercent() const {
+    return Deci::fromRaw(fuelValue);
 }
 
 bool FuelSensor::isDataValid() const {
@@ -370,48 +633,7 @@ uint8_t FuelSensor::getSensorAddress() const {
     return sensorAddress;
 }
 
-bool FuelSensor::readLimits() {
-    if (!sendRequest(EVENT_READ_LIMITS)) {
-        Serial.println("Failed to send limits request to fuel sensor");
-        limitsValid = false;
-        return false;
-    }
-    
-    // Đợi response
-    delay(50);
-    
-    if (serial->available() > 0) {
-        uint8_t response[16];
-        int bytesRead = 0;
-        
-        // Đọc response
-        while (serial->available() && bytesRead < sizeof(response)) {
-            response[bytesRead] = serial->read();
-            bytesRead++;
-            delay(2);
-        }
-        
-        Serial.print("Limits Response: ");
-        for (int i = 0; i < bytesRead; i++) {
-            Serial.printf("%02X ", response[i]);
-        }
-        Serial.println();
-        
-        if (bytesRead >= 7) {
-            return parseLimitsResponse(response, bytesRead);
-        } else {
-            Serial.printf("Insufficient limits response data: %d bytes\n", bytesRead);
-            limitsValid = false;
-            return false;
-        }
-    } else {
-        Serial.println("No limits response from fuel sensor");
-        limitsValid = false;
-        return false;
-    }
-}
-
-bool FuelSensor::parseLimitsResponse(uint8_t* response, int length) {
+bool FuelSensor::parseLimitsResponse(const uint8_t* response, int length) {
     if (length < 7) {
         Serial.println("Limits response too short");
         return false;
@@ -423,9 +645,10 @@ bool FuelSensor::parseLimitsResponse(uint8_t* response, int length) {
         return false;
     }
     
-    // Kiểm tra address
-    if (response[1] != sensorAddress) {
-        Serial.printf("Limits address mismatch: 0x%02X (expected 0x%02X)\n", response[1], sensorAddress);
+    // Kiểm tra address theo địa chỉ của request - chỉ kiểm tra nếu không phải broadcast
+    uint8_t requestAddress = activeTransaction.address;
+    if (requestAddress != BROADCAST_ADDRESS && response[1] != requestAddress) {
+        Serial.printf("Limits address mismatch: 0x%02X (expected 0x%02X)\n", response[1], requestAddress);
         return false;
     }
     
@@ -455,290 +678,106 @@ uint16_t FuelSensor::getLevelMin() const {
     return levelMin;
 }
 
-float FuelSensor::getLevelMaxLiters() const {
-    return levelMax * 0.1f;
+Deci FuelSensor::getLevelMaxLiters() const {
+    return Deci::fromRaw(levelMax);
 }
 
-float FuelSensor::getLevelMinLiters() const {
-    return levelMin * 0.1f;
+Deci FuelSensor::getLevelMinLiters() const {
+    return Deci::fromRaw(levelMin);
 }
 
 bool FuelSensor::areLimitsValid() const {
     return limitsValid;
 }
 
-bool FuelSensor::setFullLevel() {
-    Serial.println("=== SET FULL LEVEL ===");
-    
-    // Send Set Full Frequency command directly (31 FF 46 6F)
-    Serial.println("Sending Set Full Frequency command...");
-    uint8_t command[] = {0x31, 0xFF, 0x46, 0x6F}; // 31 FF 46 6F
-    
-    serial->write(command, sizeof(command));
-    
-    Serial.printf("Sent: 31 FF 46 6F\n");
-    
-    // Wait for response: 3E 01 46 00 80 (where 00=OK, 01=Error)
-    unsigned long responseStart = millis();
-    while (millis() - responseStart < RESPONSE_DELAY) {
-        // Non-blocking delay for response
-    }
-    
-    if (serial->available() >= 5) {
-        uint8_t response[8];
-        int bytesRead = serial->readBytes(response, min(8, serial->available()));
-        
-        // Store Set command response data
-        lastSetResponseLength = min(bytesRead, (int)sizeof(lastSetResponse));
-        memcpy(lastSetResponse, response, lastSetResponseLength);
-        lastSetCommand = "SET FULL";
-        
-        Serial.printf("Set Full response (%d bytes): ", bytesRead);
-        for (int i = 0; i < bytesRead; i++) {
-            Serial.printf("0x%02X ", response[i]);
-        }
-        Serial.println();
-        
-        // Check response format: 3E 01 46 00/01 80 (where 01=OK, 00=Error)
-        if (bytesRead >= 5 && response[0] == HEADER_RESPONSE && response[2] == EVENT_SET_FULL_FREQ) {
-            if (response[3] == 0x01) {
-                Serial.println("SET FULL successful (response: 01)");
-                lastSetSuccess = true;
-                // Re-read limits to update local values
-                unsigned long delayStart = millis();
-                while (millis() - delayStart < 100) {
-                    // Non-blocking delay 100ms
-                }
-                readLimits();
-                
-                // Send restart command after 5 second delay
-                Serial.println("Sending restart command after SET FULL...");
-                delayStart = millis();
-                while (millis() - delayStart < 5000) {
-                    // Non-blocking delay 5000ms (5 seconds)
-                }
-                restartSensor();
-                
-                return true;
-            } else {
-                Serial.printf("SET FULL failed (response: %02X)\n", response[3]);
-                lastSetSuccess = false;
-                return false;
-            }
-        } else {
-            Serial.println("Invalid Set Full response format");
-            lastSetSuccess = false;
-            return false;
-        }
-    }
-    
-    Serial.println("No response to Set Full command");
-    lastSetSuccess = false;
-    return false;
+FuelSensor::TransactionHandle FuelSensor::setFullLevel(uint8_t address, TransactionCallback callback, void* context) {
+    // Set step only (31 AA 46 [CRC], reply 3E AA 46 01 [CRC]); CalibrationJob runs the whole
+    // sequence with the limits read and the delayed restart
+    return submitRequest(address, EVENT_SET_FULL_FREQ, callback, context);
 }
 
-bool FuelSensor::setEmptyLevel() {
-    Serial.println("=== SET EMPTY LEVEL ===");
-    
-    // Send Set Empty Frequency command directly (31 FF 45 8D)
-    Serial.println("Sending Set Empty Frequency command...");
-    uint8_t command[] = {0x31, 0xFF, 0x45, 0x8D}; // 31 FF 45 8D
-    
-    serial->write(command, sizeof(command));
-    
-    Serial.printf("Sent: 31 FF 45 8D\n");
-    
-    // Wait for response: 3E 01 45 00 80 (where 00=OK, 01=Error)
-    unsigned long responseStart = millis();
-    while (millis() - responseStart < RESPONSE_DELAY) {
-        // Non-blocking delay for response
-    }
+FuelSensor::TransactionHandle FuelSensor::setEmptyLevel(uint8_t address, TransactionCallback callback, void* context) {
+    // Set step only (31 AA 45 [CRC], reply 3E AA 45 01 [CRC]), see setFullLevel()
+    return submitRequest(address, EVENT_SET_EMPTY_FREQ, callback, context);
+}
+
+bool FuelSensor::parseSetLevelResponse(const uint8_t* response, int length) {
+    // Store Set command response data
+    lastSetResponseLength = min(length, (int)sizeof(lastSetResponse));
+    memcpy(lastSetResponse, response, lastSetResponseLength);
+    const char* name = response[2] == EVENT_SET_FULL_FREQ ? "SET FULL" : "SET EMPTY";
+    lastSetCommand = name;
     
-    if (serial->available() >= 5) {
-        uint8_t response[8];
-        int bytesRead = serial->readBytes(response, min(8, serial->available()));
-        
-        // Store Set command response data
-        lastSetResponseLength = min(bytesRead, (int)sizeof(lastSetResponse));
-        memcpy(lastSetResponse, response, lastSetResponseLength);
-        lastSetCommand = "SET EMPTY";
-        
-        Serial.printf("Set Empty response (%d bytes): ", bytesRead);
-        for (int i = 0; i < bytesRead; i++) {
-            Serial.printf("0x%02X ", response[i]);
-        }
-        Serial.println();
-        
-        // Check response format: 3E 01 45 00/01 80 (where 01=OK, 00=Error)
-        if (bytesRead >= 5 && response[0] == HEADER_RESPONSE && response[2] == EVENT_SET_EMPTY_FREQ) {
-            if (response[3] == 0x01) {
-                Serial.println("SET EMPTY successful (response: 01)");
-                lastSetSuccess = true;
-                // Re-read limits to update local values
-                unsigned long delayStart = millis();
-                while (millis() - delayStart < 100) {
-                    // Non-blocking delay 100ms
-                }
-                readLimits();
-                
-                // Send restart command after 5 second delay
-                Serial.println("Sending restart command after SET EMPTY...");
-                delayStart = millis();
-                while (millis() - delayStart < 5000) {
-                    // Non-blocking delay 5000ms (5 seconds)
-                }
-                restartSensor();
-                
-                return true;
-            } else {
-                Serial.printf("SET EMPTY failed (response: %02X)\n", response[3]);
-                lastSetSuccess = false;
-                return false;
-            }
+    // Check response format: 3E 01 46/45 00/01 80 (where 01=OK, 00=Error)
+    if (length >= 5 && response[0] == HEADER_RESPONSE) {
+        lastSetSuccess = response[3] == 0x01;
+        if (lastSetSuccess) {
+            Serial.printf("%s successful (response: 01)\n", name);
         } else {
-            Serial.println("Invalid Set Empty response format");
-            lastSetSuccess = false;
-            return false;
+            Serial.printf("%s failed (response: %02X)\n", name, response[3]);
         }
+        // A well-formed NACK is still a completed transaction
+        return true;
     }
     
-    Serial.println("No response to Set Empty command");
+    Serial.printf("Invalid %s response format\n", name);
     lastSetSuccess = false;
     return false;
 }
 
-bool FuelSensor::readEmptyFrequency() {
-    // Build command: 31 FF 51 [CRC]
-    uint8_t command[] = {0x31, 0xFF, 0x51};
-    uint8_t checksum = calculateCRC8(command, sizeof(command));
-    
-    // Send command
-    serial->write(command, sizeof(command));
-    serial->write(checksum);
-    
-    Serial.printf("Sent Read Empty Frequency command: ");
-    for (int i = 0; i < sizeof(command); i++) {
-        Serial.printf("0x%02X ", command[i]);
-    }
-    Serial.printf("CRC: 0x%02X\n", checksum);
-    
-    // Wait for response
-    unsigned long responseStart = millis();
-    while (millis() - responseStart < RESPONSE_DELAY) {
-        // Non-blocking delay for response
-    }
-    
-    if (serial->available()) {
-        uint8_t response[8];
-        int bytesRead = 0;
-        unsigned long startTime = millis();
-        
-        // Read response with timeout
-        while (bytesRead < sizeof(response) && (millis() - startTime) < 1000) {
-            if (serial->available()) {
-                response[bytesRead] = serial->read();
-                bytesRead++;
-            }
-        }
+FuelSensor::TransactionHandle FuelSensor::readEmptyFrequency(uint8_t address, TransactionCallback callback, void* context) {
+    // Command: 31 AA 51 [CRC]
+    return submitRequest(address, EVENT_READ_EMPTY_FREQ, callback, context);
+}
+
+bool FuelSensor::parseEmptyFrequencyResponse(const uint8_t* response, int length) {
+    // Expected response: 3E 01 51 26 4A 2A (or 3E FF 51 26 4A 2A for broadcast)
+    // Parse response: Header=3E, Address=probe (any for broadcast), Event=51, Data=26 4A, CRC=2A
+    uint8_t requestAddress = activeTransaction.address;
+    bool addressMatches = requestAddress == BROADCAST_ADDRESS || response[1] == requestAddress;
+    if (length >= 6 && response[0] == HEADER_RESPONSE && addressMatches && response[2] == EVENT_READ_EMPTY_FREQ) {
+        // Extract frequency data (little-endian): 4A 26 = 0x264A = 9802
+        // But according to example: 26 4A => 4A 26 = 18982
+        emptyFrequency = (response[4] << 8) | response[3]; // 4A 26 format
+        emptyFrequencyValid = true;
         
-        // Log received response
-        Serial.printf("Read Empty Frequency response (%d bytes): ", bytesRead);
-        for (int i = 0; i < bytesRead; i++) {
-            Serial.printf("0x%02X ", response[i]);
-        }
-        Serial.println();
+        Serial.printf("Empty Frequency parsed: 0x%02X%02X = %d\n", 
+                     response[4], response[3], emptyFrequency);
         
-        // Expected response: 3E 01 51 26 4A 2A (or 3E FF 51 26 4A 2A for broadcast)
-        // Parse response: Header=3E, Address=01/FF, Event=51, Data=26 4A, CRC=2A
-        if (bytesRead >= 6 && response[0] == 0x3E && 
-            (response[1] == 0x01 || response[1] == 0xFF) && response[2] == 0x51) {
-            // Extract frequency data (little-endian): 4A 26 = 0x264A = 9802
-            // But according to example: 26 4A => 4A 26 = 18982
-            emptyFrequency = (response[4] << 8) | response[3]; // 4A 26 format
-            emptyFrequencyValid = true;
-            
-            Serial.printf("Empty Frequency parsed: 0x%02X%02X = %d\n", 
-                         response[4], response[3], emptyFrequency);
-            
-            return true;
-        } else {
-            Serial.println("Invalid Read Empty Frequency response format");
-            emptyFrequencyValid = false;
-            return false;
-        }
+        return true;
     }
     
-    Serial.println("No response to Read Empty Frequency command");
+    Serial.println("Invalid Read Empty Frequency response format");
     emptyFrequencyValid = false;
     return false;
 }
 
-bool FuelSensor::isConnected() {
-    // Quick connectivity check by sending a broadcast request
-    uint8_t originalAddress = sensorAddress;
-    sensorAddress = BROADCAST_ADDRESS; // Use broadcast for detection
-    
-    bool connected = false;
-    if (sendRequest(EVENT_READ_DATA)) {
-        // Wait for any response (even if invalid)
-        unsigned long startTime = millis();
-        while (millis() - startTime < 500) { // 500ms timeout
-            if (serial->available()) {
-                // Clear buffer and return true if we got any response
-                while (serial->available()) {
-                    serial->read();
-                }
-                connected = true;
-                break;
-            }
-            delay(10);
-        }
-    }
-    
-    sensorAddress = originalAddress; // Restore original address
-    return connected;
+// Raw data access methods
+size_t FuelSensor::formatLastRawData(char* buffer, size_t size) const {
+    return formatHex(lastRawResponse, lastRawResponseLength, buffer, size);
 }
 
-// Private helper method for reading extended command responses
-bool FuelSensor::readExtendedResponse(const char* commandName) {
-    delay(100);
+size_t FuelSensor::formatHex(const uint8_t* data, int length, char* buffer, size_t size) {
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+    if (buffer == nullptr || size == 0) {
+        return 0;
+    }
     
-    if (serial->available() > 0) {
-        uint8_t response[32];
-        int bytesRead = 0;
-        
-        // Read response with timeout
-        unsigned long startTime = millis();
-        while (bytesRead < sizeof(response) && (millis() - startTime) < 1000) {
-            if (serial->available()) {
-                response[bytesRead] = serial->read();
-                bytesRead++;
-            }
-            delay(1);
+    size_t pos = 0;
+    for (int i = 0; i < length; i++) {
+        // Separator + 2 digits must still leave room for the terminator
+        size_t needed = (i > 0) ? 3 : 2;
+        if (pos + needed >= size) {
+            break;
         }
-        
-        if (bytesRead > 0) {
-            Serial.printf("%s response: ", commandName);
-            for (int i = 0; i < bytesRead; i++) {
-                Serial.printf("%02X ", response[i]);
-            }
-            Serial.println();
-            
-            // Store in extended response buffer
-            extendedResponseLength = min(bytesRead, (int)sizeof(extendedResponse));
-            memcpy(extendedResponse, response, extendedResponseLength);
-            
-            return true;
+        if (i > 0) {
+            buffer[pos++] = ' ';
         }
+        buffer[pos++] = HEX_DIGITS[data[i] >> 4];
+        buffer[pos++] = HEX_DIGITS[data[i] & 0x0F];
     }
-    
-    Serial.printf("No response to %s command\n", commandName);
-    return false;
-}
-
-// Raw data access methods
-String FuelSensor::getLastRawData() const {
-    return lastRawDataString;
+    buffer[pos] = '\0';
+    return pos;
 }
 
 const uint8_t* FuelSensor::getLastRawResponse() const {
@@ -749,261 +788,125 @@ int FuelSensor::getLastRawResponseLength() const {
     return lastRawResponseLength;
 }
 
-bool FuelSensor::readFirmwareVersion() {
-  uint8_t command[] = {0x31, 0xFF, 0x1C};
-  uint8_t checksum = calculateCRC8(command, sizeof(command));
-  
-  // Send command with checksum
-  serial->write(command, sizeof(command));
-  serial->write(checksum);
-  
-  Serial.printf("Sent firmware read command: ");
-  for (int i = 0; i < sizeof(command); i++) {
-    Serial.printf("0x%02X ", command[i]);
-  }
-  Serial.printf("CRC: 0x%02X\n", checksum);
-  
-  // Wait for response
-  delay(RESPONSE_DELAY);
-  
-  if (serial->available() >= 4) {
-    uint8_t response[32];
-    int available = serial->available();
-    int bytesRead = serial->readBytes(response, min(32, available));
-    
-    // Store firmware response
-    memcpy(firmwareVersion, response, min(32, bytesRead));
-    firmwareVersionLength = bytesRead;
-    
-    Serial.printf("Firmware response (%d bytes): ", bytesRead);
-    for (int i = 0; i < bytesRead; i++) {
-      Serial.printf("0x%02X ", response[i]);
-    }
-    Serial.println();
-    
-    // Also print as string for debugging
-    Serial.print("Firmware as string: ");
-    for (int i = 0; i < bytesRead; i++) {
-      if (response[i] >= 32 && response[i] <= 126) {
-        Serial.print((char)response[i]);
-      } else {
-        Serial.printf("[%02X]", response[i]);
-      }
-    }
-    Serial.println();
-    
-    return true;
-  }
-  
-  Serial.println("No firmware response received");
-  return false;
+FuelSensor::TransactionHandle FuelSensor::readFirmwareVersion(uint8_t address, TransactionCallback callback, void* context) {
+  // Command: 31 AA 1C [CRC] (31 FF 1C CA broadcast)
+  return submitRequest(address, EVENT_READ_FIRMWARE, callback, context);
 }
 
-bool FuelSensor::readSerialNumber() {
-  uint8_t command[] = {0x31, 0xFF, 0x02};
-  uint8_t checksum = calculateCRC8(command, sizeof(command));
-  
-  // Clear any pending data
-  while (serial->available()) {
-    serial->read();
-  }
-  
-  // Send command with checksum
-  serial->write(command, sizeof(command));
-  serial->write(checksum);
-  
-  Serial.printf("Sent serial number read command: ");
-  for (int i = 0; i < sizeof(command); i++) {
-    Serial.printf("0x%02X ", command[i]);
+bool FuelSensor::parseFirmwareResponse(const uint8_t* response, int length) {
+  if (length < 4) {
+    return false;
   }
-  Serial.printf("CRC: 0x%02X\n", checksum);
   
-  // Wait for response
-  delay(RESPONSE_DELAY);
+  // Store firmware response
+  memcpy(firmwareVersion, response, min((int)sizeof(firmwareVersion), length));
+  firmwareVersionLength = min((int)sizeof(firmwareVersion), length);
   
-  if (serial->available() >= 8) { // Expected: 3E 01 02 3C 83 0C 00 4E (8 bytes)
-    uint8_t response[8];
-    int bytesRead = serial->readBytes(response, min(8, serial->available()));
-    
-    // Store serial number response
-    memcpy(serialNumberData, response, min(8, bytesRead));
-    serialNumberLength = bytesRead;
-    
-    Serial.printf("Serial number response (%d bytes): ", bytesRead);
-    for (int i = 0; i < bytesRead; i++) {
-      Serial.printf("0x%02X ", response[i]);
-    }
-    Serial.println();
-    
-    // Parse serial number from response
-    if (bytesRead >= 7 && response[0] == 0x3E && response[2] == 0x02) {
-      // Data is at bytes 3-6: 3C 83 0C 00 (little-endian U32)
-      serialNumber = ((uint32_t)response[6] << 24) | 
-                     ((uint32_t)response[5] << 16) | 
-                     ((uint32_t)response[4] << 8) | 
-                     ((uint32_t)response[3]);
-      
-      Serial.printf("Parsed serial number: %lu\n", serialNumber);
+  // Also print as string for debugging
+  Serial.print("Firmware as string: ");
+  for (int i = 0; i < firmwareVersionLength; i++) {
+    if (response[i] >= 32 && response[i] <= 126) {
+      Serial.print((char)response[i]);
+    } else {
+      Serial.printf("[%02X]", response[i]);
     }
-    
-    return true;
   }
+  Serial.println();
   
-  Serial.println("No serial number response received");
-  return false;
+  return true;
 }
 
-bool FuelSensor::factoryReset() {
-  uint8_t command[] = {0x31, 0xFF, 0x18};
-  uint8_t checksum = calculateCRC8(command, sizeof(command));
-  
-  // Clear any pending data
-  while (serial->available()) {
-    serial->read();
+FuelSensor::TransactionHandle FuelSensor::readSerialNumber(uint8_t address, TransactionCallback callback, void* context) {
+  // Command: 31 AA 02 [CRC]
+  return submitRequest(address, EVENT_READ_SERIAL, callback, context);
+}
+
+bool FuelSensor::parseSerialNumberResponse(const uint8_t* response, int length) {
+  // Expected: 3E 01 02 3C 83 0C 00 4E (8 bytes)
+  if (length < 8) {
+    return false;
   }
   
-  // Send command with checksum
-  serial->write(command, sizeof(command));
-  serial->write(checksum);
+  // Store serial number response
+  memcpy(serialNumberData, response, sizeof(serialNumberData));
+  serialNumberLength = sizeof(serialNumberData);
   
-  Serial.printf("Sent factory reset command: ");
-  for (int i = 0; i < sizeof(command); i++) {
-    Serial.printf("0x%02X ", command[i]);
+  // Parse serial number from response
+  if (response[0] == HEADER_RESPONSE && response[2] == EVENT_READ_SERIAL) {
+    // Data is at bytes 3-6: 3C 83 0C 00 (little-endian U32)
+    serialNumber = ((uint32_t)response[6] << 24) | 
+                   ((uint32_t)response[5] << 16) | 
+                   ((uint32_t)response[4] << 8) | 
+                   ((uint32_t)response[3]);
+    
+    Serial.printf("Parsed serial number: %lu\n", (unsigned long)serialNumber);
   }
-  Serial.printf("CRC: 0x%02X\n", checksum);
   
-  // Wait for response
-  delay(RESPONSE_DELAY);
+  return true;
+}
+
+FuelSensor::TransactionHandle FuelSensor::factoryReset(uint8_t address, TransactionCallback callback, void* context) {
+  // Command: 31 AA 18 [CRC]
+  return submitRequest(address, EVENT_FACTORY_RESET, callback, context);
+}
+
+bool FuelSensor::parseFactoryResetResponse(const uint8_t* response, int length) {
+  // Store factory reset response
+  lastSetResponseLength = min(length, (int)sizeof(lastSetResponse));
+  memcpy(lastSetResponse, response, lastSetResponseLength);
+  lastSetCommand = "FACTORY_RESET";
   
-  if (serial->available() >= 5) { // Expected: 3E 01 18 00 6C (5 bytes)
-    uint8_t response[8];
-    int bytesRead = serial->readBytes(response, min(8, serial->available()));
-    
-    // Store factory reset response
-    memcpy(lastSetResponse, response, min(8, bytesRead));
-    lastSetResponseLength = bytesRead;
-    lastSetCommand = "FACTORY_RESET";
-    
-    Serial.printf("Factory reset response (%d bytes): ", bytesRead);
-    for (int i = 0; i < bytesRead; i++) {
-      Serial.printf("0x%02X ", response[i]);
-    }
-    Serial.println();
-    
-    // Parse response: 3E 01 18 00 6C
-    if (bytesRead >= 4 && response[0] == 0x3E && response[1] == 0x01 && response[2] == 0x18) {
-      if (response[3] == 0x00) {
-        Serial.println("Factory reset successful (SET OK)");
-        lastSetSuccess = true;
-      } else {
-        Serial.printf("Factory reset failed with status: 0x%02X\n", response[3]);
-        lastSetSuccess = false;
-      }
+  // Parse response: 3E 01 18 00 6C (address of the probe that was reset, any for broadcast)
+  uint8_t requestAddress = activeTransaction.address;
+  bool addressMatches = requestAddress == BROADCAST_ADDRESS || response[1] == requestAddress;
+  if (length >= 4 && response[0] == HEADER_RESPONSE && addressMatches && response[2] == EVENT_FACTORY_RESET) {
+    if (response[3] == 0x00) {
+      Serial.println("Factory reset successful (SET OK)");
+      lastSetSuccess = true;
     } else {
-      Serial.println("Invalid factory reset response format");
+      Serial.printf("Factory reset failed with status: 0x%02X\n", response[3]);
       lastSetSuccess = false;
     }
-    
-    return lastSetSuccess;
+  } else {
+    Serial.println("Invalid factory reset response format");
+    lastSetSuccess = false;
   }
   
-  Serial.println("No factory reset response received");
-  lastSetSuccess = false;
-  return false;
+  // A well-formed NACK is still a completed transaction
+  return length >= 4;
 }
 
-bool FuelSensor::sendExtendedE3() {
-  uint8_t command[] = {0x31, 0xFF, 0xE3};
-  uint8_t checksum = calculateCRC8(command, sizeof(command));
-  
-  serial->write(command, sizeof(command));
-  serial->write(checksum);
-  
-  Serial.printf("Sent extended E3 command: ");
-  for (int i = 0; i < sizeof(command); i++) {
-    Serial.printf("0x%02X ", command[i]);
-  }
-  Serial.printf("CRC: 0x%02X\n", checksum);
-  
-  delay(RESPONSE_DELAY);
-  
-  if (serial->available() >= 4) {
-    uint8_t response[16];
-    int bytesRead = serial->readBytes(response, min(16, serial->available()));
-    
-    memcpy(extendedResponse, response, min(16, bytesRead));
-    extendedResponseLength = bytesRead;
-    
-    Serial.printf("Extended E3 response (%d bytes): ", bytesRead);
-    for (int i = 0; i < bytesRead; i++) {
-      Serial.printf("0x%02X ", response[i]);
-    }
-    Serial.println();
-    
-    return true;
-  }
-  
-  Serial.println("No E3 response received");
-  return false;
+FuelSensor::TransactionHandle FuelSensor::sendExtendedE3(uint8_t address, TransactionCallback callback, void* context) {
+  // Command: 31 AA E3 [CRC] (31 FF E3 FF broadcast)
+  return submitRequest(address, EVENT_EXTENDED_E3, callback, context);
 }
 
-bool FuelSensor::restartSensor() {
-  uint8_t command[] = {0x31, 0xFF, 0x4D, 0x0A};
-  
-  serial->write(command, sizeof(command));
-  
-  Serial.printf("Sent restart command: ");
-  for (int i = 0; i < sizeof(command); i++) {
-    Serial.printf("0x%02X ", command[i]);
-  }
-  Serial.println();
-  
-  // Restart command has no response expected
-  unsigned long delayStart = millis();
-  while (millis() - delayStart < 1000) {
-    // Non-blocking delay 1000ms - wait for sensor restart
+bool FuelSensor::parseExtendedE3Response(const uint8_t* response, int length) {
+  if (length < 4) {
+    return false;
   }
   
-  Serial.println("Sensor restart command sent (no response expected)");
+  extendedResponseLength = min(length, (int)sizeof(extendedResponse));
+  memcpy(extendedResponse, response, extendedResponseLength);
   return true;
 }
 
-bool FuelSensor::sendMultipleCommands() {
-  Serial.println("=== Sending Multiple Extended Commands ===");
-  
-  bool success = true;
-  
-  // 1. Read Firmware Version
-  Serial.println("1. Reading firmware version...");
-  if (readFirmwareVersion()) {
-    Serial.println("   Firmware read successful");
-  } else {
-    Serial.println("   Firmware read failed");
-    success = false;
-  }
-  delay(500);
-  
-  // 2. Send Extended E3
-  Serial.println("2. Sending Extended E3 command...");
-  if (sendExtendedE3()) {
-    Serial.println("   E3 command successful");
-  } else {
-    Serial.println("   E3 command failed");
-    success = false;
-  }
-  delay(500);
-  
-  // 3. Restart Sensor
-  Serial.println("3. Restarting sensor...");
-  if (restartSensor()) {
-    Serial.println("   Restart command successful");
-  } else {
-    Serial.println("   Restart command failed");
-    success = false;
+FuelSensor::TransactionHandle FuelSensor::restartSensor(uint8_t address, TransactionCallback callback, void* context) {
+  // 31 AA 4D [CRC], no reply: the engine sends it and then holds the bus for RESTART_SETTLE_MS
+  // on its own, the next request waits behind that
+  return submitRequest(address, EVENT_RESTART_SENSOR, callback, context);
+}
+
+FuelSensor::TransactionHandle FuelSensor::sendMultipleCommands(uint8_t address, TransactionCallback callback, void* context) {
+  // All three or none: a sequence cut short by a full queue would restart without the reads.
+  // The engine already spaces them, each waits for the previous reply or its deadline.
+  if (MAX_PENDING_TRANSACTIONS - pendingCount < 3) {
+    Serial.printf("Transaction queue full, multiple commands to 0x%02X not sent\n", address);
+    return INVALID_TRANSACTION;
   }
-  
-  Serial.printf("=== Multiple commands completed. Success: %s ===\n", success ? "YES" : "NO");
-  return success;
+  readFirmwareVersion(address, callback, context);
+  sendExtendedE3(address, callback, context);
+  return restartSensor(address, callback, context);
 }
 
 const uint8_t* FuelSensor::getFirmwareVersion() const {
@@ -1043,7 +946,7 @@ int FuelSensor::getLastSetResponseLength() const {
   return lastSetResponseLength;
 }
 
-String FuelSensor::getLastSetCommand() const {
+const char* FuelSensor::getLastSetCommand() const {
   return lastSetCommand;
 }
 
@@ -1051,15 +954,6 @@ bool FuelSensor::getLastSetSuccess() const {
   return lastSetSuccess;
 }
 
-String FuelSensor::getLastSetResponseString() const {
-  String responseStr = "";
-  for (int i = 0; i < lastSetResponseLength; i++) {
-    if (i > 0) responseStr += " ";
-    responseStr += String(lastSetResponse[i], HEX);
-    if (lastSetResponse[i] < 16) {
-      responseStr = responseStr.substring(0, responseStr.length()-1) + "0" + responseStr.substring(responseStr.length()-1);
-    }
-  }
-  responseStr.toUpperCase();
-  return responseStr;
+size_t FuelSensor::formatLastSetResponse(char* buffer, size_t size) const {
+  return formatHex(lastSetResponse, lastSetResponseLength, buffer, size);
 }
\ No newline at end of file
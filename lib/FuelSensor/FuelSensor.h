@@ -3,12 +3,14 @@
 
 #include <Arduino.h>
 #include <HardwareSerial.h>
+#include <FixedPoint.h>
+#include "AoooGFrameParser.h"
+
+class UartCapture;
+class UartRxBuffer;
 
 class FuelSensor {
-private:
-    uint8_t sensorAddress;
-    HardwareSerial* serial;
-    
+public:
     // Protocol constants - AoooG Protocol
     static const uint8_t HEADER_REQUEST = 0x31;
     static const uint8_t HEADER_RESPONSE = 0x3E;
@@ -31,10 +33,55 @@ private:
     static const uint8_t EVENT_EXTENDED_E3 = 0xE3; // Extended/hidden command
     static const uint8_t EVENT_RESTART_SENSOR = 0x4D; // Restart sensor (broadcast)
     
+    // Text buffer sizes for the hex formatters ("3E 01 06 ..." = 3 chars per byte incl. terminator)
+    static const size_t RAW_TEXT_SIZE = 16 * 3;
+    static const size_t SET_RESPONSE_TEXT_SIZE = 8 * 3;
+    
+    // Asynchronous transaction engine
+    enum TransactionStatus {
+        TRANSACTION_PENDING = 0,   // Queued or waiting for the reply
+        TRANSACTION_OK,            // Reply received and parsed
+        TRANSACTION_TIMEOUT,       // No complete reply before the deadline
+        TRANSACTION_INVALID,       // Reply received but rejected by the parser
+        TRANSACTION_UNKNOWN        // Handle not found (too old or never issued)
+    };
+    
+    typedef int16_t TransactionHandle;
+    static const TransactionHandle INVALID_TRANSACTION = -1;
+    
+    struct TransactionResult {
+        TransactionHandle handle;
+        uint8_t address;           // Address the request was sent to
+        uint8_t eventCode;
+        TransactionStatus status;
+        const uint8_t* response;   // Raw reply bytes, only valid inside the callback
+        int responseLength;
+        unsigned long elapsedMs;   // Time from request sent to completion
+    };
+    
+    typedef void (*TransactionCallback)(FuelSensor& sensor, const TransactionResult& result, void* context);
+    
+private:
+    uint8_t sensorAddress;
+    HardwareSerial* uart;          // UART owned by begin(), nullptr when an external stream is attached
+    Stream* serial;                // Stream used for all protocol I/O
+    UartCapture* capture;          // Optional trace of every byte on the link, nullptr = off
+    bool verbose;                  // Log every request, reply and failed exchange on Serial
+    
+    static const unsigned long TRANSACTION_TIMEOUT_MS = 1000; // Default reply deadline
+    static const unsigned long FRAME_GAP_MIN_MICROS = 1750;   // Floor for the idle gap above 19200 baud, as Modbus RTU
+    static const uint8_t UART_RX_TIMEOUT_SYMBOLS = 2;         // UART1 hands bytes over after this much line idle
+    static const unsigned long RESTART_SETTLE_MS = 1000;      // Bus quiet time after restart
+    static const int MAX_PENDING_TRANSACTIONS = 8;
+    // Handles are recorded at submit time: room for every live one (queue + active) plus the
+    // last 8 completed, so a handle never reads UNKNOWN while its request is still outstanding
+    static const int TRANSACTION_HISTORY = MAX_PENDING_TRANSACTIONS + 1 + 8;
+    static const uint8_t LINK_LOST_AFTER_MISSES = 3;          // Unanswered requests in a row before the link is down
+    
     // Response data
-    float temperature;
+    Centi temperature;         // Whole degrees from the sensor, kept as 0.01 °C
     uint16_t fuelValue;
-    uint16_t frequency;        // Current frequency value from readSensorData
+    uint16_t frequency;        // Current frequency value from the last data reply
     uint16_t levelMax;     // Maximum fuel level
     uint16_t levelMin;     // Minimum fuel level
     bool dataValid;
@@ -49,48 +96,142 @@ private:
     uint8_t extendedResponse[32];  // Buffer for extended responses
     int extendedResponseLength;    // Length of extended response
     
-    // Raw data storage
+    // Raw data storage (bytes only, hex text is rendered on demand)
     uint8_t lastRawResponse[16];  // Store last raw response
     int lastRawResponseLength;     // Length of last raw response
-    String lastRawDataString;      // Formatted hex string of raw data
     
     // Set command response data
     uint8_t lastSetResponse[8];    // Store last Set command response
     int lastSetResponseLength;     // Length of last Set response
-    String lastSetCommand;         // Name of last Set command executed
+    const char* lastSetCommand;    // Name of last Set command executed
     bool lastSetSuccess;           // Success status of last Set command
     
     // Empty frequency data
     uint16_t emptyFrequency;       // Empty frequency value (little-endian from response)
     bool emptyFrequencyValid;      // Whether empty frequency data is valid
     
+    // Transaction engine state
+    enum EngineState {
+        ENGINE_IDLE = 0,           // Nothing on the wire
+        ENGINE_WAIT_RESPONSE,      // Request sent, collecting reply bytes
+        ENGINE_QUIET               // Holding the bus after a command without reply
+    };
+    
+    struct PendingTransaction {
+        TransactionHandle handle;
+        uint8_t address;
+        uint8_t eventCode;
+        TransactionCallback callback;
+        void* context;
+        unsigned long timeoutMs;   // 0 = engine default
+    };
+    
+    PendingTransaction pendingQueue[MAX_PENDING_TRANSACTIONS];
+    int pendingHead;
+    int pendingCount;
+    PendingTransaction activeTransaction;
+    EngineState engineState;
+    unsigned long activeStartTime;
+    unsigned long lastByteMicros;  // micros() when the last reply byte was read
+    bool replyStarted;             // Bytes of an unfinished reply arrived since the request went out
+    unsigned long frameGapMicros;  // 3.5 character times: line idle this long ends the reply
+    unsigned long quietUntil;
+    unsigned long transactionTimeout;
+    AoooGFrameParser frameParser;  // Incremental reply parser, fed as bytes arrive
+    const uint8_t* responseData;   // Frame handed to the completion callback
+    int responseLength;
+    TransactionHandle nextHandle;
+    TransactionHandle historyHandles[TRANSACTION_HISTORY];
+    TransactionStatus historyStatus[TRANSACTION_HISTORY];
+    int historyIndex;
+    
+    // Link health, updated by every completed transaction
+    uint8_t consecutiveMisses;     // Requests in a row that got no reply at all
+    bool replySeen;                // At least one reply since begin()
+    unsigned long lastReplyTime;   // millis() of the last reply, valid or not
+    unsigned long lastTrafficTime; // millis() of the last completed request
+    
     // Internal methods
-    uint8_t calculateCRC8(uint8_t* data, int length);
-    bool sendRequest(uint8_t eventCode);
-    bool parseResponse(uint8_t* response, int length);
-    bool parseBroadcastResponse(uint8_t* response, int length);
-    bool parseLimitsResponse(uint8_t* response, int length);
-    bool readExtendedResponse(const char* commandName); // Helper for extended commands
+    bool sendRequest(uint8_t address, uint8_t eventCode);
+    bool parseResponse(const uint8_t* response, int length);
+    bool parseBroadcastResponse(const uint8_t* response, int length);
+    bool parseLimitsResponse(const uint8_t* response, int length);
+    bool parseFirmwareResponse(const uint8_t* response, int length);
+    bool parseSerialNumberResponse(const uint8_t* response, int length);
+    bool parseFactoryResetResponse(const uint8_t* response, int length);
+    bool parseSetLevelResponse(const uint8_t* response, int length);
+    bool parseEmptyFrequencyResponse(const uint8_t* response, int length);
+    bool parseExtendedE3Response(const uint8_t* response, int length);
+    
+    static int expectedResponseLength(uint8_t eventCode); // >0 fixed, 0 variable, -1 no reply
+    void startNextTransaction(unsigned long now);
+    void finishResponse(const AoooGFrameParser::Frame& frame);
+    bool dispatchResponse(const PendingTransaction& txn, const uint8_t* response, int length);
+    void markFailed(uint8_t eventCode);
+    void completeTransaction(TransactionStatus status);
+    int readByte();                // serial->read() plus capture
+    void discardInput();           // Drop stale bytes in chunks (still captured)
+    void setFrameGap(unsigned long baudrate);
     
 public:
     FuelSensor(uint8_t address = 0x01);
     
-    bool begin(int txPin, int rxPin, unsigned long baudrate = 9600);
-    bool readSensorData();
-    bool readSensorDataBroadcast(); // New method for broadcast reading
-    bool readLimits();      // New method to read max/min levels
-    bool setFullLevel();    // Set current level as full (100%) - NEW SEQUENCE
-    bool setEmptyLevel();   // Set current level as empty (0%) - NEW SEQUENCE
-    bool readEmptyFrequency(); // Read empty frequency (31 01 51 [CRC])
-    bool isConnected();     // Check if sensor is connected
-    
-    // Extended commands
-    bool readFirmwareVersion();    // Read firmware version (31 FF 1C CA)
-    bool readSerialNumber();       // Read serial number (31 FF 02 [CRC])
-    bool factoryReset();           // Factory reset (31 FF 18 [CRC])
-    bool sendExtendedE3();         // Send extended E3 command (31 FF E3 FF)
-    bool restartSensor();          // Restart sensor (31 FF 4D 4F)
-    bool sendMultipleCommands();   // Send multiple commands in sequence
+    bool begin(int txPin, int rxPin, unsigned long baudrate = 9600,
+               UartRxBuffer* rxBuffer = nullptr); // rxBuffer: receive through its lock-free ring
+    bool begin(Stream& stream, unsigned long baudrate = 9600); // Already configured stream (other UART, mock, simulator, replay)
+    void setCapture(UartCapture* capture);  // Record all TX/RX bytes with timestamps, nullptr stops
+    // Per-exchange trace on Serial, off by default: at a few polls per second it would flood the
+    // console and stall loop() on a full USB CDC buffer. Failures are still counted by
+    // getFrameParser() and getConsecutiveMisses().
+    void setVerbose(bool enabled);
+    bool isVerbose() const;
+    
+    // Commands below go to one probe; BROADCAST_ADDRESS reaches every probe on the link and
+    // their replies collide as soon as more than one is fitted. They queue like submitRequest()
+    // and return its handle (INVALID_TRANSACTION when the queue is full); the outcome comes
+    // through the callback or getTransactionStatus(), the parsed reply through the getters.
+    // Set full/empty: set step only, see CalibrationJob. TRANSACTION_OK means a well-formed
+    // reply, getLastSetSuccess() whether the probe accepted the new point.
+    TransactionHandle setFullLevel(uint8_t address, TransactionCallback callback = nullptr, void* context = nullptr);
+    TransactionHandle setEmptyLevel(uint8_t address, TransactionCallback callback = nullptr, void* context = nullptr);
+    // Read empty frequency (31 AA 51 [CRC])
+    TransactionHandle readEmptyFrequency(uint8_t address, TransactionCallback callback = nullptr, void* context = nullptr);
+    
+    // Non-blocking request/response API. Requests are queued and sent one at a time;
+    // poll() must be called from loop() to advance the UART state machine and fire callbacks.
+    // timeoutMs overrides the reply deadline for this request only (0 = setTransactionTimeout value).
+    TransactionHandle submitRequest(uint8_t address, uint8_t eventCode,
+                                    TransactionCallback callback = nullptr, void* context = nullptr,
+                                    unsigned long timeoutMs = 0);
+    void poll();
+    bool isBusy() const;                    // Transaction on the wire or queued
+    int getPendingCount() const;            // Queued transactions not yet sent
+    TransactionStatus getTransactionStatus(TransactionHandle handle) const;
+    void setTransactionTimeout(unsigned long timeoutMs);
+    unsigned long getFrameGap() const;      // µs of line idle that end a reply
+    const AoooGFrameParser& getFrameParser() const; // Frame/CRC/resync statistics
+    
+    // Liveness derived from normal traffic, no bus access: up once anything has replied
+    // and fewer than LINK_LOST_AFTER_MISSES requests in a row went unanswered
+    bool isLinkUp() const;
+    uint8_t getConsecutiveMisses() const;
+    unsigned long getLastReplyTime() const;   // millis() of the last reply, 0 if none yet
+    unsigned long getIdleTime() const;        // ms since the last completed request
+    
+    // Extended commands, queued the same way
+    // Read firmware version (31 AA 1C [CRC])
+    TransactionHandle readFirmwareVersion(uint8_t address, TransactionCallback callback = nullptr, void* context = nullptr);
+    // Read serial number (31 AA 02 [CRC])
+    TransactionHandle readSerialNumber(uint8_t address, TransactionCallback callback = nullptr, void* context = nullptr);
+    // Factory reset (31 AA 18 [CRC]), accepted or not: getLastSetSuccess()
+    TransactionHandle factoryReset(uint8_t address, TransactionCallback callback = nullptr, void* context = nullptr);
+    // Send extended E3 command (31 AA E3 [CRC])
+    TransactionHandle sendExtendedE3(uint8_t address, TransactionCallback callback = nullptr, void* context = nullptr);
+    // Restart sensor (31 AA 4D [CRC]), no reply: completes once sent, then the bus stays quiet 1 s
+    TransactionHandle restartSensor(uint8_t address, TransactionCallback callback = nullptr, void* context = nullptr);
+    // Firmware read, E3 and restart back to back; the callback fires for each of the three.
+    // Returns the restart's handle, INVALID_TRANSACTION (nothing queued) without room for all three
+    TransactionHandle sendMultipleCommands(uint8_t address, TransactionCallback callback = nullptr, void* context = nullptr);
     
     // Getters for extended data
     const uint8_t* getFirmwareVersion() const;
@@ -101,15 +242,15 @@ public:
     const uint8_t* getExtendedResponse() const;
     int getExtendedResponseLength() const;
     
-    float getTemperature() const;
+    Centi getTemperature() const;   // 0.01 °C
     uint16_t getFuelValue() const;
     uint16_t getFrequency() const;      // Current frequency value
-    float getFuelLiters() const;    // Fuel value * 0.1
-    float getFuelPercent() const;   // Fuel value * 0.1
+    Deci getFuelLiters() const;     // Fuel value in 0.1 L steps
+    Deci getFuelPercent() const;    // Fuel value in 0.1 steps
     uint16_t getLevelMax() const;   // Maximum fuel level
     uint16_t getLevelMin() const;   // Minimum fuel level
-    float getLevelMaxLiters() const; // Level max * 0.1
-    float getLevelMinLiters() const; // Level min * 0.1
+    Deci getLevelMaxLiters() const;  // Level max in 0.1 L steps
+    Deci getLevelMinLiters() const;  // Level min in 0.1 L steps
     bool isDataValid() const;
     bool areLimitsValid() const;
     
@@ -118,16 +259,20 @@ public:
     bool isEmptyFrequencyValid() const;     // Check if empty frequency is valid
     
     // Raw data access methods
-    String getLastRawData() const;  // Get formatted raw data string
     const uint8_t* getLastRawResponse() const; // Get raw response array
     int getLastRawResponseLength() const;      // Get raw response length
+    size_t formatLastRawData(char* buffer, size_t size) const; // Hex text into caller buffer (RAW_TEXT_SIZE)
     
     // Set command response access methods
     const uint8_t* getLastSetResponse() const; // Get last Set command response
     int getLastSetResponseLength() const;      // Get last Set response length
-    String getLastSetCommand() const;          // Get last Set command name
+    const char* getLastSetCommand() const;     // Get last Set command name
     bool getLastSetSuccess() const;            // Get last Set command success status
-    String getLastSetResponseString() const;   // Get formatted Set response string
+    size_t formatLastSetResponse(char* buffer, size_t size) const; // Hex text (SET_RESPONSE_TEXT_SIZE)
+    
+    // "3E 01 06 ..." upper case, no heap; truncates at a byte boundary, always terminated.
+    // Returns the text length.
+    static size_t formatHex(const uint8_t* data, int length, char* buffer, size_t size);
     
     void setSensorAddress(uint8_t address);
     uint8_t getSensorAddress() const;
@@ -0,0 +1,213 @@
+#include "I2CBus.h"
+
+I2CBus::I2CBus(TwoWire& wire) : wire(wire) {
+    mutex = nullptr;
+    clock = 0;
+    clockChanges = 0;
+    deviceCount = 0;
+    memset(devices, 0, sizeof(devices));
+    memset(&unknown, 0, sizeof(unknown));
+    unknown.address = ADDRESS_NONE;
+    unknown.name = "other";
+    unknown.maxClock = DEFAULT_CLOCK;
+    muxAddress = ADDRESS_NONE;
+    muxChannel = NO_CHANNEL;
+    channelSwitches = 0;
+    depth = 0;
+    current = nullptr;
+    startMicros = 0;
+    currentOk = true;
+}
+
+bool I2CBus::begin(int sdaPin, int sclPin) {
+    if (mutex == nullptr) {
+        mutex = xSemaphoreCreateRecursiveMutex();
+    }
+    bool ok = (sdaPin != -1 && sclPin != -1) ? wire.begin(sdaPin, sclPin) : wire.begin();
+    wire.setClock(DEFAULT_CLOCK);
+    clock = DEFAULT_CLOCK;
+    return ok && mutex != nullptr;
+}
+
+bool I2CBus::addDevice(uint8_t address, const char* name, uint32_t maxClock) {
+    DeviceStats* device = findDevice(address);
+    if (device == nullptr) {
+        if (deviceCount >= MAX_DEVICES) {
+            return false;
+        }
+        device = &devices[deviceCount++];
+        memset(device, 0, sizeof(*device));
+        device->address = address;
+    }
+    device->name = name;
+    device->maxClock = maxClock;
+    return true;
+}
+
+bool I2CBus::addMux(uint8_t address) {
+    addDevice(address, "MUX", MUX_CLOCK);
+    // All channels off: only the main bus is visible until a device asks for one
+    uint8_t none = 0;
+    if (!write(address, &none, 1)) {
+        return false;
+    }
+    muxAddress = address;
+    muxChannel = NO_CHANNEL;
+    return true;
+}
+
+bool I2CBus::hasMux() const {
+    return muxAddress != ADDRESS_NONE;
+}
+
+uint8_t I2CBus::getMuxAddress() const {
+    return muxAddress;
+}
+
+// Under the lock, at the current device's clock
+bool I2CBus::selectChannel(uint8_t channel) {
+    if (channel == NO_CHANNEL || muxAddress == ADDRESS_NONE || channel == muxChannel) {
+        return true;
+    }
+    wire.beginTransmission(muxAddress);
+    wire.write((uint8_t)(1 << channel));
+    if (wire.endTransmission() != 0) {
+        muxChannel = NO_CHANNEL; // Unknown now: select again next time
+        return false;
+    }
+    muxChannel = channel;
+    channelSwitches++;
+    return true;
+}
+
+I2CBus::DeviceStats* I2CBus::findDevice(uint8_t address) {
+    for (uint8_t i = 0; i < deviceCount; i++) {
+        if (devices[i].address == address) {
+            return &devices[i];
+        }
+    }
+    return nullptr;
+}
+
+bool I2CBus::lock(uint8_t address, uint8_t channel) {
+    if (mutex != nullptr) {
+        xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+    }
+    if (depth++ > 0) {
+        return true; // Nested: part of the caller's transaction
+    }
+    DeviceStats* device = findDevice(address);
+    current = device != nullptr ? device : &unknown;
+    if (current->maxClock != clock) {
+        wire.setClock(current->maxClock);
+        clock = current->maxClock;
+        clockChanges++;
+    }
+    startMicros = micros();
+    currentOk = selectChannel(channel);
+    return currentOk;
+}
+
+void I2CBus::unlock(bool ok) {
+    if (depth == 0) {
+        return;
+    }
+    currentOk = currentOk && ok;
+    if (--depth == 0) {
+        uint32_t elapsed = micros() - startMicros;
+        current->transactions++;
+        if (!currentOk) {
+            current->errors++;
+        }
+        current->lastMicros = elapsed;
+        if (elapsed > current->maxMicros) {
+            current->maxMicros = elapsed;
+        }
+        current->totalMicros += elapsed;
+        current = nullptr;
+    }
+    if (mutex != nullptr) {
+        xSemaphoreGiveRecursive(mutex);
+    }
+}
+
+TwoWire& I2CBus::getWire() {
+    return wire;
+}
+
+bool I2CBus::probe(uint8_t address) {
+    lock(address);
+    wire.beginTransmission(address);
+    bool ok = wire.endTransmission() == 0;
+    unlock(true); // Absent is an answer, not a bus error
+    return ok;
+}
+
+bool I2CBus::write(uint8_t address, const uint8_t* data, size_t length, bool stop) {
+    lock(address);
+    wire.beginTransmission(address);
+    wire.write(data, length);
+    bool ok = wire.endTransmission(stop) == 0;
+    unlock(ok);
+    return ok;
+}
+
+bool I2CBus::read(uint8_t address, uint8_t* data, size_t length) {
+    lock(address);
+    size_t received = wire.requestFrom(address, (uint8_t)length);
+    bool ok = received == length && wire.available() >= (int)length;
+    for (size_t i = 0; i < length && wire.available(); i++) {
+        data[i] = wire.read();
+    }
+    while (wire.available()) {
+        wire.read();
+    }
+    // A NACK is the device's answer (busy, no data), the caller decides if it is an error
+    unlock(true);
+    return ok;
+}
+
+uint32_t I2CBus::getClock() const {
+    return clock;
+}
+
+uint32_t I2CBus::getClockChanges() const {
+    return clockChanges;
+}
+
+uint32_t I2CBus::getChannelSwitches() const {
+    return channelSwitches;
+}
+
+const I2CBus::DeviceStats* I2CBus::getStats(uint8_t address) const {
+    for (uint8_t i = 0; i < deviceCount; i++) {
+        if (devices[i].address == address) {
+            return &devices[i];
+        }
+    }
+    return nullptr;
+}
+
+void I2CBus::printStats(Print& out) const {
+    out.printf("I2C bus: %lu Hz now, %lu clock changes", (unsigned long)clock, (unsigned long)clockChanges);
+    if (muxAddress != ADDRESS_NONE) {
+        out.printf(", mux 0x%02X %lu channel switches", muxAddress, (unsigned long)channelSwitches);
+    }
+    out.println();
+    for (uint8_t i = 0; i <= deviceCount; i++) {
+        const DeviceStats& device = i < deviceCount ? devices[i] : unknown;
+        if (i == deviceCount && device.transactions == 0) {
+            break;
+        }
+        unsigned long average = device.transactions > 0 ? (unsigned long)(device.totalMicros / device.transactions) : 0;
+        if (device.address == ADDRESS_NONE) {
+            out.printf("  --   %-8s", device.name);
+        } else {
+            out.printf("  0x%02X %-8s", device.address, device.name);
+        }
+        out.printf(" %4lu kHz  tx %lu err %lu | last %lu avg %lu max %lu us\n",
+                   (unsigned long)(device.maxClock / 1000), (unsigned long)device.transactions,
+                   (unsigned long)device.errors, (unsigned long)device.lastMicros, average,
+                   (unsigned long)device.maxMicros);
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef I2CBUS_H
+#define I2CBUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+// The one owner of Wire, shared by the OLED and the sensors.
+//   - begin() is the only Wire.begin(); devices never touch pins or the clock themselves
+//   - each device is registered with its maximum clock, the bus switches to it (only when it
+//     differs) at the start of every transaction; unknown addresses run at DEFAULT_CLOCK
+//   - transactions are serialized by a recursive mutex, so tasks can share the bus and a device
+//     can group several transfers (write + repeated-start read) between lock() and unlock()
+//   - per device: transactions, errors, last/max/average time, counted once per outermost lock
+//   - an optional TCA9548A multiplexer: lock(address, channel) selects the channel first (only
+//     when it differs from the last one), so devices with the same address sit on different
+//     channels. Devices on the main bus pass NO_CHANNEL and see any selection. Stats are per
+//     address, summed over channels.
+class I2CBus {
+public:
+    static const uint8_t MAX_DEVICES = 8;
+    static const uint32_t DEFAULT_CLOCK = 100000;
+    static const uint8_t ADDRESS_NONE = 0xFF;
+    static const uint8_t NO_CHANNEL = 0xFF;
+    static const uint8_t MUX_CHANNELS = 8;
+    static const uint32_t MUX_CLOCK = 400000;
+    
+    struct DeviceStats {
+        uint8_t address;
+        const char* name;
+        uint32_t maxClock;
+        uint32_t transactions;
+        uint32_t errors;
+        uint32_t lastMicros;
+        uint32_t maxMicros;
+        uint64_t totalMicros;
+    };
+    
+    I2CBus(TwoWire& wire = Wire);
+    
+    bool begin(int sdaPin = -1, int sclPin = -1);
+    bool addDevice(uint8_t address, const char* name, uint32_t maxClock);  // Again = update the clock
+    
+    bool addMux(uint8_t address);                                           // TCA9548A, false when it does not answer
+    bool hasMux() const;
+    uint8_t getMuxAddress() const;
+    
+    // Raw access for drivers that drive Wire themselves (Adafruit_SSD1306): hold the lock meanwhile.
+    // lock() is false when the channel could not be selected; unlock() is due either way
+    bool lock(uint8_t address, uint8_t channel = NO_CHANNEL);
+    void unlock(bool ok = true);
+    TwoWire& getWire();
+    
+    bool probe(uint8_t address);                                            // Address-only write, ACK = present
+    bool write(uint8_t address, const uint8_t* data, size_t length, bool stop = true);
+    bool read(uint8_t address, uint8_t* data, size_t length);               // false on NACK or short read
+    
+    uint32_t getClock() const;
+    uint32_t getClockChanges() const;
+    uint32_t getChannelSwitches() const;
+    const DeviceStats* getStats(uint8_t address) const;
+    void printStats(Print& out) const;
+
+private:
+    TwoWire& wire;
+    SemaphoreHandle_t mutex;
+    uint32_t clock;
+    uint32_t clockChanges;
+    
+    DeviceStats devices[MAX_DEVICES];
+    uint8_t deviceCount;
+    DeviceStats unknown;            // Probes and transfers to unregistered addresses
+    
+    uint8_t muxAddress;             // ADDRESS_NONE without a multiplexer
+    uint8_t muxChannel;             // Selected channel, NO_CHANNEL = none or unknown
+    uint32_t channelSwitches;
+    
+    // Outermost transaction
+    uint8_t depth;
+    DeviceStats* current;
+    unsigned long startMicros;
+    bool currentOk;
+    
+    DeviceStats* findDevice(uint8_t address);
+    bool selectChannel(uint8_t channel);
+};
+
+#endif
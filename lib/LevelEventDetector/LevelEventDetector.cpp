@@ -0,0 +1,134 @@
+#include "LevelEventDetector.h"
+
+LevelEventDetector::LevelEventDetector() {
+    drift = DEFAULT_DRIFT;
+    threshold = DEFAULT_THRESHOLD;
+    minStep = DEFAULT_MIN_STEP;
+    eventCount = 0;
+    droppedEvents = 0;
+    hasPending = false;
+    reset();
+}
+
+void LevelEventDetector::configure(uint16_t newDrift, uint16_t newThreshold, uint16_t newMinStep) {
+    drift = newDrift;
+    threshold = newThreshold;
+    minStep = newMinStep;
+    reset();
+}
+
+void LevelEventDetector::reset() {
+    // A pending event survives: it already happened
+    started = false;
+    inStep = false;
+    reference16 = 0;
+    sumUp = 0;
+    sumDown = 0;
+    upOnset = 0;
+    downOnset = 0;
+    upOnsetLevel = 0;
+    downOnsetLevel = 0;
+    stepType = EVENT_REFUEL;
+    stepStart = 0;
+    stepStartLevel = 0;
+    settleLevel = 0;
+    settleSince = 0;
+}
+
+void LevelEventDetector::add(uint16_t level, unsigned long now) {
+    if (!started) {
+        started = true;
+        reference16 = (int32_t)level << 4;
+        return;
+    }
+    
+    if (inStep) {
+        int32_t moved = (int32_t)level - settleLevel;
+        if (moved > SETTLE_BAND || moved < -(int32_t)SETTLE_BAND) {
+            settleLevel = level;
+            settleSince = now;
+        }
+        if (now - settleSince >= MIN_HOLD_MS || now - stepStart >= MAX_EVENT_MS) {
+            finishStep(level);
+        }
+        return;
+    }
+    
+    int32_t reference = (reference16 + 8) >> 4;
+    int32_t deviation = (int32_t)level - reference;
+    
+    // Remember where each sum leaves zero: that is where the step began
+    if (sumUp == 0) {
+        upOnset = now;
+        upOnsetLevel = (uint16_t)reference;
+    }
+    if (sumDown == 0) {
+        downOnset = now;
+        downOnsetLevel = (uint16_t)reference;
+    }
+    sumUp = sumUp + deviation - drift > 0 ? sumUp + deviation - drift : 0;
+    sumDown = sumDown - deviation - drift > 0 ? sumDown - deviation - drift : 0;
+    
+    if (sumUp > threshold || sumDown > threshold) {
+        inStep = true;
+        stepType = sumUp > threshold ? EVENT_REFUEL : EVENT_DRAIN;
+        stepStart = stepType == EVENT_REFUEL ? upOnset : downOnset;
+        stepStartLevel = stepType == EVENT_REFUEL ? upOnsetLevel : downOnsetLevel;
+        settleLevel = level;
+        settleSince = now;
+        return;
+    }
+    
+    // Quiet: let the reference follow slow consumption (1/8 of the gap per sample)
+    if (sumUp == 0 && sumDown == 0) {
+        reference16 += (((int32_t)level << 4) - reference16) / 8;
+    }
+}
+
+void LevelEventDetector::finishStep(uint16_t level) {
+    int32_t delta = (int32_t)settleLevel - stepStartLevel;
+    bool rose = stepType == EVENT_REFUEL;
+    if ((rose && delta >= minStep) || (!rose && -delta >= minStep)) {
+        if (hasPending) {
+            droppedEvents++;
+        }
+        pending.type = stepType;
+        pending.startTime = stepStart;
+        pending.endTime = settleSince;
+        pending.startLevel = stepStartLevel;
+        pending.endLevel = settleLevel;
+        hasPending = true;
+        eventCount++;
+    }
+    
+    // Either way the settled level is the new normal
+    inStep = false;
+    sumUp = 0;
+    sumDown = 0;
+    reference16 = (int32_t)level << 4;
+}
+
+bool LevelEventDetector::isInStep() const {
+    return inStep;
+}
+
+bool LevelEventDetector::takeEvent(Event& event) {
+    if (!hasPending) {
+        return false;
+    }
+    event = pending;
+    hasPending = false;
+    return true;
+}
+
+uint32_t LevelEventDetector::getEventCount() const {
+    return eventCount;
+}
+
+uint32_t LevelEventDetector::getDroppedEvents() const {
+    return droppedEvents;
+}
+
+const char* LevelEventDetector::getTypeName(EventType type) {
+    return type == EVENT_REFUEL ? "REFUEL" : "DRAIN";
+}
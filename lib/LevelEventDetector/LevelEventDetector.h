@@ -0,0 +1,78 @@
+#ifndef LEVELEVENTDETECTOR_H
+#define LEVELEVENTDETECTOR_H
+
+#include <Arduino.h>
+
+// Finds sudden level changes (refuelling, siphoning, a burst line) in one probe's level stream.
+// Two-sided CUSUM against a reference level that follows normal consumption while nothing
+// happens: deviations beyond `drift` per sample accumulate, and a sum above `threshold` starts a
+// step at the sample where the sum last left zero. The step ends once the level has held within
+// SETTLE_BAND for MIN_HOLD_MS; it is reported if it moved at least `minStep` units.
+// Timestamps are the millis() passed to add(), so any sampling rate works. Constant memory:
+// one pending event, the newest replaces one not yet taken.
+class LevelEventDetector {
+public:
+    enum EventType {
+        EVENT_REFUEL = 0,
+        EVENT_DRAIN
+    };
+    
+    struct Event {
+        EventType type;
+        unsigned long startTime;   // millis() the level started to move
+        unsigned long endTime;     // millis() it settled
+        uint16_t startLevel;       // Sensor units
+        uint16_t endLevel;
+    };
+    
+    static const uint16_t DEFAULT_DRIFT = 3;           // Units per sample taken as noise/consumption
+    static const uint16_t DEFAULT_THRESHOLD = 60;      // CUSUM alarm level, units
+    static const uint16_t DEFAULT_MIN_STEP = 50;       // Smallest reported change, units (5 L at 0.1 L/unit)
+    static const uint16_t SETTLE_BAND = 6;             // Units the new level may wander while settling
+    static const unsigned long MIN_HOLD_MS = 30000;    // New level must hold this long
+    static const unsigned long MAX_EVENT_MS = 1800000; // A step still moving after 30 min is closed anyway
+    
+    LevelEventDetector();
+    
+    void configure(uint16_t drift, uint16_t threshold, uint16_t minStep);
+    void reset();
+    void add(uint16_t level, unsigned long now);
+    
+    bool isInStep() const;                  // A change is in progress
+    bool takeEvent(Event& event);           // Oldest untaken event, false when none
+    uint32_t getEventCount() const;         // Events reported since boot
+    uint32_t getDroppedEvents() const;      // Replaced before they were taken
+    
+    static const char* getTypeName(EventType type);   // "REFUEL", "DRAIN"
+
+private:
+    uint16_t drift;
+    uint16_t threshold;
+    uint16_t minStep;
+    
+    bool started;
+    bool inStep;
+    int32_t reference16;        // Reference level, 1/16 units
+    int32_t sumUp;              // CUSUM of rises
+    int32_t sumDown;            // CUSUM of falls
+    unsigned long upOnset;      // Sample where sumUp last left zero
+    unsigned long downOnset;
+    uint16_t upOnsetLevel;
+    uint16_t downOnsetLevel;
+    
+    // Step in progress
+    EventType stepType;
+    unsigned long stepStart;
+    uint16_t stepStartLevel;
+    uint16_t settleLevel;
+    unsigned long settleSince;
+    
+    Event pending;
+    bool hasPending;
+    uint32_t eventCount;
+    uint32_t droppedEvents;
+    
+    void finishStep(uint16_t level);
+};
+
+#endif
@@ -0,0 +1,156 @@
+#include "LevelFilter.h"
+
+LevelFilter::LevelFilter() {
+    medianWindow = DEFAULT_MEDIAN_WINDOW;
+    processNoise = DEFAULT_PROCESS_NOISE;
+    measurementNoise = DEFAULT_MEASUREMENT_NOISE;
+    sloshVariance = DEFAULT_SLOSH_VARIANCE;
+    reset();
+}
+
+void LevelFilter::setMedianWindow(uint8_t window) {
+    if (window < 1) window = 1;
+    if (window > MAX_MEDIAN_WINDOW) window = MAX_MEDIAN_WINDOW;
+    if ((window & 1) == 0) window--;
+    if (window != medianWindow) {
+        medianWindow = window;
+        reset();
+    }
+}
+
+uint8_t LevelFilter::getMedianWindow() const {
+    return medianWindow;
+}
+
+void LevelFilter::setNoise(uint32_t process, uint32_t measurement) {
+    processNoise = process;
+    measurementNoise = measurement > 0 ? measurement : 1;
+}
+
+void LevelFilter::setSloshThreshold(uint32_t variance) {
+    sloshVariance = variance;
+}
+
+void LevelFilter::reset() {
+    memset(history, 0, sizeof(history));
+    historyHead = 0;
+    historyCount = 0;
+    sortedCount = 0;
+    sum = 0;
+    sumSquares = 0;
+    estimate = 0;
+    estimateVariance = 0;
+    sloshing = false;
+    lastRaw = 0;
+    median = 0;
+    sampleCount = 0;
+}
+
+// Index of the first entry >= value
+int LevelFilter::findSorted(uint16_t value) const {
+    int low = 0;
+    int high = sortedCount;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (sorted[mid] < value) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+void LevelFilter::updateMedian(uint16_t raw, bool windowFull, uint16_t leaving) {
+    if (windowFull) {
+        int index = findSorted(leaving);
+        memmove(&sorted[index], &sorted[index + 1], (sortedCount - index - 1) * sizeof(sorted[0]));
+        sortedCount--;
+    }
+    int index = findSorted(raw);
+    memmove(&sorted[index + 1], &sorted[index], (sortedCount - index) * sizeof(sorted[0]));
+    sorted[index] = raw;
+    sortedCount++;
+    median = sorted[(sortedCount - 1) / 2];
+}
+
+void LevelFilter::add(uint16_t raw) {
+    // The reading that drops out of the median window, before the ring moves on
+    bool windowFull = sortedCount >= medianWindow;
+    uint16_t leaving = history[(historyHead + HISTORY_SIZE - medianWindow) % HISTORY_SIZE];
+    
+    if (historyCount == HISTORY_SIZE) {
+        uint16_t oldest = history[historyHead];
+        sum -= oldest;
+        sumSquares -= (uint64_t)oldest * oldest;
+    } else {
+        historyCount++;
+    }
+    history[historyHead] = raw;
+    historyHead = (historyHead + 1) % HISTORY_SIZE;
+    sum += raw;
+    sumSquares += (uint64_t)raw * raw;
+    lastRaw = raw;
+    sampleCount++;
+    
+    updateMedian(raw, windowFull, leaving);
+    
+    // Slosh: enter above the threshold, leave below 3/4 of it
+    uint32_t variance = getVariance();
+    if (!sloshing && historyCount >= HISTORY_SIZE / 2 && variance > sloshVariance) {
+        sloshing = true;
+    } else if (sloshing && variance < sloshVariance - sloshVariance / 4) {
+        sloshing = false;
+    }
+    
+    int32_t measured = (int32_t)median << STATE_SHIFT;
+    if (sampleCount == 1) {
+        estimate = measured;
+        estimateVariance = measurementNoise;
+        return;
+    }
+    
+    // Predict (level constant, plus process noise), then correct with gain k = p / (p + r), k in 1/65536
+    uint64_t predicted = (uint64_t)estimateVariance + processNoise;
+    uint64_t noise = sloshing ? (uint64_t)measurementNoise * SLOSH_NOISE_SCALE : measurementNoise;
+    uint32_t gain = (uint32_t)((predicted << 16) / (predicted + noise));
+    estimate += (int32_t)((int64_t)gain * (measured - estimate) / 65536);
+    estimateVariance = (uint32_t)(predicted * (65536 - gain) >> 16);
+}
+
+bool LevelFilter::isValid() const {
+    return sampleCount > 0;
+}
+
+uint16_t LevelFilter::getRaw() const {
+    return lastRaw;
+}
+
+uint16_t LevelFilter::getMedian() const {
+    return median;
+}
+
+uint16_t LevelFilter::getLevel() const {
+    int32_t level = (estimate + (1 << (STATE_SHIFT - 1))) >> STATE_SHIFT;
+    if (level < 0) level = 0;
+    if (level > 0xFFFF) level = 0xFFFF;
+    return (uint16_t)level;
+}
+
+uint32_t LevelFilter::getVariance() const {
+    if (historyCount < 2) {
+        return 0;
+    }
+    // n * sum(x^2) - sum(x)^2 exceeds 32 bits for 16 readings near 4095
+    uint64_t n = historyCount;
+    uint64_t spread = n * sumSquares - (uint64_t)sum * sum;
+    return (uint32_t)(spread / (n * n));
+}
+
+bool LevelFilter::isSloshing() const {
+    return sloshing;
+}
+
+uint32_t LevelFilter::getSampleCount() const {
+    return sampleCount;
+}
@@ -0,0 +1,70 @@
+#ifndef LEVELFILTER_H
+#define LEVELFILTER_H
+
+#include <Arduino.h>
+
+// Smooths the level of one probe, sample by sample, in integer math:
+//   1. sliding median over the last medianWindow readings: drops single-frame spikes
+//   2. scalar Kalman filter (constant level + process noise): the displayed value
+//   3. slosh detector: variance of the last HISTORY_SIZE raw readings; above the threshold
+//      (with hysteresis) the tank is moving, the Kalman filter trusts readings SLOSH_NOISE_SCALE
+//      times less and consumers should hold alarms
+// Each add() costs a binary search and a short memmove in the sorted median window plus a few
+// multiplies, independent of the sample rate. Raw and filtered values are both kept.
+class LevelFilter {
+public:
+    static const uint8_t HISTORY_SIZE = 16;         // Readings kept for the median and the variance
+    static const uint8_t MAX_MEDIAN_WINDOW = 15;
+    static const uint8_t DEFAULT_MEDIAN_WINDOW = 5;
+    static const uint32_t DEFAULT_PROCESS_NOISE = 128;      // units^2 * 256 per sample (0.5)
+    static const uint32_t DEFAULT_MEASUREMENT_NOISE = 4096; // units^2 * 256 (16, i.e. +-4 units)
+    static const uint32_t DEFAULT_SLOSH_VARIANCE = 400;     // units^2 (20 units standard deviation)
+    static const uint8_t SLOSH_NOISE_SCALE = 16;
+    
+    LevelFilter();
+    
+    // Odd window, 1 = off; out of range values are clamped. Changing it restarts the filter.
+    void setMedianWindow(uint8_t window);
+    uint8_t getMedianWindow() const;
+    void setNoise(uint32_t processNoise, uint32_t measurementNoise);   // Both in units^2 * 256
+    void setSloshThreshold(uint32_t variance);                         // units^2; leaves at 3/4 of it
+    
+    void reset();
+    void add(uint16_t raw);
+    
+    bool isValid() const;               // At least one reading since reset()
+    uint16_t getRaw() const;            // Last reading as received
+    uint16_t getMedian() const;         // Output of the median stage
+    uint16_t getLevel() const;          // Filtered level, rounded to sensor units
+    uint32_t getVariance() const;       // units^2 over the last HISTORY_SIZE readings
+    bool isSloshing() const;
+    uint32_t getSampleCount() const;
+
+private:
+    static const int STATE_SHIFT = 8;   // Kalman state and variances kept in 1/256
+    
+    uint8_t medianWindow;
+    uint32_t processNoise;
+    uint32_t measurementNoise;
+    uint32_t sloshVariance;
+    
+    uint16_t history[HISTORY_SIZE];     // Ring, oldest overwritten
+    uint8_t historyHead;
+    uint8_t historyCount;
+    uint16_t sorted[MAX_MEDIAN_WINDOW]; // Last medianWindow readings, ascending
+    uint8_t sortedCount;
+    uint32_t sum;                       // Of the readings in history
+    uint64_t sumSquares;
+    
+    int32_t estimate;                   // Level * 256
+    uint32_t estimateVariance;          // units^2 * 256
+    bool sloshing;
+    uint16_t lastRaw;
+    uint16_t median;
+    uint32_t sampleCount;
+    
+    void updateMedian(uint16_t raw, bool windowFull, uint16_t leaving);
+    int findSorted(uint16_t value) const;
+};
+
+#endif
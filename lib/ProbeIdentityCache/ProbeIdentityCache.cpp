@@ -0,0 +1,133 @@
+#include "ProbeIdentityCache.h"
+
+ProbeIdentityCache::ProbeIdentityCache() {
+    ready = false;
+    entryCount = 0;
+    memset(serials, 0, sizeof(serials));
+}
+
+bool ProbeIdentityCache::begin(const char* name) {
+    ready = prefs.begin(name, false);
+    if (!ready) {
+        Serial.println("Probe identity cache: NVS not available");
+        return false;
+    }
+    
+    size_t length = prefs.getBytesLength("index");
+    if (length > sizeof(serials) || length % sizeof(uint32_t) != 0) {
+        // Written by another layout: start over rather than trust it
+        prefs.clear();
+        length = 0;
+    }
+    entryCount = length > 0 ? prefs.getBytes("index", serials, length) / sizeof(uint32_t) : 0;
+    
+    Serial.printf("Probe identity cache: %d entries\n", entryCount);
+    return true;
+}
+
+bool ProbeIdentityCache::isReady() const {
+    return ready;
+}
+
+void ProbeIdentityCache::makeKey(uint32_t serialNumber, char* key) {
+    snprintf(key, 16, "p%08lX", (unsigned long)serialNumber);
+}
+
+int ProbeIdentityCache::findSerial(uint32_t serialNumber) const {
+    for (int i = 0; i < entryCount; i++) {
+        if (serials[i] == serialNumber) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void ProbeIdentityCache::saveIndex() {
+    prefs.putBytes("index", serials, entryCount * sizeof(uint32_t));
+}
+
+bool ProbeIdentityCache::lookup(uint32_t serialNumber, Entry& entry) {
+    if (!ready || findSerial(serialNumber) < 0) {
+        return false;
+    }
+    
+    char key[16];
+    makeKey(serialNumber, key);
+    StoredEntry stored;
+    if (prefs.getBytes(key, &stored, sizeof(stored)) != sizeof(stored) ||
+        stored.version != FORMAT_VERSION || stored.entry.serialNumber != serialNumber ||
+        stored.entry.firmwareVersionLength > FIRMWARE_SIZE) {
+        return false;
+    }
+    
+    entry = stored.entry;
+    return true;
+}
+
+bool ProbeIdentityCache::store(const Entry& entry) {
+    if (!ready) {
+        return false;
+    }
+    
+    StoredEntry stored;
+    memset(&stored, 0, sizeof(stored));   // Padding bytes too, so equal entries compare equal
+    stored.version = FORMAT_VERSION;
+    stored.entry.serialNumber = entry.serialNumber;
+    stored.entry.firmwareVersionLength = min(entry.firmwareVersionLength, (uint8_t)FIRMWARE_SIZE);
+    memcpy(stored.entry.firmwareVersion, entry.firmwareVersion, stored.entry.firmwareVersionLength);
+    stored.entry.limitsValid = entry.limitsValid;
+    if (entry.limitsValid) {
+        stored.entry.levelMax = entry.levelMax;
+        stored.entry.levelMin = entry.levelMin;
+    }
+    
+    char key[16];
+    makeKey(entry.serialNumber, key);
+    
+    int index = findSerial(entry.serialNumber);
+    if (index >= 0) {
+        // Unchanged data is the common case on every reconnect: spare the flash
+        StoredEntry current;
+        if (prefs.getBytes(key, &current, sizeof(current)) == sizeof(current) &&
+            memcmp(&current, &stored, sizeof(stored)) == 0) {
+            return true;
+        }
+    } else {
+        if (entryCount >= MAX_ENTRIES) {
+            char oldKey[16];
+            makeKey(serials[0], oldKey);
+            prefs.remove(oldKey);
+            memmove(serials, serials + 1, (MAX_ENTRIES - 1) * sizeof(uint32_t));
+            entryCount--;
+        }
+        serials[entryCount++] = entry.serialNumber;
+        saveIndex();
+    }
+    
+    if (prefs.putBytes(key, &stored, sizeof(stored)) != sizeof(stored)) {
+        Serial.printf("Probe identity cache: write failed for %lu\n", (unsigned long)entry.serialNumber);
+        return false;
+    }
+    Serial.printf("Probe identity cache: saved %lu\n", (unsigned long)entry.serialNumber);
+    return true;
+}
+
+bool ProbeIdentityCache::invalidateLimits(uint32_t serialNumber) {
+    Entry entry;
+    if (!lookup(serialNumber, entry) || !entry.limitsValid) {
+        return false;
+    }
+    entry.limitsValid = false;
+    return store(entry);
+}
+
+void ProbeIdentityCache::clear() {
+    if (ready) {
+        prefs.clear();
+    }
+    entryCount = 0;
+}
+
+int ProbeIdentityCache::getEntryCount() const {
+    return entryCount;
+}
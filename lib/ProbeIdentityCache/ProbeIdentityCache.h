@@ -0,0 +1,54 @@
+#ifndef PROBEIDENTITYCACHE_H
+#define PROBEIDENTITYCACHE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+// Static AoooG probe data (firmware version, limits) kept in NVS, keyed by serial number.
+// A probe seen before is known as soon as its serial number is read, without asking it for
+// firmware (0x1C) and limits (0x07) again. Flash is only written when an entry changes.
+class ProbeIdentityCache {
+public:
+    static const int MAX_ENTRIES = 16;          // Oldest entry is dropped first
+    static const int FIRMWARE_SIZE = 32;
+    
+    struct Entry {
+        uint32_t serialNumber;
+        uint8_t firmwareVersion[FIRMWARE_SIZE];
+        uint8_t firmwareVersionLength;          // 0 = not known
+        bool limitsValid;
+        uint16_t levelMax;
+        uint16_t levelMin;
+    };
+    
+    ProbeIdentityCache();
+    
+    bool begin(const char* name = "fuelprobes");  // NVS namespace, max 15 chars
+    bool isReady() const;
+    
+    bool lookup(uint32_t serialNumber, Entry& entry);
+    bool store(const Entry& entry);
+    bool invalidateLimits(uint32_t serialNumber); // After a calibration command
+    void clear();
+    
+    int getEntryCount() const;
+
+private:
+    static const uint8_t FORMAT_VERSION = 1;
+    
+    struct StoredEntry {
+        uint8_t version;
+        Entry entry;
+    };
+    
+    Preferences prefs;
+    bool ready;
+    uint32_t serials[MAX_ENTRIES];   // Oldest first, mirrors the "index" blob
+    int entryCount;
+    
+    int findSerial(uint32_t serialNumber) const;
+    void saveIndex();
+    static void makeKey(uint32_t serialNumber, char* key);
+};
+
+#endif
@@ -0,0 +1,230 @@
+#include "SHTRegistry.h"
+
+SHTRegistry::SHTRegistry() {
+    bus = nullptr;
+    count = 0;
+    probeCount = 0;
+    lostMask = 0;
+    repeatability = SHTSensor::REPEATABILITY_HIGH;
+    periodicRate = -1;
+}
+
+void SHTRegistry::begin(I2CBus& i2cBus) {
+    bus = &i2cBus;
+}
+
+bool SHTRegistry::addCandidate(uint8_t address, uint8_t channel) {
+    if (count >= MAX_SENSORS) {
+        return false;
+    }
+    Entry& entry = entries[count++];
+    entry.sensor = SHTSensor(address, channel);
+    entry.probe = CircuitBreaker(1, PROBE_BASE_MS, PROBE_MAX_MS);
+    entry.present = false;
+    entry.pending = false;
+    entry.valid = false;
+    entry.misses = 0;
+    return true;
+}
+
+SHTSensor* SHTRegistry::poll(unsigned long now) {
+    if (bus == nullptr) {
+        return nullptr;
+    }
+    for (int i = 0; i < count; i++) {
+        Entry& entry = entries[i];
+        if (entry.present || !entry.probe.allowRequest(now)) {
+            continue;
+        }
+        probeCount++;
+        if (entry.sensor.begin(*bus)) {    // Its first command doubles as the probe
+            entry.probe.recordSuccess(now);
+            entry.present = true;
+            entry.misses = 0;
+            return &entry.sensor;
+        }
+        entry.probe.recordFailure(now);
+    }
+    return nullptr;
+}
+
+bool SHTRegistry::recordResult(SHTSensor* sensor, bool ok) {
+    int index = indexOf(sensor);
+    if (index < 0 || !entries[index].present) {
+        return false;
+    }
+    Entry& entry = entries[index];
+    if (ok) {
+        entry.misses = 0;
+        return false;
+    }
+    if (++entry.misses < MISSES_TO_LOSE) {
+        return false;
+    }
+    // Gone: look for it again from the shortest backoff
+    entry.present = false;
+    entry.pending = false;
+    entry.valid = false;
+    entry.misses = 0;
+    entry.sensor.cancel();
+    entry.probe.reset();
+    lostMask |= 1UL << index;
+    return true;
+}
+
+int SHTRegistry::takeLost() {
+    for (int i = 0; i < count; i++) {
+        if (lostMask & (1UL << i)) {
+            lostMask &= ~(1UL << i);
+            return i;
+        }
+    }
+    return -1;
+}
+
+void SHTRegistry::setMode(SHTSensor::Repeatability newRepeatability, int newPeriodicRate) {
+    // Applied per sensor at its next start, never under a pending measurement
+    repeatability = newRepeatability;
+    periodicRate = newPeriodicRate;
+}
+
+bool SHTRegistry::startSensor(Entry& entry, unsigned long now) {
+    SHTSensor& sensor = entry.sensor;
+    if (periodicRate >= 0) {
+        if (sensor.isPeriodic() && sensor.getRate() == periodicRate && sensor.getRepeatability() == repeatability) {
+            return true;    // Free-running: its next result is fetched when ready
+        }
+        sensor.setRepeatability(repeatability);
+        return sensor.startPeriodic((SHTSensor::Rate)periodicRate, now);
+    }
+    if (sensor.isPeriodic()) {
+        sensor.stopPeriodic();
+    }
+    sensor.setRepeatability(repeatability);
+    return sensor.startMeasurement(now);
+}
+
+int SHTRegistry::startSweep(unsigned long now) {
+    // Start every conversion first: they run in parallel while the next sensor is addressed
+    int started = 0;
+    for (int i = 0; i < count; i++) {
+        Entry& entry = entries[i];
+        entry.pending = false;
+        if (!entry.present) {
+            continue;
+        }
+        if (startSensor(entry, now)) {
+            entry.pending = true;   // Keeps its last reading until fetched
+            started++;
+        } else {
+            entry.valid = false;
+            recordResult(&entry.sensor, false);
+        }
+    }
+    return started;
+}
+
+bool SHTRegistry::updateSweep(unsigned long now) {
+    bool pending = false;
+    for (int i = 0; i < count; i++) {
+        Entry& entry = entries[i];
+        if (!entry.pending) {
+            continue;
+        }
+        if (!entry.sensor.isReady(now)) {
+            pending = true;
+            continue;
+        }
+        bool ok = entry.sensor.fetch();
+        if (!ok && entry.sensor.wasNotReady()) {
+            pending = true;     // Periodic result not there yet: fetch again shortly
+            continue;
+        }
+        entry.pending = false;
+        entry.valid = ok;
+        recordResult(&entry.sensor, ok);
+    }
+    return !pending;
+}
+
+bool SHTRegistry::isSweeping() const {
+    for (int i = 0; i < count; i++) {
+        if (entries[i].pending) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SHTRegistry::hasReading(int index) const {
+    return isPresent(index) && entries[index].valid;
+}
+int SHTRegistry::indexOf(const SHTSensor* sensor) const {
+    for (int i = 0; i < count; i++) {
+        if (&entries[i].sensor == sensor) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+SHTSensor* SHTRegistry::getActive() {
+    for (int i = 0; i < count; i++) {
+        if (entries[i].present) {
+            return &entries[i].sensor;
+        }
+    }
+    return nullptr;
+}
+
+int SHTRegistry::getCount() const {
+    return count;
+}
+
+int SHTRegistry::getPresentCount() const {
+    int present = 0;
+    for (int i = 0; i < count; i++) {
+        if (entries[i].present) {
+            present++;
+        }
+    }
+    return present;
+}
+
+SHTSensor* SHTRegistry::getSensor(int index) {
+    return index >= 0 && index < count ? &entries[index].sensor : nullptr;
+}
+
+bool SHTRegistry::isPresent(int index) const {
+    return index >= 0 && index < count && entries[index].present;
+}
+
+int SHTRegistry::getPresentIndex(int n) const {
+    for (int i = 0; i < count; i++) {
+        if (entries[i].present && n-- == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+uint32_t SHTRegistry::getProbesSent() const {
+    return probeCount;
+}
+
+void SHTRegistry::printStatus(Print& out, unsigned long now) const {
+    out.printf("SHT: %d/%d present, %lu probes\n", getPresentCount(), count, (unsigned long)probeCount);
+    for (int i = 0; i < count; i++) {
+        const Entry& entry = entries[i];
+        char where[8] = "";
+        if (entry.sensor.getChannel() != I2CBus::NO_CHANNEL) {
+            snprintf(where, sizeof(where), "c%u ", entry.sensor.getChannel());
+        }
+        if (entry.present) {
+            out.printf("  %s0x%02X present, misses %u\n", where, entry.sensor.getAddress(), entry.misses);
+        } else {
+            out.printf("  %s0x%02X absent, next probe in %lu ms\n", where, entry.sensor.getAddress(),
+                       entry.probe.getRetryIn(now));
+        }
+    }
+}
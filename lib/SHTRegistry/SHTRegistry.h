@@ -0,0 +1,76 @@
+#ifndef SHTREGISTRY_H
+#define SHTREGISTRY_H
+
+#include <Arduino.h>
+#include <I2CBus.h>
+#include <SHTSensor.h>
+#include <CircuitBreaker.h>
+
+// The SHT sensors that may sit on the bus, found and lost without idle traffic.
+//   - a present sensor is never probed: the owner reports each measurement with recordResult(),
+//     MISSES_TO_LOSE failed transactions in a row (command or read NACKed by the address) and
+//     it is gone. A periodic "no new result" NACK is not a miss.
+//   - an absent candidate address is probed only when its CircuitBreaker allows it: at once,
+//     then PROBE_BASE_MS doubling to PROBE_MAX_MS while nothing answers. A sensor that answers
+//     is begin()'d and present again.
+//   - the active sensor is the first present one, in the order the candidates were added.
+//   - candidates may sit behind the bus's TCA9548A (channel) as well as on the trunk. Add them
+//     in channel order so a sweep selects each channel once per phase.
+//   - a sweep measures every present sensor at once: startSweep() starts all conversions, then
+//     updateSweep() fetches each as it becomes ready, so N sensors take about one conversion
+//     time plus N short reads rather than N conversion times.
+class SHTRegistry {
+public:
+    static const uint8_t MAX_SENSORS = 16;
+    static const uint8_t MISSES_TO_LOSE = 2;
+    static const unsigned long PROBE_BASE_MS = 1000;
+    static const unsigned long PROBE_MAX_MS = 30000;
+    
+    SHTRegistry();
+    
+    void begin(I2CBus& bus);
+    bool addCandidate(uint8_t address, uint8_t channel = I2CBus::NO_CHANNEL);
+    
+    SHTSensor* poll(unsigned long now);                 // Probe due absent addresses; the first found, or nullptr
+    bool recordResult(SHTSensor* sensor, bool ok);      // true when this miss lost the sensor
+    int takeLost();                                     // Index of a sensor lost since the last call, or -1
+    
+    // Sweep: one measurement of every present sensor
+    void setMode(SHTSensor::Repeatability repeatability, int periodicRate); // periodicRate -1 = single shot
+    int startSweep(unsigned long now);                  // Sensors now measuring
+    bool updateSweep(unsigned long now);                // Fetch ready sensors; true once none is pending
+    bool isSweeping() const;
+    bool hasReading(int index) const;                   // Last sweep read this sensor
+    
+    SHTSensor* getActive();                             // First present sensor, nullptr when none
+    int getCount() const;                               // Candidates
+    int getPresentCount() const;
+    SHTSensor* getSensor(int index);
+    bool isPresent(int index) const;
+    int getPresentIndex(int n) const;                   // Index of the n-th present sensor, or -1
+    uint32_t getProbesSent() const;                     // Probes sent since begin
+    void printStatus(Print& out, unsigned long now) const;
+
+private:
+    struct Entry {
+        SHTSensor sensor;
+        CircuitBreaker probe;
+        bool present;
+        bool pending;                                   // Measuring in the current sweep
+        bool valid;                                     // Read by the last sweep
+        uint8_t misses;
+    };
+    
+    I2CBus* bus;
+    Entry entries[MAX_SENSORS];
+    int count;
+    uint32_t probeCount;
+    uint32_t lostMask;
+    SHTSensor::Repeatability repeatability;
+    int periodicRate;
+    
+    bool startSensor(Entry& entry, unsigned long now);
+    int indexOf(const SHTSensor* sensor) const;
+};
+
+#endif
@@ -1,76 +1,189 @@
 #include "SHTSensor.h"
+#include <CRC8.h>
 
-SHTSensor::SHTSensor(uint8_t address) {
+typedef CRC8<0x31, 0xFF, false, CRC8_NIBBLE> SHTCrc8;
+
+// Datasheet example: CRC of 0xBEEF is 0x92
+static_assert(SHTCrc8::compute(std::array<uint8_t, 2>{0xBE, 0xEF}) == 0x92, "SHT3x CRC");
+
+// Single shot, clock stretching disabled, by repeatability: command and maximum conversion
+// time (datasheet 4.5 / 6.5 / 15.5 ms, rounded up to whole ms)
+static const uint16_t MEASURE_COMMANDS[] = {0x2416, 0x240B, 0x2400};
+static const uint8_t CONVERSION_MS[] = {5, 7, 16};
+
+// Periodic mode by rate, then repeatability (low, medium, high); ART has a single command
+static const uint16_t PERIODIC_COMMANDS[][3] = {
+    {0x202F, 0x2024, 0x2032},   // 0.5 mps
+    {0x212D, 0x2126, 0x2130},   // 1 mps
+    {0x222B, 0x2220, 0x2236},   // 2 mps
+    {0x2329, 0x2322, 0x2334},   // 4 mps
+    {0x272A, 0x2721, 0x2737},   // 10 mps
+};
+static const uint16_t ART_COMMAND = 0x2B32;
+static const uint16_t FETCH_COMMAND = 0xE000;
+static const uint16_t BREAK_COMMAND = 0x3093;           // Back to single shot, takes 1 ms
+static const uint16_t HEATER_ON_COMMAND = 0x306D;
+static const uint16_t HEATER_OFF_COMMAND = 0x3066;
+static const uint16_t READ_STATUS_COMMAND = 0xF32D;
+static const uint16_t CLEAR_STATUS_COMMAND = 0x3041;
+static const unsigned long PERIOD_MS[] = {2000, 1000, 500, 250, 100, 250};
+static const char* RATE_NAMES[] = {"0.5", "1", "2", "4", "10", "ART"};
+static const unsigned long NOT_READY_RETRY_MS = 10;     // Poll again after a NACKed fetch
+static const uint8_t STALL_PERIODS = 3;                 // Periods without a result before resending the mode
+
+SHTSensor::SHTSensor(uint8_t address, uint8_t channel) {
+    _bus = nullptr;
     _address = address;
-    _temperature = 0.0;
-    _humidity = 0.0;
+    _channel = channel;
+    _temperature = Centi::fromRaw(0);
+    _humidity = Centi::fromRaw(0);
     _lastReadSuccess = false;
+    _repeatability = REPEATABILITY_HIGH;
+    _measuring = false;
+    _measureStart = 0;
+    _measureTime = 0;
+    _periodic = false;
+    _rate = RATE_1_MPS;
+    _notReady = false;
+    _lastResult = 0;
+    _restarts = 0;
 }
 
-bool SHTSensor::begin(int sda_pin, int scl_pin) {
-    if (sda_pin != -1 && scl_pin != -1) {
-        Wire.begin(sda_pin, scl_pin);
-    } else {
-        Wire.begin();
-    }
-    
-    Wire.setClock(100000); // 100kHz I2C clock
+bool SHTSensor::begin(I2CBus& bus) {
+    _bus = &bus;
+    _bus->addDevice(_address, "SHT", I2C_CLOCK);
     
     // Test connection
-    Wire.beginTransmission(_address);
-    return (Wire.endTransmission() == 0);
+    _measuring = false;
+    _periodic = false;
+    if (!sendCommand(BREAK_COMMAND)) {
+        return false;
+    }
+    delay(1); // A sensor left in periodic mode (warm restart) is back to single shot
+    return true;
 }
 
-bool SHTSensor::sendCommand(uint16_t command) {
-    Wire.beginTransmission(_address);
-    Wire.write(command >> 8);   // MSB
-    Wire.write(command & 0xFF); // LSB
-    return (Wire.endTransmission() == 0);
+bool SHTSensor::sendCommand(uint16_t command, bool stop) {
+    if (_bus == nullptr) {
+        return false;
+    }
+    uint8_t data[2] = {(uint8_t)(command >> 8), (uint8_t)(command & 0xFF)}; // MSB first
+    bool ok = _bus->lock(_address, _channel) && _bus->write(_address, data, sizeof(data), stop);
+    _bus->unlock(ok);
+    return ok;
 }
 
 uint8_t SHTSensor::calculateCRC(uint8_t data1, uint8_t data2) {
-    uint8_t crc = 0xFF;
+    // Poly 0x31, init 0xFF. Only 2 bytes per word behind a 100kHz I2C read,
+    // so the 16-byte nibble table is enough
     uint8_t data[2] = {data1, data2};
-    
-    for (int i = 0; i < 2; i++) {
-        crc ^= data[i];
-        for (int bit = 8; bit > 0; --bit) {
-            if (crc & 0x80) {
-                crc = (crc << 1) ^ 0x31;
-            } else {
-                crc = (crc << 1);
-            }
-        }
+    return SHTCrc8::compute(data, 2);
+}
+
+void SHTSensor::setRepeatability(Repeatability repeatability) {
+    _repeatability = repeatability;
+}
+
+SHTSensor::Repeatability SHTSensor::getRepeatability() const {
+    return _repeatability;
+}
+
+unsigned long SHTSensor::getConversionTime() const {
+    return CONVERSION_MS[_repeatability];
+}
+
+bool SHTSensor::startMeasurement(unsigned long now) {
+    if (_periodic) {
+        stopPeriodic();
+    }
+    _measuring = sendCommand(MEASURE_COMMANDS[_repeatability]);
+    _measureStart = now;
+    _measureTime = getConversionTime();
+    if (!_measuring) {
+        _lastReadSuccess = false;
     }
-    return crc;
+    return _measuring;
+}
+
+bool SHTSensor::isMeasuring() const {
+    return _measuring;
+}
+
+bool SHTSensor::isReady(unsigned long now) const {
+    return (_measuring || _periodic) && now - _measureStart >= _measureTime;
+}
+
+void SHTSensor::cancel() {
+    _measuring = false;
 }
 
 bool SHTSensor::readData() {
-    // Send measurement command (high repeatability)
-    if (!sendCommand(0x2400)) {
-        _lastReadSuccess = false;
+    if (!startMeasurement(millis())) {
+        return false;
+    }
+    delay(getConversionTime());
+    return fetch();
+}
+
+bool SHTSensor::fetch() {
+    _notReady = false;
+    if (_periodic) {
+        unsigned long now = millis();
+        _measureStart = now;
+        _measureTime = getPeriod();
+        // Fetch command and read under one lock: nothing may slip in before the repeated start
+        bool sent = _bus->lock(_address, _channel) && sendCommand(FETCH_COMMAND, false);
+        bool received = sent && readMeasurement();
+        _bus->unlock(sent);
+        if (!sent) {
+            _lastReadSuccess = false;
+        } else if (received) {
+            _lastResult = now;
+            return true;
+        } else {
+            // NACK: no result since the last fetch
+            _notReady = true;
+            _measureTime = NOT_READY_RETRY_MS;
+        }
+        // A sensor that reset (brown-out, replug) sits idle in single shot mode and never has a
+        // result, so resend the mode after a few periods without one
+        if (now - _lastResult >= STALL_PERIODS * getPeriod() && sendCommand(periodicCommand())) {
+            _restarts++;
+            _lastResult = now;
+        }
         return false;
     }
     
-    delay(15); // Wait for measurement
-    
-    // Request 6 bytes (temp + humidity with CRC)
-    Wire.requestFrom(_address, (uint8_t)6);
-    
-    if (Wire.available() != 6) {
+    if (!_measuring) {
+        _lastReadSuccess = false;
+        return false;
+    }
+    _measuring = false;
+    return readMeasurement();
+}
+
+bool SHTSensor::readMeasurement() {
+    // Request 6 bytes (temp + humidity with CRC); without clock stretching the sensor
+    // NACKs the read while it is still converting
+    uint8_t data[6];
+    if (_bus == nullptr) {
+        _lastReadSuccess = false;
+        return false;
+    }
+    bool received = _bus->lock(_address, _channel) && _bus->read(_address, data, sizeof(data));
+    _bus->unlock();
+    if (!received) {
         _lastReadSuccess = false;
         return false;
     }
     
-    // Read temperature
-    uint8_t tempMSB = Wire.read();
-    uint8_t tempLSB = Wire.read();
-    uint8_t tempCRC = Wire.read();
-    
-    // Read humidity
-    uint8_t humMSB = Wire.read();
-    uint8_t humLSB = Wire.read();
-    uint8_t humCRC = Wire.read();
+    // Temperature, then humidity
+    uint8_t tempMSB = data[0];
+    uint8_t tempLSB = data[1];
+    uint8_t tempCRC = data[2];
+    uint8_t humMSB = data[3];
+    uint8_t humLSB = data[4];
+    uint8_t humCRC = data[5];
     
     // Verify CRC
     if (calculateCRC(tempMSB, tempLSB) != tempCRC || 
@@ -83,22 +196,131 @@ bool SHTSensor::readData() {
     uint16_t tempRaw = (tempMSB << 8) | tempLSB;
     uint16_t humRaw = (humMSB << 8) | humLSB;
     
-    _temperature = -45.0 + 175.0 * ((float)tempRaw / 65535.0);
-    _humidity = 100.0 * ((float)humRaw / 65535.0);
+    // Datasheet: T = -45 + 175 * raw / 65535, RH = 100 * raw / 65535, in hundredths and
+    // rounded. 17500 * 65535 still fits in int32, so no float or 64-bit math is needed
+    _temperature = Centi::fromRaw(-4500 + (int32_t)((17500UL * tempRaw + 32767) / 65535));
+    _humidity = Centi::fromRaw((int32_t)((10000UL * humRaw + 32767) / 65535));
     
     _lastReadSuccess = true;
     return true;
 }
 
-float SHTSensor::getTemperature() {
+Centi SHTSensor::getTemperature() {
     return _temperature;
 }
 
-float SHTSensor::getHumidity() {
+Centi SHTSensor::getHumidity() {
     return _humidity;
 }
 
+uint16_t SHTSensor::periodicCommand() const {
+    return _rate == RATE_ART ? ART_COMMAND : PERIODIC_COMMANDS[_rate][_repeatability];
+}
+
+bool SHTSensor::startPeriodic(Rate rate, unsigned long now) {
+    // The rate of a running sensor only changes through single shot mode
+    if (_periodic) {
+        stopPeriodic();
+    }
+    _measuring = false;
+    _rate = rate;
+    _periodic = sendCommand(periodicCommand());
+    _notReady = false;
+    _measureStart = now;
+    _measureTime = getPeriod();
+    _lastResult = now;
+    return _periodic;
+}
+
+bool SHTSensor::stopPeriodic() {
+    _periodic = false;
+    bool ok = sendCommand(BREAK_COMMAND);
+    delay(1);
+    return ok;
+}
+
+bool SHTSensor::isPeriodic() const {
+    return _periodic;
+}
+
+SHTSensor::Rate SHTSensor::getRate() const {
+    return _rate;
+}
+
+unsigned long SHTSensor::getPeriod() const {
+    return PERIOD_MS[_rate];
+}
+
+bool SHTSensor::wasNotReady() const {
+    return _notReady;
+}
+
+uint32_t SHTSensor::getRestarts() const {
+    return _restarts;
+}
+
+const char* SHTSensor::getRateName(Rate rate) {
+    return rate < RATE_COUNT ? RATE_NAMES[rate] : "?";
+}
+
+bool SHTSensor::pausePeriodic() {
+    if (!_periodic) {
+        return false;
+    }
+    stopPeriodic();
+    return true;
+}
+
+void SHTSensor::resumePeriodic(bool paused) {
+    if (paused) {
+        startPeriodic(_rate, millis());
+    }
+}
+
+bool SHTSensor::setHeater(bool on) {
+    bool paused = pausePeriodic();
+    bool ok = sendCommand(on ? HEATER_ON_COMMAND : HEATER_OFF_COMMAND);
+    resumePeriodic(paused);
+    return ok;
+}
+
+bool SHTSensor::readStatus(uint16_t& status) {
+    if (_bus == nullptr) {
+        return false;
+    }
+    bool paused = pausePeriodic();
+    uint8_t data[3];
+    bool sent = _bus->lock(_address, _channel) && sendCommand(READ_STATUS_COMMAND, false);
+    bool received = sent && _bus->read(_address, data, sizeof(data));
+    _bus->unlock(received);
+    resumePeriodic(paused);
+    if (!received || calculateCRC(data[0], data[1]) != data[2]) {
+        return false;
+    }
+    status = (data[0] << 8) | data[1];
+    return true;
+}
+
+bool SHTSensor::clearStatus() {
+    bool paused = pausePeriodic();
+    bool ok = sendCommand(CLEAR_STATUS_COMMAND);
+    resumePeriodic(paused);
+    return ok;
+}
+
+uint8_t SHTSensor::getAddress() const {
+    return _address;
+}
+
+uint8_t SHTSensor::getChannel() const {
+    return _channel;
+}
+
 bool SHTSensor::isConnected() {
-    Wire.beginTransmission(_address);
-    return (Wire.endTransmission() == 0);
+    if (_bus == nullptr) {
+        return false;
+    }
+    bool ok = _bus->lock(_address, _channel) && _bus->probe(_address);
+    _bus->unlock();
+    return ok;
 }
\ No newline at end of file
@@ -2,25 +2,104 @@
 #define SHTSENSOR_H
 
 #include <Arduino.h>
-#include <Wire.h>
+#include <I2CBus.h>
+#include <FixedPoint.h>
 
+// SHT3x over I2C, without clock stretching. Two ways to measure:
+//   single shot  startMeasurement() sends the command and returns, fetch() reads the result once
+//                getConversionTime() has passed (isReady()). Several sensors can convert at once.
+//                readData() does both with a delay() in between.
+//   periodic     startPeriodic() lets the sensor free-run at 0.5-10 measurements/s (or ART);
+//                fetch() is then one write+read transaction (0xE000, repeated start). A fetch with
+//                no new result is NACKed by the sensor: fetch() fails with wasNotReady() and
+//                isReady() retries shortly. If results stop (sensor reset), periodic mode is resent.
+// Behind a TCA9548A the sensor is addressed by channel and address; every transfer selects
+// its channel through the bus.
 class SHTSensor {
 public:
-    SHTSensor(uint8_t address = 0x44);
-    bool begin(int sda_pin = -1, int scl_pin = -1);
-    bool readData();
-    float getTemperature();
-    float getHumidity();
+    enum Repeatability {
+        REPEATABILITY_LOW = 0,      // 4.5 ms, 0.25 °C / 0.21 %RH noise
+        REPEATABILITY_MEDIUM,       // 6.5 ms
+        REPEATABILITY_HIGH          // 15.5 ms, 0.06 °C / 0.08 %RH
+    };
+    
+    enum Rate {
+        RATE_0_5_MPS = 0,
+        RATE_1_MPS,
+        RATE_2_MPS,
+        RATE_4_MPS,
+        RATE_10_MPS,
+        RATE_ART,                   // Accelerated response time: 4 mps, settles faster after a step
+        RATE_COUNT
+    };
+    
+    // Status register bits
+    static const uint16_t STATUS_ALERT_PENDING = 0x8000;
+    static const uint16_t STATUS_HEATER_ON = 0x2000;
+    static const uint16_t STATUS_RESET_DETECTED = 0x0010;
+    static const uint16_t STATUS_COMMAND_FAILED = 0x0002;
+    static const uint16_t STATUS_CHECKSUM_FAILED = 0x0001;
+    
+    static const uint32_t I2C_CLOCK = 100000;   // Hot-plugged on a cable: stays at standard mode
+    
+    SHTSensor(uint8_t address = 0x44, uint8_t channel = I2CBus::NO_CHANNEL);
+    bool begin(I2CBus& bus);                    // Registers on the bus, leaves periodic mode
+    
+    void setRepeatability(Repeatability repeatability);
+    Repeatability getRepeatability() const;
+    unsigned long getConversionTime() const;    // ms from startMeasurement() to a result
+    
+    bool startMeasurement(unsigned long now);   // Single shot (leaves periodic mode first)
+    bool isMeasuring() const;                   // Single shot started, not fetched yet
+    bool isReady(unsigned long now) const;      // Conversion time (periodic: one period) has passed
+    bool fetch();                               // Read the result; ends a single shot either way
+    void cancel();                              // Forget a started single shot
+    
+    bool startPeriodic(Rate rate, unsigned long now);   // Also changes the rate of a running sensor
+    bool stopPeriodic();
+    bool isPeriodic() const;
+    Rate getRate() const;
+    unsigned long getPeriod() const;            // ms between periodic results
+    bool wasNotReady() const;                   // Last fetch() found no new periodic result yet
+    uint32_t getRestarts() const;               // Periodic mode resent after results stopped
+    static const char* getRateName(Rate rate);  // "0.5", "1", "2", "4", "10", "ART" (mps)
+    
+    // A free-running sensor only takes fetch, ART, break and soft reset: these three stop periodic
+    // mode, send their command and start it again at the same rate (the next result is one period out)
+    bool setHeater(bool on);
+    bool readStatus(uint16_t& status);
+    bool clearStatus();
+    
+    bool readData();                            // Blocking: start, wait, fetch
+    Centi getTemperature();   // 0.01 °C
+    Centi getHumidity();      // 0.01 %RH
     bool isConnected();
+    uint8_t getAddress() const;
+    uint8_t getChannel() const;                 // Multiplexer channel, I2CBus::NO_CHANNEL on the main bus
     
 private:
+    I2CBus* _bus;
     uint8_t _address;
-    float _temperature;
-    float _humidity;
+    uint8_t _channel;
+    Centi _temperature;
+    Centi _humidity;
     bool _lastReadSuccess;
+    Repeatability _repeatability;
+    bool _measuring;
+    unsigned long _measureStart;
+    unsigned long _measureTime;     // Conversion time of the measurement in progress, or time to next poll
+    bool _periodic;
+    Rate _rate;
+    bool _notReady;
+    unsigned long _lastResult;      // millis() of the last periodic result
+    uint32_t _restarts;
     
-    bool sendCommand(uint16_t command);
+    bool sendCommand(uint16_t command, bool stop = true);
+    bool pausePeriodic();                       // true when periodic mode was running and is now stopped
+    void resumePeriodic(bool paused);
+    uint16_t periodicCommand() const;
+    bool readMeasurement();
     uint8_t calculateCRC(uint8_t data1, uint8_t data2);
 };
 
-#endif // SHTSENSOR_H
\ No newline at end of file
+#endif // SHTSENSOR_H
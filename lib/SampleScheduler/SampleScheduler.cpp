@@ -0,0 +1,138 @@
+#include "SampleScheduler.h"
+
+SampleScheduler::SampleScheduler(unsigned long base, unsigned long maximum, Mode initialMode) {
+    mode = initialMode;
+    baseInterval = base;
+    maxInterval = maximum > base ? maximum : base;
+    interval = base;
+    lastStart = 0;
+    startTime = 0;
+    started = false;
+    everStarted = false;
+    stableCount = 0;
+    sampleTime16 = 0;
+    windowStart = millis();
+    windowSamples = 0;
+    windowBusy = 0;
+    rate = Centi::fromRaw(0);
+    dutyCycle = Deci::fromRaw(0);
+}
+
+void SampleScheduler::setMode(Mode newMode) {
+    mode = newMode;
+    stableCount = 0;
+    interval = baseInterval;
+    updateInterval();
+}
+
+SampleScheduler::Mode SampleScheduler::getMode() const {
+    return mode;
+}
+
+const char* SampleScheduler::getModeName() const {
+    switch (mode) {
+        case MODE_FIXED:    return "FIX";
+        case MODE_ADAPTIVE: return "ADPT";
+        case MODE_BURST:    return "BRST";
+        default:            return "?";
+    }
+}
+
+void SampleScheduler::setBaseInterval(unsigned long intervalMs) {
+    baseInterval = intervalMs;
+    if (maxInterval < baseInterval) {
+        maxInterval = baseInterval;
+    }
+    interval = baseInterval;
+    stableCount = 0;
+    updateInterval();
+}
+
+unsigned long SampleScheduler::getBaseInterval() const {
+    return baseInterval;
+}
+
+void SampleScheduler::updateInterval() {
+    if (mode == MODE_BURST) {
+        // Start to start no shorter than a sample takes: the next one goes out as soon as this one is done
+        interval = getSampleTime();
+    } else if (mode == MODE_FIXED) {
+        interval = baseInterval;
+    }
+}
+
+bool SampleScheduler::isDue(unsigned long now) const {
+    return !started && (!everStarted || now - lastStart >= interval);
+}
+
+void SampleScheduler::begin(unsigned long now) {
+    rollWindow(now);
+    lastStart = now;
+    startTime = now;
+    started = true;
+    everStarted = true;
+}
+
+void SampleScheduler::complete(unsigned long now, bool ok, bool changed) {
+    if (!started) {
+        return;
+    }
+    started = false;
+    unsigned long busy = now - startTime;
+    windowBusy += busy;
+    
+    if (ok) {
+        windowSamples++;
+        // Average over roughly the last 8 good samples
+        uint32_t sample16 = (uint32_t)busy << SAMPLE_TIME_SHIFT;
+        sampleTime16 = sampleTime16 == 0 ? sample16 : sampleTime16 - sampleTime16 / 8 + sample16 / 8;
+    }
+    
+    if (mode == MODE_ADAPTIVE) {
+        if (changed || !ok) {
+            stableCount = 0;
+            interval = baseInterval;
+        } else if (++stableCount >= STABLE_SAMPLES) {
+            stableCount = 0;
+            interval = interval * 2 < maxInterval ? interval * 2 : maxInterval;
+        }
+    }
+    updateInterval();
+    rollWindow(now);
+}
+
+void SampleScheduler::rollWindow(unsigned long now) {
+    unsigned long elapsed = now - windowStart;
+    if (elapsed < STATS_WINDOW_MS) {
+        return;
+    }
+    // A slow sensor may leave a window open much longer, the rates use its real length
+    rate = Centi::fromRaw((int32_t)(windowSamples * 100000UL / elapsed));
+    dutyCycle = Deci::fromRaw((int32_t)(windowBusy * 1000UL / elapsed));
+    windowStart = now;
+    windowSamples = 0;
+    windowBusy = 0;
+}
+
+unsigned long SampleScheduler::getInterval() const {
+    return interval;
+}
+
+unsigned long SampleScheduler::getSampleTime() const {
+    return (sampleTime16 + (1 << (SAMPLE_TIME_SHIFT - 1))) >> SAMPLE_TIME_SHIFT;
+}
+
+Centi SampleScheduler::getAchievableRate() const {
+    if (sampleTime16 == 0) {
+        return Centi::invalid();
+    }
+    return Centi::fromRaw((int32_t)((100000UL << SAMPLE_TIME_SHIFT) / sampleTime16));
+}
+
+Centi SampleScheduler::getRate() const {
+    return rate;
+}
+
+Deci SampleScheduler::getDutyCycle() const {
+    return dutyCycle;
+}
@@ -0,0 +1,69 @@
+#ifndef SAMPLESCHEDULER_H
+#define SAMPLESCHEDULER_H
+
+#include <Arduino.h>
+#include <FixedPoint.h>
+
+// When to take the next sample of one sensor, and how fast sampling actually runs.
+//   MODE_FIXED     every baseInterval
+//   MODE_ADAPTIVE  baseInterval while readings move; after STABLE_SAMPLES unchanged samples the
+//                  interval doubles, up to maxInterval, and drops back on the first change
+//   MODE_BURST     as fast as the sensor answers: the interval follows the measured sample time
+// The owner calls begin() when a sample starts and complete() when it is done. Rate and duty
+// cycle (share of time spent sampling) are published once per STATS_WINDOW_MS.
+class SampleScheduler {
+public:
+    enum Mode {
+        MODE_FIXED = 0,
+        MODE_ADAPTIVE,
+        MODE_BURST,
+        MODE_COUNT
+    };
+    
+    static const unsigned long STATS_WINDOW_MS = 5000;
+    static const uint8_t STABLE_SAMPLES = 5;    // Unchanged samples before each back-off step
+    
+    SampleScheduler(unsigned long baseInterval, unsigned long maxInterval, Mode mode = MODE_ADAPTIVE);
+    
+    void setMode(Mode mode);
+    Mode getMode() const;
+    const char* getModeName() const;            // "FIX", "ADPT", "BRST"
+    void setBaseInterval(unsigned long intervalMs);
+    unsigned long getBaseInterval() const;
+    
+    bool isDue(unsigned long now) const;
+    void begin(unsigned long now);
+    void complete(unsigned long now, bool ok, bool changed);
+    
+    unsigned long getInterval() const;          // Interval in use right now
+    unsigned long getSampleTime() const;        // Average time of a good sample, ms (0 = not measured yet)
+    Centi getAchievableRate() const;            // Hz the sensor could deliver back to back
+    Centi getRate() const;                      // Completed samples per second, last window
+    Deci getDutyCycle() const;                  // % of the last window spent sampling
+
+private:
+    static const int SAMPLE_TIME_SHIFT = 4;     // Sample time average kept in 1/16 ms
+    
+    Mode mode;
+    unsigned long baseInterval;
+    unsigned long maxInterval;
+    unsigned long interval;
+    unsigned long lastStart;
+    unsigned long startTime;    // begin() of the sample in progress
+    bool started;               // A sample is in progress
+    bool everStarted;
+    uint8_t stableCount;
+    uint32_t sampleTime16;      // Running average, 1/16 ms
+    
+    // Statistics window
+    unsigned long windowStart;
+    uint32_t windowSamples;
+    unsigned long windowBusy;
+    Centi rate;
+    Deci dutyCycle;
+    
+    void updateInterval();
+    void rollWindow(unsigned long now);
+};
+
+#endif
@@ -0,0 +1,287 @@
+#include "StrappingTable.h"
+
+StrappingTable::StrappingTable() {
+    input = INPUT_UNITS;
+    clear();
+}
+
+void StrappingTable::clear() {
+    pointCount = 0;
+    bucketScale = 0;
+    indexed = false;
+}
+
+bool StrappingTable::addPoint(uint16_t value, Deci volume) {
+    if (pointCount >= MAX_POINTS || !volume.isValid()) {
+        return false;
+    }
+    if (pointCount > 0 && value <= points[pointCount - 1].input) {
+        return false;
+    }
+    points[pointCount].input = value;
+    points[pointCount].volume = volume;
+    pointCount++;
+    indexed = false;
+    return true;
+}
+
+void StrappingTable::setInput(Input newInput) {
+    input = newInput;
+}
+
+StrappingTable::Input StrappingTable::getInput() const {
+    return input;
+}
+
+const char* StrappingTable::getInputName() const {
+    return input == INPUT_FREQUENCY ? "freq" : "units";
+}
+
+bool StrappingTable::isValid() const {
+    return pointCount >= 2;
+}
+
+int StrappingTable::getPointCount() const {
+    return pointCount;
+}
+
+const StrappingTable::Point* StrappingTable::getPoint(int index) const {
+    if (index < 0 || index >= pointCount) {
+        return nullptr;
+    }
+    return &points[index];
+}
+
+Deci StrappingTable::getMinVolume() const {
+    return pointCount > 0 ? points[0].volume : Deci::invalid();
+}
+
+Deci StrappingTable::getMaxVolume() const {
+    return pointCount > 0 ? points[pointCount - 1].volume : Deci::invalid();
+}
+
+// Segment i spans points[i]..points[i + 1]; input must lie strictly inside the table
+int StrappingTable::findSegment(uint16_t value) const {
+    int low = 0;
+    int high = pointCount - 1;
+    while (high - low > 1) {
+        int mid = (low + high) / 2;
+        if (points[mid].input <= value) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+Deci StrappingTable::interpolate(int segment, uint16_t value) const {
+    const Point& a = points[segment];
+    const Point& b = points[segment + 1];
+    int64_t span = b.input - a.input;
+    int64_t delta = (int64_t)(b.volume.toRaw() - a.volume.toRaw()) * (value - a.input);
+    // Round half away from zero, as Deci::format does
+    int64_t step = delta >= 0 ? (delta + span / 2) / span : (delta - span / 2) / span;
+    return Deci::fromRaw(a.volume.toRaw() + (int32_t)step);
+}
+
+Deci StrappingTable::lookup(uint16_t value) const {
+    if (!isValid()) {
+        return Deci::invalid();
+    }
+    if (value <= points[0].input) {
+        return points[0].volume;
+    }
+    if (value >= points[pointCount - 1].input) {
+        return points[pointCount - 1].volume;
+    }
+    
+    int segment;
+    if (indexed) {
+        // The bucket gives the segment of its lowest input, at most a few steps short of ours
+        uint32_t bucket = ((uint32_t)(value - points[0].input) * bucketScale) >> 16;
+        segment = bucketSegment[bucket];
+        while (segment < pointCount - 2 && points[segment + 1].input <= value) {
+            segment++;
+        }
+    } else {
+        segment = findSegment(value);
+    }
+    return interpolate(segment, value);
+}
+
+Deci StrappingTable::lookup(uint16_t units, uint16_t frequency) const {
+    return lookup(input == INPUT_FREQUENCY ? frequency : units);
+}
+
+void StrappingTable::buildIndex() {
+    indexed = false;
+    if (!isValid()) {
+        return;
+    }
+    
+    // span * bucketScale >> 16 stays below INDEX_SIZE, so every input maps to a bucket
+    uint32_t first = points[0].input;
+    uint32_t span = points[pointCount - 1].input - first;
+    bucketScale = ((uint32_t)INDEX_SIZE << 16) / (span + 1);
+    
+    for (int bucket = 0; bucket < INDEX_SIZE; bucket++) {
+        // Lowest input whose bucket is >= this one
+        uint32_t lowest = first + (((uint32_t)bucket << 16) + bucketScale - 1) / bucketScale;
+        if (lowest >= points[pointCount - 1].input) {
+            bucketSegment[bucket] = pointCount - 2;
+        } else if (lowest <= first) {
+            bucketSegment[bucket] = 0;
+        } else {
+            bucketSegment[bucket] = findSegment((uint16_t)lowest);
+        }
+    }
+    indexed = true;
+}
+
+bool StrappingTable::hasIndex() const {
+    return indexed;
+}
+
+size_t StrappingTable::writeTo(Print& out) const {
+    size_t written = out.printf("input,%s\n", getInputName());
+    char volumeText[FIXED_TEXT_SIZE];
+    for (int i = 0; i < pointCount; i++) {
+        points[i].volume.format(volumeText, sizeof(volumeText), 1);
+        written += out.printf("%u,%s\n", points[i].input, volumeText);
+    }
+    return written;
+}
+
+// "52.5" -> 525 deci-litres; a second decimal rounds, further digits are ignored
+bool StrappingTable::parseVolume(const char* text, Deci& volume) {
+    while (*text == ' ' || *text == '\t') {
+        text++;
+    }
+    bool negative = *text == '-';
+    if (negative) {
+        text++;
+    }
+    if (!isdigit((unsigned char)*text)) {
+        return false;
+    }
+    
+    int32_t whole = 0;
+    while (isdigit((unsigned char)*text)) {
+        whole = whole * 10 + (*text++ - '0');
+        if (whole > 100000000) {
+            return false;
+        }
+    }
+    int32_t tenths = 0;
+    if (*text == '.') {
+        text++;
+        if (isdigit((unsigned char)*text)) {
+            tenths = *text++ - '0';
+            if (isdigit((unsigned char)*text) && *text >= '5') {
+                tenths++;
+            }
+        }
+        while (isdigit((unsigned char)*text)) {
+            text++;
+        }
+    }
+    while (*text == ' ' || *text == '\t' || *text == '\r') {
+        text++;
+    }
+    if (*text != '\0') {
+        return false;
+    }
+    
+    int32_t raw = whole * 10 + tenths;
+    volume = Deci::fromRaw(negative ? -raw : raw);
+    return true;
+}
+
+bool StrappingTable::parseLine(const char* line) {
+    while (*line == ' ' || *line == '\t') {
+        line++;
+    }
+    if (*line == '\0' || *line == '\r' || *line == '#') {
+        return true;
+    }
+    if (strncmp(line, "input,", 6) == 0) {
+        if (strncmp(line + 6, "freq", 4) == 0) {
+            input = INPUT_FREQUENCY;
+        } else if (strncmp(line + 6, "units", 5) == 0) {
+            input = INPUT_UNITS;
+        } else {
+            return false;
+        }
+        return true;
+    }
+    
+    char* end;
+    unsigned long value = strtoul(line, &end, 10);
+    if (end == line || *end != ',' || value > 0xFFFF) {
+        return false;
+    }
+    Deci volume;
+    return parseVolume(end + 1, volume) && addPoint((uint16_t)value, volume);
+}
+
+bool StrappingTable::readFrom(Stream& in) {
+    clear();
+    input = INPUT_UNITS;
+    
+    char line[48];
+    size_t length = 0;
+    int lineNumber = 1;
+    bool ok = true;
+    while (ok) {
+        int c = in.read();
+        if (c < 0 || c == '\n') {
+            line[length] = '\0';
+            if (!parseLine(line)) {
+                Serial.printf("Strapping table: bad point on line %d\n", lineNumber);
+                ok = false;
+            }
+            if (c < 0) {
+                break;
+            }
+            length = 0;
+            lineNumber++;
+        } else if (length < sizeof(line) - 1) {
+            line[length++] = (char)c;
+        }
+    }
+    
+    if (!ok || !isValid()) {
+        clear();
+        return false;
+    }
+    buildIndex();
+    return true;
+}
+
+bool StrappingTable::save(fs::FS& fs, const char* path) const {
+    File file = fs.open(path, "w");
+    if (!file) {
+        Serial.printf("Strapping table: cannot create %s\n", path);
+        return false;
+    }
+    writeTo(file);
+    file.close();
+    Serial.printf("Strapping table: %d points saved to %s\n", pointCount, path);
+    return true;
+}
+
+bool StrappingTable::load(fs::FS& fs, const char* path) {
+    File file = fs.open(path, "r");
+    if (!file) {
+        return false;
+    }
+    bool ok = readFrom(file);
+    file.close();
+    if (ok) {
+        Serial.printf("Strapping table: %d points (%s) from %s\n", pointCount, getInputName(), path);
+    } else {
+        Serial.printf("Strapping table: %s is not a valid table\n", path);
+    }
+    return ok;
+}
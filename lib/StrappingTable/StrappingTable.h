@@ -0,0 +1,75 @@
+#ifndef STRAPPINGTABLE_H
+#define STRAPPINGTABLE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <FixedPoint.h>
+
+// Tank calibration ("strapping") table: sensor reading -> volume, for tanks that are not
+// straight-sided. Points are sorted by input; between two points the volume is interpolated
+// linearly in integer math, outside the table it is clamped to the first/last point.
+// lookup() is a binary search over the points; after buildIndex() it starts from a uniform
+// bucket index instead (O(1), same result). The input is either the probe's level units or
+// its raw frequency, set by the table file.
+//
+// File format (text, one point per line, '#' starts a comment):
+//   input,units          or input,freq
+//   0,0
+//   410,52.5             input value, volume in litres (0.1 L resolution)
+class StrappingTable {
+public:
+    enum Input {
+        INPUT_UNITS = 0,
+        INPUT_FREQUENCY
+    };
+    
+    struct Point {
+        uint16_t input;
+        Deci volume;
+    };
+    
+    static const int MAX_POINTS = 400;
+    static const int INDEX_SIZE = 256;      // Buckets of the uniform index
+    
+    StrappingTable();
+    
+    void clear();
+    bool addPoint(uint16_t input, Deci volume);    // Inputs must strictly increase
+    void setInput(Input input);
+    Input getInput() const;
+    const char* getInputName() const;              // "units", "freq"
+    
+    bool isValid() const;                          // At least two points
+    int getPointCount() const;
+    const Point* getPoint(int index) const;        // nullptr when out of range
+    Deci getMinVolume() const;
+    Deci getMaxVolume() const;
+    
+    Deci lookup(uint16_t input) const;             // Invalid when the table is not valid
+    Deci lookup(uint16_t units, uint16_t frequency) const;  // Picks the configured input
+    
+    void buildIndex();                             // Call after the last addPoint()
+    bool hasIndex() const;
+    
+    size_t writeTo(Print& out) const;              // Text format above
+    bool readFrom(Stream& in);                     // Replaces the table, builds the index
+    bool save(fs::FS& fs, const char* path) const;
+    bool load(fs::FS& fs, const char* path);
+
+private:
+    Point points[MAX_POINTS];
+    int pointCount;
+    Input input;
+    
+    // bucketSegment[b]: segment that holds the lowest input of bucket b
+    uint16_t bucketSegment[INDEX_SIZE];
+    uint32_t bucketScale;                   // Input offset -> bucket, 16.16 fixed point
+    bool indexed;
+    
+    int findSegment(uint16_t input) const;
+    Deci interpolate(int segment, uint16_t input) const;
+    bool parseLine(const char* line);
+    static bool parseVolume(const char* text, Deci& volume);
+};
+
+#endif
@@ -0,0 +1,296 @@
+#include "UartCapture.h"
+
+UartCapture::UartCapture() {
+    enabled = true;
+    clear();
+}
+
+void UartCapture::setEnabled(bool on) {
+    enabled = on;
+}
+
+bool UartCapture::isEnabled() const {
+    return enabled;
+}
+
+void UartCapture::clear() {
+    head = 0;
+    count = 0;
+    firstMicros = 0;
+    lastMicros = 0;
+    overwritten = 0;
+    clippedGaps = 0;
+}
+
+uint32_t UartCapture::deltaOf(uint32_t raw) {
+    return (raw & ~TX_FLAG) >> DELTA_SHIFT;
+}
+
+void UartCapture::record(Direction direction, uint8_t value) {
+    if (!enabled) {
+        return;
+    }
+    unsigned long now = micros();
+    
+    uint32_t delta = 0;
+    if (count > 0) {
+        delta = now - lastMicros;
+        if (delta > MAX_DELTA_MICROS) {
+            delta = MAX_DELTA_MICROS;
+            clippedGaps++;
+        }
+    }
+    lastMicros = now;
+    
+    uint32_t raw = (direction == CAPTURE_TX ? TX_FLAG : 0) | (delta << DELTA_SHIFT) | value;
+    if (count == 0) {
+        firstMicros = now;
+    }
+    if (count == CAPACITY) {
+        // Drop the oldest record; the next one becomes the time base
+        head = (head + 1) % CAPACITY;
+        count--;
+        firstMicros += deltaOf(records[head]);
+        overwritten++;
+    }
+    records[(head + count) % CAPACITY] = raw;
+    count++;
+}
+
+void UartCapture::record(Direction direction, const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        record(direction, data[i]);
+    }
+}
+
+int UartCapture::getCount() const {
+    return count;
+}
+
+uint32_t UartCapture::getOverwritten() const {
+    return overwritten;
+}
+
+uint32_t UartCapture::getClippedGaps() const {
+    return clippedGaps;
+}
+
+bool UartCapture::next(int& index, unsigned long& time, Record& out) const {
+    if (index < 0 || index >= count) {
+        return false;
+    }
+    uint32_t raw = records[(head + index) % CAPACITY];
+    time = index == 0 ? firstMicros : time + deltaOf(raw);
+    out.micros = time;
+    out.direction = (raw & TX_FLAG) ? CAPTURE_TX : CAPTURE_RX;
+    out.value = raw & 0xFF;
+    index++;
+    return true;
+}
+
+void UartCapture::dump(Print& out) const {
+    out.printf("=== UART capture: %d records, %lu overwritten, %lu gaps clipped ===\n",
+               count, (unsigned long)overwritten, (unsigned long)clippedGaps);
+    
+    int index = 0;
+    unsigned long time = 0;
+    unsigned long previous = 0;
+    Direction lineDirection = CAPTURE_RX;
+    Record entry;
+    while (next(index, time, entry)) {
+        // A new line for every direction change or pause, so each line is roughly one frame
+        if (index == 1 || entry.direction != lineDirection || entry.micros - previous > BURST_GAP_MICROS) {
+            if (index > 1) {
+                out.println();
+            }
+            unsigned long offset = entry.micros - firstMicros;
+            out.printf("+%lu.%03lu ms %s", offset / 1000, offset % 1000,
+                       entry.direction == CAPTURE_TX ? "TX" : "RX");
+            lineDirection = entry.direction;
+        }
+        out.printf(" %02X", entry.value);
+        previous = entry.micros;
+    }
+    if (count > 0) {
+        out.println();
+    }
+}
+
+void UartCapture::writeLE32(Print& out, uint32_t value) {
+    uint8_t bytes[4] = { (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24) };
+    out.write(bytes, sizeof(bytes));
+}
+
+bool UartCapture::readLE32(Stream& in, uint32_t& value) {
+    uint8_t bytes[4];
+    if (in.readBytes(bytes, sizeof(bytes)) != sizeof(bytes)) {
+        return false;
+    }
+    value = bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+    return true;
+}
+
+size_t UartCapture::writeTo(Print& out) const {
+    // magic, version + 3 reserved, first record time, record count, overwritten
+    writeLE32(out, FORMAT_MAGIC);
+    writeLE32(out, FORMAT_VERSION);
+    writeLE32(out, firstMicros);
+    writeLE32(out, count);
+    writeLE32(out, overwritten);
+    for (int i = 0; i < count; i++) {
+        writeLE32(out, records[(head + i) % CAPACITY]);
+    }
+    return 20 + count * sizeof(uint32_t);
+}
+
+bool UartCapture::readFrom(Stream& in) {
+    uint32_t magic, version, first, total, lost;
+    if (!readLE32(in, magic) || magic != FORMAT_MAGIC ||
+        !readLE32(in, version) || (version & 0xFF) != FORMAT_VERSION ||
+        !readLE32(in, first) || !readLE32(in, total) || !readLE32(in, lost) ||
+        total > (uint32_t)CAPACITY) {
+        return false;
+    }
+    
+    clear();
+    for (uint32_t i = 0; i < total; i++) {
+        if (!readLE32(in, records[i])) {
+            clear();
+            return false;
+        }
+    }
+    count = total;
+    firstMicros = first;
+    overwritten = lost;
+    
+    // Recompute the newest time so recording can continue after a load
+    int index = 0;
+    unsigned long time = 0;
+    Record entry;
+    while (next(index, time, entry)) {
+        // Only the running time is needed
+    }
+    lastMicros = time;
+    return true;
+}
+
+bool UartCapture::save(fs::FS& fs, const char* path) const {
+    File file = fs.open(path, "w");
+    if (!file) {
+        Serial.printf("UART capture: cannot create %s\n", path);
+        return false;
+    }
+    size_t expected = 20 + count * sizeof(uint32_t);
+    size_t written = writeTo(file);
+    file.close();
+    Serial.printf("UART capture: %d records saved to %s\n", count, path);
+    return written == expected;
+}
+
+bool UartCapture::load(fs::FS& fs, const char* path) {
+    File file = fs.open(path, "r");
+    if (!file) {
+        Serial.printf("UART capture: cannot open %s\n", path);
+        return false;
+    }
+    bool ok = readFrom(file);
+    file.close();
+    if (!ok) {
+        Serial.printf("UART capture: %s is not a capture file\n", path);
+    }
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Replay
+// ---------------------------------------------------------------------------
+
+UartReplay::UartReplay(const UartCapture& capture) : capture(capture) {
+    restart();
+}
+
+void UartReplay::restart() {
+    cursor = 0;
+    cursorTime = 0;
+    havePending = false;
+    mismatches = 0;
+    skippedRx = 0;
+    advance();
+    anchorCapture = havePending ? pending.micros : 0;
+    anchorLocal = micros();
+}
+
+void UartReplay::advance() {
+    havePending = capture.next(cursor, cursorTime, pending);
+}
+
+bool UartReplay::isFinished() const {
+    return !havePending;
+}
+
+uint32_t UartReplay::getMismatches() const {
+    return mismatches;
+}
+
+uint32_t UartReplay::getSkippedRx() const {
+    return skippedRx;
+}
+
+bool UartReplay::rxDue() {
+    return havePending && pending.direction == UartCapture::CAPTURE_RX &&
+           (long)((micros() - anchorLocal) - (pending.micros - anchorCapture)) >= 0;
+}
+
+int UartReplay::available() {
+    if (!rxDue()) {
+        return 0;
+    }
+    
+    // Count the due RX bytes that follow without consuming them
+    unsigned long elapsed = micros() - anchorLocal;
+    int index = cursor;
+    unsigned long time = cursorTime;
+    UartCapture::Record entry;
+    int due = 1;
+    while (capture.next(index, time, entry) && entry.direction == UartCapture::CAPTURE_RX &&
+           (long)(elapsed - (entry.micros - anchorCapture)) >= 0) {
+        due++;
+    }
+    return due;
+}
+
+int UartReplay::read() {
+    if (!rxDue()) {
+        return -1;
+    }
+    uint8_t value = pending.value;
+    advance();
+    return value;
+}
+
+int UartReplay::peek() {
+    return rxDue() ? pending.value : -1;
+}
+
+void UartReplay::flush() {
+    // Nothing is transmitted
+}
+
+size_t UartReplay::write(uint8_t byte) {
+    // RX bytes the driver did not pick up before this request were flushed in the original run too
+    while (havePending && pending.direction == UartCapture::CAPTURE_RX) {
+        skippedRx++;
+        advance();
+    }
+    if (!havePending) {
+        return 1;
+    }
+    
+    if (pending.value != byte) {
+        mismatches++;
+    }
+    anchorCapture = pending.micros;
+    anchorLocal = micros();
+    advance();
+    return 1;
+}
@@ -0,0 +1,109 @@
+#ifndef UARTCAPTURE_H
+#define UARTCAPTURE_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+// Every byte FuelSensor sends or receives, with its micros() timestamp, in a RAM ring:
+//   fuelSensor.setCapture(&capture);
+// A record is one uint32_t: bit 31 = TX, bits 30..8 = µs since the previous record, bits 7..0 = byte.
+// Gaps longer than MAX_DELTA_MICROS (~8.4 s) are clipped; when the ring is full the oldest
+// records are overwritten. dump() prints the trace for the console, writeTo()/readFrom() move it
+// as binary (a LittleFS File works for both) and UartReplay feeds it back into FuelSensor.
+class UartCapture {
+public:
+    static const int CAPACITY = 2048;                        // Records, 4 bytes each
+    static const uint32_t MAX_DELTA_MICROS = 0x7FFFFF;
+    static const uint32_t FORMAT_MAGIC = 0x50434741;         // "AGCP" as written little-endian
+    static const uint8_t FORMAT_VERSION = 1;
+    
+    enum Direction {
+        CAPTURE_RX = 0,
+        CAPTURE_TX
+    };
+    
+    struct Record {
+        unsigned long micros;      // Absolute micros() of the byte (after clipping of long gaps)
+        Direction direction;
+        uint8_t value;
+    };
+    
+    UartCapture();
+    
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+    void clear();
+    
+    void record(Direction direction, uint8_t value);
+    void record(Direction direction, const uint8_t* data, size_t length);
+    
+    int getCount() const;
+    uint32_t getOverwritten() const;   // Records lost to the ring wrapping since clear()
+    uint32_t getClippedGaps() const;   // Gaps stored shorter than they were
+    
+    // Records oldest first: start with index 0 and a zeroed time, keep passing both back
+    bool next(int& index, unsigned long& time, Record& out) const;
+    
+    void dump(Print& out) const;                  // One line per burst: "+12.345 ms TX 31 FF 06 29"
+    size_t writeTo(Print& out) const;             // Header + raw records, little-endian
+    bool readFrom(Stream& in);                    // Inverse of writeTo, replaces the current contents
+    bool save(fs::FS& fs, const char* path) const;
+    bool load(fs::FS& fs, const char* path);
+
+private:
+    static const uint32_t TX_FLAG = 0x80000000UL;
+    static const int DELTA_SHIFT = 8;
+    static const unsigned long BURST_GAP_MICROS = 5000;     // dump() starts a new line after this much silence
+    
+    uint32_t records[CAPACITY];
+    int head;                      // Oldest record
+    int count;
+    unsigned long firstMicros;     // Time of the oldest record
+    unsigned long lastMicros;      // micros() of the newest record, deltas are taken from it
+    uint32_t overwritten;
+    uint32_t clippedGaps;
+    bool enabled;
+    
+    static uint32_t deltaOf(uint32_t raw);
+    static void writeLE32(Print& out, uint32_t value);
+    static bool readLE32(Stream& in, uint32_t& value);
+};
+
+// Plays a capture back as the fuel UART: fuelSensor.begin(replay).
+// Timing is anchored on the requests: when the driver writes a byte that was a TX byte in the
+// capture, the following RX bytes become readable at the same offsets as in the original trace.
+// RX bytes still unread when the driver sends its next request are dropped, as sendRequest()
+// flushes its input anyway. Written bytes that differ from the capture are counted.
+class UartReplay : public Stream {
+public:
+    UartReplay(const UartCapture& capture);
+    
+    void restart();                 // Back to the first record, timing restarts now
+    bool isFinished() const;        // Every record consumed
+    uint32_t getMismatches() const; // Bytes written that differ from the captured TX byte
+    uint32_t getSkippedRx() const;  // Captured RX bytes the driver never read
+    
+    // Stream
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override;
+    size_t write(uint8_t byte) override;
+    using Print::write;
+
+private:
+    const UartCapture& capture;
+    int cursor;                     // Next record to play
+    unsigned long cursorTime;       // Captured time of the record before the cursor
+    UartCapture::Record pending;    // Record at the cursor
+    bool havePending;
+    unsigned long anchorCapture;    // Captured time of the last matched TX byte
+    unsigned long anchorLocal;      // micros() when the driver wrote it
+    uint32_t mismatches;
+    uint32_t skippedRx;
+    
+    void advance();
+    bool rxDue();
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include "UartRxBuffer.h"
+
+UartRxBuffer::UartRxBuffer() {
+    uart = nullptr;
+    head.store(0);
+    tail.store(0);
+    overflows.store(0);
+    events.store(0);
+    notifyTask = nullptr;
+}
+
+void UartRxBuffer::begin(HardwareSerial& serial) {
+    uart = &serial;
+    // Every DATA event, not only RX timeouts: the ring is smaller than a full driver buffer
+    uart->onReceive([this]() { receive(); }, false);
+}
+
+void UartRxBuffer::setNotifyTask(TaskHandle_t task) {
+    notifyTask = task;
+}
+
+bool UartRxBuffer::waitForData(uint32_t timeoutMs) {
+    if (available() > 0) {
+        return true;
+    }
+    return ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs)) > 0 && available() > 0;
+}
+
+void UartRxBuffer::receive() {
+    events.fetch_add(1, std::memory_order_relaxed);
+    
+    uint16_t in = head.load(std::memory_order_relaxed);
+    uint16_t out = tail.load(std::memory_order_acquire);
+    int count = uart->available();
+    while (count-- > 0) {
+        int value = uart->read();
+        if (value < 0) {
+            break;
+        }
+        if ((uint16_t)(in - out) >= CAPACITY) {
+            // Consumer is behind: keep what is queued, it is older and part of a frame already
+            out = tail.load(std::memory_order_acquire);
+            if ((uint16_t)(in - out) >= CAPACITY) {
+                overflows.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+        }
+        buffer[in & INDEX_MASK] = (uint8_t)value;
+        in++;
+        // Publish each byte, so the consumer can start parsing while a long burst is copied
+        head.store(in, std::memory_order_release);
+    }
+    
+    if (notifyTask != nullptr) {
+        xTaskNotifyGive(notifyTask);
+    }
+}
+
+int UartRxBuffer::available() {
+    return (uint16_t)(head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed));
+}
+
+int UartRxBuffer::read() {
+    uint16_t out = tail.load(std::memory_order_relaxed);
+    if (head.load(std::memory_order_acquire) == out) {
+        return -1;
+    }
+    uint8_t value = buffer[out & INDEX_MASK];
+    tail.store((uint16_t)(out + 1), std::memory_order_release);
+    return value;
+}
+
+int UartRxBuffer::peek() {
+    uint16_t out = tail.load(std::memory_order_relaxed);
+    if (head.load(std::memory_order_acquire) == out) {
+        return -1;
+    }
+    return buffer[out & INDEX_MASK];
+}
+
+void UartRxBuffer::flush() {
+    if (uart != nullptr) {
+        uart->flush();
+    }
+}
+
+size_t UartRxBuffer::write(uint8_t byte) {
+    return uart != nullptr ? uart->write(byte) : 0;
+}
+
+size_t UartRxBuffer::write(const uint8_t* data, size_t length) {
+    return uart != nullptr ? uart->write(data, length) : 0;
+}
+
+uint32_t UartRxBuffer::getOverflows() const {
+    return overflows.load(std::memory_order_relaxed);
+}
+
+uint32_t UartRxBuffer::getEvents() const {
+    return events.load(std::memory_order_relaxed);
+}
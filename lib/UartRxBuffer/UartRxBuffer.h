@@ -0,0 +1,52 @@
+#ifndef UARTRXBUFFER_H
+#define UARTRXBUFFER_H
+
+#include <Arduino.h>
+#include <HardwareSerial.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Receive side of a HardwareSerial moved into a lock-free single-producer/single-consumer ring.
+// The UART event task (onReceive) is the only producer, the protocol engine the only consumer,
+// so available()/read() are a couple of atomic loads instead of a locked driver query.
+// Writes go straight to the UART. Use it as the fuel link stream:
+//   fuelSensor.begin(txPin, rxPin, 9600, &rxBuffer);
+// A task running the engine can sleep in waitForData() until bytes or a line-idle event arrive.
+class UartRxBuffer : public Stream {
+public:
+    static const int CAPACITY = 256;           // Power of two
+    
+    UartRxBuffer();
+    
+    void begin(HardwareSerial& uart);          // UART already started; installs the onReceive hook
+    void setNotifyTask(TaskHandle_t task);     // Task woken on every receive event, nullptr = none
+    bool waitForData(uint32_t timeoutMs);      // In the notify task: true when woken by data
+    
+    uint32_t getOverflows() const;             // Bytes dropped because the ring was full
+    uint32_t getEvents() const;                // onReceive calls so far
+    
+    // Stream
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override;
+    size_t write(uint8_t byte) override;
+    size_t write(const uint8_t* data, size_t length) override;
+    using Print::write;
+
+private:
+    static const uint16_t INDEX_MASK = CAPACITY - 1;
+    
+    HardwareSerial* uart;
+    uint8_t buffer[CAPACITY];
+    std::atomic<uint16_t> head;                // Next slot to fill, written by the producer only
+    std::atomic<uint16_t> tail;                // Next slot to read, written by the consumer only
+    std::atomic<uint32_t> overflows;
+    std::atomic<uint32_t> events;
+    TaskHandle_t notifyTask;
+    
+    void receive();                            // Producer, runs in the UART event task
+};
+
+#endif
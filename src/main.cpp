@@ -1,9 +1,23 @@
 #include <Arduino.h>
 #include <Wire.h>
+#include "I2CBus.h"
 #include "SHTSensor.h"
+#include "SHTRegistry.h"
 #include "DisplayManager.h"
 #include "BuzzerManager.h"
 #include "FuelSensor.h"
+#include "FuelBusManager.h"
+#include "ProbeIdentityCache.h"
+#include "CalibrationJob.h"
+#include "SampleScheduler.h"
+#include "UartCapture.h"
+#include "UartRxBuffer.h"
+#include "CircuitBreaker.h"
+#include "StrappingTable.h"
+#include <LittleFS.h>
+#ifdef FUEL_SIMULATOR
+#include "AoooGSimulator.h"
+#endif
 #include "RotaryEncoder.h"
 
 // Function declarations
@@ -13,7 +27,21 @@ void handleSingleClick();
 void handleDoubleClick();
 void handleTripleClick();
 void handleLongPress();
-float calculateFuelPercentage(int currentLevel);
+Centi calculateFuelPercentage(int currentLevel);
+uint8_t selectedProbeAddress();
+void updateFuelReading();
+void updateFuelConsumption(const FuelBusManager::Probe* probe);
+void updateCalibration(unsigned long currentTime);
+void notify(const char* title, const char* message, unsigned long duration);
+void updateNotifications(unsigned long currentTime);
+void handleConsole();
+void formatScheduleLine(char* buffer, size_t size, const char* name, const SampleScheduler& schedule);
+bool mountFileSystem();
+void loadTankTable(uint32_t serialNumber);
+void checkFuelEvents();
+void checkShtPresence(unsigned long currentTime);
+void formatShtName(char* buffer, size_t size, const SHTSensor* sht);
+void updateShtAvailability();
 
 // Pin definitions for ESP32-C3
 #define SDA_PIN 6
@@ -28,21 +56,52 @@ float calculateFuelPercentage(int currentLevel);
 #define ROTARY_CLK_PIN 10 // Rotary encoder CLK
 
 // Create sensor, display and buzzer objects
-SHTSensor sht1(0x44);  // SHT sensor at address 0x44
-SHTSensor sht2(0x45);  // SHT sensor at address 0x45
+I2CBus i2cBus;         // Owns Wire: OLED at 400 kHz, SHT at 100 kHz ('i' for stats)
+SHTRegistry shtSensors; // SHT at 0x44 / 0x45 (on each TCA9548A channel if fitted), found and lost from their own traffic
+const uint8_t SHT_MUX_ADDRESS = 0x70; // TCA9548A for up to 16 SHT, looked for at boot
+SHTSensor::Repeatability shtRepeatability = SHTSensor::REPEATABILITY_HIGH; // 16 ms conversion, off the loop ('r')
+int shtPeriodicRate = -1;           // SHTSensor::Rate while free-running, -1 = single shot ('m')
+bool shtHeater = false;             // SHT heater ('h'), to dry the sensor after condensation
 DisplayManager display(128, 32, 0x3C);  // OLED 0.91" usually 128x32
 BuzzerManager buzzer(BUZZER_PIN, 0);    // Buzzer on pin 7, PWM channel 0
 FuelSensor fuelSensor(0xFF);            // Fuel sensor with broadcast address 0xFF
+FuelBusManager fuelBus(fuelSensor);     // All AoooG probes on the fuel link, polled round-robin
+ProbeIdentityCache probeCache;          // Firmware/limits of probes seen before, kept in NVS by serial number
+CalibrationJob calibration(fuelSensor); // Set Full/Empty sequence, advanced from loop()
+UartCapture fuelCapture;                // Last ~2048 bytes on the fuel link, see handleConsole()
+UartRxBuffer fuelRx;                    // UART1 receive ring filled by the UART event task
+StrappingTable tankTable;               // Volume of the selected probe's tank, from LittleFS (see loadTankTable)
+#ifdef FUEL_SIMULATOR
+AoooGSimulator fuelSimulator;           // Virtual probes instead of UART1 (env:esp32-c3-simulator)
+#endif
 RotaryEncoder encoder(ROTARY_SW_PIN, ROTARY_DT_PIN, ROTARY_CLK_PIN); // Rotary encoder
 
 // Timing variables
 unsigned long lastReadTime = 0;
 const unsigned long READ_INTERVAL = 2000; // Read every 2 seconds
+const unsigned long SHT_MAX_INTERVAL = 30000; // SHT back-off limit while readings are steady
+SampleScheduler shtSchedule(READ_INTERVAL, SHT_MAX_INTERVAL); // SHT sampling rate, see MENU_DIAGNOSTICS
 
 // Sensor status
 bool sht_sensor_available = false;
-uint8_t sht_sensor_address = 0x00;  // Detected SHT address
+uint8_t sht_sensor_address = 0x00;  // Active SHT (first present in shtSensors)
 bool fuel_sensor_available = false;
+int selectedProbe = 0;              // Probe shown on the main menu and fuel detail view
+
+// Latest readings; fuel values come from the selected probe in fuelBus
+Centi fuelTemp;                     // Invalid until the first good reading
+int fuelLevel = -1;                 // Filtered level (see LevelFilter); the probe record keeps the raw value
+bool fuelSloshing = false;          // Level swinging (vehicle moving): level alerts are held
+Deci fuelConsumption;               // L/h from the level trend, invalid while measuring
+long fuelMinutesToEmpty = -1;       // At that rate, -1 = unknown
+const uint16_t CONSUMPTION_SLOPE_UNITS = 20; // Half width of the tank table slope used to turn units/h into L/h
+Deci fuelVolume;                    // Litres from the tank table, invalid without one
+uint32_t tankTableSerial = 0;       // Probe the table was looked up for
+bool tankTableChecked = false;
+const int32_t FUEL_ALERT_MARGIN_UNITS = 50;   // Level alert distance from min/max without a tank table
+const int32_t FUEL_ALERT_MARGIN_PERCENT = 2;  // ... and from empty/full of the tank table
+bool shtReadOk = false;
+bool fuelReadOk = false;
 
 // Menu system
 enum MenuState {
@@ -51,7 +110,9 @@ enum MenuState {
   MENU_FUEL_DETAIL,     // Detailed fuel information
   MENU_SHT_DETAIL,      // Large temperature/humidity display
   MENU_SETTING,         // Setting menu: Set Full/Empty
-  MENU_EXTENDED         // Extended commands menu
+  MENU_EXTENDED,        // Extended commands menu
+  MENU_CALIBRATING,     // Set Full/Empty job progress, then its result
+  MENU_DIAGNOSTICS      // Sampling rate and duty cycle per sensor, encoder changes the fuel mode
 };
 
 enum MenuHighlight {
@@ -75,6 +136,7 @@ enum ExtendedOption {
   EXTENDED_E3,
   EXTENDED_RESTART,
   EXTENDED_ALL,
+  EXTENDED_DIAGNOSTICS,
   EXTENDED_COUNT
 };
 
@@ -95,6 +157,25 @@ int menuTimeoutCounter = MENU_TIMEOUT_SECONDS;
 // Scroll position for detail views
 int detailScrollPosition = 0;
 const int MAX_SCROLL_POSITIONS = 5; // 0: Default view, 1: Raw data, 2: Firmware info, 3: Serial number, 4: Additional info
+const int FUEL_DETAIL_PAGES = 6;    // ... and for fuel 5: Consumption
+const int SHT_DETAIL_PAGES = 3;     // Per SHT sensor: 0: Large display, 1: Details, 2: Sensor info
+
+// Calibration result stays on screen for a moment after the job ends
+unsigned long calibrationEndTime = 0;
+const unsigned long CALIBRATION_RESULT_TIME = 2000;
+
+// Notifications cover the menu for their duration while loop() keeps running; more queue up behind
+struct Notification {
+  char title[24];
+  char message[FuelSensor::SET_RESPONSE_TEXT_SIZE];
+  unsigned long duration;
+};
+const int NOTIFICATION_QUEUE_SIZE = 4;
+const unsigned long NOTIFICATION_TIME = 2000;
+Notification notifications[NOTIFICATION_QUEUE_SIZE];
+int notificationCount = 0;
+unsigned long notificationShownAt = 0;  // When notifications[0] went on screen
+bool allCommandsOk = true;              // Extended "All Commands" replies so far all succeeded
 
 // Display update flags for responsive UI
 bool forceDisplayUpdate = false;
@@ -102,10 +183,12 @@ unsigned long lastDisplayUpdate = 0;
 const unsigned long MIN_DISPLAY_INTERVAL = 50; // Minimum 50ms between display updates
 
 // Hotswap detection variables
-bool prev_sht_sensor_available = false;
 bool prev_fuel_sensor_available = false;
 unsigned long lastSensorCheck = 0;
 const unsigned long SENSOR_CHECK_INTERVAL = 5000; // Check every 5 seconds
+const unsigned long FUEL_RESCAN_MAX_INTERVAL = 60000; // Quick rescans of an empty link back off to this
+CircuitBreaker fuelRescan(1, SENSOR_CHECK_INTERVAL, FUEL_RESCAN_MAX_INTERVAL); // Opens on each rescan that finds nothing
+bool fuelRescanPending = false;
 
 // Function declarations for hotswap detection
 void checkSensorHotswap();
@@ -138,11 +221,16 @@ void handleEncoderMenu(unsigned long currentTime) {
         break;
         
       case MENU_FUEL_DETAIL:
-      case MENU_SHT_DETAIL:
+      case MENU_SHT_DETAIL: {
         // Scroll through detail view sections
-        detailScrollPosition = (detailScrollPosition + positionChange + MAX_SCROLL_POSITIONS) % MAX_SCROLL_POSITIONS;
+        // SHT pages run on through every present sensor
+        int pages = currentMenuState == MENU_FUEL_DETAIL
+                        ? FUEL_DETAIL_PAGES
+                        : SHT_DETAIL_PAGES * max(1, shtSensors.getPresentCount());
+        detailScrollPosition = (detailScrollPosition + positionChange + pages) % pages;
         Serial.printf("Detail scroll position: %d\n", detailScrollPosition);
         break;
+      }
         
       case MENU_SETTING:
         // Navigate between Set Full and Set Empty
@@ -156,6 +244,15 @@ void handleEncoderMenu(unsigned long currentTime) {
         Serial.printf("Extended option: %d\n", currentExtended);
         break;
         
+      case MENU_DIAGNOSTICS: {
+        // Fixed -> adaptive -> burst for the fuel data polls
+        SampleScheduler& schedule = fuelBus.getDataSchedule();
+        int mode = (schedule.getMode() + positionChange) % SampleScheduler::MODE_COUNT;
+        schedule.setMode((SampleScheduler::Mode)((mode + SampleScheduler::MODE_COUNT) % SampleScheduler::MODE_COUNT));
+        Serial.printf("Fuel sampling mode: %s\n", schedule.getModeName());
+        break;
+      }
+      
       default:
         break;
     }
@@ -211,8 +308,8 @@ void handleEncoderMenu(unsigned long currentTime) {
     clickCount = 0;
   }
   
-  // Handle menu timeout (return to main after inactivity)
-  if (currentMenuState != MENU_MAIN && currentTime - lastMenuActivity >= 1000) {
+  // Handle menu timeout (return to main after inactivity); the diagnostics page stays up while rates are watched
+  if (currentMenuState != MENU_MAIN && currentMenuState != MENU_DIAGNOSTICS && currentTime - lastMenuActivity >= 1000) {
     lastMenuActivity = currentTime;
     if (menuTimeoutCounter > 0) {
       menuTimeoutCounter--;
@@ -259,29 +356,15 @@ void handleSingleClick() {
       break;
       
     case MENU_FUEL_DETAIL:
-      // Check if we're on the firmware page (page 3, index 2) and need to read firmware
-      if (detailScrollPosition == 2 && fuel_sensor_available) {
-        // Check if we already have firmware data
-        if (fuelSensor.getFirmwareVersionLength() == 0) {
-          Serial.println("Reading firmware version...");
-          if (fuelSensor.readFirmwareVersion()) {
-            Serial.println("Firmware version read successfully");
-          } else {
-            Serial.println("Failed to read firmware version");
-          }
-          // Stay in detail view to see the result
-          break;
-        }
-      } else if (detailScrollPosition == 3 && fuel_sensor_available) {
-        // Check if we already have serial number data
-        if (fuelSensor.getSerialNumberLength() == 0) {
-          Serial.println("Reading serial number...");
-          if (fuelSensor.readSerialNumber()) {
-            Serial.println("Serial number read successfully");
-          } else {
-            Serial.println("Failed to read serial number");
-          }
-          // Stay in detail view to see the result
+      // Firmware (page 3, index 2) and serial (page 4, index 3) are read when the probe is
+      // found; if that failed, queue the identity reads again and stay to see the result
+      if ((detailScrollPosition == 2 || detailScrollPosition == 3) && fuel_sensor_available) {
+        const FuelBusManager::Probe* probe = fuelBus.getProbe(selectedProbe);
+        bool missing = probe && (detailScrollPosition == 2 ? probe->firmwareVersionLength == 0
+                                                           : probe->serialNumberLength == 0);
+        if (missing) {
+          Serial.printf("Reading identity of probe 0x%02X...\n", probe->address);
+          fuelBus.requestIdentity(selectedProbe);
           break;
         }
       }
@@ -312,7 +395,24 @@ void handleSingleClick() {
       detailScrollPosition = 0; // Reset scroll position
       Serial.println("Returning to main menu from extended");
       break;
+    
+    case MENU_DIAGNOSTICS:
+      // Return to main menu, the selected fuel sampling mode stays in effect
+      currentMenuState = MENU_MAIN;
+      Serial.println("Returning to main menu from diagnostics");
+      break;
       
+    case MENU_CALIBRATING:
+      // Cancel a running job (no effect once the restart is sent), or close the result
+      if (calibration.isRunning()) {
+        calibration.cancel();
+      } else {
+        currentMenuState = MENU_MAIN;
+        detailScrollPosition = 0; // Reset scroll position
+        Serial.println("Returning to main menu from calibration");
+      }
+      break;
+    
     default:
       break;
   }
@@ -330,7 +430,28 @@ void handleDoubleClick() {
       currentSetting = SETTING_SET_FULL; // Reset to first option
       Serial.println("Entering setting mode");
       break;
+    
+    case MENU_FUEL_DETAIL:
+      // Switch to the next probe on the fuel link
+      if (fuelBus.getProbeCount() > 1) {
+        selectedProbe = (selectedProbe + 1) % fuelBus.getProbeCount();
+        updateFuelReading();
+        forceDisplayUpdate = true;
+        Serial.printf("Selected fuel probe %d/%d (0x%02X)\n", selectedProbe + 1, fuelBus.getProbeCount(),
+                      fuelBus.getProbe(selectedProbe)->address);
+      }
+      break;
       
+    case MENU_SHT_DETAIL:
+      // Jump to the first page of the next SHT sensor
+      if (shtSensors.getPresentCount() > 1) {
+        int sensor = (detailScrollPosition / SHT_DETAIL_PAGES + 1) % shtSensors.getPresentCount();
+        detailScrollPosition = sensor * SHT_DETAIL_PAGES;
+        forceDisplayUpdate = true;
+        Serial.printf("Selected SHT sensor %d/%d\n", sensor + 1, shtSensors.getPresentCount());
+      }
+      break;
+    
     default:
       break;
   }
@@ -355,6 +476,70 @@ void handleTripleClick() {
   }
 }
 
+// Menu commands only queue their request; the reply comes back through fuelSensor.poll() in
+// loop() and is shown from these callbacks, so display and encoder keep running meanwhile
+void onFactoryResetReply(FuelSensor& sensor, const FuelSensor::TransactionResult& result, void*) {
+  char responseStr[FuelSensor::SET_RESPONSE_TEXT_SIZE];
+  bool hasResponse = sensor.formatLastSetResponse(responseStr, sizeof(responseStr)) > 0;
+  if (result.status == FuelSensor::TRANSACTION_OK && sensor.getLastSetSuccess()) {
+    // Show detailed response information
+    notify("RESET OK", responseStr, NOTIFICATION_TIME);
+    Serial.println("FACTORY RESET command successful");
+  } else {
+    // Show error with response if available
+    if (hasResponse) {
+      notify("RESET ERR", responseStr, NOTIFICATION_TIME);
+    } else {
+      notify("FACTORY RESET", "NO RESPONSE", NOTIFICATION_TIME);
+    }
+    Serial.println("FACTORY RESET command failed");
+  }
+  
+  // Factory reset changes the probe's limits: drop cached values, read them again
+  fuelBus.invalidateLimits();
+}
+
+void onEmptyFrequencyReply(FuelSensor& sensor, const FuelSensor::TransactionResult& result, void*) {
+  if (result.status != FuelSensor::TRANSACTION_OK) {
+    notify("READ FREQ", "FAILED", NOTIFICATION_TIME);
+    Serial.println("READ EMPTY FREQUENCY command failed");
+    return;
+  }
+  
+  // Show response first, then the frequency value for 3 seconds
+  notify("READ FREQ", "SUCCESS", NOTIFICATION_TIME);
+  uint16_t frequency = sensor.getEmptyFrequency();
+  char freqStr[16];
+  sprintf(freqStr, "FREQ: %d", frequency);
+  notify("EMPTY FREQ", freqStr, 3000);
+  Serial.printf("READ EMPTY FREQUENCY successful: %d\n", frequency);
+}
+
+// context: the menu title of the command
+void onExtendedReply(FuelSensor&, const FuelSensor::TransactionResult& result, void* context) {
+  const char* title = (const char*)context;
+  bool success = result.status == FuelSensor::TRANSACTION_OK;
+  notify(title, success ? "SUCCESS" : "FAILED", NOTIFICATION_TIME);
+  Serial.printf("%s command: %s\n", title, success ? "SUCCESS" : "FAILED");
+}
+
+// "All Commands" is three requests; the restart, queued last, reports the whole sequence
+void onAllCommandsReply(FuelSensor&, const FuelSensor::TransactionResult& result, void*) {
+  allCommandsOk = allCommandsOk && result.status == FuelSensor::TRANSACTION_OK;
+  if (result.eventCode == FuelSensor::EVENT_RESTART_SENSOR) {
+    notify("All Commands", allCommandsOk ? "SUCCESS" : "FAILED", NOTIFICATION_TIME);
+    Serial.printf("Multiple commands: %s\n", allCommandsOk ? "SUCCESS" : "FAILED");
+  }
+}
+
+// Queue one extended command; a full queue is reported at once, the outcome by onExtendedReply()
+void sendExtendedCommand(const char* title, uint8_t eventCode) {
+  if (fuelSensor.submitRequest(selectedProbeAddress(), eventCode, onExtendedReply, (void*)title) ==
+      FuelSensor::INVALID_TRANSACTION) {
+    notify(title, "BUSY", NOTIFICATION_TIME);
+  }
+}
+
 void handleLongPress() {
   buzzer.playTemperatureAlert(); // Long beep for confirmation
   Serial.printf("Long press detected in menu state: %d\n", currentMenuState);
@@ -369,126 +554,78 @@ void handleLongPress() {
       break;
       
     case MENU_SETTING:
+      // Set Full/Empty run as a background job with their own progress screen
+      if ((currentSetting == SETTING_SET_FULL || currentSetting == SETTING_SET_EMPTY) && fuel_sensor_available) {
+        // Only the selected probe stores the new point; a lone probe answers broadcast whatever its address
+        uint8_t address = fuelBus.getOnlineCount() == 1 ? FuelSensor::BROADCAST_ADDRESS : selectedProbeAddress();
+        calibration.start(currentSetting == SETTING_SET_FULL ? CalibrationJob::CALIBRATE_FULL
+                                                              : CalibrationJob::CALIBRATE_EMPTY, address);
+        currentMenuState = MENU_CALIBRATING;
+        calibrationEndTime = 0;
+        forceDisplayUpdate = true;
+        break;
+      }
+      
       // Send command to fuel sensor
-      if (currentSetting == SETTING_SET_FULL) {
-        Serial.println("Sending SET FULL command to fuel sensor");
-        if (fuel_sensor_available && fuelSensor.setFullLevel()) {
-          // Show detailed response information
-          String responseStr = fuelSensor.getLastSetResponseString();
-          display.showNotification("SET FULL OK", responseStr.c_str());
-          Serial.println("SET FULL command successful");
-        } else {
-          // Show error with response if available
-          String responseStr = fuelSensor.getLastSetResponseString();
-          if (responseStr.length() > 0) {
-            display.showNotification("SET FULL ERR", responseStr.c_str());
-          } else {
-            display.showNotification("SET FULL", "NO RESPONSE");
-          }
-          Serial.println("SET FULL command failed");
-        }
-      } else if (currentSetting == SETTING_SET_EMPTY) {
-        Serial.println("Sending SET EMPTY command to fuel sensor");
-        if (fuel_sensor_available && fuelSensor.setEmptyLevel()) {
-          // Show detailed response information
-          String responseStr = fuelSensor.getLastSetResponseString();
-          display.showNotification("SET EMPTY OK", responseStr.c_str());
-          Serial.println("SET EMPTY command successful");
-        } else {
-          // Show error with response if available
-          String responseStr = fuelSensor.getLastSetResponseString();
-          if (responseStr.length() > 0) {
-            display.showNotification("SET EMPTY ERR", responseStr.c_str());
-          } else {
-            display.showNotification("SET EMPTY", "NO RESPONSE");
-          }
-          Serial.println("SET EMPTY command failed");
-        }
+      if (currentSetting == SETTING_SET_FULL || currentSetting == SETTING_SET_EMPTY) {
+        notify(currentSetting == SETTING_SET_FULL ? "SET FULL" : "SET EMPTY", "NO SENSOR", NOTIFICATION_TIME);
+        Serial.println("Calibration not started - no sensor");
       } else if (currentSetting == SETTING_FACTORY_RESET) {
-        Serial.println("Sending FACTORY RESET command to fuel sensor");
-        if (fuel_sensor_available && fuelSensor.factoryReset()) {
-          // Show detailed response information
-          String responseStr = fuelSensor.getLastSetResponseString();
-          display.showNotification("RESET OK", responseStr.c_str());
-          Serial.println("FACTORY RESET command successful");
-        } else {
-          // Show error with response if available
-          String responseStr = fuelSensor.getLastSetResponseString();
-          if (responseStr.length() > 0) {
-            display.showNotification("RESET ERR", responseStr.c_str());
-          } else {
-            display.showNotification("FACTORY RESET", "NO RESPONSE");
-          }
-          Serial.println("FACTORY RESET command failed");
+        Serial.printf("Sending FACTORY RESET command to fuel probe 0x%02X\n", selectedProbeAddress());
+        if (!fuel_sensor_available) {
+          notify("FACTORY RESET", "NO RESPONSE", NOTIFICATION_TIME);
+        } else if (fuelSensor.factoryReset(selectedProbeAddress(), onFactoryResetReply) == FuelSensor::INVALID_TRANSACTION) {
+          notify("FACTORY RESET", "BUSY", NOTIFICATION_TIME);
         }
       } else if (currentSetting == SETTING_RESTART) {
-        Serial.println("Sending RESTART command to fuel sensor");
-        if (fuel_sensor_available) {
-          fuelSensor.restartSensor(); // No response expected
-          display.showNotification("RESTART", "COMMAND SENT");
-          Serial.println("RESTART command sent successfully");
+        Serial.printf("Sending RESTART command to fuel probe 0x%02X\n", selectedProbeAddress());
+        // No response expected: queued is as good as sent
+        if (fuel_sensor_available && fuelSensor.restartSensor(selectedProbeAddress()) != FuelSensor::INVALID_TRANSACTION) {
+          notify("RESTART", "COMMAND SENT", NOTIFICATION_TIME);
+          Serial.println("RESTART command queued");
         } else {
-          display.showNotification("RESTART", "NO SENSOR");
-          Serial.println("RESTART command failed - no sensor");
+          notify("RESTART", fuel_sensor_available ? "BUSY" : "NO SENSOR", NOTIFICATION_TIME);
+          Serial.println("RESTART command failed");
         }
       } else if (currentSetting == SETTING_READ_EMPTY_FREQ) {
-        Serial.println("Sending READ EMPTY FREQUENCY command to fuel sensor");
-        if (fuel_sensor_available && fuelSensor.readEmptyFrequency()) {
-          // Show response first
-          display.showNotification("READ FREQ", "SUCCESS");
-          delay(2000);
-          
-          // Then show the frequency value for 3 seconds
-          uint16_t frequency = fuelSensor.getEmptyFrequency();
-          char freqStr[16];
-          sprintf(freqStr, "FREQ: %d", frequency);
-          display.showNotification("EMPTY FREQ", freqStr);
-          delay(3000);
-          
-          Serial.printf("READ EMPTY FREQUENCY successful: %d\n", frequency);
-        } else {
-          display.showNotification("READ FREQ", "FAILED");
+        Serial.printf("Sending READ EMPTY FREQUENCY command to fuel probe 0x%02X\n", selectedProbeAddress());
+        if (!fuel_sensor_available ||
+            fuelSensor.readEmptyFrequency(selectedProbeAddress(), onEmptyFrequencyReply) == FuelSensor::INVALID_TRANSACTION) {
+          notify("READ FREQ", "FAILED", NOTIFICATION_TIME);
           Serial.println("READ EMPTY FREQUENCY command failed");
         }
       }
       
-      // Show confirmation for 2 seconds
-      delay(2000);
-      
-      // Return to main menu after command
+      // Return to main menu after queuing the command, the reply shows up as a notification
       currentMenuState = MENU_MAIN;
       detailScrollPosition = 0; // Reset scroll position
       Serial.println("Returning to main menu after long press action");
       break;
       
     case MENU_EXTENDED:
-      // Execute selected extended command
+      // Diagnostics is a page, not a command: open it without the confirmation pause
+      if (currentExtended == EXTENDED_DIAGNOSTICS) {
+        currentMenuState = MENU_DIAGNOSTICS;
+        forceDisplayUpdate = true;
+        Serial.println("Entering diagnostics");
+        break;
+      }
+      
+      // Queue the selected extended command, its callback shows the result
       if (currentExtended == EXTENDED_FIRMWARE) {
-        display.showNotification("Read FW", "Sending...");
-        bool success = fuelSensor.readFirmwareVersion();
-        display.showNotification("Read FW", success ? "SUCCESS" : "FAILED");
-        Serial.printf("Read firmware command: %s\n", success ? "SUCCESS" : "FAILED");
+        sendExtendedCommand("Read FW", FuelSensor::EVENT_READ_FIRMWARE);
       } else if (currentExtended == EXTENDED_E3) {
-        display.showNotification("Extended E3", "Sending...");
-        bool success = fuelSensor.sendExtendedE3();
-        display.showNotification("Extended E3", success ? "SUCCESS" : "FAILED");
-        Serial.printf("Extended E3 command: %s\n", success ? "SUCCESS" : "FAILED");
+        sendExtendedCommand("Extended E3", FuelSensor::EVENT_EXTENDED_E3);
       } else if (currentExtended == EXTENDED_RESTART) {
-        display.showNotification("Restart", "Sending...");
-        bool success = fuelSensor.restartSensor();
-        display.showNotification("Restart", success ? "SUCCESS" : "FAILED");
-        Serial.printf("Restart sensor command: %s\n", success ? "SUCCESS" : "FAILED");
+        sendExtendedCommand("Restart", FuelSensor::EVENT_RESTART_SENSOR);
       } else if (currentExtended == EXTENDED_ALL) {
-        display.showNotification("All Commands", "Sending...");
-        bool success = fuelSensor.sendMultipleCommands();
-        display.showNotification("All Commands", success ? "SUCCESS" : "FAILED");
-        Serial.printf("Multiple commands: %s\n", success ? "SUCCESS" : "FAILED");
+        allCommandsOk = true;
+        if (fuelSensor.sendMultipleCommands(selectedProbeAddress(), onAllCommandsReply) == FuelSensor::INVALID_TRANSACTION) {
+          notify("All Commands", "BUSY", NOTIFICATION_TIME);
+        }
       }
       
-      // Show confirmation for 2 seconds
-      delay(2000);
-      
-      // Return to main menu after command
+      // Return to main menu after queuing the command, the reply shows up as a notification
       currentMenuState = MENU_MAIN;
       detailScrollPosition = 0; // Reset scroll position
       Serial.println("Returning to main menu after extended command");
@@ -500,24 +637,82 @@ void handleLongPress() {
   }
 }
 
-// Calculate fuel percentage based on min/max levels
-float calculateFuelPercentage(int currentLevel) {
-  if (!fuel_sensor_available || !fuelSensor.areLimitsValid() || currentLevel < 0) {
-    return -1.0; // Invalid
+// Calculate fuel percentage (0.01 % steps): share of the tank table's volume range when one is
+// loaded, otherwise linear between the probe's min/max levels in raw sensor units
+Centi calculateFuelPercentage(int currentLevel) {
+  const FuelBusManager::Probe* probe = fuelBus.getProbe(selectedProbe);
+  if (tankTable.isValid() && fuelVolume.isValid()) {
+    int32_t emptyVolume = tankTable.getMinVolume().toRaw();
+    int32_t fullVolume = tankTable.getMaxVolume().toRaw();
+    if (fullVolume <= emptyVolume) {
+      return Centi::invalid();
+    }
+    return Centi::fromRaw((int32_t)((int64_t)(fuelVolume.toRaw() - emptyVolume) * 10000 / (fullVolume - emptyVolume)));
+  }
+  if (!fuel_sensor_available || !probe || !probe->limitsValid || currentLevel < 0) {
+    return Centi::invalid();
   }
   
-  float minLevel = fuelSensor.getLevelMinLiters();
-  float maxLevel = fuelSensor.getLevelMaxLiters();
+  int32_t minLevel = probe->levelMin;
+  int32_t maxLevel = probe->levelMax;
   
   if (maxLevel <= minLevel) {
-    return -1.0; // Invalid range
+    return Centi::invalid(); // Invalid range
   }
   
-  float percentage = ((float)currentLevel - minLevel) / (maxLevel - minLevel) * 100.0;
+  int32_t percentage = (currentLevel - minLevel) * 10000 / (maxLevel - minLevel);
   if (percentage < 0) percentage = 0;
-  if (percentage > 100) percentage = 100;
+  if (percentage > 10000) percentage = 10000;
   
-  return percentage;
+  return Centi::fromRaw(percentage);
+}
+
+// SHT presence without polling present sensors: absent addresses are probed with backoff
+// (1 s doubling to 30 s), present ones are lost when their sweep measurements fail
+void checkShtPresence(unsigned long currentTime) {
+  char foundName[16], lostName[16];
+  int found = 0;
+  while (SHTSensor* sht = shtSensors.poll(currentTime)) {
+    formatShtName(foundName, sizeof(foundName), sht);
+    found++;
+  }
+  int lost = 0;
+  for (int index = shtSensors.takeLost(); index >= 0; index = shtSensors.takeLost()) {
+    formatShtName(lostName, sizeof(lostName), shtSensors.getSensor(index));
+    lost++;
+  }
+  if (found == 0 && lost == 0) {
+    return;
+  }
+  updateShtAvailability();
+  // One notification per batch (a multiplexer plugged in or pulled out with its sensors)
+  if (found > 1) {
+    snprintf(foundName, sizeof(foundName), "%d SHT sensors", found);
+  }
+  if (found > 0) {
+    onSensorConnected(foundName);
+  }
+  if (lost > 1) {
+    snprintf(lostName, sizeof(lostName), "%d SHT sensors", lost);
+  }
+  if (lost > 0) {
+    onSensorDisconnected(lostName);
+  }
+}
+
+// "SHT c3 0x44" behind the multiplexer, "SHT at 0x44" on the main bus
+void formatShtName(char* buffer, size_t size, const SHTSensor* sht) {
+  if (sht->getChannel() != I2CBus::NO_CHANNEL) {
+    snprintf(buffer, size, "SHT c%u 0x%02X", sht->getChannel(), sht->getAddress());
+  } else {
+    snprintf(buffer, size, "SHT at 0x%02X", sht->getAddress());
+  }
+}
+
+void updateShtAvailability() {
+  SHTSensor* active = shtSensors.getActive();
+  sht_sensor_available = active != nullptr;
+  sht_sensor_address = active != nullptr ? active->getAddress() : 0;
 }
 
 // Hotswap detection functions
@@ -529,63 +724,343 @@ void checkSensorHotswap() {
   
   lastSensorCheck = currentTime;
   
-  // Check SHT sensor hotswap
-  bool current_sht_available = false;
-  
-  // Try to detect SHT sensor (quick check without full begin)
-  Wire.beginTransmission(0x44);
-  if (Wire.endTransmission() == 0) {
-    current_sht_available = true;
-    if (!sht_sensor_available && sht_sensor_address != 0x44) {
-      // New SHT sensor detected at 0x44
-      if (sht1.begin(SDA_PIN, SCL_PIN)) {
-        sht_sensor_available = true;
-        sht_sensor_address = 0x44;
-        onSensorConnected("SHT at 0x44");
-      }
+  // SHT presence is event driven, see checkShtPresence()
+  
+  // Check Fuel probes hotswap: the bus manager marks probes offline/online from its
+  // round-robin polls, so availability is just "any probe online" (no extra request on the link)
+  bool current_fuel_available = fuelBus.getOnlineCount() > 0;
+  if (current_fuel_available && !fuel_sensor_available) {
+    // Fuel sensor reconnected
+    fuel_sensor_available = true;
+    onSensorConnected("Fuel");
+  } else if (!current_fuel_available && fuel_sensor_available) {
+    // Fuel sensor disconnected
+    fuel_sensor_available = false;
+    fuelTemp = Centi::invalid();
+    fuelLevel = -1;
+    fuelVolume = Deci::invalid();
+    fuelReadOk = false;
+    onSensorDisconnected("Fuel");
+  }
+  
+  // Nothing answering: look for a newly plugged probe in the usual address range, less often
+  // each time a rescan comes back empty (5 s doubling to 60 s)
+  if (current_fuel_available) {
+    if (fuelRescanPending || !fuelRescan.isClosed()) {
+      fuelRescan.recordSuccess(currentTime);
+    }
+    fuelRescanPending = false;
+  } else if (!fuelBus.isScanning()) {
+    if (fuelRescanPending) {
+      fuelRescan.recordFailure(currentTime);
+      fuelRescanPending = false;
     }
+    if (fuelRescan.allowRequest(currentTime)) {
+      fuelBus.startScan(FuelBusManager::FIRST_ADDRESS, FuelBusManager::QUICK_SCAN_LAST);
+      fuelRescanPending = true;
+    }
+  }
+  prev_fuel_sensor_available = current_fuel_available;
+}
+
+// Follow the calibration job: progress while it runs, then its result for a moment
+void updateCalibration(unsigned long currentTime) {
+  if (currentMenuState != MENU_CALIBRATING) {
+    return;
+  }
+  menuTimeoutCounter = MENU_TIMEOUT_SECONDS; // No menu timeout on this screen
+  if (calibration.isRunning()) {
+    return;
+  }
+  
+  if (calibrationEndTime == 0) {
+    calibrationEndTime = currentTime;
+    forceDisplayUpdate = true;
+    // The calibrated probe's limits (and cached copy) are stale; after a broadcast that may be any probe
+    fuelBus.invalidateLimits();
+    if (calibration.getState() == CalibrationJob::JOB_DONE) {
+      buzzer.playSuccess();
+    } else {
+      buzzer.playError();
+    }
+  } else if (currentTime - calibrationEndTime >= CALIBRATION_RESULT_TIME) {
+    currentMenuState = MENU_MAIN;
+    detailScrollPosition = 0; // Reset scroll position
+    forceDisplayUpdate = true;
+    Serial.println("Returning to main menu after calibration");
+  }
+}
+
+// Queue a notification; it goes on screen at once when none is showing
+void notify(const char* title, const char* message, unsigned long duration) {
+  if (notificationCount == NOTIFICATION_QUEUE_SIZE) {
+    Serial.printf("Notification dropped: %s %s\n", title, message);
+    return;
+  }
+  Notification& notification = notifications[notificationCount++];
+  snprintf(notification.title, sizeof(notification.title), "%s", title);
+  snprintf(notification.message, sizeof(notification.message), "%s", message);
+  notification.duration = duration;
+  if (notificationCount == 1) {
+    notificationShownAt = millis();
+    display.showNotification(notification.title, notification.message);
+  }
+}
+
+// Take the current notification down once its time is up and show the next, or the menu again
+void updateNotifications(unsigned long currentTime) {
+  if (notificationCount == 0 || currentTime - notificationShownAt < notifications[0].duration) {
+    return;
+  }
+  notificationCount--;
+  memmove(notifications, notifications + 1, notificationCount * sizeof(Notification));
+  if (notificationCount > 0) {
+    notificationShownAt = currentTime;
+    display.showNotification(notifications[0].title, notifications[0].message);
   } else {
-    Wire.beginTransmission(0x45);
-    if (Wire.endTransmission() == 0) {
-      current_sht_available = true;
-      if (!sht_sensor_available && sht_sensor_address != 0x45) {
-        // New SHT sensor detected at 0x45
-        if (sht2.begin(SDA_PIN, SCL_PIN)) {
-          sht_sensor_available = true;
-          sht_sensor_address = 0x45;
-          onSensorConnected("SHT at 0x45");
+    forceDisplayUpdate = true;
+  }
+}
+
+// "FUEL ADPT 0.5Hz 1%": name, mode, samples per second and % of the time spent sampling
+void formatScheduleLine(char* buffer, size_t size, const char* name, const SampleScheduler& schedule) {
+  char rateText[FIXED_TEXT_SIZE], dutyText[FIXED_TEXT_SIZE];
+  schedule.getRate().format(rateText, sizeof(rateText), 1);
+  schedule.getDutyCycle().format(dutyText, sizeof(dutyText), 0);
+  snprintf(buffer, size, "%-4s %-4s %sHz %s%%", name, schedule.getModeName(), rateText, dutyText);
+}
+
+// LittleFS holds the link captures and tank tables; formatted if it cannot be mounted
+bool mountFileSystem() {
+  static bool fsMounted = false;
+  if (!fsMounted) {
+    fsMounted = LittleFS.begin(true);
+  }
+  return fsMounted;
+}
+
+// Tank table of a probe: /tank_<serial>.csv, else the shared /tank.csv (format in StrappingTable.h);
+// without either the level stays in sensor units
+void loadTankTable(uint32_t serialNumber) {
+  char path[32];
+  snprintf(path, sizeof(path), "/tank_%lu.csv", (unsigned long)serialNumber);
+  tankTableSerial = serialNumber;
+  tankTableChecked = true;
+  if (!mountFileSystem() || (!tankTable.load(LittleFS, path) && !tankTable.load(LittleFS, "/tank.csv"))) {
+    tankTable.clear();
+  }
+}
+
+// Single-letter commands on the USB console for field traces of the fuel link:
+//   d = dump capture as text, s = save to LittleFS, c = clear, p = pause/resume recording,
+//   v = trace every fuel request and reply on/off, l = link health (breaker state and counters
+//   per probe), t = reload and print the tank table, r = next SHT repeatability (low/medium/
+//   high), m = next SHT mode (single shot, periodic 0.5/1/2/4/10 mps, ART), h = SHT heater
+//   on/off and status register, i = I2C bus statistics
+void handleConsole() {
+  static const char* CAPTURE_PATH = "/fuel_capture.bin";
+  
+  while (Serial.available()) {
+    switch (Serial.read()) {
+      case 'd':
+        fuelCapture.dump(Serial);
+        break;
+      case 's':
+        if (!mountFileSystem() || !fuelCapture.save(LittleFS, CAPTURE_PATH)) {
+          Serial.println("UART capture: save failed");
+        }
+        break;
+      case 'c':
+        fuelCapture.clear();
+        Serial.println("UART capture cleared");
+        break;
+      case 'p':
+        fuelCapture.setEnabled(!fuelCapture.isEnabled());
+        Serial.printf("UART capture %s\n", fuelCapture.isEnabled() ? "recording" : "paused");
+        break;
+      case 'v':
+        fuelSensor.setVerbose(!fuelSensor.isVerbose());
+        Serial.printf("Fuel link trace %s\n", fuelSensor.isVerbose() ? "on" : "off");
+        break;
+      case 'l':
+        fuelBus.printLinkHealth(Serial);
+        Serial.printf("Rescan: %s, next in %lu ms\n", fuelRescan.getStateName(), fuelRescan.getRetryIn(millis()));
+        break;
+      case 't':
+        loadTankTable(tankTableSerial);
+        if (tankTable.isValid()) {
+          tankTable.writeTo(Serial);
+        } else {
+          Serial.println("No tank table, level in sensor units");
+        }
+        break;
+      case 'r': {
+        static const char* REPEATABILITY_NAMES[] = {"low", "medium", "high"};
+        shtRepeatability = (SHTSensor::Repeatability)((shtRepeatability + 1) % 3);
+        shtSensors.setMode(shtRepeatability, shtPeriodicRate);
+        SHTSensor* sht = shtSensors.getActive();
+        if (sht != nullptr) {
+          sht->setRepeatability(shtRepeatability);
+          Serial.printf("SHT repeatability %s (%lu ms conversion)\n", REPEATABILITY_NAMES[shtRepeatability],
+                        sht->getConversionTime());
+        } else {
+          Serial.printf("SHT repeatability %s\n", REPEATABILITY_NAMES[shtRepeatability]);
+        }
+        break;
+      }
+      case 'm':
+        // Applied to each sensor at the start of the next sweep
+        shtPeriodicRate = shtPeriodicRate + 1 < SHTSensor::RATE_COUNT ? shtPeriodicRate + 1 : -1;
+        shtSensors.setMode(shtRepeatability, shtPeriodicRate);
+        if (shtPeriodicRate < 0) {
+          Serial.println("SHT single shot");
+        } else {
+          Serial.printf("SHT periodic %s mps\n", SHTSensor::getRateName((SHTSensor::Rate)shtPeriodicRate));
         }
+        break;
+      case 'i':
+        i2cBus.printStats(Serial);
+        shtSensors.printStatus(Serial, millis());
+        break;
+      case 'h': {
+        SHTSensor* sht = shtSensors.getActive();
+        if (sht == nullptr) {
+          Serial.println("No SHT sensor");
+          break;
+        }
+        shtHeater = !shtHeater;
+        uint16_t status = 0;
+        bool heaterOk = sht->setHeater(shtHeater);
+        if (sht->readStatus(status)) {
+          Serial.printf("SHT heater %s%s, status 0x%04X%s%s, restarts %lu\n", shtHeater ? "on" : "off",
+                        heaterOk ? "" : " (failed)", status,
+                        (status & SHTSensor::STATUS_HEATER_ON) ? " heater" : "",
+                        (status & SHTSensor::STATUS_RESET_DETECTED) ? " reset" : "",
+                        (unsigned long)sht->getRestarts());
+          sht->clearStatus();
+        } else {
+          Serial.printf("SHT heater %s%s, status unreadable\n", shtHeater ? "on" : "off", heaterOk ? "" : " (failed)");
+        }
+        break;
       }
+      default:
+        break;
     }
   }
+}
+
+// Address for commands meant for the selected probe; broadcast only while no probe is known
+uint8_t selectedProbeAddress() {
+  const FuelBusManager::Probe* probe = fuelBus.getProbe(selectedProbe);
+  return probe ? probe->address : FuelSensor::BROADCAST_ADDRESS;
+}
+
+// Copy the selected probe's latest reading into the display values
+void updateFuelReading() {
+  const FuelBusManager::Probe* probe = fuelBus.getProbe(selectedProbe);
+  if (probe && probe->serialNumberLength > 0) {
+    if (!tankTableChecked || probe->serialNumber != tankTableSerial) {
+      loadTankTable(probe->serialNumber);
+    }
+  } else if (tankTableChecked) {
+    // Serial not read yet: the table of the previously selected probe does not apply to this one
+    tankTable.clear();
+    tankTableSerial = 0;
+    tankTableChecked = false;
+  }
   
-  // Check if SHT sensor was disconnected
-  if (prev_sht_sensor_available && !current_sht_available && sht_sensor_available) {
-    sht_sensor_available = false;
-    sht_sensor_address = 0;
-    onSensorDisconnected("SHT");
+  if (probe && probe->online && probe->dataValid) {
+    fuelTemp = probe->temperature;
+    fuelLevel = probe->level.getLevel(); // 0-4095, smoothed
+    fuelSloshing = probe->level.isSloshing();
+    fuelVolume = tankTable.lookup(fuelLevel, probe->frequency);
+    updateFuelConsumption(probe);
+    char volumeText[FIXED_TEXT_SIZE];
+    fuelVolume.format(volumeText, sizeof(volumeText), 1);
+    Serial.printf("Fuel Sensor 0x%02X (RS232): %ld°C, %d units (raw %u, var %lu%s), %s L\n", probe->address,
+                  (long)fuelTemp.whole(), fuelLevel, probe->fuelValue, (unsigned long)probe->level.getVariance(),
+                  fuelSloshing ? ", slosh" : "", volumeText);
+    char rawText[FuelSensor::RAW_TEXT_SIZE];
+    FuelSensor::formatHex(probe->rawFrame, probe->rawFrameLength, rawText, sizeof(rawText));
+    Serial.printf("Raw Data: %s\n", rawText);
+    fuelReadOk = true;
+  } else {
+    fuelTemp = Centi::invalid();
+    fuelLevel = -1;
+    fuelSloshing = false;
+    fuelVolume = Deci::invalid();
+    fuelConsumption = Deci::invalid();
+    fuelMinutesToEmpty = -1;
+    fuelReadOk = false;
+  }
+}
+
+// Level trend of the selected probe in L/h (positive = burning) and the time left at that rate
+void updateFuelConsumption(const FuelBusManager::Probe* probe) {
+  fuelConsumption = Deci::invalid();
+  fuelMinutesToEmpty = -1;
+  Centi unitsPerHour = probe->consumption.getRate();
+  if (!unitsPerHour.isValid()) {
+    return;
   }
   
-  // Check Fuel sensor hotswap (try basic communication)
-  bool current_fuel_available = false;
-  if (fuelSensor.isConnected()) {
-    current_fuel_available = true;
-    if (!fuel_sensor_available) {
-      // Fuel sensor reconnected
-      fuel_sensor_available = true;
-      onSensorConnected("Fuel");
+  // Litres per unit at the current level: local slope of the tank table, else the probe's 0.1 L
+  int64_t litres = 1;    // 0.1 L ...
+  int64_t units = 1;     // ... per this many units
+  if (tankTable.isValid() && tankTable.getInput() == StrappingTable::INPUT_UNITS) {
+    uint16_t low = fuelLevel > CONSUMPTION_SLOPE_UNITS ? fuelLevel - CONSUMPTION_SLOPE_UNITS : 0;
+    uint16_t high = fuelLevel + CONSUMPTION_SLOPE_UNITS;
+    litres = tankTable.lookup(high).toRaw() - tankTable.lookup(low).toRaw();
+    units = high - low;
+  }
+  fuelConsumption = Deci::fromRaw((int32_t)(unitsPerHour.toRaw() * litres / (units * 100)));
+  
+  // Fuel above empty: tank table volume, else units above the probe's empty level
+  Deci remaining = Deci::fromRaw(fuelLevel);
+  if (fuelVolume.isValid()) {
+    remaining = fuelVolume - tankTable.getMinVolume();
+  } else if (probe->limitsValid) {
+    remaining = Deci::fromRaw(fuelLevel > probe->levelMin ? fuelLevel - probe->levelMin : 0);
+  }
+  if (fuelConsumption > Deci::fromRaw(0)) {
+    fuelMinutesToEmpty = (long)((int64_t)remaining.toRaw() * 60 / fuelConsumption.toRaw());
+  }
+}
+
+// Refuel/drain steps found by the bus manager: log, beep and show them. Litres come from the
+// tank table for the selected probe (units table), others use the probe's 0.1 L per unit.
+void checkFuelEvents() {
+  for (int i = 0; i < fuelBus.getProbeCount(); i++) {
+    LevelEventDetector::Event event;
+    if (!fuelBus.takeLevelEvent(i, event)) {
+      continue;
     }
-  } else {
-    if (fuel_sensor_available) {
-      // Fuel sensor disconnected
-      fuel_sensor_available = false;
-      onSensorDisconnected("Fuel");
+    
+    Deci startVolume = Deci::fromRaw(event.startLevel);
+    Deci endVolume = Deci::fromRaw(event.endLevel);
+    if (i == selectedProbe && tankTable.isValid() && tankTable.getInput() == StrappingTable::INPUT_UNITS) {
+      startVolume = tankTable.lookup(event.startLevel);
+      endVolume = tankTable.lookup(event.endLevel);
     }
+    Deci delta = endVolume - startVolume;
+    char deltaText[FIXED_TEXT_SIZE], title[24], message[24];
+    delta.format(deltaText, sizeof(deltaText), 1);
+    const char* sign = delta > Deci::fromRaw(0) ? "+" : "";
+    const char* name = LevelEventDetector::getTypeName(event.type);
+    
+    Serial.printf("Fuel probe 0x%02X %s %s%s L (%u -> %u units), %lu-%lu s\n", fuelBus.getProbe(i)->address,
+                  name, sign, deltaText, event.startLevel, event.endLevel,
+                  event.startTime / 1000, event.endTime / 1000);
+    if (event.type == LevelEventDetector::EVENT_REFUEL) {
+      buzzer.playSuccess();
+    } else {
+      buzzer.playWarning();   // Siphoning or a leak
+    }
+    
+    snprintf(title, sizeof(title), "%s %02X:", name, fuelBus.getProbe(i)->address);
+    snprintf(message, sizeof(message), "%s%s L", sign, deltaText);
+    notify(title, message, NOTIFICATION_TIME);
   }
-  
-  // Update previous states
-  prev_sht_sensor_available = current_sht_available;
-  prev_fuel_sensor_available = current_fuel_available;
 }
 
 void onSensorConnected(const char* sensorName) {
@@ -593,8 +1068,7 @@ void onSensorConnected(const char* sensorName) {
   buzzer.playSensorFound(1);
   
   // Brief notification on display
-  display.showNotification("SENSOR CONNECTED:", sensorName);
-  delay(1500);
+  notify("SENSOR CONNECTED:", sensorName, NOTIFICATION_TIME);
 }
 
 void onSensorDisconnected(const char* sensorName) {
@@ -602,8 +1076,7 @@ void onSensorDisconnected(const char* sensorName) {
   buzzer.playWarning();
   
   // Brief notification on display
-  display.showNotification("SENSOR LOST:", sensorName);
-  delay(1500);
+  notify("SENSOR LOST:", sensorName, NOTIFICATION_TIME);
 }
 
 void setup() {
@@ -640,8 +1113,9 @@ void setup() {
   }
   buzzer.playStartupSequence();
   
-  // Initialize display
-  if (!display.begin(SDA_PIN, SCL_PIN)) {
+  // Initialize the I2C bus, then the display on it
+  i2cBus.begin(SDA_PIN, SCL_PIN);
+  if (!display.begin(i2cBus)) {
     Serial.println("OLED display initialization failed!");
     // Error indication: fast blinking LED1
     for (int i = 0; i < 10; i++) {
@@ -658,20 +1132,31 @@ void setup() {
   display.showStartupMessage();
   delay(2000);
   
-  // Initialize I2C for sensors (already done by display.begin)
+  // SHT sensors share the display's bus (i2cBus)
   display.showConnecting();
   
-  // Auto-detect SHT sensor (try 0x44 first, then 0x45)
+  // Auto-detect SHT sensors (0x44 first, then 0x45); later ones are found by checkShtPresence.
+  // With a TCA9548A both addresses are looked for on each of its channels instead
   Serial.println("Auto-detecting SHT sensor...");
-  if (sht1.begin(SDA_PIN, SCL_PIN)) {
-    sht_sensor_available = true;
-    sht_sensor_address = 0x44;
-    Serial.println("SHT sensor found at 0x44");
-    buzzer.playSensorFound(1);
-  } else if (sht2.begin(SDA_PIN, SCL_PIN)) {
-    sht_sensor_available = true; 
-    sht_sensor_address = 0x45;
-    Serial.println("SHT sensor found at 0x45");
+  shtSensors.begin(i2cBus);
+  shtSensors.setMode(shtRepeatability, shtPeriodicRate);
+  if (i2cBus.addMux(SHT_MUX_ADDRESS)) {
+    Serial.printf("TCA9548A at 0x%02X, SHT on channels 0-%d\n", SHT_MUX_ADDRESS, I2CBus::MUX_CHANNELS - 1);
+    for (uint8_t channel = 0; channel < I2CBus::MUX_CHANNELS; channel++) {
+      shtSensors.addCandidate(0x44, channel);
+      shtSensors.addCandidate(0x45, channel);
+    }
+  } else {
+    shtSensors.addCandidate(0x44);
+    shtSensors.addCandidate(0x45);
+  }
+  while (SHTSensor* found = shtSensors.poll(millis())) {
+    char name[16];
+    formatShtName(name, sizeof(name), found);
+    Serial.printf("%s found\n", name);
+  }
+  updateShtAvailability();
+  if (sht_sensor_available) {
     buzzer.playSensorFound(1);
   } else {
     Serial.println("No SHT sensor found at 0x44 or 0x45");
@@ -679,25 +1164,38 @@ void setup() {
   
   // Initialize Fuel Sensor (RS232)
   Serial.println("Initializing Fuel Sensor (RS232)...");
-  fuel_sensor_available = fuelSensor.begin(FUEL_TX_PIN, FUEL_RX_PIN, 9600);
+#ifdef FUEL_SIMULATOR
+  // Hai đầu dò ảo để chạy thử menu/hiển thị khi không có cảm biến thật
+  fuelSimulator.addProbe(0x01);
+  fuelSimulator.addProbe(0x02);
+  fuelSimulator.setBroadcastCollisions(false);
+  fuelSensor.begin(fuelSimulator);
+#else
+  fuelSensor.begin(FUEL_TX_PIN, FUEL_RX_PIN, 9600, &fuelRx);
+#endif
+  fuelSensor.setCapture(&fuelCapture);
+  if (probeCache.begin()) {
+    fuelBus.setIdentityCache(&probeCache);
+  }
+  
+  // Quét nhanh dải địa chỉ thường dùng (0x01-0x10); phần còn lại quét nền trong loop()
+  fuelBus.startScan(FuelBusManager::FIRST_ADDRESS, FuelBusManager::QUICK_SCAN_LAST);
+  while (fuelBus.isScanning()) {
+    fuelSensor.poll();
+    fuelBus.poll();
+    delay(1);
+  }
+  fuel_sensor_available = fuelBus.getOnlineCount() > 0;
   if (fuel_sensor_available) {
-    Serial.println("Fuel sensor (RS232) connected successfully!");
+    Serial.printf("Fuel sensor (RS232) connected successfully! %d probe(s)\n", fuelBus.getProbeCount());
     buzzer.playSuccess(); // Success buzzer for fuel sensor connection
     delay(200);
     buzzer.playSuccess(); // Double beep for fuel sensor
-    
-    // Đọc limits từ fuel sensor
-    Serial.println("Reading fuel sensor limits...");
-    delay(500);
-    if (fuelSensor.readLimits()) {
-      Serial.printf("Fuel Limits - Max: %.1fL, Min: %.1fL\n", 
-                    fuelSensor.getLevelMaxLiters(), fuelSensor.getLevelMinLiters());
-    } else {
-      Serial.println("Failed to read fuel sensor limits");
-    }
   } else {
     Serial.println("Failed to connect fuel sensor (RS232)");
   }
+  // Serial, limits and firmware of each probe are read (or restored from probeCache) by fuelBus in idle bus time
+  fuelBus.startScan(FuelBusManager::QUICK_SCAN_LAST + 1, FuelBusManager::LAST_ADDRESS);
   
   // Set LED2 status based on sensors
   setLED2(sht_sensor_available || fuel_sensor_available);
@@ -717,7 +1215,6 @@ void setup() {
   }
   
   // Initialize previous sensor states for hotswap detection
-  prev_sht_sensor_available = sht_sensor_available;
   prev_fuel_sensor_available = fuel_sensor_available;
   lastSensorCheck = millis();
   
@@ -727,8 +1224,22 @@ void setup() {
 void loop() {
   unsigned long currentTime = millis();
   
+  // Advance the fuel sensor UART state machine (never blocks), then let the
+  // bus manager queue the next round-robin poll or scan request. A calibration job
+  // owns the link while it runs: probes rebooting after it must not count as lost.
+  fuelSensor.poll();
+  calibration.poll();
+  if (!calibration.isRunning()) {
+    fuelBus.poll();
+  }
+  updateCalibration(currentTime);
+  updateNotifications(millis()); // Not currentTime: a notification may have been posted since
+  checkFuelEvents();
+  handleConsole();
+  
   // Check for sensor hotswap
   checkSensorHotswap();
+  checkShtPresence(currentTime);
   
   // Handle rotary encoder for menu navigation
   handleEncoderMenu(currentTime);
@@ -743,78 +1254,82 @@ void loop() {
   }
   
   // Variables for current sensor readings
-  static float shtTemp = NAN, shtHum = NAN;
-  static float fuelTemp = NAN;
-  static int fuelLevel = -1;
-  static bool readSuccess = false;
+  static Centi shtTemp, shtHum;
+  
+  // SHT sampled on its own schedule: adaptive backs off while temperature and humidity hold still.
+  // A sample is a sweep of every present sensor: all conversions are started together and each
+  // result is fetched on a later pass once converted, so the loop never waits and 16 sensors
+  // behind the multiplexer take about one conversion time. Periodic: the sensors free-run and
+  // the sweep just fetches their latest results. Failed reads count against shtSensors presence
+  static bool shtSweeping = false;  // Between shtSchedule.begin() and complete()
+  if (!shtSweeping && sht_sensor_available && shtSchedule.isDue(currentTime)) {
+    shtSchedule.begin(currentTime);
+    shtSensors.startSweep(currentTime);
+    shtSweeping = true;
+  }
+  if (shtSweeping && shtSensors.updateSweep(currentTime)) {
+    shtSweeping = false;
+    // Steady = every sensor within 0.1 °C and 0.5 %RH of its previous sample
+    static Centi previousTemp[SHTRegistry::MAX_SENSORS], previousHum[SHTRegistry::MAX_SENSORS];
+    bool anyRead = false, changed = false;
+    for (int i = 0; i < shtSensors.getCount(); i++) {
+      SHTSensor* sensor = shtSensors.getSensor(i);
+      char name[16];
+      formatShtName(name, sizeof(name), sensor);
+      if (shtSensors.hasReading(i)) {
+        Centi temp = sensor->getTemperature(), hum = sensor->getHumidity();
+        char tempText[FIXED_TEXT_SIZE], humText[FIXED_TEXT_SIZE];
+        temp.format(tempText, sizeof(tempText), 1);
+        hum.format(humText, sizeof(humText), 0);
+        Serial.printf("%s: %s°C, %s%%\n", name, tempText, humText);
+        changed = changed || !previousTemp[i].isValid() || !previousHum[i].isValid() ||
+                  abs((temp - previousTemp[i]).toRaw()) > 10 || abs((hum - previousHum[i]).toRaw()) > 50;
+        previousTemp[i] = temp;
+        previousHum[i] = hum;
+        anyRead = true;
+      } else {
+        if (shtSensors.isPresent(i)) {
+          Serial.printf("Failed to read %s\n", name);
+        }
+        changed = changed || shtSensors.isPresent(i) || previousTemp[i].isValid();
+        previousTemp[i] = Centi::invalid();
+        previousHum[i] = Centi::invalid();
+      }
+    }
+    shtSchedule.complete(millis(), anyRead, changed);
+    
+    // Main menu and alerts follow the active (first present) sensor
+    int active = shtSensors.getPresentIndex(0);
+    shtReadOk = shtSensors.hasReading(active);
+    shtTemp = shtReadOk ? previousTemp[active] : Centi::invalid();
+    shtHum = shtReadOk ? previousHum[active] : Centi::invalid();
+  }
   
   if (currentTime - lastReadTime >= READ_INTERVAL) {
     lastReadTime = currentTime;
     
-    // Reset values
-    shtTemp = NAN; shtHum = NAN;
-    fuelTemp = NAN;
-    fuelLevel = -1;
-    readSuccess = false;
-    
-    // Read SHT sensor if available
-    if (sht_sensor_available) {
-      bool shtReadSuccess = false;
-      if (sht_sensor_address == 0x44) {
-        shtReadSuccess = sht1.readData();
-        if (shtReadSuccess) {
-          shtTemp = sht1.getTemperature();
-          shtHum = sht1.getHumidity();
-        }
-      } else if (sht_sensor_address == 0x45) {
-        shtReadSuccess = sht2.readData();
-        if (shtReadSuccess) {
-          shtTemp = sht2.getTemperature();
-          shtHum = sht2.getHumidity();
-        }
-      }
-      
-      if (shtReadSuccess) {
-        Serial.printf("SHT (0x%02X): %.1f°C, %.0f%%\n", sht_sensor_address, shtTemp, shtHum);
-        readSuccess = true;
-      } else {
-        Serial.printf("Failed to read SHT sensor at 0x%02X\n", sht_sensor_address);
-      }
+    // No SHT fitted (or unplugged): nothing to show
+    if (!sht_sensor_available) {
+      shtTemp = Centi::invalid(); shtHum = Centi::invalid();
+      shtReadOk = false;
     }
     
-    // Read fuel sensor (RS232) if available using broadcast
+    // Fuel probes are polled round-robin by fuelBus; pick up the selected one
     if (fuel_sensor_available) {
-      // Try broadcast first for auto-detection and compatibility
-      bool fuelReadSuccess = fuelSensor.readSensorDataBroadcast();
-      if (!fuelReadSuccess) {
-        // Fallback to specific address if broadcast fails
-        Serial.println("Broadcast failed, trying specific address...");
-        fuelReadSuccess = fuelSensor.readSensorData();
-      }
-      
-      if (fuelReadSuccess) {
-        fuelTemp = fuelSensor.getTemperature();
-        fuelLevel = fuelSensor.getFuelValue(); // Raw value 0-4095
-        String rawData = fuelSensor.getLastRawData();
-        Serial.printf("Fuel Sensor (RS232): %.1f°C, %d units\n", fuelTemp, fuelLevel);
-        Serial.printf("Raw Data: %s\n", rawData.c_str());
-        readSuccess = true;
-      } else {
-        Serial.println("Failed to read fuel sensor (RS232) - both broadcast and specific address");
-      }
+      updateFuelReading();
     }
     
     // Update LED2 based on read success
-    setLED2(readSuccess);
+    setLED2(shtReadOk || fuelReadOk);
     
     Serial.println("---");
   }
   
-  // Update display immediately when encoder changes or periodically
+  // Update display immediately when encoder changes or periodically; a notification keeps the screen
   bool shouldUpdateDisplay = forceDisplayUpdate || 
                            (currentTime - lastDisplayUpdate >= MIN_DISPLAY_INTERVAL);
   
-  if (shouldUpdateDisplay) {
+  if (shouldUpdateDisplay && notificationCount == 0) {
     lastDisplayUpdate = currentTime;
     forceDisplayUpdate = false;
     
@@ -827,47 +1342,21 @@ void loop() {
         
       case MENU_MAIN:
         // Main menu with highlighting
-        display.showMainMenu(shtTemp, shtHum, fuelTemp, fuelLevel, 
+        display.showMainMenu(shtTemp, shtHum, fuelTemp, fuelLevel, fuelVolume,
                            (int)currentHighlight, sht_sensor_available, fuel_sensor_available);
         break;
         
       case MENU_FUEL_DETAIL:
         // Scrollable fuel detail view
         if (fuel_sensor_available) {
-          String rawData = fuelSensor.getLastRawData();
-          const uint8_t* firmwareData = fuelSensor.getFirmwareVersion();
-          int firmwareLen = fuelSensor.getFirmwareVersionLength();
-          const uint8_t* serialData = fuelSensor.getSerialNumberData();
-          int serialLen = fuelSensor.getSerialNumberLength();
-          uint32_t serialNumber = fuelSensor.getSerialNumber();
-          
-          // Auto-read firmware if not available and on firmware page
-          static bool firmwareReadAttempted = false;
-          if (detailScrollPosition == 2 && firmwareLen == 0 && !firmwareReadAttempted) {
-            Serial.println("Auto-reading firmware version...");
-            fuelSensor.readFirmwareVersion();
-            firmwareReadAttempted = true;
-            firmwareData = fuelSensor.getFirmwareVersion();
-            firmwareLen = fuelSensor.getFirmwareVersionLength();
-          }
-          
-          // Auto-read serial number if not available and on serial page
-          static bool serialReadAttempted = false;
-          if (detailScrollPosition == 3 && serialLen == 0 && !serialReadAttempted) {
-            Serial.println("Auto-reading serial number...");
-            fuelSensor.readSerialNumber();
-            serialReadAttempted = true;
-            serialData = fuelSensor.getSerialNumberData();
-            serialLen = fuelSensor.getSerialNumberLength();
-            serialNumber = fuelSensor.getSerialNumber();
-          }
-          
-          display.showFuelDetailsScrollable(fuelTemp, fuelLevel, 
-                                fuelSensor.areLimitsValid() ? fuelSensor.getLevelMax() : -1,
-                                fuelSensor.areLimitsValid() ? fuelSensor.getLevelMin() : -1,
-                                fuelSensor.getFrequency(),
-                                rawData, firmwareData, firmwareLen,
-                                serialData, serialLen, serialNumber, detailScrollPosition);
+          const FuelBusManager::Probe* probe = fuelBus.getProbe(selectedProbe);
+          display.showFuelDetailsScrollable(fuelTemp, fuelLevel, fuelVolume, calculateFuelPercentage(fuelLevel),
+                                probe->limitsValid ? probe->levelMax : -1,
+                                probe->limitsValid ? probe->levelMin : -1,
+                                probe->frequency,
+                                probe->rawFrame, probe->rawFrameLength, probe->firmwareVersion, probe->firmwareVersionLength,
+                                probe->serialNumberData, probe->serialNumberLength, probe->serialNumber,
+                                fuelConsumption, fuelMinutesToEmpty, detailScrollPosition, probe->address, selectedProbe, fuelBus.getProbeCount());
         } else {
           display.showError("No fuel sensor");
         }
@@ -876,7 +1365,16 @@ void loop() {
       case MENU_SHT_DETAIL:
         // Scrollable SHT detail view
         if (sht_sensor_available) {
-          display.showSHTDetailsScrollable(shtTemp, shtHum, sht_sensor_address, detailScrollPosition);
+          // detailScrollPosition runs over SHT_DETAIL_PAGES per present sensor
+          int sensorCount = shtSensors.getPresentCount();
+          int sensor = detailScrollPosition / SHT_DETAIL_PAGES % sensorCount;
+          int index = shtSensors.getPresentIndex(sensor);
+          SHTSensor* sht = shtSensors.getSensor(index);
+          bool valid = shtSensors.hasReading(index);
+          display.showSHTDetailsScrollable(valid ? sht->getTemperature() : Centi::invalid(),
+                                           valid ? sht->getHumidity() : Centi::invalid(), sht->getAddress(),
+                                           detailScrollPosition % SHT_DETAIL_PAGES, sht->getChannel(),
+                                           sensor, sensorCount);
         } else {
           display.showError("No SHT sensor");
         }
@@ -900,28 +1398,66 @@ void loop() {
         // Extended commands menu
         display.showExtendedMenu((int)currentExtended);
         break;
+      
+      case MENU_CALIBRATING: {
+        // Current step (with the seconds left in a wait), then the outcome and the set reply bytes
+        char status[32];
+        char responseStr[FuelSensor::SET_RESPONSE_TEXT_SIZE];
+        unsigned long remaining = calibration.getStepRemaining();
+        if (calibration.isRunning() && remaining >= 1000) {
+          snprintf(status, sizeof(status), "%s %lus", calibration.getStepName(), (remaining + 999) / 1000);
+        } else if (!calibration.isRunning() && calibration.getState() != CalibrationJob::JOB_CANCELLED &&
+                   fuelSensor.formatLastSetResponse(responseStr, sizeof(responseStr)) > 0) {
+          snprintf(status, sizeof(status), "%s %s", calibration.getStepName(), responseStr);
+        } else {
+          snprintf(status, sizeof(status), "%s", calibration.getStepName());
+        }
+        display.showCalibrationProgress(calibration.getName(), status, calibration.getProgress());
+        break;
+      }
+      
+      case MENU_DIAGNOSTICS: {
+        // Achieved rate and duty cycle per sensor, then what the fuel link could do back to back
+        SampleScheduler& fuelSchedule = fuelBus.getDataSchedule();
+        char fuelLine[24], shtLine[24], linkLine[24], maxText[FIXED_TEXT_SIZE];
+        formatScheduleLine(fuelLine, sizeof(fuelLine), "FUEL", fuelSchedule);
+        formatScheduleLine(shtLine, sizeof(shtLine), "SHT", shtSchedule);
+        fuelSchedule.getAchievableRate().format(maxText, sizeof(maxText), 1);
+        snprintf(linkLine, sizeof(linkLine), "Max %sHz int %lums", maxText, fuelSchedule.getInterval());
+        display.showDiagnostics("Sampling", fuelLine, shtLine, linkLine);
+        break;
+      }
     }
   }
   
   // Temperature and fuel level alerts (only when we have fresh sensor data)
   if (currentTime - lastReadTime < READ_INTERVAL + 100) {
     // Beep if temperature is too high (SHT: 35°C, Fuel: 80°C)
-    if ((shtTemp > 35.0 && !isnan(shtTemp)) || (fuelTemp > 80.0 && !isnan(fuelTemp))) {
+    if ((shtTemp.isValid() && shtTemp > Centi::fromUnits(35)) ||
+        (fuelTemp.isValid() && fuelTemp > Centi::fromUnits(80))) {
       buzzer.playTemperatureAlert(); // Temperature warning buzzer
     }
     
-    // Check fuel level limits and alert
-    if (fuel_sensor_available && fuelSensor.areLimitsValid() && fuelLevel >= 0) {
-      uint16_t levelMax = fuelSensor.getLevelMax();
-      uint16_t levelMin = fuelSensor.getLevelMin();
-      
-      if (fuelLevel <= levelMin + 50) { // Alert when within 50 units of minimum
-        Serial.println("WARNING: Fuel level near minimum!");
-        buzzer.playTemperatureAlert(); // Use temperature alert sound for fuel warning
-      } else if (fuelLevel >= levelMax - 50) { // Alert when within 50 units of maximum
-        Serial.println("WARNING: Fuel level near maximum!");
-        buzzer.playTemperatureAlert();
-      }
+    // Check fuel level limits and alert: near empty/full of the tank table, else near the probe's min/max.
+    // Nothing while the fuel sloshes, the swings would cross either margin.
+    const FuelBusManager::Probe* probe = fuelBus.getProbe(selectedProbe);
+    bool nearMinimum = false;
+    bool nearMaximum = false;
+    if (!fuelSloshing && fuel_sensor_available && tankTable.isValid() && fuelVolume.isValid()) {
+      Centi percent = calculateFuelPercentage(fuelLevel);
+      nearMinimum = percent.isValid() && percent <= Centi::fromUnits(FUEL_ALERT_MARGIN_PERCENT);
+      nearMaximum = percent.isValid() && percent >= Centi::fromUnits(100 - FUEL_ALERT_MARGIN_PERCENT);
+    } else if (!fuelSloshing && fuel_sensor_available && probe && probe->limitsValid && fuelLevel >= 0) {
+      nearMinimum = fuelLevel <= probe->levelMin + FUEL_ALERT_MARGIN_UNITS;
+      nearMaximum = fuelLevel >= probe->levelMax - FUEL_ALERT_MARGIN_UNITS;
+    }
+    
+    if (nearMinimum) {
+      Serial.println("WARNING: Fuel level near minimum!");
+      buzzer.playTemperatureAlert(); // Use temperature alert sound for fuel warning
+    } else if (nearMaximum) {
+      Serial.println("WARNING: Fuel level near maximum!");
+      buzzer.playTemperatureAlert();
     }
   }
   
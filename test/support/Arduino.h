@@ -0,0 +1,147 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// Minimal Arduino core for [env:native]: enough of Print/Stream/HardwareSerial and the
+// timing functions to build the lib/ drivers on the host. Time is virtual (NativeClock),
+// so tests step through timeouts and waits without sleeping.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+#include <functional>
+
+#define IRAM_ATTR
+#define HEX 16
+#define DEC 10
+#define LOW 0
+#define HIGH 1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define CHANGE 0x03
+#define SERIAL_8N1 0x800001c
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+
+class NativeClock {
+public:
+    static unsigned long millis() { return (unsigned long)(nowMicros / 1000); }
+    static unsigned long micros() { return (unsigned long)nowMicros; }
+    static void advance(unsigned long ms) { nowMicros += (uint64_t)ms * 1000; }
+    static void advanceMicros(unsigned long us) { nowMicros += us; }
+    static void reset() { nowMicros = 0; }
+
+private:
+    static inline uint64_t nowMicros = 0;
+};
+
+inline unsigned long millis() { return NativeClock::millis(); }
+inline unsigned long micros() { return NativeClock::micros(); }
+inline void delay(unsigned long ms) { NativeClock::advance(ms); }
+inline void delayMicroseconds(unsigned int us) { NativeClock::advanceMicros(us); }
+inline void yield() {}
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return LOW; }
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t value) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t written = 0;
+        while (written < size && write(buffer[written])) {
+            written++;
+        }
+        return written;
+    }
+    size_t write(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+    virtual void flush() {}
+    
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buffer[256];
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        if (length < 0) {
+            return 0;
+        }
+        return write((const uint8_t*)buffer, min((size_t)length, sizeof(buffer) - 1));
+    }
+    size_t print(const char* text) { return write(text); }
+    size_t print(char value) { return write((uint8_t)value); }
+    size_t print(int value, int base = DEC) { return printf(base == HEX ? "%X" : "%d", value); }
+    size_t print(unsigned int value, int base = DEC) { return printf(base == HEX ? "%X" : "%u", value); }
+    size_t print(long value) { return printf("%ld", value); }
+    size_t print(unsigned long value) { return printf("%lu", value); }
+    size_t print(double value, int digits = 2) { return printf("%.*f", digits, value); }
+    size_t println() { return write("\n"); }
+    template <typename T> size_t println(T value) { return print(value) + println(); }
+    template <typename T> size_t println(T value, int format) { return print(value, format) + println(); }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    void setTimeout(unsigned long) {}
+    
+    // No waiting on the host: returns what is already there
+    size_t readBytes(uint8_t* buffer, size_t length) {
+        size_t count = 0;
+        while (count < length && available() > 0) {
+            buffer[count++] = (uint8_t)read();
+        }
+        return count;
+    }
+    size_t readBytes(char* buffer, size_t length) { return readBytes((uint8_t*)buffer, length); }
+};
+
+// UART without a line: writes vanish, nothing is received. Tests attach their own Stream
+// through the drivers' begin(Stream&) instead
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long, uint32_t = SERIAL_8N1, int8_t = -1, int8_t = -1) {}
+    void end() {}
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    size_t write(uint8_t) override { return 1; }
+    using Print::write;
+    bool setRxTimeout(uint8_t) { return true; }
+    size_t setRxBufferSize(size_t size) { return size; }
+    void onReceive(std::function<void(void)> callback, bool = false) { receiveCallback = callback; }
+    
+    std::function<void(void)> receiveCallback;
+};
+
+// Console output is dropped unless NATIVE_VERBOSE is set in the environment
+class NativeConsole : public HardwareSerial {
+public:
+    size_t write(uint8_t value) override {
+        static const bool verbose = getenv("NATIVE_VERBOSE") != nullptr;
+        if (verbose) {
+            putchar(value);
+        }
+        return 1;
+    }
+    using Print::write;
+};
+
+inline NativeConsole Serial;
+inline HardwareSerial Serial1;
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef NATIVE_FS_H
+#define NATIVE_FS_H
+
+// In-memory filesystem for [env:native]: files live in the FS object, so save/load
+// round trips can be tested without flash
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace fs {
+
+class File : public Stream {
+public:
+    File() : data(nullptr), position(0) {}
+    explicit File(std::vector<uint8_t>* contents) : data(contents), position(0) {}
+    
+    explicit operator bool() const { return data != nullptr; }
+    int available() override { return data != nullptr ? (int)(data->size() - position) : 0; }
+    int read() override { return available() > 0 ? (*data)[position++] : -1; }
+    int peek() override { return available() > 0 ? (*data)[position] : -1; }
+    size_t write(uint8_t value) override {
+        if (data == nullptr) {
+            return 0;
+        }
+        data->push_back(value);
+        return 1;
+    }
+    using Print::write;
+    size_t size() const { return data != nullptr ? data->size() : 0; }
+    void close() { data = nullptr; }
+
+private:
+    std::vector<uint8_t>* data;
+    size_t position;
+};
+
+class FS {
+public:
+    File open(const char* path, const char* mode) {
+        if (mode[0] == 'w') {
+            std::vector<uint8_t>& contents = files[path];
+            contents.clear();
+            return File(&contents);
+        }
+        auto it = files.find(path);
+        return it != files.end() ? File(&it->second) : File();
+    }
+    bool exists(const char* path) const { return files.count(path) > 0; }
+    bool remove(const char* path) { return files.erase(path) > 0; }
+
+private:
+    std::map<std::string, std::vector<uint8_t>> files;
+};
+
+} // namespace fs
+
+using fs::File;
+
+#endif
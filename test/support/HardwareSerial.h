@@ -0,0 +1,6 @@
+#ifndef NATIVE_HARDWARESERIAL_H
+#define NATIVE_HARDWARESERIAL_H
+
+#include <Arduino.h>
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef NATIVE_PREFERENCES_H
+#define NATIVE_PREFERENCES_H
+
+// NVS stand-in for [env:native]: one in-memory key space shared by every instance,
+// so a second Preferences object sees what the first one stored (like a reboot)
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+class Preferences {
+public:
+    bool begin(const char*, bool = false) { return true; }
+    void end() {}
+    bool isKey(const char* key) { return store().count(key) > 0; }
+    size_t getBytesLength(const char* key) {
+        auto it = store().find(key);
+        return it != store().end() ? it->second.size() : 0;
+    }
+    size_t getBytes(const char* key, void* buffer, size_t length) {
+        auto it = store().find(key);
+        if (it == store().end()) {
+            return 0;
+        }
+        size_t count = min(length, it->second.size());
+        memcpy(buffer, it->second.data(), count);
+        return count;
+    }
+    size_t putBytes(const char* key, const void* buffer, size_t length) {
+        const uint8_t* bytes = (const uint8_t*)buffer;
+        store()[key] = std::vector<uint8_t>(bytes, bytes + length);
+        return length;
+    }
+    bool remove(const char* key) { return store().erase(key) > 0; }
+    bool clear() {
+        store().clear();
+        return true;
+    }
+    
+    static std::map<std::string, std::vector<uint8_t>>& store() {
+        static std::map<std::string, std::vector<uint8_t>> values;
+        return values;
+    }
+};
+
+#endif
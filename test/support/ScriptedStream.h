@@ -0,0 +1,69 @@
+#ifndef SCRIPTEDSTREAM_H
+#define SCRIPTEDSTREAM_H
+
+// Stream whose receive side follows a script on the NativeClock: each scheduled byte becomes
+// readable at its time, as if it had just crossed the line. Everything written is kept for
+// inspection.
+
+#include <Arduino.h>
+#include <deque>
+#include <vector>
+
+class ScriptedStream : public Stream {
+public:
+    static const unsigned long BYTE_MICROS_9600 = 1042;  // One 8N1 character at 9600 baud
+    
+    // Bytes start arriving delayMicros from now, one character time apart
+    void schedule(unsigned long delayMicros, const uint8_t* data, size_t length,
+                  unsigned long byteMicros = BYTE_MICROS_9600) {
+        unsigned long due = NativeClock::micros() + delayMicros;
+        for (size_t i = 0; i < length; i++) {
+            incoming.push_back({data[i], due});
+            due += byteMicros;
+        }
+    }
+    void schedule(unsigned long delayMicros, const std::vector<uint8_t>& data,
+                  unsigned long byteMicros = BYTE_MICROS_9600) {
+        schedule(delayMicros, data.data(), data.size(), byteMicros);
+    }
+    
+    const std::vector<uint8_t>& written() const { return sent; }
+    size_t scheduledLength() const { return incoming.size(); }
+    void clearWritten() { sent.clear(); }
+    
+    int available() override {
+        int count = 0;
+        for (const Byte& byte : incoming) {
+            if ((long)(NativeClock::micros() - byte.due) < 0) {
+                break;
+            }
+            count++;
+        }
+        return count;
+    }
+    int read() override {
+        if (available() == 0) {
+            return -1;
+        }
+        uint8_t value = incoming.front().value;
+        incoming.pop_front();
+        return value;
+    }
+    int peek() override { return available() > 0 ? incoming.front().value : -1; }
+    size_t write(uint8_t value) override {
+        sent.push_back(value);
+        return 1;
+    }
+    using Print::write;
+
+private:
+    struct Byte {
+        uint8_t value;
+        unsigned long due;
+    };
+    
+    std::deque<Byte> incoming;
+    std::vector<uint8_t> sent;
+};
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef NATIVE_FREERTOS_H
+#define NATIVE_FREERTOS_H
+
+#include <stdint.h>
+
+typedef void* TaskHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xFFFFFFFFUL
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef NATIVE_FREERTOS_TASK_H
+#define NATIVE_FREERTOS_TASK_H
+
+#include <freertos/FreeRTOS.h>
+
+// Single threaded host: notifications are never pending
+inline BaseType_t xTaskNotifyGive(TaskHandle_t) { return pdTRUE; }
+inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return nullptr; }
+
+#endif
@@ -0,0 +1,230 @@
+// CalibrationJob end to end against a simulated probe: set, limits read, restart delay,
+// restart and settle, all in virtual time (pio test -e native -f test_calibration_job)
+
+#include <unity.h>
+#include <CalibrationJob.h>
+#include <AoooGSimulator.h>
+#include <string>
+#include <vector>
+
+static const unsigned long LOOP_STEP_MS = 1;
+static const unsigned long REPLY_TIMEOUT_MS = 1000;   // FuelSensor's default reply deadline
+static const unsigned long NOMINAL_MS = CalibrationJob::LIMITS_SETTLE_MS + CalibrationJob::RESTART_DELAY_MS +
+                                        CalibrationJob::RESTART_SETTLE_MS;
+
+struct Run {
+    unsigned long elapsedMs = 0;
+    std::vector<std::string> steps;   // Step names in the order they were shown
+    bool progressMonotonic = true;
+};
+
+// Drive sensor and job as loop() does until the job stops; every call must return without
+// consuming time. onStep, when given, runs once per pass (to cancel at a chosen moment)
+template <typename Hook>
+static Run runJob(FuelSensor& sensor, CalibrationJob& job, Hook onStep, unsigned long limitMs = 20000) {
+    Run run;
+    unsigned long start = millis();
+    int lastProgress = 0;
+    while (job.isRunning() && millis() - start < limitMs) {
+        unsigned long before = micros();
+        sensor.poll();
+        job.poll();
+        TEST_ASSERT_EQUAL_UINT32(before, micros());
+        
+        if (run.steps.empty() || run.steps.back() != job.getStepName()) {
+            run.steps.push_back(job.getStepName());
+        }
+        run.progressMonotonic = run.progressMonotonic && job.getProgress() >= lastProgress;
+        lastProgress = job.getProgress();
+        onStep(millis() - start);
+        NativeClock::advance(LOOP_STEP_MS);
+    }
+    run.elapsedMs = millis() - start;
+    return run;
+}
+
+static Run runJob(FuelSensor& sensor, CalibrationJob& job) {
+    return runJob(sensor, job, [](unsigned long) {});
+}
+
+void setUp() {
+    NativeClock::reset();
+}
+
+void tearDown() {}
+
+void test_set_full_runs_every_step() {
+    AoooGSimulator simulator;
+    simulator.addProbe(0x01);
+    simulator.getProbe(0)->fuelValue = 3210;
+    FuelSensor sensor(0x01);
+    sensor.begin(simulator);
+    CalibrationJob job(sensor);
+    
+    TEST_ASSERT_TRUE(job.start(CalibrationJob::CALIBRATE_FULL, 0x01));
+    TEST_ASSERT_FALSE(job.start(CalibrationJob::CALIBRATE_EMPTY, 0x01));
+    Run run = runJob(sensor, job);
+    
+    TEST_ASSERT_EQUAL(CalibrationJob::JOB_DONE, job.getState());
+    TEST_ASSERT_EQUAL(100, job.getProgress());
+    TEST_ASSERT_TRUE(run.progressMonotonic);
+    const char* expected[] = {"Sending...", "Read limits", "Restart in", "Restarting", "DONE"};
+    TEST_ASSERT_EQUAL(5, run.steps.size());
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_STRING(expected[i], run.steps[i].c_str());
+    }
+    
+    // Set, limits, restart: the probe stored the point and the driver read it back
+    TEST_ASSERT_EQUAL_UINT32(3, simulator.getStats().requests);
+    TEST_ASSERT_EQUAL_UINT16(3210, simulator.getProbe(0)->levelMax);
+    TEST_ASSERT_EQUAL_UINT16(3210, sensor.getLevelMax());
+    TEST_ASSERT_TRUE(sensor.getLastSetSuccess());
+    // The waits plus two replies of a few character times each
+    TEST_ASSERT_GREATER_OR_EQUAL(NOMINAL_MS, run.elapsedMs);
+    TEST_ASSERT_LESS_OR_EQUAL(NOMINAL_MS + 100, run.elapsedMs);
+}
+
+void test_set_empty_stores_current_level() {
+    AoooGSimulator simulator;
+    simulator.addProbe(0x01);
+    simulator.getProbe(0)->fuelValue = 150;
+    FuelSensor sensor(0x01);
+    sensor.begin(simulator);
+    CalibrationJob job(sensor);
+    
+    TEST_ASSERT_TRUE(job.start(CalibrationJob::CALIBRATE_EMPTY, 0x01));
+    runJob(sensor, job);
+    
+    TEST_ASSERT_EQUAL(CalibrationJob::JOB_DONE, job.getState());
+    TEST_ASSERT_EQUAL_UINT16(150, simulator.getProbe(0)->levelMin);
+    TEST_ASSERT_EQUAL_UINT16(150, sensor.getLevelMin());
+}
+
+void test_only_the_addressed_probe_is_calibrated() {
+    AoooGSimulator simulator;
+    for (uint8_t address = 1; address <= 3; address++) {
+        simulator.getProbe(simulator.addProbe(address))->fuelValue = address * 1000;
+    }
+    FuelSensor sensor(0x01);
+    sensor.begin(simulator);
+    CalibrationJob job(sensor);
+    
+    TEST_ASSERT_TRUE(job.start(CalibrationJob::CALIBRATE_FULL, 0x02));
+    runJob(sensor, job);
+    
+    TEST_ASSERT_EQUAL(CalibrationJob::JOB_DONE, job.getState());
+    TEST_ASSERT_EQUAL_UINT16(4000, simulator.getProbe(0)->levelMax);
+    TEST_ASSERT_EQUAL_UINT16(2000, simulator.getProbe(1)->levelMax);
+    TEST_ASSERT_EQUAL_UINT16(4000, simulator.getProbe(2)->levelMax);
+    TEST_ASSERT_EQUAL_UINT16(2000, sensor.getLevelMax());
+    TEST_ASSERT_EQUAL_UINT32(0, simulator.getStats().collisions);
+}
+
+void test_broadcast_with_several_probes_fails() {
+    AoooGSimulator simulator;
+    simulator.addProbe(0x01);
+    simulator.addProbe(0x02);
+    FuelSensor sensor(0x01);
+    sensor.begin(simulator);
+    CalibrationJob job(sensor);
+    
+    // Both probes store the point and answer at once: the merged reply is no reply
+    job.start(CalibrationJob::CALIBRATE_FULL, FuelSensor::BROADCAST_ADDRESS);
+    runJob(sensor, job);
+    
+    TEST_ASSERT_EQUAL(CalibrationJob::JOB_FAILED, job.getState());
+    TEST_ASSERT_EQUAL_UINT32(1, simulator.getStats().collisions);
+}
+
+void test_no_reply_fails_without_restart() {
+    AoooGSimulator simulator;
+    simulator.addProbe(0x01);
+    simulator.getProbe(0)->online = false;
+    FuelSensor sensor(0x01);
+    sensor.begin(simulator);
+    CalibrationJob job(sensor);
+    
+    job.start(CalibrationJob::CALIBRATE_FULL, 0x01);
+    Run run = runJob(sensor, job);
+    
+    TEST_ASSERT_EQUAL(CalibrationJob::JOB_FAILED, job.getState());
+    TEST_ASSERT_EQUAL_STRING("FAILED", job.getStepName());
+    TEST_ASSERT_EQUAL_UINT32(1, simulator.getStats().requests);
+    // Ends with the set command's response timeout, not the 6 s of waits
+    TEST_ASSERT_LESS_OR_EQUAL(REPLY_TIMEOUT_MS + 50, run.elapsedMs);
+}
+
+void test_cancel_during_restart_delay() {
+    AoooGSimulator simulator;
+    simulator.addProbe(0x01);
+    FuelSensor sensor(0x01);
+    sensor.begin(simulator);
+    CalibrationJob job(sensor);
+    
+    job.start(CalibrationJob::CALIBRATE_FULL, 0x01);
+    Run run = runJob(sensor, job, [&](unsigned long elapsed) {
+        if (elapsed == 2000) {
+            // The delay began after the set reply, the settle and the limits reply (~150 ms in)
+            TEST_ASSERT_EQUAL_STRING("Restart in", job.getStepName());
+            TEST_ASSERT_UINT32_WITHIN(50, 3150, job.getStepRemaining());
+            job.cancel();
+        }
+    });
+    
+    TEST_ASSERT_EQUAL(CalibrationJob::JOB_CANCELLED, job.getState());
+    TEST_ASSERT_UINT32_WITHIN(5, 2000, run.elapsedMs);
+    // The point was stored, the restart never went out
+    TEST_ASSERT_EQUAL_UINT32(2, simulator.getStats().requests);
+}
+
+void test_cancel_after_restart_is_ignored() {
+    AoooGSimulator simulator;
+    simulator.addProbe(0x01);
+    FuelSensor sensor(0x01);
+    sensor.begin(simulator);
+    CalibrationJob job(sensor);
+    
+    job.start(CalibrationJob::CALIBRATE_FULL, 0x01);
+    runJob(sensor, job, [&](unsigned long elapsed) {
+        if (elapsed == NOMINAL_MS - 500) {
+            job.cancel();
+        }
+    });
+    
+    TEST_ASSERT_EQUAL(CalibrationJob::JOB_DONE, job.getState());
+    TEST_ASSERT_EQUAL_UINT32(3, simulator.getStats().requests);
+}
+
+void test_restarted_probe_is_silent_while_booting() {
+    AoooGSimulator simulator;
+    simulator.addProbe(0x01);
+    simulator.setBootTime(CalibrationJob::RESTART_SETTLE_MS / 2);
+    FuelSensor sensor(0x01);
+    sensor.begin(simulator);
+    CalibrationJob job(sensor);
+    
+    job.start(CalibrationJob::CALIBRATE_FULL, 0x01);
+    runJob(sensor, job);
+    TEST_ASSERT_EQUAL(CalibrationJob::JOB_DONE, job.getState());
+    
+    // The settle wait covers the boot: the first poll afterwards is answered
+    FuelSensor::TransactionHandle handle = sensor.submitRequest(0x01, FuelSensor::EVENT_READ_DATA);
+    for (int i = 0; i < 100 && sensor.getTransactionStatus(handle) == FuelSensor::TRANSACTION_PENDING; i++) {
+        sensor.poll();
+        NativeClock::advance(LOOP_STEP_MS);
+    }
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, sensor.getTransactionStatus(handle));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_set_full_runs_every_step);
+    RUN_TEST(test_set_empty_stores_current_level);
+    RUN_TEST(test_only_the_addressed_probe_is_calibrated);
+    RUN_TEST(test_broadcast_with_several_probes_fails);
+    RUN_TEST(test_no_reply_fails_without_restart);
+    RUN_TEST(test_cancel_during_restart_delay);
+    RUN_TEST(test_cancel_after_restart_is_ignored);
+    RUN_TEST(test_restarted_probe_is_silent_while_booting);
+    return UNITY_END();
+}
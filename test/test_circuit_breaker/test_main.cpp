@@ -0,0 +1,134 @@
+// CircuitBreaker on the virtual clock: tripping, one trial per backoff, backoff doubling and
+// its cap, recovery, and a trial handed back with cancelRequest()
+// (pio test -e native -f test_circuit_breaker)
+
+#include <unity.h>
+#include <CircuitBreaker.h>
+
+static const unsigned long BASE_BACKOFF_MS = 1000;
+static const unsigned long MAX_BACKOFF_MS = 6000;
+
+// Fail the requests the breaker lets through until it opens
+static void trip(CircuitBreaker& breaker) {
+    while (breaker.getState() != CircuitBreaker::BREAKER_OPEN) {
+        TEST_ASSERT_TRUE(breaker.allowRequest(millis()));
+        breaker.recordFailure(millis());
+    }
+}
+
+// Wait out the backoff, then fail the trial request
+static void failTrial(CircuitBreaker& breaker) {
+    NativeClock::advance(breaker.getRetryIn(millis()));
+    TEST_ASSERT_TRUE(breaker.allowRequest(millis()));
+    TEST_ASSERT_EQUAL(CircuitBreaker::BREAKER_HALF_OPEN, breaker.getState());
+    breaker.recordFailure(millis());
+}
+
+void setUp() {
+    NativeClock::reset();
+}
+
+void tearDown() {}
+
+void test_trips_after_threshold_and_rejects_during_backoff() {
+    CircuitBreaker breaker(3, BASE_BACKOFF_MS, MAX_BACKOFF_MS);
+    
+    // Failures below the threshold, and a success in between, keep it closed
+    breaker.recordFailure(millis());
+    breaker.recordFailure(millis());
+    breaker.recordSuccess(millis());
+    breaker.recordFailure(millis());
+    breaker.recordFailure(millis());
+    TEST_ASSERT_TRUE(breaker.isClosed());
+    TEST_ASSERT_TRUE(breaker.allowRequest(millis()));
+    
+    breaker.recordFailure(millis());
+    TEST_ASSERT_EQUAL(CircuitBreaker::BREAKER_OPEN, breaker.getState());
+    TEST_ASSERT_EQUAL_UINT32(BASE_BACKOFF_MS, breaker.getBackoff());
+    TEST_ASSERT_EQUAL_UINT32(BASE_BACKOFF_MS, breaker.getRetryIn(millis()));
+    
+    NativeClock::advance(BASE_BACKOFF_MS - 1);
+    TEST_ASSERT_FALSE(breaker.allowRequest(millis()));
+    TEST_ASSERT_EQUAL_UINT32(1, breaker.getRetryIn(millis()));
+    
+    // Exactly one trial once the backoff is over, nothing else while it is out
+    NativeClock::advance(1);
+    TEST_ASSERT_TRUE(breaker.allowRequest(millis()));
+    TEST_ASSERT_EQUAL(CircuitBreaker::BREAKER_HALF_OPEN, breaker.getState());
+    TEST_ASSERT_EQUAL_UINT32(0, breaker.getRetryIn(millis()));
+    TEST_ASSERT_FALSE(breaker.allowRequest(millis()));
+    
+    const CircuitBreaker::Counters& counters = breaker.getCounters();
+    TEST_ASSERT_EQUAL_UINT32(1, counters.opened);
+    TEST_ASSERT_EQUAL_UINT32(1, counters.halfOpened);
+    TEST_ASSERT_EQUAL_UINT32(2, counters.rejected);
+    TEST_ASSERT_EQUAL_UINT32(5, counters.failures);
+}
+
+void test_backoff_doubles_up_to_the_cap() {
+    CircuitBreaker breaker(2, BASE_BACKOFF_MS, MAX_BACKOFF_MS);
+    trip(breaker);
+    
+    // 1 s -> 2 s -> 4 s -> 6 s (capped, not 8 s) -> 6 s
+    const unsigned long expected[] = {2000, 4000, 6000, 6000};
+    for (unsigned long backoff : expected) {
+        failTrial(breaker);
+        TEST_ASSERT_EQUAL(CircuitBreaker::BREAKER_OPEN, breaker.getState());
+        TEST_ASSERT_EQUAL_UINT32(backoff, breaker.getBackoff());
+        TEST_ASSERT_EQUAL_UINT32(backoff, breaker.getRetryIn(millis()));
+    }
+    TEST_ASSERT_EQUAL_UINT32(5, breaker.getCounters().opened);
+    TEST_ASSERT_EQUAL_UINT32(6, breaker.getConsecutiveFailures());
+}
+
+void test_successful_trial_closes_and_resets_backoff() {
+    CircuitBreaker breaker(1, BASE_BACKOFF_MS, MAX_BACKOFF_MS);
+    trip(breaker);
+    failTrial(breaker);
+    failTrial(breaker);
+    TEST_ASSERT_EQUAL_UINT32(4000, breaker.getBackoff());
+    
+    NativeClock::advance(breaker.getRetryIn(millis()));
+    TEST_ASSERT_TRUE(breaker.allowRequest(millis()));
+    breaker.recordSuccess(millis());
+    TEST_ASSERT_TRUE(breaker.isClosed());
+    TEST_ASSERT_EQUAL_UINT32(BASE_BACKOFF_MS, breaker.getBackoff());
+    TEST_ASSERT_EQUAL_UINT8(0, breaker.getConsecutiveFailures());
+    TEST_ASSERT_EQUAL_UINT32(1, breaker.getCounters().closed);
+    
+    // The next outage starts over at the base backoff
+    trip(breaker);
+    TEST_ASSERT_EQUAL_UINT32(BASE_BACKOFF_MS, breaker.getRetryIn(millis()));
+}
+
+void test_cancelled_trial_returns_to_open() {
+    CircuitBreaker breaker(1, BASE_BACKOFF_MS, MAX_BACKOFF_MS);
+    trip(breaker);
+    NativeClock::advance(BASE_BACKOFF_MS);
+    TEST_ASSERT_TRUE(breaker.allowRequest(millis()));
+    
+    // The trial never went out (queue full, say): back to OPEN with the backoff already served,
+    // so the trial is handed out again at once and the backoff is not doubled
+    breaker.cancelRequest();
+    TEST_ASSERT_EQUAL(CircuitBreaker::BREAKER_OPEN, breaker.getState());
+    TEST_ASSERT_EQUAL_UINT32(0, breaker.getCounters().halfOpened);
+    TEST_ASSERT_EQUAL_UINT32(0, breaker.getRetryIn(millis()));
+    TEST_ASSERT_EQUAL_UINT32(BASE_BACKOFF_MS, breaker.getBackoff());
+    TEST_ASSERT_TRUE(breaker.allowRequest(millis()));
+    TEST_ASSERT_EQUAL(CircuitBreaker::BREAKER_HALF_OPEN, breaker.getState());
+    TEST_ASSERT_EQUAL_UINT32(1, breaker.getCounters().halfOpened);
+    
+    // Outside HALF_OPEN there is nothing to give back
+    breaker.recordSuccess(millis());
+    breaker.cancelRequest();
+    TEST_ASSERT_TRUE(breaker.isClosed());
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_trips_after_threshold_and_rejects_during_backoff);
+    RUN_TEST(test_backoff_doubles_up_to_the_cap);
+    RUN_TEST(test_successful_trial_closes_and_resets_backoff);
+    RUN_TEST(test_cancelled_trial_returns_to_open);
+    return UNITY_END();
+}
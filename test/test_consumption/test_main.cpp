@@ -0,0 +1,147 @@
+// ConsumptionEstimator: slope of a known burn, sliding window, millis() wrap, anchor rebase and
+// the MAX_GAP_MS restart (pio test -e native -f test_consumption)
+
+#include <unity.h>
+#include <ConsumptionEstimator.h>
+
+static const unsigned long SAMPLE_MS = 1000;
+static const uint32_t HOUR_MS = 3600000;
+
+// Level falling `unitsPerHour` from `level` over `durationMs`, one reading per periodMs from
+// `start`; times are taken in 32 bits as millis() on the C3. Returns the time after the last one
+static unsigned long burn(ConsumptionEstimator& estimator, unsigned long start, uint32_t durationMs,
+                          uint16_t level, uint32_t unitsPerHour, unsigned long periodMs = SAMPLE_MS) {
+    uint32_t elapsed = 0;
+    for (; elapsed < durationMs; elapsed += periodMs) {
+        uint16_t value = (uint16_t)(level - (uint64_t)elapsed * unitsPerHour / HOUR_MS);
+        estimator.add(value, (uint32_t)(start + elapsed));
+    }
+    return (uint32_t)(start + elapsed);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_no_rate_before_min_buckets() {
+    ConsumptionEstimator estimator;
+    TEST_ASSERT_FALSE(estimator.isValid());
+    TEST_ASSERT_FALSE(estimator.getRate().isValid());
+    
+    // A bucket closes with the first reading after BUCKET_MS
+    unsigned long now = burn(estimator, 0, ConsumptionEstimator::MIN_BUCKETS * ConsumptionEstimator::BUCKET_MS,
+                             3000, 7200);
+    TEST_ASSERT_EQUAL(ConsumptionEstimator::MIN_BUCKETS - 1, estimator.getBucketCount());
+    TEST_ASSERT_FALSE(estimator.isValid());
+    estimator.add(3000 - 2 * ConsumptionEstimator::MIN_BUCKETS * 15, now);
+    TEST_ASSERT_EQUAL(ConsumptionEstimator::MIN_BUCKETS, estimator.getBucketCount());
+    TEST_ASSERT_TRUE(estimator.isValid());
+    TEST_ASSERT_EQUAL_UINT32(7 * ConsumptionEstimator::BUCKET_MS, estimator.getSpan());
+}
+
+void test_slope_of_known_burn() {
+    // 2 units/s: every bucket mean sits exactly on the line
+    ConsumptionEstimator estimator;
+    burn(estimator, 0, 10 * 60000, 3000, 7200);
+    TEST_ASSERT_EQUAL_INT32(720000, estimator.getRate().toRaw());
+    
+    // 45 L/h at 8 s polls: 1 unit every 8 s, read as a staircase
+    estimator.reset();
+    burn(estimator, 0, 20 * 60000, 3000, 450, 8000);
+    TEST_ASSERT_INT_WITHIN(100, 45000, estimator.getRate().toRaw());
+    
+    // A rising level gives a negative rate
+    estimator.reset();
+    for (uint32_t t = 0; t < 10 * 60000; t += SAMPLE_MS) {
+        estimator.add((uint16_t)(1000 + t / 1000), t);
+    }
+    TEST_ASSERT_EQUAL_INT32(-360000, estimator.getRate().toRaw());
+}
+
+void test_window_slides() {
+    // 16 min of burn, then the engine stops: once the window holds only the idle part the rate is 0
+    ConsumptionEstimator estimator;
+    unsigned long now = burn(estimator, 0, 20 * 60000, 3000, 3600);
+    TEST_ASSERT_EQUAL_INT32(360000, estimator.getRate().toRaw());
+    TEST_ASSERT_EQUAL(ConsumptionEstimator::WINDOW_SIZE, estimator.getBucketCount());
+    
+    now = burn(estimator, now, 10 * 60000, 1800, 0);
+    TEST_ASSERT_TRUE(estimator.getRate().toRaw() > 0);
+    TEST_ASSERT_TRUE(estimator.getRate().toRaw() < 360000);
+    burn(estimator, now, 17 * 60000, 1800, 0);
+    TEST_ASSERT_EQUAL_INT32(0, estimator.getRate().toRaw());
+    TEST_ASSERT_EQUAL(ConsumptionEstimator::WINDOW_SIZE, estimator.getBucketCount());
+    TEST_ASSERT_EQUAL_UINT32((ConsumptionEstimator::WINDOW_SIZE - 1) * ConsumptionEstimator::BUCKET_MS,
+                             estimator.getSpan());
+}
+
+void test_millis_wrap() {
+    // Starts 5 min before millis() wraps (49.7 days) and runs 15 min past it
+    ConsumptionEstimator reference;
+    ConsumptionEstimator wrapped;
+    burn(reference, 0, 20 * 60000, 3000, 7200);
+    unsigned long end = burn(wrapped, 0xFFFFFFFFUL - 5 * 60000, 20 * 60000, 3000, 7200);
+    TEST_ASSERT_TRUE(end < 20 * 60000);
+    TEST_ASSERT_EQUAL(reference.getBucketCount(), wrapped.getBucketCount());
+    TEST_ASSERT_EQUAL_INT32(720000, wrapped.getRate().toRaw());
+    TEST_ASSERT_EQUAL_UINT32(reference.getSpan(), wrapped.getSpan());
+}
+
+void test_rebase_keeps_the_slope() {
+    // 12 units/h without a break for 13 days: the anchor moves after 2^20 s (12.1 days). A second
+    // estimator started an hour before that never rebases; one reading per bucket keeps the two
+    // windows identical, so the rates must match exactly
+    ConsumptionEstimator estimator;
+    ConsumptionEstimator fresh;
+    const uint32_t periodMs = ConsumptionEstimator::BUCKET_MS;
+    const uint32_t rebaseSample = (1UL << 20) * 1000 / periodMs;
+    const uint32_t freshStart = rebaseSample - HOUR_MS / periodMs;
+    uint32_t compared = 0;
+    for (uint32_t i = 0; i < 13UL * 86400000 / periodMs; i++) {
+        uint16_t level = (uint16_t)(4000 - (uint64_t)i * periodMs * 12 / HOUR_MS);
+        estimator.add(level, i * periodMs);
+        if (i >= freshStart) {
+            fresh.add(level, i * periodMs);
+        }
+        if (fresh.getBucketCount() == ConsumptionEstimator::WINDOW_SIZE) {
+            TEST_ASSERT_EQUAL_INT32(fresh.getRate().toRaw(), estimator.getRate().toRaw());
+            compared++;
+        }
+    }
+    TEST_ASSERT_TRUE(compared > 5000);
+    TEST_ASSERT_INT_WITHIN(100, 1200, estimator.getRate().toRaw());
+    TEST_ASSERT_EQUAL_UINT32((ConsumptionEstimator::WINDOW_SIZE - 1) * ConsumptionEstimator::BUCKET_MS,
+                             estimator.getSpan());
+}
+
+void test_gap_restarts_the_window() {
+    ConsumptionEstimator estimator;
+    unsigned long now = burn(estimator, 0, 10 * 60000, 3000, 7200);
+    TEST_ASSERT_TRUE(estimator.isValid());
+    
+    // Exactly MAX_GAP_MS still continues the window
+    now += ConsumptionEstimator::MAX_GAP_MS - SAMPLE_MS;
+    uint8_t buckets = estimator.getBucketCount();
+    estimator.add(1800, now);
+    TEST_ASSERT_EQUAL(buckets + 1, estimator.getBucketCount());
+    
+    // One millisecond more starts over from the reading after the gap
+    now += ConsumptionEstimator::MAX_GAP_MS + 1;
+    estimator.add(1700, now);
+    TEST_ASSERT_EQUAL(0, estimator.getBucketCount());
+    TEST_ASSERT_FALSE(estimator.isValid());
+    burn(estimator, now + SAMPLE_MS, 3 * 60000, 1700, 3600);
+    TEST_ASSERT_TRUE(estimator.isValid());
+    TEST_ASSERT_EQUAL_INT32(360000, estimator.getRate().toRaw());
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_no_rate_before_min_buckets);
+    RUN_TEST(test_slope_of_known_burn);
+    RUN_TEST(test_window_slides);
+    RUN_TEST(test_millis_wrap);
+    RUN_TEST(test_rebase_keeps_the_slope);
+    RUN_TEST(test_gap_restarts_the_window);
+    return UNITY_END();
+}
@@ -0,0 +1,105 @@
+// CRC8 lookup variants: agreement on random data and host throughput in bytes/s
+// (pio test -e native -f test_crc8, add -v to see the benchmark figures)
+
+#include <unity.h>
+#include <CRC8.h>
+#include <chrono>
+#include <vector>
+
+static const size_t BENCH_BYTES = 1UL << 20;
+static const int BENCH_ROUNDS = 8;
+
+// The two parameter sets in use: AoooG frames (reflected) and SHT words (MSB-first)
+template <CRC8Variant V> using Maxim = CRC8<0x31, 0x00, true, V>;
+template <CRC8Variant V> using Nrsc5 = CRC8<0x31, 0xFF, false, V>;
+
+static uint32_t randomState = 0x1234567;
+static uint8_t nextByte() {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return (uint8_t)randomState;
+}
+
+static std::vector<uint8_t> randomBytes(size_t length) {
+    std::vector<uint8_t> data(length);
+    for (uint8_t& byte : data) {
+        byte = nextByte();
+    }
+    return data;
+}
+
+// Bytes per second of Crc::compute over data, best of BENCH_ROUNDS
+template <typename Crc>
+static double measure(const std::vector<uint8_t>& data, uint8_t& result) {
+    double best = 0;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        auto start = std::chrono::steady_clock::now();
+        volatile uint8_t crc = Crc::compute(data.data(), data.size());
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        result = crc;
+        best = max(best, data.size() / elapsed.count());
+    }
+    return best;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_variants_agree_on_random_data() {
+    for (int i = 0; i < 2000; i++) {
+        std::vector<uint8_t> data = randomBytes(nextByte() % 40);
+        uint8_t maxim = Maxim<CRC8_TABLE>::compute(data.data(), data.size());
+        TEST_ASSERT_EQUAL_HEX8(maxim, Maxim<CRC8_NIBBLE>::compute(data.data(), data.size()));
+        TEST_ASSERT_EQUAL_HEX8(maxim, Maxim<CRC8_BITWISE>::compute(data.data(), data.size()));
+        uint8_t nrsc5 = Nrsc5<CRC8_TABLE>::compute(data.data(), data.size());
+        TEST_ASSERT_EQUAL_HEX8(nrsc5, Nrsc5<CRC8_NIBBLE>::compute(data.data(), data.size()));
+        TEST_ASSERT_EQUAL_HEX8(nrsc5, Nrsc5<CRC8_BITWISE>::compute(data.data(), data.size()));
+    }
+}
+
+void test_appended_crc_checks_to_zero() {
+    // How the frame parser validates a reply: the CRC over frame and CRC byte is 0 (no init, no xorout)
+    for (int i = 0; i < 200; i++) {
+        std::vector<uint8_t> frame = randomBytes(1 + nextByte() % 31);
+        frame.push_back(Maxim<CRC8_TABLE>::compute(frame.data(), frame.size()));
+        TEST_ASSERT_EQUAL_HEX8(0, Maxim<CRC8_TABLE>::compute(frame.data(), frame.size()));
+    }
+}
+
+void test_benchmark_variants() {
+    std::vector<uint8_t> data = randomBytes(BENCH_BYTES);
+    uint8_t results[6];
+    double rates[6] = {
+        measure<Maxim<CRC8_BITWISE>>(data, results[0]),
+        measure<Maxim<CRC8_NIBBLE>>(data, results[1]),
+        measure<Maxim<CRC8_TABLE>>(data, results[2]),
+        measure<Nrsc5<CRC8_BITWISE>>(data, results[3]),
+        measure<Nrsc5<CRC8_NIBBLE>>(data, results[4]),
+        measure<Nrsc5<CRC8_TABLE>>(data, results[5]),
+    };
+    const char* names[6] = {"MAXIM bitwise", "MAXIM nibble", "MAXIM table",
+                            "NRSC-5 bitwise", "NRSC-5 nibble", "NRSC-5 table"};
+    char message[96];
+    for (int i = 0; i < 6; i++) {
+        snprintf(message, sizeof(message), "%-14s %8.1f MB/s %6.2f ns/byte", names[i], rates[i] / 1e6, 1e9 / rates[i]);
+        TEST_MESSAGE(message);
+    }
+    
+    // Same answer whatever the variant, and the 256-byte table earns its flash
+    TEST_ASSERT_EQUAL_HEX8(results[2], results[0]);
+    TEST_ASSERT_EQUAL_HEX8(results[2], results[1]);
+    TEST_ASSERT_EQUAL_HEX8(results[5], results[3]);
+    TEST_ASSERT_EQUAL_HEX8(results[5], results[4]);
+    TEST_ASSERT_TRUE(rates[2] > rates[0]);
+    TEST_ASSERT_TRUE(rates[5] > rates[3]);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_variants_agree_on_random_data);
+    RUN_TEST(test_appended_crc_checks_to_zero);
+    RUN_TEST(test_benchmark_variants);
+    return UNITY_END();
+}
@@ -0,0 +1,184 @@
+// Centi/Deci against the float pipeline they replaced: same results, and the host cost of each
+// (pio test -e native -f test_fixed_point, add -v to see the benchmark figures)
+//
+// The host has an FPU, so hardware double understates what float costs on the ESP32-C3. The
+// soft-float column runs the same formulas in binary128, which GCC implements in software
+// (__addtf3, __multf3, __divtf3) like the C3's __adddf3 family: an upper bound, not the C3 figure.
+
+#include <unity.h>
+#include <FixedPoint.h>
+#include <chrono>
+#include <vector>
+
+static const int BENCH_SAMPLES = 1 << 16;
+static const int BENCH_ROUNDS = 5;
+
+#ifdef __SIZEOF_FLOAT128__
+typedef __float128 SoftFloat;
+#endif
+
+// SHTSensor::readMeasurement() conversion, hundredths rounded
+static Centi shtTemperature(uint16_t raw) {
+    return Centi::fromRaw(-4500 + (int32_t)((17500UL * raw + 32767) / 65535));
+}
+static Centi shtHumidity(uint16_t raw) {
+    return Centi::fromRaw((int32_t)((10000UL * raw + 32767) / 65535));
+}
+
+// calculateFuelPercentage() with a tank table: share of the volume range in 0.01 %
+static Centi fuelPercent(Deci volume, Deci emptyVolume, Deci fullVolume) {
+    int32_t range = fullVolume.toRaw() - emptyVolume.toRaw();
+    return Centi::fromRaw((int32_t)((int64_t)(volume.toRaw() - emptyVolume.toRaw()) * 10000 / range));
+}
+
+// One measurement cycle as loop() runs it: convert, compare against the alert limits, percentage
+template <typename T>
+struct FloatPipeline {
+    static int run(uint16_t tempRaw, uint16_t humRaw, uint16_t fuelRaw) {
+        T temperature = (T)-45.0 + (T)175.0 * ((T)tempRaw / (T)65535.0);
+        T humidity = (T)100.0 * ((T)humRaw / (T)65535.0);
+        T litres = (T)fuelRaw * (T)0.1;
+        T percent = (litres - (T)10.0) * (T)100.0 / ((T)400.0 - (T)10.0);
+        return (temperature > (T)35.0) + (humidity > (T)90.0) + (percent <= (T)5.0);
+    }
+};
+
+struct FixedPipeline {
+    static int run(uint16_t tempRaw, uint16_t humRaw, uint16_t fuelRaw) {
+        Centi temperature = shtTemperature(tempRaw);
+        Centi humidity = shtHumidity(humRaw);
+        Deci litres = Deci::fromRaw(fuelRaw);
+        Centi percent = fuelPercent(litres, Deci::fromUnits(10), Deci::fromUnits(400));
+        return (temperature > Centi::fromUnits(35)) + (humidity > Centi::fromUnits(90)) +
+               (percent <= Centi::fromUnits(5));
+    }
+};
+
+struct Samples {
+    std::vector<uint16_t> temp, hum, fuel;
+};
+
+static Samples makeSamples() {
+    Samples samples;
+    uint32_t state = 0xC0FFEE;
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        state = state * 1664525 + 1013904223;
+        samples.temp.push_back((uint16_t)(state >> 16));
+        samples.hum.push_back((uint16_t)state);
+        samples.fuel.push_back((uint16_t)(state >> 20));
+    }
+    return samples;
+}
+
+// Nanoseconds per sample, best of BENCH_ROUNDS
+template <typename Pipeline>
+static double measure(const Samples& samples, int& alerts) {
+    double best = 1e30;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        volatile int sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < BENCH_SAMPLES; i++) {
+            sink = sink + Pipeline::run(samples.temp[i], samples.hum[i], samples.fuel[i]);
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        alerts = sink;
+        best = min(best, elapsed.count() / BENCH_SAMPLES);
+    }
+    return best;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_sht_conversion_matches_double_everywhere() {
+    // Every raw value: the integer formula is the rounded double result (it never hits a tie)
+    for (uint32_t raw = 0; raw <= 0xFFFF; raw++) {
+        double temperature = -45.0 + 175.0 * (raw / 65535.0);
+        double humidity = 100.0 * (raw / 65535.0);
+        TEST_ASSERT_EQUAL_INT32((int32_t)lround(temperature * 100), shtTemperature(raw).toRaw());
+        TEST_ASSERT_EQUAL_INT32((int32_t)lround(humidity * 100), shtHumidity(raw).toRaw());
+    }
+}
+
+void test_fuel_percent_within_one_step_of_double() {
+    const Deci emptyVolume = Deci::fromUnits(10), fullVolume = Deci::fromUnits(400);
+    for (int32_t volume = 100; volume <= 4000; volume++) {
+        double expected = (volume / 10.0 - 10.0) * 10000.0 / (400.0 - 10.0);
+        int32_t percent = fuelPercent(Deci::fromRaw(volume), emptyVolume, fullVolume).toRaw();
+        // Truncates where the float code was displayed rounded: at most one 0.01 % step apart
+        TEST_ASSERT_INT_WITHIN(1, (int32_t)lround(expected), percent);
+    }
+}
+
+void test_format_matches_printf() {
+    // Rounded half away from zero; test off the ties, where binary doubles round either way
+    char fixed[FIXED_TEXT_SIZE], reference[FIXED_TEXT_SIZE];
+    for (int32_t raw = -9999; raw <= 9999; raw++) {
+        if (abs(raw) % 10 == 5) {
+            continue;
+        }
+        Centi::fromRaw(raw).format(fixed, sizeof(fixed), 1);
+        double value = raw / 100.0;
+        snprintf(reference, sizeof(reference), "%.1f", value);
+        // printf keeps "-0.0", the fixed formatter drops the sign of a zero result
+        if (strcmp(reference, "-0.0") == 0) {
+            strcpy(reference, "0.0");
+        }
+        TEST_ASSERT_EQUAL_STRING(reference, fixed);
+    }
+}
+
+void test_benchmark_pipeline() {
+    Samples samples = makeSamples();
+    int fixedAlerts, doubleAlerts;
+    double fixedNs = measure<FixedPipeline>(samples, fixedAlerts);
+    double doubleNs = measure<FloatPipeline<double>>(samples, doubleAlerts);
+    char message[128];
+    snprintf(message, sizeof(message), "fixed point    %7.2f ns/sample", fixedNs);
+    TEST_MESSAGE(message);
+    snprintf(message, sizeof(message), "double (FPU)   %7.2f ns/sample, %.1fx fixed", doubleNs, doubleNs / fixedNs);
+    TEST_MESSAGE(message);
+    // Same decisions, to within the samples that sit exactly on a limit
+    TEST_ASSERT_INT_WITHIN(BENCH_SAMPLES / 1000, doubleAlerts, fixedAlerts);
+
+#ifdef __SIZEOF_FLOAT128__
+    int softAlerts;
+    double softNs = measure<FloatPipeline<SoftFloat>>(samples, softAlerts);
+    snprintf(message, sizeof(message), "soft-float     %7.2f ns/sample, %.1fx fixed", softNs, softNs / fixedNs);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_INT_WITHIN(BENCH_SAMPLES / 1000, softAlerts, fixedAlerts);
+    TEST_ASSERT_TRUE(fixedNs < softNs);
+#endif
+}
+
+void test_benchmark_format() {
+    char text[FIXED_TEXT_SIZE];
+    double fixedNs = 1e30, floatNs = 1e30;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int32_t raw = -BENCH_SAMPLES / 2; raw < BENCH_SAMPLES / 2; raw++) {
+            Centi::fromRaw(raw).format(text, sizeof(text), 1);
+        }
+        auto middle = std::chrono::steady_clock::now();
+        for (int32_t raw = -BENCH_SAMPLES / 2; raw < BENCH_SAMPLES / 2; raw++) {
+            snprintf(text, sizeof(text), "%.1f", raw / 100.0);
+        }
+        auto end = std::chrono::steady_clock::now();
+        fixedNs = min(fixedNs, std::chrono::duration<double, std::nano>(middle - start).count() / BENCH_SAMPLES);
+        floatNs = min(floatNs, std::chrono::duration<double, std::nano>(end - middle).count() / BENCH_SAMPLES);
+    }
+    char message[128];
+    snprintf(message, sizeof(message), "Centi::format %7.2f ns, printf %%.1f %7.2f ns per value", fixedNs, floatNs);
+    TEST_MESSAGE(message);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_sht_conversion_matches_double_everywhere);
+    RUN_TEST(test_fuel_percent_within_one_step_of_double);
+    RUN_TEST(test_format_matches_printf);
+    RUN_TEST(test_benchmark_pipeline);
+    RUN_TEST(test_benchmark_format);
+    return UNITY_END();
+}
@@ -0,0 +1,98 @@
+#ifndef FRAME_PARSER_CORPUS_H
+#define FRAME_PARSER_CORPUS_H
+
+// Seed corpus for the AoooGFrameParser tests: line captures with the frames a correct
+// parser must emit from them. The fuzz test mutates these inputs.
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct CorpusFrame {
+    const uint8_t* data;
+    size_t length;
+};
+
+struct CorpusCase {
+    const char* name;
+    const uint8_t* input;
+    size_t inputLength;
+    const CorpusFrame* frames;   // Expected frames in order
+    size_t frameCount;
+    bool endsOnIdle;             // Variable-length frame closed by finish()
+};
+
+// Clean data frame
+static const uint8_t CASE0_INPUT[] = {0x3E, 0x01, 0x06, 0x19, 0xD2, 0x04, 0xE7, 0xA7, 0xEA};
+static const uint8_t CASE0_FRAME0[] = {0x3E, 0x01, 0x06, 0x19, 0xD2, 0x04, 0xE7, 0xA7, 0xEA};
+static const CorpusFrame CASE0_FRAMES[] = {{CASE0_FRAME0, sizeof(CASE0_FRAME0)}};
+
+// Leading noise
+static const uint8_t CASE1_INPUT[] = {0x00, 0xFF, 0x31, 0xFF, 0x06, 0x29, 0x3E, 0x01, 0x06, 0x19, 0xD2, 0x04, 0xE7, 0xA7, 0xEA};
+static const uint8_t CASE1_FRAME0[] = {0x3E, 0x01, 0x06, 0x19, 0xD2, 0x04, 0xE7, 0xA7, 0xEA};
+static const CorpusFrame CASE1_FRAMES[] = {{CASE1_FRAME0, sizeof(CASE1_FRAME0)}};
+
+// Tail of previous reply
+static const uint8_t CASE2_INPUT[] = {0x04, 0xE7, 0xA7, 0xEA, 0x3E, 0x02, 0x06, 0x1A, 0x10, 0x00, 0x12, 0x34, 0xD6};
+static const uint8_t CASE2_FRAME0[] = {0x3E, 0x02, 0x06, 0x1A, 0x10, 0x00, 0x12, 0x34, 0xD6};
+static const CorpusFrame CASE2_FRAMES[] = {{CASE2_FRAME0, sizeof(CASE2_FRAME0)}};
+
+// Stray headers before frame
+static const uint8_t CASE3_INPUT[] = {0x3E, 0x3E, 0x3E, 0x3E, 0x01, 0x07, 0x0F, 0xFF, 0x00, 0x10, 0xD8};
+static const uint8_t CASE3_FRAME0[] = {0x3E, 0x01, 0x07, 0x0F, 0xFF, 0x00, 0x10, 0xD8};
+static const CorpusFrame CASE3_FRAMES[] = {{CASE3_FRAME0, sizeof(CASE3_FRAME0)}};
+
+// Bad CRC then good frame
+static const uint8_t CASE4_INPUT[] = {0x3E, 0x01, 0x06, 0x19, 0xD3, 0x04, 0xE7, 0xA7, 0xEA, 0x3E, 0x02, 0x06, 0x1A, 0x10, 0x00, 0x12, 0x34, 0xD6};
+static const uint8_t CASE4_FRAME0[] = {0x3E, 0x02, 0x06, 0x1A, 0x10, 0x00, 0x12, 0x34, 0xD6};
+static const CorpusFrame CASE4_FRAMES[] = {{CASE4_FRAME0, sizeof(CASE4_FRAME0)}};
+
+// Truncated frame then full frame
+static const uint8_t CASE5_INPUT[] = {0x3E, 0x01, 0x06, 0x19, 0xD2, 0x3E, 0x02, 0x06, 0x1A, 0x10, 0x00, 0x12, 0x34, 0xD6};
+static const uint8_t CASE5_FRAME0[] = {0x3E, 0x02, 0x06, 0x1A, 0x10, 0x00, 0x12, 0x34, 0xD6};
+static const CorpusFrame CASE5_FRAMES[] = {{CASE5_FRAME0, sizeof(CASE5_FRAME0)}};
+
+// Unknown event code
+static const uint8_t CASE6_INPUT[] = {0x3E, 0x01, 0x99, 0x00, 0x3E, 0x01, 0x46, 0x00, 0xC7};
+static const uint8_t CASE6_FRAME0[] = {0x3E, 0x01, 0x46, 0x00, 0xC7};
+static const CorpusFrame CASE6_FRAMES[] = {{CASE6_FRAME0, sizeof(CASE6_FRAME0)}};
+
+// Header bytes inside payload
+static const uint8_t CASE7_INPUT[] = {0x3E, 0x01, 0x06, 0x3E, 0x3E, 0x00, 0x3E, 0x3E, 0xE1};
+static const uint8_t CASE7_FRAME0[] = {0x3E, 0x01, 0x06, 0x3E, 0x3E, 0x00, 0x3E, 0x3E, 0xE1};
+static const CorpusFrame CASE7_FRAMES[] = {{CASE7_FRAME0, sizeof(CASE7_FRAME0)}};
+
+// Back to back frames
+static const uint8_t CASE8_INPUT[] = {0x3E, 0x01, 0x07, 0x0F, 0xFF, 0x00, 0x10, 0xD8, 0x3E, 0x01, 0x46, 0x00, 0xC7, 0x3E, 0x01, 0x02, 0x3C, 0x83, 0x0C, 0x00, 0x4E, 0x3E, 0x01, 0x51, 0x26, 0x4A, 0x2A};
+static const uint8_t CASE8_FRAME0[] = {0x3E, 0x01, 0x07, 0x0F, 0xFF, 0x00, 0x10, 0xD8};
+static const uint8_t CASE8_FRAME1[] = {0x3E, 0x01, 0x46, 0x00, 0xC7};
+static const uint8_t CASE8_FRAME2[] = {0x3E, 0x01, 0x02, 0x3C, 0x83, 0x0C, 0x00, 0x4E};
+static const uint8_t CASE8_FRAME3[] = {0x3E, 0x01, 0x51, 0x26, 0x4A, 0x2A};
+static const CorpusFrame CASE8_FRAMES[] = {{CASE8_FRAME0, sizeof(CASE8_FRAME0)}, {CASE8_FRAME1, sizeof(CASE8_FRAME1)}, {CASE8_FRAME2, sizeof(CASE8_FRAME2)}, {CASE8_FRAME3, sizeof(CASE8_FRAME3)}};
+
+// Firmware ends on line idle
+static const uint8_t CASE9_INPUT[] = {0x3E, 0x01, 0x1C, 0x41, 0x6F, 0x6F, 0x6F, 0x47, 0x20, 0x56, 0x32, 0x2E, 0x31, 0xA9};
+static const uint8_t CASE9_FRAME0[] = {0x3E, 0x01, 0x1C, 0x41, 0x6F, 0x6F, 0x6F, 0x47, 0x20, 0x56, 0x32, 0x2E, 0x31, 0xA9};
+static const CorpusFrame CASE9_FRAMES[] = {{CASE9_FRAME0, sizeof(CASE9_FRAME0)}};
+
+// Bad CRC hides a frame
+static const uint8_t CASE10_INPUT[] = {0x3E, 0x01, 0x06, 0x3E, 0x02, 0x06, 0x1A, 0x10, 0x00, 0x12, 0x34, 0xD6, 0x19, 0xD3, 0x04, 0xE7, 0xA7, 0xEA};
+static const uint8_t CASE10_FRAME0[] = {0x3E, 0x02, 0x06, 0x1A, 0x10, 0x00, 0x12, 0x34, 0xD6};
+static const CorpusFrame CASE10_FRAMES[] = {{CASE10_FRAME0, sizeof(CASE10_FRAME0)}};
+
+static const CorpusCase CORPUS[] = {
+    {"clean data frame", CASE0_INPUT, sizeof(CASE0_INPUT), CASE0_FRAMES, 1, false},
+    {"leading noise", CASE1_INPUT, sizeof(CASE1_INPUT), CASE1_FRAMES, 1, false},
+    {"tail of previous reply", CASE2_INPUT, sizeof(CASE2_INPUT), CASE2_FRAMES, 1, false},
+    {"stray headers before frame", CASE3_INPUT, sizeof(CASE3_INPUT), CASE3_FRAMES, 1, false},
+    {"bad CRC then good frame", CASE4_INPUT, sizeof(CASE4_INPUT), CASE4_FRAMES, 1, false},
+    {"truncated frame then full frame", CASE5_INPUT, sizeof(CASE5_INPUT), CASE5_FRAMES, 1, false},
+    {"unknown event code", CASE6_INPUT, sizeof(CASE6_INPUT), CASE6_FRAMES, 1, false},
+    {"header bytes inside payload", CASE7_INPUT, sizeof(CASE7_INPUT), CASE7_FRAMES, 1, false},
+    {"back to back frames", CASE8_INPUT, sizeof(CASE8_INPUT), CASE8_FRAMES, 4, false},
+    {"firmware ends on line idle", CASE9_INPUT, sizeof(CASE9_INPUT), CASE9_FRAMES, 1, true},
+    {"bad CRC hides a frame", CASE10_INPUT, sizeof(CASE10_INPUT), CASE10_FRAMES, 1, false},
+};
+
+static const size_t CORPUS_SIZE = sizeof(CORPUS) / sizeof(CORPUS[0]);
+
+#endif
@@ -0,0 +1,223 @@
+// AoooGFrameParser: seed corpus, seeded fuzzing and a host throughput benchmark
+// (pio test -e native -f test_frame_parser, add -v to see the benchmark figures)
+
+#include <unity.h>
+#include <AoooGFrameParser.h>
+#include <AoooGFrame.h>
+#include <chrono>
+#include <vector>
+#include "corpus.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+static const int FUZZ_ITERATIONS = 20000;
+static const size_t BENCH_BYTES = 4UL << 20;
+static const double MIN_BYTES_PER_SECOND = 1e6;  // 9600 baud needs 960 B/s
+
+// Small deterministic generator so a failing iteration can be reproduced from its number
+static uint32_t fuzzState;
+static uint32_t nextRandom() {
+    fuzzState ^= fuzzState << 13;
+    fuzzState ^= fuzzState >> 17;
+    fuzzState ^= fuzzState << 5;
+    return fuzzState;
+}
+
+static Bytes feedAll(AoooGFrameParser& parser, const uint8_t* data, size_t length, bool endsOnIdle = false) {
+    Bytes frames;
+    std::vector<Bytes> emitted;
+    for (size_t i = 0; i < length; i++) {
+        if (parser.feed(data[i])) {
+            const AoooGFrameParser::Frame& frame = parser.frame();
+            emitted.push_back(Bytes(frame.data, frame.data + frame.length));
+        }
+    }
+    if (endsOnIdle && parser.finish()) {
+        const AoooGFrameParser::Frame& frame = parser.frame();
+        emitted.push_back(Bytes(frame.data, frame.data + frame.length));
+    }
+    // Flatten as [length, bytes...] so a whole run compares in one assert
+    for (const Bytes& frame : emitted) {
+        frames.push_back((uint8_t)frame.size());
+        frames.insert(frames.end(), frame.begin(), frame.end());
+    }
+    return frames;
+}
+
+// Checks every frame a correct parser may emit, whatever the input was
+static void checkFrameInvariants(const AoooGFrameParser::Frame& frame) {
+    TEST_ASSERT_GREATER_OR_EQUAL(AoooGFrameParser::MIN_FRAME_LENGTH, frame.length);
+    TEST_ASSERT_LESS_OR_EQUAL(AoooGFrameParser::MAX_FRAME_LENGTH, frame.length);
+    TEST_ASSERT_EQUAL_HEX8(AoooGFrameParser::HEADER, frame.data[0]);
+    int expected = AoooGFrameParser::frameLength(frame.eventCode());
+    TEST_ASSERT_GREATER_OR_EQUAL(0, expected);
+    if (expected > 0) {
+        // Fixed-length frames are only emitted with a good CRC
+        TEST_ASSERT_EQUAL(expected, frame.length);
+        TEST_ASSERT_TRUE(frame.crcValid);
+    }
+    TEST_ASSERT_EQUAL(frame.crcValid, AoooGCrc8::compute(frame.data, frame.length) == 0);
+}
+
+static void mutate(Bytes& input) {
+    int mutations = 1 + nextRandom() % 4;
+    for (int m = 0; m < mutations; m++) {
+        size_t at = input.empty() ? 0 : nextRandom() % input.size();
+        switch (nextRandom() % 5) {
+            case 0:  // Bit error on the line
+                if (!input.empty()) {
+                    input[at] ^= (uint8_t)(1 << (nextRandom() % 8));
+                }
+                break;
+            case 1:  // Dropped byte
+                if (!input.empty()) {
+                    input.erase(input.begin() + at);
+                }
+                break;
+            case 2:  // Noise byte, often a header
+                input.insert(input.begin() + at, (nextRandom() & 1) ? AoooGFrameParser::HEADER : (uint8_t)nextRandom());
+                break;
+            case 3: {  // Repeated run, as from a second probe answering
+                size_t length = 1 + nextRandom() % 8;
+                Bytes run(input.begin() + at, input.begin() + min(input.size(), at + length));
+                input.insert(input.begin() + at, run.begin(), run.end());
+                break;
+            }
+            default: {  // Spliced with another capture
+                const CorpusCase& other = CORPUS[nextRandom() % CORPUS_SIZE];
+                input.insert(input.begin() + at, other.input, other.input + other.inputLength);
+                break;
+            }
+        }
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_corpus_frames_are_recovered() {
+    for (size_t c = 0; c < CORPUS_SIZE; c++) {
+        const CorpusCase& entry = CORPUS[c];
+        Bytes expected;
+        for (size_t f = 0; f < entry.frameCount; f++) {
+            expected.push_back((uint8_t)entry.frames[f].length);
+            expected.insert(expected.end(), entry.frames[f].data, entry.frames[f].data + entry.frames[f].length);
+        }
+        AoooGFrameParser parser;
+        Bytes frames = feedAll(parser, entry.input, entry.inputLength, entry.endsOnIdle);
+        TEST_ASSERT_EQUAL_MESSAGE(expected.size(), frames.size(), entry.name);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(expected.data(), frames.data(), expected.size(), entry.name);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(entry.frameCount, parser.getFrameCount(), entry.name);
+    }
+}
+
+void test_corpus_byte_by_byte_matches_whole() {
+    // The driver feeds whatever each poll() finds in the UART buffer, so frame boundaries
+    // must not depend on how the bytes were chunked
+    for (size_t c = 0; c < CORPUS_SIZE; c++) {
+        const CorpusCase& entry = CORPUS[c];
+        AoooGFrameParser whole, split;
+        Bytes expected = feedAll(whole, entry.input, entry.inputLength, entry.endsOnIdle);
+        Bytes frames;
+        for (size_t i = 0; i < entry.inputLength; i++) {
+            Bytes part = feedAll(split, entry.input + i, 1, entry.endsOnIdle && i + 1 == entry.inputLength);
+            frames.insert(frames.end(), part.begin(), part.end());
+        }
+        TEST_ASSERT_EQUAL_MESSAGE(expected.size(), frames.size(), entry.name);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(expected.data(), frames.data(), expected.size(), entry.name);
+    }
+}
+
+void test_fuzz_invariants_and_recovery() {
+    const CorpusCase& clean = CORPUS[0];
+    fuzzState = 0x2545F491;
+    for (int iteration = 0; iteration < FUZZ_ITERATIONS; iteration++) {
+        const CorpusCase& seed = CORPUS[nextRandom() % CORPUS_SIZE];
+        Bytes input(seed.input, seed.input + seed.inputLength);
+        mutate(input);
+        
+        AoooGFrameParser parser;
+        uint32_t emitted = 0;
+        for (uint8_t byte : input) {
+            if (parser.feed(byte)) {
+                checkFrameInvariants(parser.frame());
+                emitted++;
+            }
+        }
+        if (parser.finish()) {
+            checkFrameInvariants(parser.frame());
+            emitted++;
+        }
+        TEST_ASSERT_EQUAL_UINT32(emitted, parser.getFrameCount());
+        
+        // Whatever the garbage left behind, a quiet line and one good reply get through
+        Bytes recovery(2 * AoooGFrameParser::MAX_FRAME_LENGTH, 0x00);
+        recovery.insert(recovery.end(), clean.input, clean.input + clean.inputLength);
+        bool recovered = false;
+        for (uint8_t byte : recovery) {
+            if (parser.feed(byte)) {
+                checkFrameInvariants(parser.frame());
+                const AoooGFrameParser::Frame& frame = parser.frame();
+                recovered = frame.length == clean.inputLength && memcmp(frame.data, clean.input, frame.length) == 0;
+            }
+        }
+        if (!recovered) {
+            char message[64];
+            snprintf(message, sizeof(message), "no recovery after fuzz iteration %d", iteration);
+            TEST_FAIL_MESSAGE(message);
+        }
+    }
+}
+
+static double benchmark(const Bytes& stream, uint32_t& frames) {
+    AoooGFrameParser parser;
+    auto start = std::chrono::steady_clock::now();
+    for (uint8_t byte : stream) {
+        parser.feed(byte);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    frames = parser.getFrameCount();
+    return stream.size() / elapsed.count();
+}
+
+void test_benchmark_throughput() {
+    // Mix of the fixed-length replies seen in normal polling
+    Bytes clean;
+    const size_t mix[] = {0, 8};  // Data frame; limits, status, serial, empty frequency
+    while (clean.size() < BENCH_BYTES) {
+        for (size_t c : mix) {
+            clean.insert(clean.end(), CORPUS[c].input, CORPUS[c].input + CORPUS[c].inputLength);
+        }
+    }
+    Bytes noisy = clean;
+    fuzzState = 0x9E3779B9;
+    for (size_t i = 0; i < noisy.size(); i += 1 + nextRandom() % 200) {
+        noisy[i] ^= (uint8_t)(1 << (nextRandom() % 8));   // About one bit error per 100 bytes
+    }
+    
+    uint32_t cleanFrames, noisyFrames;
+    double cleanRate = benchmark(clean, cleanFrames);
+    double noisyRate = benchmark(noisy, noisyFrames);
+    
+    char message[128];
+    snprintf(message, sizeof(message), "clean: %.1f MB/s, %.1f ns/byte, %lu frames",
+             cleanRate / 1e6, 1e9 / cleanRate, (unsigned long)cleanFrames);
+    TEST_MESSAGE(message);
+    snprintf(message, sizeof(message), "1%% bit errors: %.1f MB/s, %.1f ns/byte, %lu frames",
+             noisyRate / 1e6, 1e9 / noisyRate, (unsigned long)noisyFrames);
+    TEST_MESSAGE(message);
+    
+    TEST_ASSERT_GREATER_THAN(0, noisyFrames);
+    TEST_ASSERT_TRUE(cleanRate > MIN_BYTES_PER_SECOND);
+    TEST_ASSERT_TRUE(noisyRate > MIN_BYTES_PER_SECOND);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_corpus_frames_are_recovered);
+    RUN_TEST(test_corpus_byte_by_byte_matches_whole);
+    RUN_TEST(test_fuzz_invariants_and_recovery);
+    RUN_TEST(test_benchmark_throughput);
+    return UNITY_END();
+}
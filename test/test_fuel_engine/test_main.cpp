@@ -0,0 +1,306 @@
+// FuelSensor transaction engine against a scripted link: replies, timeouts, partial frames
+// and late replies, all in virtual time (pio test -e native -f test_fuel_engine)
+
+#include <unity.h>
+#include <FuelSensor.h>
+#include <AoooGFrame.h>
+#include <ScriptedStream.h>
+#include <vector>
+
+static const unsigned long POLL_STEP_MICROS = 100;
+
+// 3E [address] 06 [temperature] [fuel lo] [fuel hi] [freq hi] [freq lo] [CRC]
+static std::vector<uint8_t> dataReply(uint8_t address, uint8_t temperature, uint16_t fuelValue, uint16_t frequency) {
+    std::vector<uint8_t> frame = {0x3E, address, 0x06, temperature,
+                                  (uint8_t)fuelValue, (uint8_t)(fuelValue >> 8),
+                                  (uint8_t)(frequency >> 8), (uint8_t)frequency};
+    frame.push_back(AoooGCrc8::compute(frame.data(), frame.size()));
+    return frame;
+}
+
+// Call poll() as loop() would until the transaction completes; every call must return
+// without consuming time, waiting happens between the calls
+static FuelSensor::TransactionStatus pump(FuelSensor& sensor, FuelSensor::TransactionHandle handle,
+                                          unsigned long limitMs = 5000) {
+    unsigned long start = millis();
+    FuelSensor::TransactionStatus status;
+    while ((status = sensor.getTransactionStatus(handle)) == FuelSensor::TRANSACTION_PENDING &&
+           millis() - start < limitMs) {
+        unsigned long before = micros();
+        sensor.poll();
+        TEST_ASSERT_EQUAL_UINT32(before, micros());
+        NativeClock::advanceMicros(POLL_STEP_MICROS);
+    }
+    return status;
+}
+
+struct CallbackLog {
+    int calls = 0;
+    FuelSensor::TransactionResult result;
+    std::vector<uint8_t> response;
+};
+
+static void recordResult(FuelSensor&, const FuelSensor::TransactionResult& result, void* context) {
+    CallbackLog* log = (CallbackLog*)context;
+    log->calls++;
+    log->result = result;
+    log->response.assign(result.response, result.response + result.responseLength);
+}
+
+void setUp() {
+    NativeClock::reset();
+}
+
+void tearDown() {}
+
+void test_reply_completes_through_callback() {
+    ScriptedStream link;
+    FuelSensor sensor(0x01);
+    sensor.begin(link);
+    CallbackLog log;
+    
+    FuelSensor::TransactionHandle handle = sensor.submitRequest(0x01, FuelSensor::EVENT_READ_DATA, recordResult, &log);
+    TEST_ASSERT_NOT_EQUAL(FuelSensor::INVALID_TRANSACTION, handle);
+    sensor.poll();  // Sends the request
+    std::vector<uint8_t> request = {0x31, 0x01, 0x06};
+    request.push_back(AoooGCrc8::compute(request.data(), request.size()));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(request.data(), link.written().data(), 4);
+    
+    std::vector<uint8_t> reply = dataReply(0x01, 25, 1234, 0xE7A7);
+    link.schedule(20000, reply);
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, pump(sensor, handle));
+    
+    TEST_ASSERT_EQUAL(1, log.calls);
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, log.result.status);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(reply.data(), log.response.data(), reply.size());
+    // 20 ms latency plus 9 characters at 9600 baud
+    TEST_ASSERT_UINT32_WITHIN(2, 29, log.result.elapsedMs);
+    TEST_ASSERT_TRUE(sensor.isDataValid());
+    TEST_ASSERT_EQUAL_UINT16(1234, sensor.getFuelValue());
+    TEST_ASSERT_EQUAL_UINT16(0xE7A7, sensor.getFrequency());
+    TEST_ASSERT_TRUE(sensor.isLinkUp());
+}
+
+void test_timeout_without_reply() {
+    ScriptedStream link;
+    FuelSensor sensor(0x01);
+    sensor.begin(link);
+    CallbackLog log;
+    
+    FuelSensor::TransactionHandle handle = sensor.submitRequest(0x01, FuelSensor::EVENT_READ_DATA, recordResult, &log);
+    unsigned long start = millis();
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_TIMEOUT, pump(sensor, handle));
+    
+    // Fails at the deadline, not before, and only once
+    TEST_ASSERT_UINT32_WITHIN(1, 1000, millis() - start);
+    TEST_ASSERT_EQUAL(1, log.calls);
+    TEST_ASSERT_EQUAL(0, log.result.responseLength);
+    TEST_ASSERT_FALSE(sensor.isDataValid());
+    TEST_ASSERT_EQUAL_UINT8(1, sensor.getConsecutiveMisses());
+    TEST_ASSERT_FALSE(sensor.isBusy());
+}
+
+void test_timeout_override_per_request() {
+    ScriptedStream link;
+    FuelSensor sensor(0x01);
+    sensor.begin(link);
+    
+    FuelSensor::TransactionHandle handle = sensor.submitRequest(0x01, FuelSensor::EVENT_READ_DATA, nullptr, nullptr, 150);
+    unsigned long start = millis();
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_TIMEOUT, pump(sensor, handle));
+    TEST_ASSERT_UINT32_WITHIN(1, 150, millis() - start);
+}
+
+void test_partial_frame_ends_on_line_idle() {
+    ScriptedStream link;
+    FuelSensor sensor(0x01);
+    sensor.begin(link);
+    
+    FuelSensor::TransactionHandle handle = sensor.submitRequest(0x01, FuelSensor::EVENT_READ_DATA);
+    sensor.poll();
+    std::vector<uint8_t> reply = dataReply(0x01, 25, 1234, 0xE7A7);
+    link.schedule(20000, reply.data(), 5);  // Line drops after 5 of 9 bytes
+    unsigned long start = millis();
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_TIMEOUT, pump(sensor, handle));
+    
+    // Given up 3.5 character times after the last byte, long before the 1 s deadline
+    unsigned long lastByteMs = 20 + (5 * ScriptedStream::BYTE_MICROS_9600) / 1000;
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(lastByteMs + sensor.getFrameGap() / 1000 + 2, millis() - start);
+    TEST_ASSERT_FALSE(sensor.isDataValid());
+    // No complete frame came back: counts as unanswered
+    TEST_ASSERT_EQUAL_UINT8(1, sensor.getConsecutiveMisses());
+}
+
+void test_split_reply_reassembled_across_polls() {
+    ScriptedStream link;
+    FuelSensor sensor(0x01);
+    sensor.begin(link);
+    
+    FuelSensor::TransactionHandle handle = sensor.submitRequest(0x01, FuelSensor::EVENT_READ_DATA);
+    sensor.poll();
+    // Two bursts with a pause shorter than the frame gap: still one frame
+    std::vector<uint8_t> reply = dataReply(0x01, 30, 2000, 0x1000);
+    link.schedule(10000, reply.data(), 4);
+    link.schedule(10000 + 4 * ScriptedStream::BYTE_MICROS_9600 + sensor.getFrameGap() / 2,
+                  reply.data() + 4, reply.size() - 4);
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, pump(sensor, handle));
+    TEST_ASSERT_EQUAL_UINT16(2000, sensor.getFuelValue());
+}
+
+void test_late_reply_is_not_taken_for_the_next_request() {
+    ScriptedStream link;
+    FuelSensor sensor(0x01);
+    sensor.begin(link);
+    
+    FuelSensor::TransactionHandle first = sensor.submitRequest(0x01, FuelSensor::EVENT_READ_DATA, nullptr, nullptr, 100);
+    sensor.poll();
+    link.schedule(250000, dataReply(0x01, 20, 111, 0x1111));  // Answers 150 ms after the deadline
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_TIMEOUT, pump(sensor, first));
+    
+    // The late frame lands while the engine is idle
+    for (int i = 0; i < 3000; i++) {
+        sensor.poll();
+        NativeClock::advanceMicros(POLL_STEP_MICROS);
+    }
+    TEST_ASSERT_EQUAL(0, (int)link.scheduledLength());
+    
+    FuelSensor::TransactionHandle second = sensor.submitRequest(0x01, FuelSensor::EVENT_READ_DATA);
+    sensor.poll();
+    link.schedule(20000, dataReply(0x01, 21, 222, 0x2222));
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, pump(sensor, second));
+    TEST_ASSERT_EQUAL_UINT16(222, sensor.getFuelValue());
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_TIMEOUT, sensor.getTransactionStatus(first));
+}
+
+void test_late_reply_in_input_is_dropped_before_sending() {
+    ScriptedStream link;
+    FuelSensor sensor(0x01);
+    sensor.begin(link);
+    
+    FuelSensor::TransactionHandle first = sensor.submitRequest(0x01, FuelSensor::EVENT_READ_DATA, nullptr, nullptr, 100);
+    sensor.poll();
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_TIMEOUT, pump(sensor, first));
+    
+    // The stale reply is already waiting when the next request is queued behind it
+    link.schedule(0, dataReply(0x01, 20, 111, 0x1111), 0);
+    FuelSensor::TransactionHandle second = sensor.submitRequest(0x01, FuelSensor::EVENT_READ_DATA);
+    sensor.poll();
+    link.schedule(20000, dataReply(0x01, 21, 222, 0x2222));
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, pump(sensor, second));
+    TEST_ASSERT_EQUAL_UINT16(222, sensor.getFuelValue());
+}
+
+void test_corrupted_reply_is_rejected() {
+    ScriptedStream link;
+    FuelSensor sensor(0x01);
+    sensor.begin(link);
+    
+    CallbackLog log;
+    FuelSensor::TransactionHandle handle = sensor.submitRequest(0x01, FuelSensor::EVENT_READ_DATA, recordResult, &log);
+    sensor.poll();
+    std::vector<uint8_t> reply = dataReply(0x01, 25, 1234, 0xE7A7);
+    reply[4] ^= 0x01;
+    link.schedule(20000, reply);
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_INVALID, pump(sensor, handle));
+    TEST_ASSERT_FALSE(sensor.isDataValid());
+    TEST_ASSERT_EQUAL_UINT32(1, sensor.getFrameParser().getCrcErrors());
+    // Nothing is left pending after the resync, yet the idle line ends the exchange, not the deadline
+    TEST_ASSERT_TRUE(log.result.elapsedMs < 50);
+}
+
+void test_corrupted_variable_reply_is_rejected() {
+    ScriptedStream link;
+    FuelSensor sensor(0x01);
+    sensor.begin(link);
+    
+    // 0x1C has no fixed length: the frame ends on line idle and only then is its CRC known
+    std::vector<uint8_t> reply = {0x3E, 0x01, 0x1C, 'F', 'W', ' ', '2', '.', '1'};
+    reply.push_back(AoooGCrc8::compute(reply.data(), reply.size()));
+    FuelSensor::TransactionHandle good = sensor.submitRequest(0x01, FuelSensor::EVENT_READ_FIRMWARE);
+    sensor.poll();
+    link.schedule(20000, reply);
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, pump(sensor, good));
+    TEST_ASSERT_EQUAL((int)reply.size(), sensor.getFirmwareVersionLength());
+    
+    reply[5] = 'X';
+    CallbackLog log;
+    FuelSensor::TransactionHandle bad = sensor.submitRequest(0x01, FuelSensor::EVENT_READ_FIRMWARE, recordResult, &log);
+    sensor.poll();
+    link.schedule(20000, reply);
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_INVALID, pump(sensor, bad));
+    TEST_ASSERT_EQUAL((int)reply.size(), log.result.responseLength);
+    // The previous good version is kept, the corrupted one never reaches the getters
+    TEST_ASSERT_EQUAL_UINT8(' ', sensor.getFirmwareVersion()[5]);
+    // Someone answered: a bad frame still counts for the link
+    TEST_ASSERT_EQUAL_UINT8(0, sensor.getConsecutiveMisses());
+}
+
+void test_queued_requests_run_in_order() {
+    ScriptedStream link;
+    FuelSensor sensor(0x01);
+    sensor.begin(link);
+    CallbackLog first, second;
+    
+    FuelSensor::TransactionHandle a = sensor.submitRequest(0x01, FuelSensor::EVENT_READ_DATA, recordResult, &first);
+    FuelSensor::TransactionHandle b = sensor.submitRequest(0x02, FuelSensor::EVENT_READ_DATA, recordResult, &second);
+    TEST_ASSERT_EQUAL(2, sensor.getPendingCount());
+    sensor.poll();
+    TEST_ASSERT_EQUAL(1, sensor.getPendingCount());
+    link.schedule(10000, dataReply(0x01, 20, 100, 0x0100));
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, pump(sensor, a));
+    sensor.poll();
+    link.schedule(10000, dataReply(0x02, 21, 200, 0x0200));
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, pump(sensor, b));
+    
+    TEST_ASSERT_EQUAL_UINT8(0x01, first.response[1]);
+    TEST_ASSERT_EQUAL_UINT8(0x02, second.response[1]);
+    TEST_ASSERT_EQUAL_UINT16(200, sensor.getFuelValue());
+}
+
+void test_handles_resolve_with_the_queue_kept_full() {
+    ScriptedStream link;
+    FuelSensor sensor(0x01);
+    sensor.begin(link);
+    std::vector<FuelSensor::TransactionHandle> handles;
+    
+    FuelSensor::TransactionHandle handle;
+    while ((handle = sensor.submitRequest(0x01, FuelSensor::EVENT_READ_DATA)) != FuelSensor::INVALID_TRANSACTION) {
+        handles.push_back(handle);
+    }
+    TEST_ASSERT_EQUAL(8, (int)handles.size());
+    
+    // Refill after each send: one request on the wire and a full queue behind it, 20 times over
+    for (size_t done = 0; done < 20; done++) {
+        sensor.poll();
+        handle = sensor.submitRequest(0x01, FuelSensor::EVENT_READ_DATA);
+        TEST_ASSERT_NOT_EQUAL(FuelSensor::INVALID_TRANSACTION, handle);
+        handles.push_back(handle);
+        for (size_t i = done; i < handles.size(); i++) {
+            TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_PENDING, sensor.getTransactionStatus(handles[i]));
+        }
+        
+        link.schedule(10000, dataReply(0x01, 20, (uint16_t)done, 0x0100));
+        TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, pump(sensor, handles[done]));
+        // The last 8 completed stay readable as well
+        for (size_t i = done >= 7 ? done - 7 : 0; i <= done; i++) {
+            TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, sensor.getTransactionStatus(handles[i]));
+        }
+    }
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_UNKNOWN, sensor.getTransactionStatus(handles[0]));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_reply_completes_through_callback);
+    RUN_TEST(test_timeout_without_reply);
+    RUN_TEST(test_timeout_override_per_request);
+    RUN_TEST(test_partial_frame_ends_on_line_idle);
+    RUN_TEST(test_split_reply_reassembled_across_polls);
+    RUN_TEST(test_late_reply_is_not_taken_for_the_next_request);
+    RUN_TEST(test_late_reply_in_input_is_dropped_before_sending);
+    RUN_TEST(test_corrupted_reply_is_rejected);
+    RUN_TEST(test_corrupted_variable_reply_is_rejected);
+    RUN_TEST(test_queued_requests_run_in_order);
+    RUN_TEST(test_handles_resolve_with_the_queue_kept_full);
+    return UNITY_END();
+}
@@ -0,0 +1,337 @@
+// FuelSensor against AoooGSimulator: reply latency, every command, several probes, line faults,
+// and a load generator that finds the fastest sustainable poll rate
+// (pio test -e native -f test_fuel_simulator, add -v to see the load figures)
+
+#include <unity.h>
+#include <FuelSensor.h>
+#include <AoooGSimulator.h>
+#include <AoooGFrame.h>
+
+static const unsigned long POLL_STEP_MICROS = 100;
+static const int DATA_FRAME_LENGTH = 9;
+
+struct ReplyLog {
+    int ok = 0;
+    int timeout = 0;
+    int invalid = 0;
+    int wrongData = 0;                 // OK replies whose bytes differ from what the probe sent
+    unsigned long minElapsedMs = ~0UL;
+    unsigned long maxElapsedMs = 0;
+    unsigned long totalElapsedMs = 0;
+    AoooGSimulator* simulator = nullptr;
+    uint8_t lastAddress = 0;
+    uint16_t lastFuelValue = 0;
+};
+
+static void countReply(FuelSensor&, const FuelSensor::TransactionResult& result, void* context) {
+    ReplyLog* log = (ReplyLog*)context;
+    switch (result.status) {
+        case FuelSensor::TRANSACTION_OK:      log->ok++; break;
+        case FuelSensor::TRANSACTION_TIMEOUT: log->timeout++; return;
+        default:                              log->invalid++; return;
+    }
+    log->minElapsedMs = min(log->minElapsedMs, result.elapsedMs);
+    log->maxElapsedMs = max(log->maxElapsedMs, result.elapsedMs);
+    log->totalElapsedMs += result.elapsedMs;
+    if (result.eventCode != FuelSensor::EVENT_READ_DATA || result.responseLength != DATA_FRAME_LENGTH) {
+        return;
+    }
+    log->lastAddress = result.response[1];
+    log->lastFuelValue = result.response[4] | (result.response[5] << 8);
+    // A reply passed as OK must be the probe's own, byte for byte
+    const AoooGSimulator::Probe* probe = log->simulator ? log->simulator->findProbe(result.address) : nullptr;
+    if (probe && (result.response[1] != probe->address || log->lastFuelValue != probe->fuelValue)) {
+        log->wrongData++;
+    }
+}
+
+// Run a queued request to completion the way loop() does, one poll every POLL_STEP_MICROS
+static FuelSensor::TransactionStatus settle(FuelSensor& sensor, FuelSensor::TransactionHandle handle) {
+    TEST_ASSERT_NOT_EQUAL(FuelSensor::INVALID_TRANSACTION, handle);
+    unsigned long start = millis();
+    while (sensor.getTransactionStatus(handle) == FuelSensor::TRANSACTION_PENDING && millis() - start < 5000) {
+        sensor.poll();
+        NativeClock::advanceMicros(POLL_STEP_MICROS);
+    }
+    return sensor.getTransactionStatus(handle);
+}
+
+static FuelSensor::TransactionStatus transact(FuelSensor& sensor, uint8_t address, uint8_t eventCode,
+                                              ReplyLog* log = nullptr) {
+    return settle(sensor, sensor.submitRequest(address, eventCode, log ? countReply : nullptr, log));
+}
+
+struct LoadResult {
+    uint32_t completed;
+    uint32_t ok;
+    double rateHz;       // Successful reads per second
+};
+
+// Load generator: keep the link saturated with data reads round-robin over every probe, polling
+// every loopMicros, and count what gets through in durationMs of virtual time
+static LoadResult generateLoad(AoooGSimulator& simulator, unsigned long loopMicros, unsigned long durationMs) {
+    FuelSensor sensor(0x01);
+    sensor.begin(simulator);
+    ReplyLog log;
+    log.simulator = &simulator;
+    uint32_t submitted = 0;
+    unsigned long start = millis();
+    while (millis() - start < durationMs) {
+        sensor.poll();
+        if (!sensor.isBusy()) {
+            uint8_t address = simulator.getProbe(submitted % simulator.getProbeCount())->address;
+            sensor.submitRequest(address, FuelSensor::EVENT_READ_DATA, countReply, &log);
+            submitted++;
+            sensor.poll();  // Sends it
+        }
+        NativeClock::advanceMicros(loopMicros);
+    }
+    TEST_ASSERT_EQUAL(0, log.wrongData);
+    LoadResult result;
+    result.completed = log.ok + log.timeout + log.invalid;
+    result.ok = log.ok;
+    result.rateHz = log.ok * 1000.0 / durationMs;
+    return result;
+}
+
+void setUp() {
+    NativeClock::reset();
+}
+
+void tearDown() {}
+
+void test_reply_latency_follows_link() {
+    // Elapsed = probe latency + reply characters; a fixed-length frame ends on its last byte
+    struct Case { unsigned long latencyMs; unsigned long baudrate; };
+    const Case cases[] = {{5, 9600}, {15, 9600}, {40, 9600}, {15, 19200}, {15, 115200}};
+    for (const Case& c : cases) {
+        AoooGSimulator simulator;
+        simulator.addProbe(0x01);
+        simulator.setLatency(c.latencyMs);
+        simulator.setBaudrate(c.baudrate);
+        FuelSensor sensor(0x01);
+        sensor.begin(simulator, c.baudrate);
+        ReplyLog log;
+        TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, transact(sensor, 0x01, FuelSensor::EVENT_READ_DATA, &log));
+        unsigned long expected = c.latencyMs + DATA_FRAME_LENGTH * 10000UL / c.baudrate;
+        TEST_ASSERT_UINT32_WITHIN(1, expected, log.maxElapsedMs);
+    }
+}
+
+void test_jitter_stays_within_bounds() {
+    AoooGSimulator simulator(7);
+    simulator.addProbe(0x01);
+    simulator.setLatency(10, 20);
+    FuelSensor sensor(0x01);
+    sensor.begin(simulator);
+    ReplyLog log;
+    for (int i = 0; i < 200; i++) {
+        TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, transact(sensor, 0x01, FuelSensor::EVENT_READ_DATA, &log));
+    }
+    // 9 characters at 9600 baud take 9.4 ms on top of 10-30 ms
+    TEST_ASSERT_GREATER_OR_EQUAL(19, log.minElapsedMs);
+    TEST_ASSERT_LESS_OR_EQUAL(40, log.maxElapsedMs);
+    TEST_ASSERT_UINT32_WITHIN(4, 29, log.totalElapsedMs / log.ok);
+    // Spread actually exercised, not a constant
+    TEST_ASSERT_GREATER_OR_EQUAL(15, log.maxElapsedMs - log.minElapsedMs);
+}
+
+void test_every_command_round_trips() {
+    AoooGSimulator simulator;
+    int index = simulator.addProbe(0x01);
+    AoooGSimulator::Probe* probe = simulator.getProbe(index);
+    probe->temperature = 31;
+    probe->fuelValue = 2750;
+    probe->frequency = 41234;
+    probe->levelMax = 3900;
+    probe->levelMin = 120;
+    probe->emptyFrequency = 18000;
+    probe->serialNumber = 123456;
+    FuelSensor sensor(0x01);
+    sensor.begin(simulator);
+    
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, transact(sensor, 0x01, FuelSensor::EVENT_READ_DATA));
+    TEST_ASSERT_EQUAL_UINT16(2750, sensor.getFuelValue());
+    TEST_ASSERT_EQUAL_UINT16(41234, sensor.getFrequency());
+    TEST_ASSERT_TRUE(sensor.getTemperature() == Centi::fromUnits(31));
+    
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, transact(sensor, 0x01, FuelSensor::EVENT_READ_LIMITS));
+    TEST_ASSERT_EQUAL_UINT16(3900, sensor.getLevelMax());
+    TEST_ASSERT_EQUAL_UINT16(120, sensor.getLevelMin());
+    
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, transact(sensor, 0x01, FuelSensor::EVENT_READ_SERIAL));
+    TEST_ASSERT_EQUAL_UINT32(123456, sensor.getSerialNumber());
+    
+    // Variable length: ends on line idle
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, transact(sensor, 0x01, FuelSensor::EVENT_READ_FIRMWARE));
+    TEST_ASSERT_GREATER_THAN(0, sensor.getFirmwareVersionLength());
+    TEST_ASSERT_TRUE(memmem(sensor.getFirmwareVersion(), sensor.getFirmwareVersionLength(), "SIM-AoooG", 9) != nullptr);
+    
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, transact(sensor, 0x01, FuelSensor::EVENT_EXTENDED_E3));
+    TEST_ASSERT_GREATER_THAN(0, sensor.getExtendedResponseLength());
+    
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, transact(sensor, 0x01, FuelSensor::EVENT_READ_EMPTY_FREQ));
+    TEST_ASSERT_EQUAL_UINT16(18000, sensor.getEmptyFrequency());
+    
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, transact(sensor, 0x01, FuelSensor::EVENT_SET_FULL_FREQ));
+    TEST_ASSERT_TRUE(sensor.getLastSetSuccess());
+    TEST_ASSERT_EQUAL_UINT16(2750, probe->levelMax);
+    
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, transact(sensor, 0x01, FuelSensor::EVENT_FACTORY_RESET));
+    TEST_ASSERT_EQUAL_UINT16(4095, probe->levelMax);
+    
+    // Restart: nothing comes back and the probe ignores requests while it boots
+    transact(sensor, FuelSensor::BROADCAST_ADDRESS, FuelSensor::EVENT_RESTART_SENSOR);
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_TIMEOUT, transact(sensor, 0x01, FuelSensor::EVENT_READ_DATA));
+    NativeClock::advance(AoooGSimulator::DEFAULT_BOOT_TIME_MS);
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, transact(sensor, 0x01, FuelSensor::EVENT_READ_DATA));
+}
+
+void test_each_address_answers_for_itself() {
+    AoooGSimulator simulator;
+    for (uint8_t address = 1; address <= 4; address++) {
+        simulator.getProbe(simulator.addProbe(address))->fuelValue = address * 1000;
+    }
+    FuelSensor sensor(0x01);
+    sensor.begin(simulator);
+    ReplyLog log;
+    log.simulator = &simulator;
+    
+    for (uint8_t address = 1; address <= 4; address++) {
+        TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, transact(sensor, address, FuelSensor::EVENT_READ_DATA, &log));
+        TEST_ASSERT_EQUAL_UINT8(address, log.lastAddress);
+        TEST_ASSERT_EQUAL_UINT16(address * 1000, log.lastFuelValue);
+    }
+    // An address nobody has is simply not answered
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_TIMEOUT, transact(sensor, 0x09, FuelSensor::EVENT_READ_DATA));
+    TEST_ASSERT_EQUAL(0, log.wrongData);
+}
+
+void test_menu_commands_reach_only_their_probe() {
+    AoooGSimulator simulator;
+    for (uint8_t address = 1; address <= 3; address++) {
+        AoooGSimulator::Probe* probe = simulator.getProbe(simulator.addProbe(address));
+        probe->fuelValue = address * 1000;
+        probe->emptyFrequency = address * 100;
+    }
+    FuelSensor sensor(0x01);
+    sensor.begin(simulator);
+    
+    // Addressed to 0x02 and answered by 0x02 alone, not rejected for not being 0x01
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, settle(sensor, sensor.readEmptyFrequency(0x02)));
+    TEST_ASSERT_EQUAL_UINT16(200, sensor.getEmptyFrequency());
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, settle(sensor, sensor.setFullLevel(0x02)));
+    TEST_ASSERT_TRUE(sensor.getLastSetSuccess());
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, settle(sensor, sensor.factoryReset(0x03)));
+    TEST_ASSERT_TRUE(sensor.getLastSetSuccess());
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, settle(sensor, sensor.readSerialNumber(0x03)));
+    TEST_ASSERT_EQUAL_UINT32(simulator.getProbe(2)->serialNumber, sensor.getSerialNumber());
+    
+    // The three-command sequence is queued at once, nothing waits inside the call
+    ReplyLog log;
+    unsigned long before = micros();
+    FuelSensor::TransactionHandle restart = sensor.sendMultipleCommands(0x01, countReply, &log);
+    TEST_ASSERT_EQUAL_UINT32(before, micros());
+    TEST_ASSERT_EQUAL(3, sensor.getPendingCount());
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK, settle(sensor, restart));
+    TEST_ASSERT_EQUAL(3, log.ok);
+    
+    TEST_ASSERT_EQUAL_UINT16(4000, simulator.getProbe(0)->levelMax);
+    TEST_ASSERT_EQUAL_UINT16(2000, simulator.getProbe(1)->levelMax);
+    TEST_ASSERT_EQUAL_UINT16(4095, simulator.getProbe(2)->levelMax);
+    TEST_ASSERT_EQUAL_UINT32(0, simulator.getStats().collisions);
+}
+
+void test_broadcast_collision_is_rejected() {
+    AoooGSimulator simulator;
+    simulator.addProbe(0x01);
+    simulator.addProbe(0x02);
+    FuelSensor sensor(0x01);
+    sensor.begin(simulator);
+    
+    // Two serial numbers on the line at once: the merged frame must not pass as either one
+    TEST_ASSERT_NOT_EQUAL(FuelSensor::TRANSACTION_OK,
+                          transact(sensor, FuelSensor::BROADCAST_ADDRESS, FuelSensor::EVENT_READ_SERIAL));
+    TEST_ASSERT_EQUAL_UINT32(1, simulator.getStats().collisions);
+    
+    simulator.setBroadcastCollisions(false);
+    TEST_ASSERT_EQUAL(FuelSensor::TRANSACTION_OK,
+                      transact(sensor, FuelSensor::BROADCAST_ADDRESS, FuelSensor::EVENT_READ_SERIAL));
+    TEST_ASSERT_EQUAL_UINT32(800001, sensor.getSerialNumber());
+}
+
+void test_line_faults_never_pass_as_data() {
+    AoooGSimulator simulator(42);
+    simulator.addProbe(0x01);
+    simulator.addProbe(0x02);
+    simulator.setLatency(10, 10);
+    simulator.setByteDropRate(5);     // 0.5 % of bytes: about one reply in 20
+    simulator.setCrcErrorRate(50);    // 5 % of replies
+    FuelSensor sensor(0x01);
+    sensor.begin(simulator);
+    ReplyLog log;
+    log.simulator = &simulator;
+    
+    const int requests = 2000;
+    for (int i = 0; i < requests; i++) {
+        simulator.getProbe(i % 2)->fuelValue = (uint16_t)(i * 7 % 4096);
+        transact(sensor, simulator.getProbe(i % 2)->address, FuelSensor::EVENT_READ_DATA, &log);
+    }
+    
+    TEST_ASSERT_EQUAL(requests, log.ok + log.timeout + log.invalid);
+    TEST_ASSERT_EQUAL(0, log.wrongData);
+    // Every damaged reply is lost, every clean one gets through
+    uint32_t damaged = simulator.getStats().corruptedFrames + simulator.getStats().droppedBytes;
+    TEST_ASSERT_GREATER_OR_EQUAL(requests - damaged, (uint32_t)log.ok);
+    TEST_ASSERT_GREATER_OR_EQUAL(requests * 85 / 100, log.ok);
+    TEST_ASSERT_LESS_OR_EQUAL(simulator.getStats().corruptedFrames, sensor.getFrameParser().getCrcErrors());
+    // Isolated losses never take the link down
+    TEST_ASSERT_TRUE(sensor.isLinkUp());
+}
+
+void test_load_generator_finds_max_poll_rate() {
+    // Loop periods: as fast as the engine allows, and main.cpp's loop with its delay(10)
+    const unsigned long loopMicros[] = {100, 1000, 10000};
+    const unsigned long durationMs = 30000;
+    char message[128];
+    
+    for (unsigned long loop : loopMicros) {
+        AoooGSimulator simulator;
+        simulator.addProbe(0x01);
+        simulator.addProbe(0x02);
+        LoadResult clean = generateLoad(simulator, loop, durationMs);
+        
+        AoooGSimulator noisy(3);
+        noisy.addProbe(0x01);
+        noisy.addProbe(0x02);
+        noisy.setLatency(AoooGSimulator::DEFAULT_LATENCY_MS, 10);
+        noisy.setByteDropRate(5);
+        noisy.setCrcErrorRate(20);
+        LoadResult faulty = generateLoad(noisy, loop, durationMs);
+        
+        snprintf(message, sizeof(message), "loop %lu us: %.1f reads/s clean, %.1f reads/s with faults (%lu/%lu ok)",
+                 loop, clean.rateHz, faulty.rateHz, (unsigned long)faulty.ok, (unsigned long)faulty.completed);
+        TEST_MESSAGE(message);
+        
+        // The link bound: latency plus 9 characters per read, polled at loop granularity
+        double linkMs = AoooGSimulator::DEFAULT_LATENCY_MS + DATA_FRAME_LENGTH * 10000.0 / 9600;
+        double cycleMs = (loop / 1000.0) * ((unsigned long)(linkMs * 1000 / loop) + 1);
+        TEST_ASSERT_GREATER_OR_EQUAL((uint32_t)(1000.0 / cycleMs * 0.9), (uint32_t)clean.rateHz);
+        TEST_ASSERT_LESS_OR_EQUAL((uint32_t)(1000.0 / linkMs) + 1, (uint32_t)clean.rateHz);
+        TEST_ASSERT_GREATER_THAN(0, faulty.ok);
+        TEST_ASSERT_TRUE(faulty.rateHz <= clean.rateHz);
+    }
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_reply_latency_follows_link);
+    RUN_TEST(test_jitter_stays_within_bounds);
+    RUN_TEST(test_every_command_round_trips);
+    RUN_TEST(test_each_address_answers_for_itself);
+    RUN_TEST(test_menu_commands_reach_only_their_probe);
+    RUN_TEST(test_broadcast_collision_is_rejected);
+    RUN_TEST(test_line_faults_never_pass_as_data);
+    RUN_TEST(test_load_generator_finds_max_poll_rate);
+    return UNITY_END();
+}
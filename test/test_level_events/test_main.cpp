@@ -0,0 +1,225 @@
+// LevelEventDetector on recorded-style level traces (1 s samples): refuel, siphon, small top-up,
+// slow consumption and slosh, then a steady burn through FuelBusManager in virtual time
+// (pio test -e native -f test_level_events)
+
+#include <unity.h>
+#include <LevelEventDetector.h>
+#include <LevelFilter.h>
+#include <FuelBusManager.h>
+#include <AoooGSimulator.h>
+#include <vector>
+
+static const unsigned long SAMPLE_MS = 1000;
+static const unsigned long LOOP_STEP_MS = 1;
+
+typedef std::vector<uint16_t> Trace;
+
+// Straight line from the last level to `to` over `samples` samples
+static void ramp(Trace& trace, int samples, int to) {
+    int from = trace.back();
+    for (int i = 1; i <= samples; i++) {
+        trace.push_back((uint16_t)(from + (to - from) * i / samples));
+    }
+}
+
+static void hold(Trace& trace, int samples) {
+    trace.insert(trace.end(), samples, trace.back());
+}
+
+struct Result {
+    std::vector<LevelEventDetector::Event> events;
+    std::vector<size_t> steps;      // Sample index of each step entry
+};
+
+// One sample per periodMs, events taken as soon as they are reported
+static Result run(LevelEventDetector& detector, const Trace& trace, unsigned long periodMs = SAMPLE_MS) {
+    Result result;
+    LevelEventDetector::Event event;
+    for (size_t i = 0; i < trace.size(); i++) {
+        bool wasInStep = detector.isInStep();
+        detector.add(trace[i], i * periodMs);
+        if (detector.isInStep() && !wasInStep) {
+            result.steps.push_back(i);
+        }
+        if (detector.takeEvent(event)) {
+            result.events.push_back(event);
+        }
+    }
+    return result;
+}
+
+static Result run(const Trace& trace) {
+    LevelEventDetector detector;
+    return run(detector, trace);
+}
+
+void setUp() {
+    NativeClock::reset();
+}
+
+void tearDown() {}
+
+void test_refuel() {
+    Trace trace(60, 3000);
+    ramp(trace, 20, 3400);          // 40 L in 20 s
+    hold(trace, 60);
+    Result result = run(trace);
+    
+    TEST_ASSERT_EQUAL(1, result.events.size());
+    const LevelEventDetector::Event& event = result.events[0];
+    TEST_ASSERT_EQUAL(LevelEventDetector::EVENT_REFUEL, event.type);
+    TEST_ASSERT_EQUAL_UINT32(60000, event.startTime);     // First rising sample
+    TEST_ASSERT_EQUAL_UINT32(79000, event.endTime);       // Top reached
+    TEST_ASSERT_EQUAL_UINT16(3000, event.startLevel);
+    TEST_ASSERT_EQUAL_UINT16(3400, event.endLevel);
+}
+
+void test_siphon() {
+    Trace trace(60, 3000);
+    ramp(trace, 100, 2800);         // 20 L over 100 s
+    hold(trace, 60);
+    Result result = run(trace);
+    
+    // 2 units/sample is inside the drift allowance only for the first sample; the new level
+    // counts as settled once it stays within SETTLE_BAND
+    TEST_ASSERT_EQUAL(1, result.events.size());
+    const LevelEventDetector::Event& event = result.events[0];
+    TEST_ASSERT_EQUAL(LevelEventDetector::EVENT_DRAIN, event.type);
+    TEST_ASSERT_EQUAL_UINT32(61000, event.startTime);
+    TEST_ASSERT_EQUAL_UINT32(156000, event.endTime);
+    TEST_ASSERT_EQUAL_UINT16(3000, event.startLevel);
+    TEST_ASSERT_EQUAL_UINT16(2806, event.endLevel);
+    TEST_ASSERT_EQUAL(-194, (int)event.endLevel - event.startLevel);
+}
+
+void test_small_top_up_is_not_reported() {
+    Trace trace(60, 3000);
+    ramp(trace, 3, 3030);           // 3 L: a step, but below minStep
+    hold(trace, 60);
+    LevelEventDetector detector;
+    Result result = run(detector, trace);
+    
+    TEST_ASSERT_EQUAL(1, result.steps.size());
+    TEST_ASSERT_FALSE(detector.isInStep());
+    TEST_ASSERT_EQUAL(0, result.events.size());
+    TEST_ASSERT_EQUAL_UINT32(0, detector.getEventCount());
+    
+    // The top-up level is the new reference: a refuel from there measures from 3030
+    trace.clear();
+    trace.assign(1, 3030);
+    ramp(trace, 10, 3130);
+    hold(trace, 40);
+    result = run(detector, trace);
+    TEST_ASSERT_EQUAL(1, result.events.size());
+    TEST_ASSERT_EQUAL_UINT16(3030, result.events[0].startLevel);
+    TEST_ASSERT_EQUAL_UINT16(3130, result.events[0].endLevel);
+}
+
+void test_slow_consumption_is_no_step() {
+    Trace trace(10, 3000);
+    ramp(trace, 1200, 2880);        // 0.1 unit/s, 36 L/h
+    Result result = run(trace);
+    TEST_ASSERT_EQUAL(0, result.steps.size());
+    TEST_ASSERT_EQUAL(0, result.events.size());
+}
+
+void test_slosh_is_held_back_by_the_filter() {
+    // Level swinging +-60 around a steady 3000, as on a rough road
+    Trace trace(30, 3000);
+    for (int i = 0; i < 120; i++) {
+        static const int swing[] = {0, 40, 60, 40, 0, -40, -60, -40};
+        trace.push_back((uint16_t)(3000 + swing[i % 8] + (i % 3) * 7));
+    }
+    trace.insert(trace.end(), 60, 3000);
+    
+    // Fed straight in, the swings read as steps
+    Result raw = run(trace);
+    TEST_ASSERT_TRUE(!raw.steps.empty());
+    
+    // As FuelBusManager feeds it: the median, and nothing while the filter flags slosh
+    LevelFilter filter;
+    LevelEventDetector detector;
+    int sloshSamples = 0;
+    for (size_t i = 0; i < trace.size(); i++) {
+        filter.add(trace[i]);
+        if (filter.isSloshing()) {
+            sloshSamples++;
+            continue;
+        }
+        detector.add(filter.getMedian(), i * SAMPLE_MS);
+        TEST_ASSERT_FALSE(detector.isInStep());
+    }
+    TEST_ASSERT_TRUE(sloshSamples > 100);
+    TEST_ASSERT_EQUAL_UINT32(0, detector.getEventCount());
+}
+
+void test_steady_burn_enters_short_steps() {
+    // 1 unit/sample: the reference lags 8 units behind, beyond the drift allowance, and it only
+    // follows while both sums are zero. So every 19 samples the fall reads as a step that
+    // settles below minStep and is never reported.
+    Trace trace(10, 3000);
+    ramp(trace, 400, 2600);
+    LevelEventDetector detector;
+    Result result = run(detector, trace, 8000);     // Adaptive polling backs off to 8 s at this rate
+    TEST_ASSERT_EQUAL(21, result.steps.size());
+    TEST_ASSERT_EQUAL(24, result.steps[0]);
+    for (size_t i = 1; i < result.steps.size(); i++) {
+        TEST_ASSERT_EQUAL(19, result.steps[i] - result.steps[i - 1]);
+    }
+    TEST_ASSERT_EQUAL(0, result.events.size());
+    TEST_ASSERT_FALSE(detector.isInStep());
+    
+    // At 1 s samples a step at this rate never holds still long enough to settle
+    trace.assign(10, 3000);
+    ramp(trace, 600, 2400);
+    result = run(trace);
+    TEST_ASSERT_EQUAL(1, result.steps.size());
+    TEST_ASSERT_EQUAL(0, result.events.size());
+}
+
+void test_steady_burn_keeps_the_consumption_rate() {
+    // The short steps above must not restart the rate: 1 unit per 8 s poll is 450 units/h
+    AoooGSimulator simulator;
+    simulator.addProbe(0x01);
+    AoooGSimulator::Probe* simulated = simulator.getProbe(0);
+    simulated->fuelValue = 3000;
+    FuelSensor sensor(0xFF);
+    sensor.begin(simulator);
+    FuelBusManager bus(sensor);
+    bus.setRequestInterval(8000);
+    bus.startScan(FuelBusManager::FIRST_ADDRESS, 0x02);
+    
+    uint32_t polls = 0;
+    bool stepSeen = false;
+    while (millis() < 1200000) {
+        sensor.poll();
+        bus.poll();
+        const FuelBusManager::Probe* probe = bus.getProbe(0);
+        if (probe && probe->pollCount != polls) {
+            polls = probe->pollCount;
+            simulated->fuelValue--;
+            stepSeen = stepSeen || probe->events.isInStep();
+        }
+        NativeClock::advance(LOOP_STEP_MS);
+    }
+    
+    const FuelBusManager::Probe* probe = bus.getProbe(0);
+    TEST_ASSERT_NOT_NULL(probe);
+    TEST_ASSERT_TRUE(polls > 100);
+    TEST_ASSERT_TRUE(stepSeen);
+    TEST_ASSERT_EQUAL_UINT32(0, probe->events.getEventCount());
+    TEST_ASSERT_TRUE(probe->consumption.isValid());
+    TEST_ASSERT_INT_WITHIN(2000, 45000, probe->consumption.getRate().toRaw());
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_refuel);
+    RUN_TEST(test_siphon);
+    RUN_TEST(test_small_top_up_is_not_reported);
+    RUN_TEST(test_slow_consumption_is_no_step);
+    RUN_TEST(test_slosh_is_held_back_by_the_filter);
+    RUN_TEST(test_steady_burn_enters_short_steps);
+    RUN_TEST(test_steady_burn_keeps_the_consumption_rate);
+    return UNITY_END();
+}
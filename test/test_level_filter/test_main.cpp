@@ -0,0 +1,258 @@
+// LevelFilter: median against a sorted reference, Kalman smoothing, slosh hysteresis and the
+// host cost of add() (pio test -e native -f test_level_filter, add -v to see the benchmark figures)
+
+#include <unity.h>
+#include <LevelFilter.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+static const int BENCH_SAMPLES = 1 << 20;
+static const int BENCH_ROUNDS = 5;
+static const double MIN_SAMPLES_PER_SECOND = 1e6;  // A probe answers at most ~100 polls/s at 9600 baud
+
+static uint32_t randomState = 0x13579BD;
+static uint32_t nextRandom() {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+// Level around base with +-noise units and an occasional single-frame spike
+static std::vector<uint16_t> noisyLevel(size_t count, uint16_t base, int noise) {
+    std::vector<uint16_t> samples(count);
+    for (uint16_t& sample : samples) {
+        int value = base + (int)(nextRandom() % (2 * noise + 1)) - noise;
+        if (nextRandom() % 20 == 0) {
+            value += (int)(nextRandom() % 1000) - 500;
+        }
+        sample = (uint16_t)std::max(0, std::min(4095, value));
+    }
+    return samples;
+}
+
+// Lower median of the last window readings, sorted from scratch
+static uint16_t referenceMedian(const std::vector<uint16_t>& samples, size_t end, size_t window) {
+    size_t begin = end > window ? end - window : 0;
+    std::vector<uint16_t> last(samples.begin() + begin, samples.begin() + end);
+    std::sort(last.begin(), last.end());
+    return last[(last.size() - 1) / 2];
+}
+
+// Alternating base +- amplitude, the variance of an even run is amplitude^2
+static void addSwing(LevelFilter& filter, int count, int amplitude) {
+    for (int i = 0; i < count; i++) {
+        filter.add((uint16_t)(2000 + (i % 2 ? amplitude : -amplitude)));
+    }
+}
+
+// Samples per second through add(), best of BENCH_ROUNDS
+static double measureFilter(uint8_t window, const std::vector<uint16_t>& samples, uint16_t& level) {
+    double best = 0;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        LevelFilter filter;
+        filter.setMedianWindow(window);
+        auto start = std::chrono::steady_clock::now();
+        for (uint16_t sample : samples) {
+            filter.add(sample);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        level = filter.getLevel();
+        best = std::max(best, samples.size() / elapsed.count());
+    }
+    return best;
+}
+
+// Same median by copying and sorting the window every sample
+static double measureSortedMedian(size_t window, const std::vector<uint16_t>& samples, uint16_t& median) {
+    double best = 0;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        uint16_t ring[LevelFilter::MAX_MEDIAN_WINDOW] = {};
+        uint16_t scratch[LevelFilter::MAX_MEDIAN_WINDOW];
+        size_t head = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint16_t sample : samples) {
+            ring[head] = sample;
+            head = (head + 1) % window;
+            memcpy(scratch, ring, window * sizeof(ring[0]));
+            std::sort(scratch, scratch + window);
+            median = scratch[(window - 1) / 2];
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::max(best, samples.size() / elapsed.count());
+    }
+    return best;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_median_matches_sorted_reference() {
+    for (uint8_t window = 1; window <= LevelFilter::MAX_MEDIAN_WINDOW; window += 2) {
+        std::vector<uint16_t> samples = noisyLevel(500, 1500, 30);
+        LevelFilter filter;
+        filter.setMedianWindow(window);
+        for (size_t i = 0; i < samples.size(); i++) {
+            filter.add(samples[i]);
+            TEST_ASSERT_EQUAL_UINT16(samples[i], filter.getRaw());
+            TEST_ASSERT_EQUAL_UINT16(referenceMedian(samples, i + 1, window), filter.getMedian());
+        }
+    }
+}
+
+void test_median_drops_short_spikes() {
+    LevelFilter filter;
+    for (int i = 0; i < 10; i++) {
+        filter.add(1000);
+    }
+    // Window 5: two spikes in a row are outvoted, a third one is not
+    filter.add(3000);
+    filter.add(3000);
+    TEST_ASSERT_EQUAL_UINT16(1000, filter.getMedian());
+    TEST_ASSERT_EQUAL_UINT16(1000, filter.getLevel());
+    filter.add(3000);
+    TEST_ASSERT_EQUAL_UINT16(3000, filter.getMedian());
+}
+
+void test_window_is_clamped_and_restarts_the_filter() {
+    LevelFilter filter;
+    TEST_ASSERT_FALSE(filter.isValid());
+    filter.add(100);
+    TEST_ASSERT_TRUE(filter.isValid());
+    
+    filter.setMedianWindow(4);
+    TEST_ASSERT_EQUAL(3, filter.getMedianWindow());
+    TEST_ASSERT_FALSE(filter.isValid());
+    TEST_ASSERT_EQUAL_UINT32(0, filter.getSampleCount());
+    filter.setMedianWindow(0);
+    TEST_ASSERT_EQUAL(1, filter.getMedianWindow());
+    filter.setMedianWindow(200);
+    TEST_ASSERT_EQUAL(LevelFilter::MAX_MEDIAN_WINDOW, filter.getMedianWindow());
+    
+    // Same window: the filter keeps its state
+    filter.add(100);
+    filter.setMedianWindow(LevelFilter::MAX_MEDIAN_WINDOW);
+    TEST_ASSERT_EQUAL_UINT32(1, filter.getSampleCount());
+}
+
+void test_kalman_smooths_noise_and_follows_steps() {
+    LevelFilter filter;
+    filter.setSloshThreshold(1000000);
+    for (int i = 0; i < 20; i++) {
+        filter.add(2000);
+        TEST_ASSERT_EQUAL_UINT16(2000, filter.getLevel());
+    }
+    
+    // +-4 units of noise: the level stays well inside it
+    for (int i = 0; i < 200; i++) {
+        filter.add((uint16_t)(2000 + (int)(nextRandom() % 9) - 4));
+        TEST_ASSERT_INT_WITHIN(2, 2000, filter.getLevel());
+    }
+    
+    // Step of 100 units: no overshoot, settled within a few dozen samples
+    uint16_t previous = filter.getLevel();
+    int settled = -1;
+    for (int i = 0; i < 60; i++) {
+        filter.add(2100);
+        TEST_ASSERT_TRUE(filter.getLevel() >= previous);
+        TEST_ASSERT_TRUE(filter.getLevel() <= 2100);
+        previous = filter.getLevel();
+        if (settled < 0 && previous >= 2095) {
+            settled = i;
+        }
+    }
+    TEST_ASSERT_TRUE(settled > 2);
+    TEST_ASSERT_TRUE(settled < 40);
+}
+
+void test_sloshing_slows_the_kalman_stage() {
+    // A real step also reads as slosh while it is in the variance window
+    LevelFilter calm;
+    LevelFilter moving;
+    calm.setSloshThreshold(1000000);
+    for (int i = 0; i < 20; i++) {
+        calm.add(1000);
+        moving.add(1000);
+    }
+    for (int i = 0; i < 6; i++) {
+        calm.add(1200);
+        moving.add(1200);
+    }
+    TEST_ASSERT_FALSE(calm.isSloshing());
+    TEST_ASSERT_TRUE(moving.isSloshing());
+    TEST_ASSERT_EQUAL_UINT16(calm.getMedian(), moving.getMedian());
+    TEST_ASSERT_TRUE(moving.getLevel() < calm.getLevel());
+}
+
+void test_slosh_hysteresis() {
+    LevelFilter filter;
+    
+    // Needs half the history before it can enter
+    addSwing(filter, LevelFilter::HISTORY_SIZE / 2 - 1, 30);
+    TEST_ASSERT_TRUE(filter.getVariance() > LevelFilter::DEFAULT_SLOSH_VARIANCE);
+    TEST_ASSERT_FALSE(filter.isSloshing());
+    addSwing(filter, 1, 30);
+    TEST_ASSERT_TRUE(filter.isSloshing());
+    
+    // 19^2 = 361: below the threshold, above 3/4 of it, so it stays
+    addSwing(filter, 2 * LevelFilter::HISTORY_SIZE, 19);
+    TEST_ASSERT_EQUAL_UINT32(361, filter.getVariance());
+    TEST_ASSERT_TRUE(filter.isSloshing());
+    
+    // 17^2 = 289 leaves
+    addSwing(filter, LevelFilter::HISTORY_SIZE, 17);
+    TEST_ASSERT_EQUAL_UINT32(289, filter.getVariance());
+    TEST_ASSERT_FALSE(filter.isSloshing());
+    
+    // Back to 361 does not re-enter, 21^2 = 441 does
+    for (int i = 0; i < LevelFilter::HISTORY_SIZE; i++) {
+        addSwing(filter, 2, 19);
+        TEST_ASSERT_FALSE(filter.isSloshing());
+    }
+    addSwing(filter, LevelFilter::HISTORY_SIZE, 21);
+    TEST_ASSERT_TRUE(filter.isSloshing());
+    
+    filter.reset();
+    TEST_ASSERT_FALSE(filter.isSloshing());
+    TEST_ASSERT_EQUAL_UINT32(0, filter.getVariance());
+}
+
+void test_benchmark_add() {
+    std::vector<uint16_t> samples = noisyLevel(BENCH_SAMPLES, 2000, 40);
+    uint16_t levels[2], medians[2];
+    double rates[4] = {
+        measureFilter(LevelFilter::DEFAULT_MEDIAN_WINDOW, samples, levels[0]),
+        measureFilter(LevelFilter::MAX_MEDIAN_WINDOW, samples, levels[1]),
+        measureSortedMedian(LevelFilter::DEFAULT_MEDIAN_WINDOW, samples, medians[0]),
+        measureSortedMedian(LevelFilter::MAX_MEDIAN_WINDOW, samples, medians[1]),
+    };
+    const char* names[4] = {"filter, window 5", "filter, window 15",
+                            "sorted median, 5", "sorted median, 15"};
+    char message[96];
+    for (int i = 0; i < 4; i++) {
+        snprintf(message, sizeof(message), "%-18s %7.1f M samples/s %6.1f ns/sample",
+                 names[i], rates[i] / 1e6, 1e9 / rates[i]);
+        TEST_MESSAGE(message);
+    }
+    
+    // The whole filter (median, variance, Kalman) still beats sorting the widest window alone
+    TEST_ASSERT_INT_WITHIN(40, 2000, levels[0]);
+    TEST_ASSERT_INT_WITHIN(40, 2000, levels[1]);
+    TEST_ASSERT_TRUE(rates[0] > MIN_SAMPLES_PER_SECOND);
+    TEST_ASSERT_TRUE(rates[1] > MIN_SAMPLES_PER_SECOND);
+    TEST_ASSERT_TRUE(rates[1] > rates[3]);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_median_matches_sorted_reference);
+    RUN_TEST(test_median_drops_short_spikes);
+    RUN_TEST(test_window_is_clamped_and_restarts_the_filter);
+    RUN_TEST(test_kalman_smooths_noise_and_follows_steps);
+    RUN_TEST(test_sloshing_slows_the_kalman_stage);
+    RUN_TEST(test_slosh_hysteresis);
+    RUN_TEST(test_benchmark_add);
+    return UNITY_END();
+}
@@ -0,0 +1,137 @@
+// SampleScheduler on the virtual clock: adaptive back-off and reset, burst intervals that
+// follow the sample time, and the rate/duty-cycle window (pio test -e native -f test_sample_scheduler)
+
+#include <unity.h>
+#include <SampleScheduler.h>
+
+static const unsigned long BASE_MS = 1000;
+static const unsigned long MAX_MS = 8000;
+
+// Wait until the next sample is due, then run one that takes busyMs
+static void sample(SampleScheduler& schedule, unsigned long busyMs, bool ok = true, bool changed = false) {
+    while (!schedule.isDue(millis())) {
+        NativeClock::advance(1);
+    }
+    schedule.begin(millis());
+    TEST_ASSERT_FALSE(schedule.isDue(millis()));
+    NativeClock::advance(busyMs);
+    schedule.complete(millis(), ok, changed);
+}
+
+static void stableSamples(SampleScheduler& schedule, int count) {
+    for (int i = 0; i < count; i++) {
+        sample(schedule, 50);
+    }
+}
+
+void setUp() {
+    NativeClock::reset();
+}
+
+void tearDown() {}
+
+void test_adaptive_backs_off_while_stable() {
+    SampleScheduler schedule(BASE_MS, MAX_MS);
+    TEST_ASSERT_TRUE(schedule.isDue(millis()));
+    
+    // Each run of STABLE_SAMPLES unchanged readings doubles the interval, up to the maximum
+    const unsigned long expected[] = {2000, 4000, 8000, 8000};
+    unsigned long previous = BASE_MS;
+    for (unsigned long interval : expected) {
+        stableSamples(schedule, SampleScheduler::STABLE_SAMPLES - 1);
+        TEST_ASSERT_EQUAL_UINT32(previous, schedule.getInterval());
+        stableSamples(schedule, 1);
+        TEST_ASSERT_EQUAL_UINT32(interval, schedule.getInterval());
+        previous = interval;
+    }
+    
+    // Start to start, not end to start
+    unsigned long start = millis() - 50;
+    while (!schedule.isDue(millis())) {
+        NativeClock::advance(1);
+    }
+    TEST_ASSERT_EQUAL_UINT32(MAX_MS, millis() - start);
+}
+
+void test_adaptive_drops_back_on_change_or_failure() {
+    SampleScheduler schedule(BASE_MS, MAX_MS);
+    stableSamples(schedule, 2 * SampleScheduler::STABLE_SAMPLES);
+    TEST_ASSERT_EQUAL_UINT32(4000, schedule.getInterval());
+    
+    sample(schedule, 50, true, true);
+    TEST_ASSERT_EQUAL_UINT32(BASE_MS, schedule.getInterval());
+    
+    // The stable count starts over too: a change one sample short of a step prevents it
+    stableSamples(schedule, SampleScheduler::STABLE_SAMPLES - 1);
+    sample(schedule, 50, true, true);
+    stableSamples(schedule, SampleScheduler::STABLE_SAMPLES - 1);
+    TEST_ASSERT_EQUAL_UINT32(BASE_MS, schedule.getInterval());
+    stableSamples(schedule, 1);
+    TEST_ASSERT_EQUAL_UINT32(2000, schedule.getInterval());
+    
+    // A failed sample is no evidence of a steady level
+    sample(schedule, 50, false);
+    TEST_ASSERT_EQUAL_UINT32(BASE_MS, schedule.getInterval());
+}
+
+void test_fixed_ignores_stability() {
+    SampleScheduler schedule(BASE_MS, MAX_MS, SampleScheduler::MODE_FIXED);
+    stableSamples(schedule, 3 * SampleScheduler::STABLE_SAMPLES);
+    TEST_ASSERT_EQUAL_UINT32(BASE_MS, schedule.getInterval());
+    
+    // Leaving adaptive mode drops a backed-off interval at once
+    schedule.setMode(SampleScheduler::MODE_ADAPTIVE);
+    stableSamples(schedule, 2 * SampleScheduler::STABLE_SAMPLES);
+    TEST_ASSERT_EQUAL_UINT32(4000, schedule.getInterval());
+    schedule.setMode(SampleScheduler::MODE_FIXED);
+    TEST_ASSERT_EQUAL_UINT32(BASE_MS, schedule.getInterval());
+}
+
+void test_burst_interval_follows_sample_time() {
+    SampleScheduler schedule(BASE_MS, MAX_MS, SampleScheduler::MODE_BURST);
+    TEST_ASSERT_FALSE(schedule.getAchievableRate().isValid());
+    
+    // The next sample is due the moment the previous one completes
+    sample(schedule, 40);
+    TEST_ASSERT_EQUAL_UINT32(40, schedule.getSampleTime());
+    TEST_ASSERT_EQUAL_UINT32(40, schedule.getInterval());
+    TEST_ASSERT_TRUE(schedule.isDue(millis()));
+    TEST_ASSERT_EQUAL_INT32(2500, schedule.getAchievableRate().toRaw());  // 25.00 Hz
+    
+    // A slower sensor pulls the average, and with it the interval, along
+    for (int i = 0; i < 40; i++) {
+        sample(schedule, 80);
+    }
+    TEST_ASSERT_UINT32_WITHIN(1, 80, schedule.getSampleTime());
+    TEST_ASSERT_EQUAL_UINT32(schedule.getSampleTime(), schedule.getInterval());
+    
+    // Failed samples do not count towards the sample time
+    sample(schedule, 1000, false);
+    TEST_ASSERT_UINT32_WITHIN(1, 80, schedule.getSampleTime());
+    
+    schedule.setMode(SampleScheduler::MODE_ADAPTIVE);
+    TEST_ASSERT_EQUAL_UINT32(BASE_MS, schedule.getInterval());
+}
+
+void test_rate_and_duty_cycle_per_window() {
+    SampleScheduler schedule(BASE_MS, MAX_MS, SampleScheduler::MODE_FIXED);
+    
+    // One 100 ms sample per second: 1.00 Hz, 10.0 % busy, published when the window closes
+    for (int i = 0; i < 5; i++) {
+        sample(schedule, 100);
+    }
+    TEST_ASSERT_EQUAL_INT32(0, schedule.getRate().toRaw());
+    sample(schedule, 100);
+    TEST_ASSERT_EQUAL_INT32(100, schedule.getRate().toRaw());
+    TEST_ASSERT_EQUAL_INT32(100, schedule.getDutyCycle().toRaw());
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_adaptive_backs_off_while_stable);
+    RUN_TEST(test_adaptive_drops_back_on_change_or_failure);
+    RUN_TEST(test_fixed_ignores_stability);
+    RUN_TEST(test_burst_interval_follows_sample_time);
+    RUN_TEST(test_rate_and_duty_cycle_per_window);
+    return UNITY_END();
+}
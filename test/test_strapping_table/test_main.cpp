@@ -0,0 +1,175 @@
+// StrappingTable: text parsing, interpolation, and the bucket index against the binary search
+// (pio test -e native -f test_strapping_table)
+
+#include <unity.h>
+#include <StrappingTable.h>
+#include <ScriptedStream.h>
+#include <string.h>
+#include <string>
+
+// Collects writeTo() output
+class TextPrint : public Print {
+public:
+    std::string text;
+    size_t write(uint8_t c) override {
+        text += (char)c;
+        return 1;
+    }
+    using Print::write;
+};
+
+static StrappingTable table;
+static StrappingTable plain;
+
+static uint32_t randomState = 0x2468ACE;
+static uint32_t nextRandom() {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+// Whole text readable at once, as from a file
+static bool readText(StrappingTable& target, const char* text) {
+    ScriptedStream stream;
+    stream.schedule(0, (const uint8_t*)text, strlen(text), 0);
+    return target.readFrom(stream);
+}
+
+// Volume of the second point of "0,0\n100,<volume>"
+static int32_t parsedVolume(const char* volume) {
+    char text[64];
+    snprintf(text, sizeof(text), "0,0\n100,%s\n", volume);
+    TEST_ASSERT_TRUE(readText(table, text));
+    return table.getPoint(1)->volume.toRaw();
+}
+
+// Every input 0..65535 gives the same volume with and without the index
+static void checkIndexAgrees() {
+    plain = table;
+    table.buildIndex();
+    TEST_ASSERT_TRUE(table.hasIndex());
+    TEST_ASSERT_FALSE(plain.hasIndex());
+    for (uint32_t input = 0; input <= 0xFFFF; input++) {
+        TEST_ASSERT_EQUAL_INT32(plain.lookup((uint16_t)input).toRaw(), table.lookup((uint16_t)input).toRaw());
+    }
+}
+
+void setUp() {
+    table.clear();
+}
+
+void tearDown() {}
+
+void test_parse_volume_rounds_the_second_decimal() {
+    TEST_ASSERT_EQUAL_INT32(70, parsedVolume("7"));
+    TEST_ASSERT_EQUAL_INT32(70, parsedVolume("7."));
+    TEST_ASSERT_EQUAL_INT32(525, parsedVolume("52.5"));
+    TEST_ASSERT_EQUAL_INT32(525, parsedVolume("52.45"));
+    TEST_ASSERT_EQUAL_INT32(524, parsedVolume("52.44"));
+    TEST_ASSERT_EQUAL_INT32(524, parsedVolume("52.4499"));   // Only the second decimal counts
+    TEST_ASSERT_EQUAL_INT32(100, parsedVolume("9.95"));
+    TEST_ASSERT_EQUAL_INT32(-13, parsedVolume("-1.25"));     // Half away from zero
+    TEST_ASSERT_EQUAL_INT32(31, parsedVolume(" 3.1 \r"));
+}
+
+void test_bad_lines_reject_the_whole_table() {
+    const char* bad[] = {
+        "0,0\n100,abc\n",
+        "0,0\n100,\n",
+        "0,0\n100,1.2kg\n",
+        "0,0\n100 1.2\n",
+        "0,0\n70000,1\n",             // Input beyond 16 bits
+        "0,0\n100,5\n100,6\n",        // Inputs must strictly increase
+        "input,litres\n0,0\n100,5\n",
+        "0,0\n",                      // One point is not a table
+    };
+    for (const char* text : bad) {
+        TEST_ASSERT_TRUE(readText(table, "0,0\n10,1\n"));
+        TEST_ASSERT_FALSE(readText(table, text));
+        TEST_ASSERT_FALSE(table.isValid());
+        TEST_ASSERT_EQUAL(0, table.getPointCount());
+    }
+}
+
+void test_comments_header_and_round_trip() {
+    TEST_ASSERT_TRUE(readText(table, "# tank 3\ninput,freq\r\n\n  20000,0 \n30000,120.5\r\n45000,400\n"));
+    TEST_ASSERT_EQUAL(StrappingTable::INPUT_FREQUENCY, table.getInput());
+    TEST_ASSERT_EQUAL(3, table.getPointCount());
+    TEST_ASSERT_TRUE(table.hasIndex());
+    TEST_ASSERT_EQUAL_INT32(1205, table.lookup(0, 30000).toRaw());
+    
+    TextPrint printer;
+    table.writeTo(printer);
+    TEST_ASSERT_EQUAL_STRING("input,freq\n20000,0.0\n30000,120.5\n45000,400.0\n", printer.text.c_str());
+}
+
+void test_lookup_interpolates_and_clamps() {
+    TEST_ASSERT_FALSE(table.lookup(10).isValid());
+    TEST_ASSERT_TRUE(table.addPoint(100, Deci::fromRaw(0)));
+    TEST_ASSERT_TRUE(table.addPoint(400, Deci::fromRaw(1000)));
+    TEST_ASSERT_TRUE(table.addPoint(700, Deci::fromRaw(999)));
+    table.buildIndex();
+    TEST_ASSERT_EQUAL_INT32(0, table.lookup(0).toRaw());
+    TEST_ASSERT_EQUAL_INT32(0, table.lookup(100).toRaw());
+    TEST_ASSERT_EQUAL_INT32(500, table.lookup(250).toRaw());
+    TEST_ASSERT_EQUAL_INT32(3, table.lookup(101).toRaw());     // 3.33 rounds down
+    TEST_ASSERT_EQUAL_INT32(7, table.lookup(102).toRaw());     // 6.67 rounds up
+    TEST_ASSERT_EQUAL_INT32(1000, table.lookup(400).toRaw());
+    TEST_ASSERT_EQUAL_INT32(1000, table.lookup(549).toRaw());  // -0.49 rounds to 0
+    TEST_ASSERT_EQUAL_INT32(999, table.lookup(551).toRaw());   // -0.50 rounds away from zero
+    TEST_ASSERT_EQUAL_INT32(999, table.lookup(65535).toRaw());
+}
+
+void test_index_agrees_on_random_tables() {
+    for (int round = 0; round < 12; round++) {
+        table.clear();
+        int count = 2 + nextRandom() % (StrappingTable::MAX_POINTS - 1);
+        uint32_t input = nextRandom() % 2000;
+        int32_t volume = 0;
+        for (int i = 0; i < count && input <= 0xFFFF; i++) {
+            TEST_ASSERT_TRUE(table.addPoint((uint16_t)input, Deci::fromRaw(volume)));
+            input += 1 + nextRandom() % (round % 2 ? 300 : 20);
+            volume += nextRandom() % 500;
+        }
+        checkIndexAgrees();
+    }
+}
+
+void test_index_agrees_on_uneven_tables() {
+    // Dense cluster inside one bucket, then a long sparse tail
+    for (int i = 0; i < 300; i++) {
+        TEST_ASSERT_TRUE(table.addPoint(1000 + i, Deci::fromRaw(i * 3)));
+    }
+    TEST_ASSERT_TRUE(table.addPoint(60000, Deci::fromRaw(5000)));
+    checkIndexAgrees();
+    
+    // Full 16-bit span, and the smallest table
+    table.clear();
+    TEST_ASSERT_TRUE(table.addPoint(0, Deci::fromRaw(0)));
+    TEST_ASSERT_TRUE(table.addPoint(65535, Deci::fromRaw(65535)));
+    checkIndexAgrees();
+    table.clear();
+    TEST_ASSERT_TRUE(table.addPoint(500, Deci::fromRaw(10)));
+    TEST_ASSERT_TRUE(table.addPoint(501, Deci::fromRaw(20)));
+    checkIndexAgrees();
+    
+    // One point per input over a span wider than the index
+    table.clear();
+    for (int i = 0; i < StrappingTable::MAX_POINTS; i++) {
+        TEST_ASSERT_TRUE(table.addPoint(2000 + i, Deci::fromRaw(i * i)));
+    }
+    TEST_ASSERT_FALSE(table.addPoint(3000, Deci::fromRaw(0)));
+    checkIndexAgrees();
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_volume_rounds_the_second_decimal);
+    RUN_TEST(test_bad_lines_reject_the_whole_table);
+    RUN_TEST(test_comments_header_and_round_trip);
+    RUN_TEST(test_lookup_interpolates_and_clamps);
+    RUN_TEST(test_index_agrees_on_random_tables);
+    RUN_TEST(test_index_agrees_on_uneven_tables);
+    return UNITY_END();
+}
@@ -0,0 +1,163 @@
+// Stored fuel link captures played back through UartReplay into FuelSensor + FuelBusManager:
+// the driver must send the captured requests byte for byte and decode the same readings at the
+// same times (pio test -e native -f test_uart_replay)
+//
+// corpus/ holds captures saved with console 's' (/fuel_capture.bin on LittleFS), one file per
+// entry, each listed in CORPUS with what the bus manager decoded when it was recorded. Every
+// capture starts at boot: quick scan 0x01-0x10, then identity reads and round-robin polls.
+
+#include <unity.h>
+#include <FuelBusManager.h>
+#include <UartCapture.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+static const unsigned long LOOP_STEP_MS = 1;
+
+struct ExpectedProbe {
+    uint8_t address;
+    uint16_t fuelValue;
+    uint16_t frequency;
+    int32_t temperature;       // Whole °C
+    uint16_t levelMax;
+    uint16_t levelMin;
+    uint32_t serialNumber;
+    unsigned long foundTime;   // ms after boot
+    unsigned long lastSeen;    // ms after boot
+    uint32_t pollCount;
+};
+
+struct CorpusEntry {
+    const char* file;
+    int records;
+    unsigned long durationMs;  // Replayed this long, as recorded
+    int probeCount;
+    ExpectedProbe probes[FuelBusManager::MAX_PROBES];
+};
+
+// sim_two_probes.bin: recorded on AoooGSimulator with the simulator build's two probes,
+// 0x01 burning 1 unit/s and 0x02 topped up by 300 units after 10 s
+static const CorpusEntry CORPUS[] = {
+    {"sim_two_probes.bin", 382, 20000, 2, {
+        {0x01, 2463, 41250, 27, 4000, 100, 800001, 26, 16090, 9},
+        {0x02, 1210, 52110, 25, 4000, 100, 800002, 167, 18090, 9},
+    }},
+};
+
+static std::string corpusPath(const char* file) {
+    std::string path = __FILE__;
+    return path.substr(0, path.find_last_of("/\\") + 1) + "corpus/" + file;
+}
+
+static bool loadCapture(const char* file, UartCapture& capture) {
+    FILE* in = fopen(corpusPath(file).c_str(), "rb");
+    if (in == nullptr) {
+        return false;
+    }
+    std::vector<uint8_t> bytes;
+    int c;
+    while ((c = fgetc(in)) != EOF) {
+        bytes.push_back((uint8_t)c);
+    }
+    fclose(in);
+    fs::File stream(&bytes);
+    return capture.readFrom(stream);
+}
+
+void setUp() {
+    NativeClock::reset();
+}
+
+void tearDown() {}
+
+void test_corpus_replays_to_recorded_readings() {
+    for (const CorpusEntry& entry : CORPUS) {
+        static UartCapture capture;
+        TEST_ASSERT_TRUE_MESSAGE(loadCapture(entry.file, capture), entry.file);
+        TEST_ASSERT_EQUAL(entry.records, capture.getCount());
+        
+        NativeClock::reset();
+        UartReplay replay(capture);
+        FuelSensor sensor(0xFF);
+        sensor.begin(replay);
+        FuelBusManager bus(sensor);
+        bus.startScan(FuelBusManager::FIRST_ADDRESS, FuelBusManager::QUICK_SCAN_LAST);
+        while (millis() < entry.durationMs) {
+            sensor.poll();
+            bus.poll();
+            NativeClock::advance(LOOP_STEP_MS);
+        }
+        
+        // Same requests in the same order, every reply picked up
+        TEST_ASSERT_TRUE_MESSAGE(replay.isFinished(), entry.file);
+        TEST_ASSERT_EQUAL_UINT32(0, replay.getMismatches());
+        TEST_ASSERT_EQUAL_UINT32(0, replay.getSkippedRx());
+        
+        TEST_ASSERT_EQUAL(entry.probeCount, bus.getProbeCount());
+        for (int i = 0; i < entry.probeCount; i++) {
+            const ExpectedProbe& expected = entry.probes[i];
+            const FuelBusManager::Probe* probe = bus.getProbe(i);
+            TEST_ASSERT_EQUAL_HEX8(expected.address, probe->address);
+            TEST_ASSERT_TRUE(probe->online);
+            TEST_ASSERT_TRUE(probe->dataValid);
+            TEST_ASSERT_EQUAL_UINT16(expected.fuelValue, probe->fuelValue);
+            TEST_ASSERT_EQUAL_UINT16(expected.frequency, probe->frequency);
+            TEST_ASSERT_EQUAL_INT32(expected.temperature, probe->temperature.whole());
+            TEST_ASSERT_TRUE(probe->limitsValid);
+            TEST_ASSERT_EQUAL_UINT16(expected.levelMax, probe->levelMax);
+            TEST_ASSERT_EQUAL_UINT16(expected.levelMin, probe->levelMin);
+            TEST_ASSERT_EQUAL_UINT32(expected.serialNumber, probe->serialNumber);
+            TEST_ASSERT_EQUAL_UINT32(expected.foundTime, probe->foundTime);
+            TEST_ASSERT_EQUAL_UINT32(expected.lastSeen, probe->lastSeen);
+            TEST_ASSERT_EQUAL_UINT32(expected.pollCount, probe->pollCount);
+        }
+    }
+}
+
+void test_reply_timing_follows_capture() {
+    static UartCapture capture;
+    TEST_ASSERT_TRUE(loadCapture(CORPUS[0].file, capture));
+    
+    // First request and its reply, straight off the capture
+    int index = 0;
+    unsigned long time = 0;
+    UartCapture::Record record;
+    std::vector<UartCapture::Record> request, reply;
+    while (capture.next(index, time, record)) {
+        if (record.direction == UartCapture::CAPTURE_TX) {
+            if (!reply.empty()) {
+                break;
+            }
+            request.push_back(record);
+        } else {
+            reply.push_back(record);
+        }
+    }
+    TEST_ASSERT_EQUAL(4, request.size());
+    TEST_ASSERT_EQUAL(9, reply.size());
+    
+    // Sending the request late shifts the reply by the same amount
+    NativeClock::reset();
+    UartReplay replay(capture);
+    NativeClock::advance(250);
+    unsigned long sentMicros = micros();
+    for (const UartCapture::Record& byte : request) {
+        replay.write(byte.value);
+    }
+    unsigned long offset = reply[0].micros - request.back().micros;
+    NativeClock::advanceMicros(offset - 1);
+    TEST_ASSERT_EQUAL(0, replay.available());
+    NativeClock::advanceMicros(1);
+    TEST_ASSERT_EQUAL(1, replay.available());
+    TEST_ASSERT_EQUAL_HEX8(reply[0].value, replay.read());
+    TEST_ASSERT_EQUAL_UINT32(sentMicros + offset, micros());
+    TEST_ASSERT_EQUAL_UINT32(0, replay.getMismatches());
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_corpus_replays_to_recorded_readings);
+    RUN_TEST(test_reply_timing_follows_capture);
+    return UNITY_END();
+}
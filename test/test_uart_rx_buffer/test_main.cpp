@@ -0,0 +1,165 @@
+// UartRxBuffer ring: order across the wrap, drop on overflow, reading after a full ring and
+// the 16-bit head/tail counters rolling over (pio test -e native -f test_uart_rx_buffer)
+
+#include <unity.h>
+#include <UartRxBuffer.h>
+#include <deque>
+#include <vector>
+
+// UART driver stand-in: deliver() queues bytes in its FIFO and raises the receive event,
+// as the UART event task does on the target
+class FakeUart : public HardwareSerial {
+public:
+    std::deque<uint8_t> fifo;
+    std::vector<uint8_t> sent;
+    
+    void deliver(const std::vector<uint8_t>& bytes) {
+        fifo.insert(fifo.end(), bytes.begin(), bytes.end());
+        receiveCallback();
+    }
+    int available() override { return (int)fifo.size(); }
+    int read() override {
+        if (fifo.empty()) {
+            return -1;
+        }
+        uint8_t value = fifo.front();
+        fifo.pop_front();
+        return value;
+    }
+    size_t write(uint8_t value) override {
+        sent.push_back(value);
+        return 1;
+    }
+    using Print::write;
+};
+
+// count bytes of a pattern that repeats every 256, continuing from *next
+static std::vector<uint8_t> sequence(uint32_t* next, int count) {
+    std::vector<uint8_t> bytes;
+    for (int i = 0; i < count; i++) {
+        bytes.push_back((uint8_t)((*next)++ * 7));
+    }
+    return bytes;
+}
+
+static void expectSequence(UartRxBuffer& ring, uint32_t* next, int count) {
+    for (int i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL((uint8_t)(*next * 7), ring.peek());
+        TEST_ASSERT_EQUAL((uint8_t)((*next)++ * 7), ring.read());
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_bytes_keep_their_order_across_the_wrap() {
+    FakeUart uart;
+    UartRxBuffer ring;
+    ring.begin(uart);
+    uint32_t produced = 0, consumed = 0;
+    
+    TEST_ASSERT_EQUAL(0, ring.available());
+    TEST_ASSERT_EQUAL(-1, ring.read());
+    TEST_ASSERT_EQUAL(-1, ring.peek());
+    
+    // 100-byte bursts read back in uneven pieces: the slots wrap several times
+    for (int burst = 0; burst < 10; burst++) {
+        uart.deliver(sequence(&produced, 100));
+        TEST_ASSERT_EQUAL(100, ring.available());
+        expectSequence(ring, &consumed, 37);
+        TEST_ASSERT_EQUAL(63, ring.available());
+        expectSequence(ring, &consumed, 63);
+        TEST_ASSERT_EQUAL(0, ring.available());
+    }
+    TEST_ASSERT_EQUAL(-1, ring.read());
+    TEST_ASSERT_EQUAL_UINT32(0, ring.getOverflows());
+    TEST_ASSERT_EQUAL_UINT32(10, ring.getEvents());
+    TEST_ASSERT_TRUE(uart.fifo.empty());
+}
+
+void test_overflow_drops_the_newest_bytes() {
+    FakeUart uart;
+    UartRxBuffer ring;
+    ring.begin(uart);
+    uint32_t produced = 0, consumed = 0;
+    
+    // The queued bytes are older and part of a frame already: they stay, the excess is counted
+    uart.deliver(sequence(&produced, UartRxBuffer::CAPACITY + 44));
+    TEST_ASSERT_EQUAL(UartRxBuffer::CAPACITY, ring.available());
+    TEST_ASSERT_EQUAL_UINT32(44, ring.getOverflows());
+    TEST_ASSERT_TRUE(uart.fifo.empty());
+    expectSequence(ring, &consumed, UartRxBuffer::CAPACITY);
+    TEST_ASSERT_EQUAL(0, ring.available());
+}
+
+void test_read_after_full_frees_slots() {
+    FakeUart uart;
+    UartRxBuffer ring;
+    ring.begin(uart);
+    uint32_t produced = 0, consumed = 0;
+    
+    uart.deliver(sequence(&produced, UartRxBuffer::CAPACITY));
+    TEST_ASSERT_EQUAL(UartRxBuffer::CAPACITY, ring.available());
+    TEST_ASSERT_EQUAL_UINT32(0, ring.getOverflows());
+    
+    // Room for exactly what was read, one more byte overflows
+    expectSequence(ring, &consumed, 10);
+    uart.deliver(sequence(&produced, 10));
+    TEST_ASSERT_EQUAL(UartRxBuffer::CAPACITY, ring.available());
+    TEST_ASSERT_EQUAL_UINT32(0, ring.getOverflows());
+    std::vector<uint8_t> extra = {0xAA};
+    uart.deliver(extra);
+    TEST_ASSERT_EQUAL_UINT32(1, ring.getOverflows());
+    
+    expectSequence(ring, &consumed, UartRxBuffer::CAPACITY);
+    TEST_ASSERT_EQUAL(-1, ring.read());
+}
+
+void test_index_counters_roll_over() {
+    FakeUart uart;
+    UartRxBuffer ring;
+    ring.begin(uart);
+    uint32_t produced = 0, consumed = 0;
+    
+    // head and tail are free-running uint16_t: past 65535 head is numerically behind tail
+    // while bytes are queued, available() must still be the difference modulo 2^16
+    while (produced < 3 * 65536UL) {
+        uart.deliver(sequence(&produced, 250));
+        TEST_ASSERT_EQUAL(250, ring.available());
+        expectSequence(ring, &consumed, 200);
+        TEST_ASSERT_EQUAL(50, ring.available());
+        expectSequence(ring, &consumed, 50);
+    }
+    TEST_ASSERT_EQUAL(0, ring.available());
+    TEST_ASSERT_EQUAL_UINT32(0, ring.getOverflows());
+    
+    // Full and overflowing after the rollovers behave as on a fresh ring
+    uart.deliver(sequence(&produced, UartRxBuffer::CAPACITY + 1));
+    TEST_ASSERT_EQUAL(UartRxBuffer::CAPACITY, ring.available());
+    TEST_ASSERT_EQUAL_UINT32(1, ring.getOverflows());
+    expectSequence(ring, &consumed, UartRxBuffer::CAPACITY);
+}
+
+void test_writes_go_to_the_uart() {
+    FakeUart uart;
+    UartRxBuffer ring;
+    TEST_ASSERT_EQUAL(0, ring.write(0x31));
+    
+    ring.begin(uart);
+    const uint8_t bytes[] = {0x31, 0x01, 0x06};
+    TEST_ASSERT_EQUAL(sizeof(bytes), ring.write(bytes, sizeof(bytes)));
+    TEST_ASSERT_EQUAL(sizeof(bytes), uart.sent.size());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(bytes, uart.sent.data(), sizeof(bytes));
+    TEST_ASSERT_EQUAL(0, ring.available());
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_bytes_keep_their_order_across_the_wrap);
+    RUN_TEST(test_overflow_drops_the_newest_bytes);
+    RUN_TEST(test_read_after_full_frees_slots);
+    RUN_TEST(test_index_counters_roll_over);
+    RUN_TEST(test_writes_go_to_the_uart);
+    return UNITY_END();
+}